@@ -0,0 +1,262 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/* Transformed layer benchmark and regression. A tiled layer with flipped and rotated tiles over a
+ * bitmap layer, both covering the whole screen, are rotated and zoomed, then scaled, and must
+ * produce the reference frames of the per pixel renderers. Then layers larger than 32768 pixels,
+ * built by repeating the small ones, are zoomed and scaled far from the origin, where 32 bit
+ * fixed point coordinates overflow, and must produce the frames of the small layers. */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include "Bench.h"
+#include "Tilengine.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+#define BENCH_WIDTH		640			/* Framebuffer width. */
+#define BENCH_HEIGHT	480			/* Framebuffer height. */
+#define BENCH_FRAMES	200			/* Frames rendered per pass. */
+#define BENCH_WARMUP	10			/* Frames rendered before timing starts. */
+#define BENCH_THREADS	4			/* Render threads of the threaded passes. */
+#define BENCH_COLS		64			/* Small tilemap columns, 1024 pixels. */
+#define BENCH_ROWS		32			/* Small tilemap rows, 512 pixels. */
+#define BENCH_REPEAT	36			/* Times the large layers repeat the small ones across. */
+#define BENCH_CASES		8			/* Transforms of the large layer pass. */
+#define BENCH_ROTATING	0x652ba1cdu	/* Hash of every frame of the rotating pass. */
+#define BENCH_SCALING	0xb0231e65u	/* Hash of every frame of the scaling pass. */
+
+/**************************************************************************************************
+ * Benchmark Context
+ *************************************************************************************************/
+
+typedef struct
+{
+	TLN_Tilemap tilemap;			/* Layer 0, transparent tiles. */
+	TLN_Bitmap bitmap;				/* Layer 1, opaque. */
+}
+BenchLayers;
+
+static uint32_t framebuffer[BENCH_WIDTH * BENCH_HEIGHT];
+static TLN_Palette palette;
+static BenchLayers small_layers;
+static BenchLayers large_layers;
+
+/**************************************************************************************************
+ * Scene Setup
+ *************************************************************************************************/
+
+/* Creates the tilemap repeated the given number of times across and down, 16x16 tiles with
+ * every fifth one empty and some flipped or rotated. */
+static TLN_Tilemap CreateTilemap(TLN_Tileset tileset, int hrepeat, int vrepeat)
+{
+	const int cols = BENCH_COLS * hrepeat;
+	const int rows = BENCH_ROWS * vrepeat;
+	TLN_Tilemap tilemap;
+	TLN_Tile tiles;
+	int x, y;
+
+	tiles = (TLN_Tile)calloc((size_t)cols * rows, sizeof(*tiles));
+	for (y = 0; y < rows; y++)
+	{
+		for (x = 0; x < cols; x++)
+		{
+			const int i = (y % BENCH_ROWS) * BENCH_COLS + x % BENCH_COLS;
+			const uint32_t random = ((uint32_t)i * 2654435761u) >> 7;
+			TLN_Tile tile = &tiles[(size_t)y * cols + x];
+
+			tile->index = random % 5 == 0 ? 0 : (uint16_t)(1 + random % 32);
+			if (random % 11 == 0)
+				tile->flags |= FLAG_FLIPX;
+			if (random % 13 == 0)
+				tile->flags |= FLAG_FLIPY;
+			if (random % 17 == 0)
+				tile->flags |= FLAG_ROTATE;
+		}
+	}
+
+	tilemap = TLN_CreateTilemap(rows, cols, tiles, 0, tileset);
+	free(tiles);
+	return tilemap;
+}
+
+/* Creates the opaque bitmap repeated the given number of times horizontally. */
+static TLN_Bitmap CreateBitmap(int repeat)
+{
+	const int width = BENCH_COLS * 16 * repeat;
+	TLN_Bitmap bitmap = TLN_CreateBitmap(width, BENCH_ROWS * 16, 8);
+	int x, y;
+
+	for (y = 0; y < BENCH_ROWS * 16; y++)
+	{
+		for (x = 0; x < width; x++)
+		{
+			const int sx = x % (BENCH_COLS * 16);
+			*TLN_GetBitmapPtr(bitmap, x, y) = (uint8_t)(1 + (sx * 5 + y * 3 + (sx ^ y) / 7) % 255);
+		}
+	}
+	TLN_SetBitmapPalette(bitmap, palette);
+	return bitmap;
+}
+
+/* Sets up the palette and the small and large layers, sharing one tileset. */
+static void CreateScene(void)
+{
+	TLN_Tileset tileset;
+	uint8_t pixels[16 * 16];
+	int t, i;
+
+	palette = TLN_CreatePalette(256);
+	for (i = 0; i < 256; i++)
+		TLN_SetPaletteColor(palette, i, (uint8_t)i, (uint8_t)(i * 3), (uint8_t)(i * 7));
+
+	tileset = TLN_CreateTileset(33, 16, 16, palette, NULL, NULL);
+	for (t = 1; t < 33; t++)
+	{
+		for (i = 0; i < 16 * 16; i++)
+		{
+			const int value = (i * 7 + t * 13 + i / 16 * t) % 40;
+			pixels[i] = value < 8 ? 0 : (uint8_t)(1 + (value + t) % 254);
+		}
+		TLN_SetTilesetPixels(tileset, t, pixels, 16);
+	}
+
+	/* the large tilemap is 36864 pixels square, the large bitmap 36864 pixels wide */
+	small_layers.tilemap = CreateTilemap(tileset, 1, 1);
+	small_layers.bitmap = CreateBitmap(1);
+	large_layers.tilemap = CreateTilemap(tileset, BENCH_REPEAT, BENCH_REPEAT * 2);
+	large_layers.bitmap = CreateBitmap(BENCH_REPEAT);
+	TLN_SetBGColor(10, 20, 30);
+}
+
+/* Attaches a pair of layers, placed at the origin. */
+static void SetLayers(const BenchLayers* layers)
+{
+	TLN_SetLayerTilemap(0, layers->tilemap);
+	TLN_SetLayerBitmap(1, layers->bitmap);
+	TLN_SetLayerPosition(0, 0, 0);
+	TLN_SetLayerPosition(1, 0, 0);
+}
+
+/**************************************************************************************************
+ * Benchmark
+ *************************************************************************************************/
+
+/* Rotates both layers in opposite directions around the screen center while zooming. */
+static void SetRotating(int frame)
+{
+	const float zoom = 0.75f + (float)(frame % 40) * 0.0125f;
+
+	TLN_SetLayerPosition(0, 0, 0);
+	TLN_SetLayerPosition(1, 0, 0);
+	TLN_SetLayerTransform(0, (float)frame * 1.8f, BENCH_WIDTH / 2, BENCH_HEIGHT / 2, zoom, zoom);
+	TLN_SetLayerTransform(1, (float)frame * -0.9f, BENCH_WIDTH / 2, BENCH_HEIGHT / 2, 2.0f - zoom, 2.0f - zoom);
+}
+
+/* Scales and scrolls both layers. */
+static void SetScaling(int frame)
+{
+	const float zoom = 0.5f + (float)(frame % 50) * 0.03f;
+
+	TLN_SetLayerPosition(0, frame * 3, frame);
+	TLN_SetLayerPosition(1, frame, frame * 2);
+	TLN_SetLayerScaling(0, zoom, zoom * 0.8f);
+	TLN_SetLayerScaling(1, 2.5f - zoom, 1.25f);
+}
+
+/* Zooms and scales far from the origin, with power of two factors and no rotation so the
+ * transformed coordinates are exact and the repeated layers must match the small ones. */
+static void SetLargeCase(int frame)
+{
+	static const float factors[BENCH_CASES / 2] = { 0.25f, 0.5f, 2.0f, 4.0f };
+	const float factor = factors[frame % (BENCH_CASES / 2)];
+	const int offset = 33000 + frame * 400;
+
+	TLN_ResetLayerMode(0);
+	TLN_ResetLayerMode(1);
+	TLN_SetLayerPosition(0, 0, 0);
+	TLN_SetLayerPosition(1, 0, 0);
+	if (frame < BENCH_CASES / 2)
+	{
+		TLN_SetLayerTransform(0, 0.0f, (float)offset, (float)offset, factor, factor);
+		TLN_SetLayerTransform(1, 0.0f, (float)offset, 0.0f, factor, 1.0f);
+	}
+	else
+	{
+		TLN_SetLayerPosition(0, offset, offset);
+		TLN_SetLayerPosition(1, offset, 0);
+		TLN_SetLayerScaling(0, factor, factor);
+		TLN_SetLayerScaling(1, factor >= 1.0f ? 2.0f : 0.5f, 1.0f);
+	}
+}
+
+/* Renders every frame of a pass, returns the milliseconds per frame after the warm up frames. */
+static double RenderFrames(void (*setup)(int frame), int frames, uint32_t* hash)
+{
+	const int warmup = frames > BENCH_WARMUP ? BENCH_WARMUP : 0;
+	double start = BenchTime();
+	int frame;
+
+	*hash = BENCH_HASH_SEED;
+	for (frame = 0; frame < frames; frame++)
+	{
+		setup(frame);
+		if (frame == warmup)
+			start = BenchTime();
+		TLN_UpdateFrame(frame);
+
+		*hash = BenchHash(*hash, framebuffer, sizeof(framebuffer));
+	}
+
+	return (BenchTime() - start) / (frames - warmup);
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t hash, reference;
+	double ms;
+	int failed;
+
+	TLN_Init(BENCH_WIDTH, BENCH_HEIGHT, 2, 0, 0);
+	TLN_SetLogLevel(TLN_LOG_NONE);
+	TLN_SetRenderTarget((uint8_t*)framebuffer, BENCH_WIDTH * sizeof(uint32_t));
+	CreateScene();
+
+	printf("transformed layers, %dx%d, %d frames\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES);
+
+	SetLayers(&small_layers);
+	ms = RenderFrames(SetRotating, BENCH_FRAMES, &hash);
+	failed = BenchReport("rotating", ms, hash, BENCH_ROTATING);
+	ms = RenderFrames(SetScaling, BENCH_FRAMES, &hash);
+	failed |= BenchReport("scaling", ms, hash, BENCH_SCALING);
+
+	TLN_SetRenderThreads(BENCH_THREADS);
+	ms = RenderFrames(SetRotating, BENCH_FRAMES, &hash);
+	failed |= BenchReport("rotating, 4 threads", ms, hash, BENCH_ROTATING);
+	ms = RenderFrames(SetScaling, BENCH_FRAMES, &hash);
+	failed |= BenchReport("scaling, 4 threads", ms, hash, BENCH_SCALING);
+	TLN_SetRenderThreads(1);
+
+	SetLayers(&small_layers);
+	ms = RenderFrames(SetLargeCase, BENCH_CASES, &reference);
+	BenchReport("small layers", ms, reference, 0);
+	SetLayers(&large_layers);
+	ms = RenderFrames(SetLargeCase, BENCH_CASES, &hash);
+	failed |= BenchReport("large layers", ms, hash, reference);
+
+	/* layer objects share the palette and tileset, they go away with the process */
+	TLN_Deinit();
+	return failed;
+}
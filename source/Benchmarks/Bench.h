@@ -0,0 +1,83 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+/* clock_gettime() is POSIX, the benchmarks build as C99 */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/**************************************************************************************************
+ * Benchmark Helpers
+ *************************************************************************************************/
+
+/* Gets a monotonic wall clock time in milliseconds, render threads make processor time add up. */
+static double BenchTime(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER now, frequency;
+
+	QueryPerformanceCounter(&now);
+	QueryPerformanceFrequency(&frequency);
+	return (double)now.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1e6;
+#endif
+}
+
+/* Folds a block of memory into a running FNV-1a hash. */
+static uint32_t BenchHash(uint32_t hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	size_t i;
+
+	for (i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+#define BENCH_HASH_SEED	2166136261u
+
+/* Prints a result line and checks a hash against its reference, 0 skips the check. */
+static int BenchReport(const char* name, double ms, uint32_t hash, uint32_t reference)
+{
+	const int failed = reference != 0 && hash != reference;
+
+	printf("%-24s %10.4f ms  hash=%08x%s\n", name, ms, hash,
+		failed ? "  MISMATCH" : "");
+	return failed;
+}
+
+#endif
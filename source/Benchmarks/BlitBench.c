@@ -0,0 +1,306 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/* Scanline blitter benchmark and blend regression. A tiled layer with 8 and 16 pixel wide tiles,
+ * and a bitmap layer spanning whole lines, are drawn over an opaque bitmap in every blend mode.
+ * Each frame is checked pixel by pixel against a plain C reference built with the formulas of
+ * the former blend lookup tables, so the SIMD blitters and blending must stay bit exact. */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include "Bench.h"
+#include "Tilengine.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+#define BENCH_WIDTH		640		/* Framebuffer width. */
+#define BENCH_HEIGHT	480		/* Framebuffer height. */
+#define BENCH_FRAMES	50		/* Frames timed per scene and blend mode. */
+#define BENCH_TILES		17		/* Tileset entries, entry 0 stays empty. */
+#define BENCH_COLS		96		/* Tilemap columns. */
+#define BENCH_ROWS		64		/* Tilemap rows. */
+#define BENCH_HSTART	5		/* Front layer scroll, keeps partial tiles at the edges. */
+#define BENCH_VSTART	3
+
+#define RGB_MASK		0x00FFFFFF
+
+/**************************************************************************************************
+ * Benchmark Context
+ *************************************************************************************************/
+
+typedef enum
+{
+	SCENE_TILES8,
+	SCENE_TILES16,
+	SCENE_BITMAP,
+	MAX_SCENES
+}
+BenchScene;
+
+static const char* scene_names[MAX_SCENES] = { "tiles8", "tiles16", "bitmap" };
+
+static const TLN_Blend blend_modes[] = { BLEND_NONE, BLEND_MIX25, BLEND_MIX50, BLEND_MIX75, BLEND_ADD, BLEND_SUB, BLEND_MOD };
+static const char* blend_names[] = { "none", "mix25", "mix50", "mix75", "add", "sub", "mod" };
+
+static uint32_t framebuffer[BENCH_WIDTH * BENCH_HEIGHT];
+static uint32_t reference[BENCH_WIDTH * BENCH_HEIGHT];
+static uint32_t colors[256];
+static uint8_t back_pixels[BENCH_WIDTH * BENCH_HEIGHT];
+static uint8_t front_pixels[BENCH_WIDTH * BENCH_HEIGHT];
+static uint8_t tile_pixels[BENCH_TILES][16 * 16];
+static TLN_Tile tiles;
+static TLN_Palette palette;
+
+/**************************************************************************************************
+ * Scene Setup
+ *************************************************************************************************/
+
+/* Color of a palette index, the same channels the palette is given. */
+static uint32_t GetColor(int index)
+{
+	return (uint32_t)(index << 16) | (uint32_t)(((index * 3) & 255) << 8) | (uint32_t)((index * 7) & 255);
+}
+
+/* Creates the shared palette and the opaque bitmap drawn behind every scene. */
+static TLN_Bitmap CreateBackLayer(void)
+{
+	TLN_Bitmap bitmap = TLN_CreateBitmap(BENCH_WIDTH, BENCH_HEIGHT, 8);
+	int x, y, i;
+
+	palette = TLN_CreatePalette(256);
+	for (i = 0; i < 256; i++)
+	{
+		TLN_SetPaletteColor(palette, i, (uint8_t)i, (uint8_t)(i * 3), (uint8_t)(i * 7));
+		colors[i] = GetColor(i);
+	}
+
+	for (y = 0; y < BENCH_HEIGHT; y++)
+	{
+		for (x = 0; x < BENCH_WIDTH; x++)
+		{
+			back_pixels[y * BENCH_WIDTH + x] = (uint8_t)(1 + (x * 3 + y * 5 + 17) % 255);
+			*TLN_GetBitmapPtr(bitmap, x, y) = back_pixels[y * BENCH_WIDTH + x];
+		}
+	}
+	TLN_SetBitmapPalette(bitmap, palette);
+	return bitmap;
+}
+
+/* Creates a tilemap with solid, holed and half empty tiles of the given width. */
+static TLN_Tilemap CreateTileLayer(int size)
+{
+	TLN_Tileset tileset = TLN_CreateTileset(BENCH_TILES, size, size, palette, NULL, NULL);
+	uint32_t seed = 1;
+	int t, x, y, i;
+
+	for (t = 1; t < BENCH_TILES; t++)
+	{
+		for (y = 0; y < size; y++)
+		{
+			for (x = 0; x < size; x++)
+			{
+				bool empty;
+
+				switch (t % 4)
+				{
+				case 0:  empty = false; break;
+				case 1:  empty = ((x ^ y) & 1) != 0; break;
+				case 2:  empty = x < size / 2; break;
+				default: empty = (x + y * 3 + t) % 9 == 0; break;
+				}
+				tile_pixels[t][y * size + x] = empty ? 0 : (uint8_t)(1 + (x * 7 + y * 11 + t * 13) % 254);
+			}
+		}
+		TLN_SetTilesetPixels(tileset, t, tile_pixels[t], size);
+	}
+
+	for (i = 0; i < BENCH_ROWS * BENCH_COLS; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		tiles[i].value = 0;
+		tiles[i].index = (uint16_t)((seed >> 16) % BENCH_TILES);
+		if ((seed >> 8) & 1)
+			tiles[i].flags = FLAG_FLIPX;
+	}
+
+	return TLN_CreateTilemap(BENCH_ROWS, BENCH_COLS, tiles, 0, tileset);
+}
+
+/* Creates a framebuffer sized bitmap with scattered transparent pixels. */
+static TLN_Bitmap CreateBitmapLayer(void)
+{
+	TLN_Bitmap bitmap = TLN_CreateBitmap(BENCH_WIDTH, BENCH_HEIGHT, 8);
+	int x, y;
+
+	for (y = 0; y < BENCH_HEIGHT; y++)
+	{
+		for (x = 0; x < BENCH_WIDTH; x++)
+		{
+			front_pixels[y * BENCH_WIDTH + x] = (x / 3 + y) % 7 == 0 ? 0 : (uint8_t)(1 + (x * 5 + y * 3) % 254);
+			*TLN_GetBitmapPtr(bitmap, x, y) = front_pixels[y * BENCH_WIDTH + x];
+		}
+	}
+	TLN_SetBitmapPalette(bitmap, palette);
+	return bitmap;
+}
+
+/**************************************************************************************************
+ * Reference
+ *************************************************************************************************/
+
+/* Blends a channel the way the former lookup tables did. */
+static int BlendChannel(TLN_Blend mode, int src, int dst)
+{
+	switch (mode)
+	{
+	case BLEND_MIX25: return (src + dst + dst) / 3;
+	case BLEND_MIX50: return (src + dst) >> 1;
+	case BLEND_MIX75: return (src + src + dst) / 3;
+	case BLEND_ADD:   return (src + dst) > 255 ? 255 : src + dst;
+	case BLEND_SUB:   return (src - dst) < 0 ? 0 : src - dst;
+	case BLEND_MOD:   return (src * dst) / 255;
+	default:          return src;
+	}
+}
+
+/* Gets the front layer's palette index at a screen position, 0 is transparent. */
+static int GetFrontPixel(BenchScene scene, int x, int y)
+{
+	const int size = scene == SCENE_TILES8 ? 8 : 16;
+	TLN_Tile tile;
+	int lx, ly, sx;
+
+	if (scene == SCENE_BITMAP)
+		return front_pixels[y * BENCH_WIDTH + x];
+
+	lx = (x + BENCH_HSTART) % (BENCH_COLS * size);
+	ly = (y + BENCH_VSTART) % (BENCH_ROWS * size);
+	tile = &tiles[(ly / size) * BENCH_COLS + lx / size];
+	if (tile->index == 0)
+		return 0;
+
+	sx = lx % size;
+	if (tile->flags & FLAG_FLIPX)
+		sx = size - 1 - sx;
+	return tile_pixels[tile->index][(ly % size) * size + sx];
+}
+
+/* Builds the expected frame of a scene and blend mode. */
+static void BuildReference(BenchScene scene, TLN_Blend mode)
+{
+	int x, y;
+
+	for (y = 0; y < BENCH_HEIGHT; y++)
+	{
+		for (x = 0; x < BENCH_WIDTH; x++)
+		{
+			const uint32_t dst = colors[back_pixels[y * BENCH_WIDTH + x]];
+			const int index = GetFrontPixel(scene, x, y);
+			uint32_t src, pixel = 0;
+			int shift;
+
+			if (index == 0)
+			{
+				reference[y * BENCH_WIDTH + x] = dst;
+				continue;
+			}
+
+			src = colors[index];
+			for (shift = 0; shift < 24; shift += 8)
+				pixel |= (uint32_t)BlendChannel(mode, (src >> shift) & 255, (dst >> shift) & 255) << shift;
+			reference[y * BENCH_WIDTH + x] = pixel;
+		}
+	}
+}
+
+/* Counts the pixels of the last frame that differ from the reference. */
+static int CountMismatches(void)
+{
+	int count = 0;
+	int i;
+
+	for (i = 0; i < BENCH_WIDTH * BENCH_HEIGHT; i++)
+	{
+		if ((framebuffer[i] & RGB_MASK) != reference[i])
+			count++;
+	}
+	return count;
+}
+
+/**************************************************************************************************
+ * Benchmark
+ *************************************************************************************************/
+
+int main(int argc, char* argv[])
+{
+	TLN_Bitmap front_bitmap;
+	int failed = 0;
+	int scene, mode, frame;
+
+	TLN_Init(BENCH_WIDTH, BENCH_HEIGHT, 2, 0, 0);
+	TLN_SetLogLevel(TLN_LOG_NONE);
+	TLN_SetRenderTarget((uint8_t*)framebuffer, BENCH_WIDTH * sizeof(uint32_t));
+
+	tiles = (TLN_Tile)calloc(BENCH_ROWS * BENCH_COLS, sizeof(*tiles));
+	TLN_SetLayerBitmap(1, CreateBackLayer());
+	front_bitmap = CreateBitmapLayer();
+
+	printf("scanline blitters, %dx%d, %d frames per case\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES);
+	for (scene = 0; scene < MAX_SCENES; scene++)
+	{
+		if (scene == SCENE_BITMAP)
+		{
+			TLN_SetLayerBitmap(0, front_bitmap);
+			TLN_SetLayerPosition(0, 0, 0);
+		}
+		else
+		{
+			TLN_SetLayerTilemap(0, CreateTileLayer(scene == SCENE_TILES8 ? 8 : 16));
+			TLN_SetLayerPosition(0, BENCH_HSTART, BENCH_VSTART);
+		}
+
+		for (mode = 0; mode < (int)(sizeof(blend_modes) / sizeof(blend_modes[0])); mode++)
+		{
+			char name[32];
+			uint32_t hash;
+			double start;
+			int mismatches;
+
+			TLN_SetLayerBlendMode(0, blend_modes[mode], 0);
+			start = BenchTime();
+			for (frame = 0; frame < BENCH_FRAMES; frame++)
+				TLN_UpdateFrame(frame);
+			start = BenchTime() - start;
+
+			BuildReference((BenchScene)scene, blend_modes[mode]);
+			mismatches = CountMismatches();
+			hash = BenchHash(BENCH_HASH_SEED, framebuffer, sizeof(framebuffer));
+
+			snprintf(name, sizeof(name), "%s %s", scene_names[scene], blend_names[mode]);
+			BenchReport(name, start / BENCH_FRAMES, hash, 0);
+			if (mismatches != 0)
+			{
+				printf("%-24s %d pixels differ from the reference\n", name, mismatches);
+				failed = 1;
+			}
+		}
+	}
+
+	/* layer objects share the palette, they go away with the process */
+	free(tiles);
+	TLN_Deinit();
+
+	return failed;
+}
@@ -0,0 +1,293 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/* Concurrent context benchmark and regression. Two engine contexts with their own scenes, custom
+ * blend functions, mosaic, raster table and sprites are each rendered alone on the calling thread,
+ * then both at once on two threads bound with TLN_SetThreadContext(), without and with render
+ * threads of their own. Every concurrent pass must produce the frames of the single context one. */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include "Bench.h"
+#include "Tilengine.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+#define BENCH_WIDTH		640		/* Framebuffer width. */
+#define BENCH_HEIGHT	480		/* Framebuffer height. */
+#define BENCH_CONTEXTS	2		/* Contexts rendered at once. */
+#define BENCH_SPRITES	16		/* Sprites per context. */
+#define BENCH_FRAMES	100		/* Frames rendered per context and pass. */
+#define BENCH_THREADS	2		/* Render threads of each context in the last pass. */
+
+/**************************************************************************************************
+ * Benchmark Context
+ *************************************************************************************************/
+
+typedef struct BenchContext
+{
+	TLN_Engine engine;			/* Context drawing this scene. */
+	int seed;					/* Scene variation. */
+	uint32_t* framebuffer;		/* Render target of the context. */
+	uint32_t reference;			/* Hash of the frames rendered alone. */
+	uint32_t hash;				/* Hash of the frames of the last pass. */
+}
+BenchContext;
+
+static BenchContext contexts[BENCH_CONTEXTS];
+static TLN_RasterLine table[BENCH_HEIGHT];
+static TLN_Palette palette;
+
+/**************************************************************************************************
+ * Scene Setup
+ *************************************************************************************************/
+
+/* Custom blend functions, each context owns its lookup table. */
+static uint8_t BlendInvert(uint8_t src, uint8_t dst)
+{
+	return (uint8_t)(255 - src);
+}
+
+static uint8_t BlendLighten(uint8_t src, uint8_t dst)
+{
+	return src > dst ? src : dst;
+}
+
+/* Creates a 64x64 tilemap of 16x16 tiles, every fifth tile empty. */
+static TLN_Tilemap CreateTilemap(int seed)
+{
+	TLN_Tileset tileset = TLN_CreateTileset(33, 16, 16, palette, NULL, NULL);
+	TLN_Tilemap tilemap;
+	TLN_Tile tiles;
+	uint8_t pixels[16 * 16];
+	int t, i;
+
+	for (t = 1; t < 33; t++)
+	{
+		for (i = 0; i < 16 * 16; i++)
+		{
+			const int value = (i * 7 + t * 13 + seed) % 40;
+			pixels[i] = value < 8 ? 0 : (uint8_t)(1 + (value + t) % 254);
+		}
+		TLN_SetTilesetPixels(tileset, t, pixels, 16);
+	}
+
+	tiles = (TLN_Tile)calloc(64 * 64, sizeof(*tiles));
+	for (i = 0; i < 64 * 64; i++)
+	{
+		const uint32_t random = ((uint32_t)i * 2654435761u + (uint32_t)seed) >> 7;
+
+		tiles[i].index = random % 5 == 0 ? 0 : (uint16_t)(1 + random % 32);
+		if (random % 11 == 0)
+			tiles[i].flags |= FLAG_FLIPX;
+	}
+
+	tilemap = TLN_CreateTilemap(64, 64, tiles, 0, tileset);
+	free(tiles);
+	return tilemap;
+}
+
+/* Creates a spriteset of four 32x32 discs. */
+static TLN_Spriteset CreateSpriteset(void)
+{
+	TLN_Bitmap bitmap = TLN_CreateBitmap(32 * 4, 32, 8);
+	TLN_SpriteData data[4];
+	int x, y, i;
+
+	TLN_SetBitmapPalette(bitmap, palette);
+	for (y = 0; y < 32; y++)
+	{
+		for (x = 0; x < 32 * 4; x++)
+		{
+			const int dx = x % 32 - 16;
+			const int dy = y - 16;
+
+			*TLN_GetBitmapPtr(bitmap, x, y) = dx * dx + dy * dy < 200 ? (uint8_t)(1 + (x / 32) * 60 + y) : 0;
+		}
+	}
+
+	for (i = 0; i < 4; i++)
+	{
+		snprintf(data[i].name, sizeof(data[i].name), "disc%d", i);
+		data[i].x = i * 32;
+		data[i].y = 0;
+		data[i].w = 32;
+		data[i].h = 32;
+	}
+	return TLN_CreateSpriteset(bitmap, data, 4);
+}
+
+/* Creates a context and its scene, the first one gets mosaic and the second a raster table. */
+static void CreateScene(BenchContext* context, int seed)
+{
+	TLN_Spriteset spriteset;
+	int i;
+
+	context->seed = seed;
+	context->framebuffer = (uint32_t*)calloc(BENCH_WIDTH * BENCH_HEIGHT, sizeof(uint32_t));
+	context->engine = TLN_Init(BENCH_WIDTH, BENCH_HEIGHT, 2, BENCH_SPRITES, 0);
+	TLN_SetThreadContext(context->engine);
+	TLN_SetLogLevel(TLN_LOG_NONE);
+	TLN_SetRenderTarget((uint8_t*)context->framebuffer, BENCH_WIDTH * sizeof(uint32_t));
+
+	TLN_SetLayerTilemap(0, CreateTilemap(seed * 2));
+	TLN_SetLayerTilemap(1, CreateTilemap(seed * 2 + 1));
+	TLN_SetCustomBlendFunction(seed == 0 ? BlendLighten : BlendInvert);
+	TLN_SetLayerBlendMode(0, BLEND_CUSTOM, 0);
+	TLN_SetBGColor((uint8_t)(seed * 40), 20, 30);
+	if (seed == 0)
+		TLN_SetLayerMosaic(1, 2, 3);
+	else
+		TLN_SetLayerRasterTable(1, table);
+
+	spriteset = CreateSpriteset();
+	for (i = 0; i < BENCH_SPRITES; i++)
+	{
+		TLN_ConfigSprite(i, spriteset, (i + seed) % 3 == 0 ? FLAG_FLIPX : 0);
+		TLN_SetSpritePicture(i, (i + seed) % 4);
+		if (i % 4 == seed)
+			TLN_SetSpriteBlendMode(i, BLEND_ADD, 0);
+	}
+
+	TLN_SetThreadContext(NULL);
+}
+
+/**************************************************************************************************
+ * Benchmark
+ *************************************************************************************************/
+
+/* Renders every frame of a context on the calling thread. */
+static void RenderFrames(BenchContext* context)
+{
+	int frame, i;
+
+	TLN_SetThreadContext(context->engine);
+	context->hash = BENCH_HASH_SEED;
+	for (frame = 0; frame < BENCH_FRAMES; frame++)
+	{
+		TLN_SetLayerPosition(0, frame * (context->seed + 2), frame);
+		for (i = 0; i < BENCH_SPRITES; i++)
+			TLN_SetSpritePosition(i, (i * 37 + frame * (context->seed + 1)) % BENCH_WIDTH, (i * 29 + frame) % BENCH_HEIGHT);
+		TLN_UpdateFrame(frame);
+		context->hash = BenchHash(context->hash, context->framebuffer, BENCH_WIDTH * BENCH_HEIGHT * sizeof(uint32_t));
+	}
+	TLN_SetThreadContext(NULL);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI RenderThread(LPVOID data)
+{
+	RenderFrames((BenchContext*)data);
+	return 0;
+}
+#else
+static void* RenderThread(void* data)
+{
+	RenderFrames((BenchContext*)data);
+	return NULL;
+}
+#endif
+
+/* Renders every context at once, one thread each. Returns the milliseconds per frame. */
+static double RenderConcurrent(void)
+{
+	double start = BenchTime();
+	int c;
+#ifdef _WIN32
+	HANDLE threads[BENCH_CONTEXTS];
+
+	for (c = 0; c < BENCH_CONTEXTS; c++)
+		threads[c] = CreateThread(NULL, 0, RenderThread, &contexts[c], 0, NULL);
+	WaitForMultipleObjects(BENCH_CONTEXTS, threads, TRUE, INFINITE);
+	for (c = 0; c < BENCH_CONTEXTS; c++)
+		CloseHandle(threads[c]);
+#else
+	pthread_t threads[BENCH_CONTEXTS];
+
+	for (c = 0; c < BENCH_CONTEXTS; c++)
+		pthread_create(&threads[c], NULL, RenderThread, &contexts[c]);
+	for (c = 0; c < BENCH_CONTEXTS; c++)
+		pthread_join(threads[c], NULL);
+#endif
+	return (BenchTime() - start) / BENCH_FRAMES;
+}
+
+/* Reports the hashes of the last pass against the single context ones. */
+static int ReportPass(const char* name, double ms)
+{
+	char label[32];
+	int failed = 0;
+	int c;
+
+	for (c = 0; c < BENCH_CONTEXTS; c++)
+	{
+		snprintf(label, sizeof(label), "%s, context %d", name, c);
+		failed |= BenchReport(label, ms, contexts[c].hash, contexts[c].reference);
+	}
+	return failed;
+}
+
+int main(int argc, char* argv[])
+{
+	double start, ms;
+	int failed;
+	int c, y;
+
+	palette = TLN_CreatePalette(256);
+	for (c = 0; c < 256; c++)
+		TLN_SetPaletteColor(palette, c, (uint8_t)c, (uint8_t)(c * 3), (uint8_t)(c * 7));
+	for (y = 0; y < BENCH_HEIGHT; y++)
+		table[y].dx = (int16_t)(y % 16);
+
+	for (c = 0; c < BENCH_CONTEXTS; c++)
+		CreateScene(&contexts[c], c);
+
+	printf("concurrent contexts, %d contexts, %dx%d, %d frames\n", BENCH_CONTEXTS, BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES);
+
+	start = BenchTime();
+	for (c = 0; c < BENCH_CONTEXTS; c++)
+	{
+		RenderFrames(&contexts[c]);
+		contexts[c].reference = contexts[c].hash;
+	}
+	ms = (BenchTime() - start) / BENCH_FRAMES;
+	failed = ReportPass("alone", ms);
+
+	ms = RenderConcurrent();
+	failed |= ReportPass("concurrent", ms);
+
+	for (c = 0; c < BENCH_CONTEXTS; c++)
+	{
+		TLN_SetThreadContext(contexts[c].engine);
+		TLN_SetRenderThreads(BENCH_THREADS);
+	}
+	TLN_SetThreadContext(NULL);
+	ms = RenderConcurrent();
+	failed |= ReportPass("threaded", ms);
+
+	/* scene objects share the palette, they go away with the process */
+	for (c = 0; c < BENCH_CONTEXTS; c++)
+	{
+		TLN_DeleteContext(contexts[c].engine);
+		free(contexts[c].framebuffer);
+	}
+	return failed;
+}
@@ -0,0 +1,231 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/* Input dispatch micro-benchmark. Eight players with the keyboard enabled receive a fixed stream
+ * of key and button events, the way the window driver fans them out. The reverse lookups in
+ * InputDriver.c are timed against the former linear scan of the input maps, and both must leave
+ * every player with the same inputs. */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include "Bench.h"
+#include "MainEngine.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+#define EVENT_COUNT		1000000	/* Number of events dispatched per pass. */
+#define EVENT_PASSES	5		/* Passes per path, the fastest one is reported. */
+
+/**************************************************************************************************
+ * Benchmark Context
+ *************************************************************************************************/
+
+MainEngine* legacy_machine = NULL;
+
+static MainEngine bench_engine;
+static InputDriver bench_input;
+static JoypadDriver bench_joypad;
+
+typedef struct BenchEvent
+{
+	uint32_t code;		/* Keycode or button. */
+	uint8_t button;		/* Joypad button event instead of a key event. */
+	uint8_t state;		/* 1 pressed, 0 released. */
+}
+BenchEvent;
+
+static BenchEvent events[EVENT_COUNT];
+
+/**************************************************************************************************
+ * Dispatch Paths
+ *************************************************************************************************/
+
+/* Former keyboard dispatch, scans the key map for every event. */
+static void ScanKeycodeInput(LMC_Player player, uint32_t keycode, uint8_t state)
+{
+	JoypadInputState* joypad_state = &legacy_machine->input->joypad->state[player];
+	LMC_Input input = LMC_INPUT_NONE;
+	int i;
+
+	for (i = LMC_INPUT_B; i < MAX_INPUTS && input == LMC_INPUT_NONE; i++)
+	{
+		if (joypad_state->key_map[i] == keycode)
+			input = (LMC_Input)i;
+	}
+
+	if (input != LMC_INPUT_NONE)
+	{
+		if (state)
+			SetInput(player, input);
+		else
+			ClearInput(player, input);
+	}
+}
+
+/* Former joypad button dispatch, scans the button map for every event. */
+static void ScanButtonInput(LMC_Player player, uint8_t button, uint8_t state)
+{
+	JoypadInputState* joypad_state = &legacy_machine->input->joypad->state[player];
+	LMC_Input input = LMC_INPUT_NONE;
+	int i;
+
+	for (i = LMC_INPUT_B; i < MAX_INPUTS && input == LMC_INPUT_NONE; i++)
+	{
+		if (joypad_state->button_map[i] == button)
+			input = (LMC_Input)i;
+	}
+
+	if (input != LMC_INPUT_NONE)
+	{
+		if (state)
+			SetInput(player, input);
+		else
+			ClearInput(player, input);
+	}
+}
+
+/* Keyboard dispatch through the keycode hash table. */
+static void LookupKeycodeInput(LMC_Player player, uint32_t keycode, uint8_t state)
+{
+	LMC_Input input = GetKeyInput(player, keycode);
+
+	if (input != LMC_INPUT_NONE)
+	{
+		if (state)
+			SetInput(player, input);
+		else
+			ClearInput(player, input);
+	}
+}
+
+/* Joypad button dispatch through the button array. */
+static void LookupButtonInput(LMC_Player player, uint8_t button, uint8_t state)
+{
+	LMC_Input input = (LMC_Input)legacy_machine->input->joypad->state[player].button_lookup[button];
+
+	if (input != LMC_INPUT_NONE)
+	{
+		if (state)
+			SetInput(player, input);
+		else
+			ClearInput(player, input);
+	}
+}
+
+/**************************************************************************************************
+ * Benchmark
+ *************************************************************************************************/
+
+/* Maps a distinct key and button to the first inputs of every player. */
+static void SetupPlayers(void)
+{
+	int player, i;
+
+	for (player = LMC_PLAYER1; player < MAX_PLAYERS; player++)
+	{
+		JoypadInputState* joypad_state = &bench_joypad.state[player];
+
+		joypad_state->keyboard_enabled = true;
+		joypad_state->connected = true;
+		for (i = LMC_INPUT_B; i <= 16; i++)
+		{
+			joypad_state->key_map[i] = (uint32_t)('a' + player * 16 + i);
+			joypad_state->button_map[i] = (uint8_t)(i - 1);
+		}
+		UpdateInputLookups((LMC_Player)player);
+	}
+}
+
+/* Builds a fixed mix of mapped keys, unmapped keys and joypad buttons. */
+static void SetupEvents(void)
+{
+	uint32_t seed = 1;
+	int i;
+
+	for (i = 0; i < EVENT_COUNT; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		events[i].button = (seed >> 8) % 4 == 0;
+		events[i].code = events[i].button ? (seed >> 12) % 24 : 'a' + (seed >> 12) % 160;
+		events[i].state = (seed >> 20) & 1;
+	}
+}
+
+/* Dispatches every event to all players and returns the fastest pass in milliseconds. */
+static double RunEvents(bool lookup, uint32_t* hash)
+{
+	double best = 0.0;
+	int pass, i, player;
+
+	for (pass = 0; pass < EVENT_PASSES; pass++)
+	{
+		double start;
+
+		for (player = LMC_PLAYER1; player < MAX_PLAYERS; player++)
+			bench_joypad.state[player].inputs = 0;
+
+		*hash = BENCH_HASH_SEED;
+		start = BenchTime();
+		for (i = 0; i < EVENT_COUNT; i++)
+		{
+			const BenchEvent* event = &events[i];
+
+			for (player = LMC_PLAYER1; player < MAX_PLAYERS; player++)
+			{
+				if (event->button && lookup)
+					LookupButtonInput((LMC_Player)player, (uint8_t)event->code, event->state);
+				else if (event->button)
+					ScanButtonInput((LMC_Player)player, (uint8_t)event->code, event->state);
+				else if (lookup)
+					LookupKeycodeInput((LMC_Player)player, event->code, event->state);
+				else
+					ScanKeycodeInput((LMC_Player)player, event->code, event->state);
+			}
+			if ((i & 1023) == 0)
+			{
+				for (player = LMC_PLAYER1; player < MAX_PLAYERS; player++)
+					*hash = BenchHash(*hash, &bench_joypad.state[player].inputs, sizeof(uint32_t));
+			}
+		}
+		start = BenchTime() - start;
+		if (pass == 0 || start < best)
+			best = start;
+	}
+
+	return best;
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t scan_hash, lookup_hash;
+	double scan_ms, lookup_ms;
+
+	bench_engine.input = &bench_input;
+	bench_input.joypad = &bench_joypad;
+	legacy_machine = &bench_engine;
+
+	SetupPlayers();
+	SetupEvents();
+
+	printf("input dispatch, %d players, %d events\n", MAX_PLAYERS, EVENT_COUNT);
+	scan_ms = RunEvents(false, &scan_hash);
+	lookup_ms = RunEvents(true, &lookup_hash);
+	BenchReport("linear scan", scan_ms, scan_hash, 0);
+	BenchReport("reverse lookup", lookup_ms, lookup_hash, scan_hash);
+	printf("%.1f ns per event before, %.1f ns after\n",
+		scan_ms * 1e6 / EVENT_COUNT, lookup_ms * 1e6 / EVENT_COUNT);
+
+	return lookup_hash != scan_hash;
+}
@@ -0,0 +1,228 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/* Raster table benchmark and regression. A blended tiled layer gets a per line scroll, clip,
+ * blend factor and palette over a static background layer. The effects are first applied from
+ * a raster callback, then from the same values given as a layer raster table, drawn on the
+ * calling thread, on render threads and with dirty tracking. Every table pass must produce the
+ * frames of the callback pass. Then the layer gets mosaic, whose blocks take the entry of their
+ * first line, and dirty tracking must produce the frames drawn without it. */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include "Bench.h"
+#include "Tilengine.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+#define BENCH_WIDTH		640		/* Framebuffer width. */
+#define BENCH_HEIGHT	480		/* Framebuffer height. */
+#define BENCH_FRAMES	200		/* Frames rendered per pass. */
+#define BENCH_WARMUP	10		/* Frames rendered before timing starts. */
+#define BENCH_UPDATE	5		/* Frames between raster table updates. */
+#define BENCH_THREADS	4		/* Render threads of the threaded pass. */
+#define BENCH_HSTART	8		/* Effect layer position the raster offsets are added to. */
+#define BENCH_VSTART	4
+#define BENCH_MOSAIC_W	4		/* Mosaic of the effect layer in the mosaic passes. */
+#define BENCH_MOSAIC_H	6
+
+/**************************************************************************************************
+ * Benchmark Context
+ *************************************************************************************************/
+
+static uint32_t framebuffer[BENCH_WIDTH * BENCH_HEIGHT];
+static TLN_RasterLine table[BENCH_HEIGHT];
+static TLN_Palette palettes[2];
+
+/**************************************************************************************************
+ * Scene Setup
+ *************************************************************************************************/
+
+/* Creates a 64x64 tilemap of 16x16 tiles, every fifth tile empty. */
+static TLN_Tilemap CreateTilemap(int seed)
+{
+	TLN_Tileset tileset = TLN_CreateTileset(33, 16, 16, palettes[0], NULL, NULL);
+	TLN_Tilemap tilemap;
+	TLN_Tile tiles;
+	uint8_t pixels[16 * 16];
+	int t, i;
+
+	for (t = 1; t < 33; t++)
+	{
+		for (i = 0; i < 16 * 16; i++)
+		{
+			const int value = (i * 7 + t * 13 + seed) % 40;
+			pixels[i] = value < 8 ? 0 : (uint8_t)(1 + (value + t) % 254);
+		}
+		TLN_SetTilesetPixels(tileset, t, pixels, 16);
+	}
+
+	tiles = (TLN_Tile)calloc(64 * 64, sizeof(*tiles));
+	for (i = 0; i < 64 * 64; i++)
+	{
+		const uint32_t random = ((uint32_t)i * 2654435761u + (uint32_t)seed) >> 7;
+
+		tiles[i].index = random % 5 == 0 ? 0 : (uint16_t)(1 + random % 32);
+		if (random % 11 == 0)
+			tiles[i].flags |= FLAG_FLIPX;
+	}
+
+	tilemap = TLN_CreateTilemap(64, 64, tiles, 0, tileset);
+	free(tiles);
+	return tilemap;
+}
+
+/* Sets up the palettes, the effect layer and the background layer. */
+static void CreateScene(void)
+{
+	int i;
+
+	palettes[0] = TLN_CreatePalette(256);
+	for (i = 0; i < 256; i++)
+		TLN_SetPaletteColor(palettes[0], i, (uint8_t)i, (uint8_t)(i * 3), (uint8_t)(i * 7));
+	palettes[1] = TLN_ClonePalette(palettes[0]);
+	TLN_AddPaletteColor(palettes[1], 60, 0, 90, 1, 255);
+
+	TLN_SetLayerTilemap(0, CreateTilemap(0));
+	TLN_SetLayerTilemap(1, CreateTilemap(1));
+	TLN_SetBGColor(10, 20, 30);
+}
+
+/* Fills the raster table for a frame: a wavy scroll, clipped bands, a blended band and a
+ * palette swap at the bottom. */
+static void FillTable(int frame)
+{
+	int y;
+
+	for (y = 0; y < BENCH_HEIGHT; y++)
+	{
+		const int wave = (y + frame) % 48;
+		TLN_RasterLine* line = &table[y];
+
+		line->dx = (int16_t)(wave < 24 ? wave - 12 : 36 - wave);
+		line->dy = (int16_t)(-(y / 80) * 3);
+		line->x1 = y % 100 < 20 ? (int16_t)(40 + y % 7) : 0;
+		line->x2 = y % 100 < 20 ? (int16_t)(600 - y % 5) : 0;
+		line->blend = y > 200 && y < 320 ? (uint8_t)(1 + (y + frame) % 255) : 0;
+		line->palette = y > 400 ? palettes[1] : NULL;
+	}
+}
+
+/* Fills the raster table for a frame with entries on the first line of each mosaic block only,
+ * editing one must redraw the whole block. */
+static void FillMosaicTable(int frame)
+{
+	int y;
+
+	FillTable(frame);
+	for (y = 0; y < BENCH_HEIGHT; y++)
+	{
+		if (y % BENCH_MOSAIC_H != 0)
+			memset(&table[y], 0, sizeof(table[y]));
+	}
+}
+
+/* Resets the effect layer to the state the raster offsets are relative to. */
+static void ResetLayer(void)
+{
+	TLN_SetLayerPosition(0, BENCH_HSTART, BENCH_VSTART);
+	TLN_DisableLayerClip(0);
+	TLN_SetLayerBlendMode(0, BLEND_MIX50, 0);
+	TLN_SetLayerPalette(0, palettes[0]);
+}
+
+/* Applies a table line the way the renderer applies raster tables. */
+static void RasterCallback(int line)
+{
+	const TLN_RasterLine* raster = &table[line];
+
+	TLN_SetLayerPosition(0, BENCH_HSTART + raster->dx, BENCH_VSTART + raster->dy);
+	if (raster->x1 != 0 || raster->x2 != 0)
+		TLN_SetLayerClip(0, raster->x1, 0, raster->x2, BENCH_HEIGHT);
+	else
+		TLN_DisableLayerClip(0);
+	TLN_SetLayerBlendMode(0, BLEND_MIX50, raster->blend);
+	TLN_SetLayerPalette(0, raster->palette != NULL ? raster->palette : palettes[0]);
+}
+
+/**************************************************************************************************
+ * Benchmark
+ *************************************************************************************************/
+
+/* Renders every frame of a pass, returns the milliseconds per frame after the warm up frames. */
+static double RenderFrames(void (*fill)(int frame), uint32_t* hash)
+{
+	double start = 0.0;
+	int frame;
+
+	ResetLayer();
+	*hash = BENCH_HASH_SEED;
+	for (frame = 0; frame < BENCH_FRAMES; frame++)
+	{
+		if (frame % BENCH_UPDATE == 0)
+			fill(frame);
+
+		if (frame == BENCH_WARMUP)
+			start = BenchTime();
+		TLN_UpdateFrame(frame);
+
+		*hash = BenchHash(*hash, framebuffer, sizeof(framebuffer));
+	}
+
+	return (BenchTime() - start) / (BENCH_FRAMES - BENCH_WARMUP);
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t callback_hash, mosaic_hash, hash;
+	double ms;
+	int failed;
+
+	TLN_Init(BENCH_WIDTH, BENCH_HEIGHT, 2, 0, 0);
+	TLN_SetLogLevel(TLN_LOG_NONE);
+	TLN_SetRenderTarget((uint8_t*)framebuffer, BENCH_WIDTH * sizeof(uint32_t));
+	CreateScene();
+
+	printf("raster effects, %dx%d, %d frames\n", BENCH_WIDTH, BENCH_HEIGHT, BENCH_FRAMES);
+
+	TLN_SetRasterCallback(RasterCallback);
+	ms = RenderFrames(FillTable, &callback_hash);
+	BenchReport("raster callback", ms, callback_hash, 0);
+	TLN_SetRasterCallback(NULL);
+
+	TLN_SetLayerRasterTable(0, table);
+	ms = RenderFrames(FillTable, &hash);
+	failed = BenchReport("raster table", ms, hash, callback_hash);
+
+	TLN_SetRenderThreads(BENCH_THREADS);
+	ms = RenderFrames(FillTable, &hash);
+	failed |= BenchReport("raster table, 4 threads", ms, hash, callback_hash);
+
+	TLN_EnableDirtyTracking(true);
+	ms = RenderFrames(FillTable, &hash);
+	failed |= BenchReport("raster table, dirty", ms, hash, callback_hash);
+
+	TLN_EnableDirtyTracking(false);
+	TLN_SetLayerMosaic(0, BENCH_MOSAIC_W, BENCH_MOSAIC_H);
+	ms = RenderFrames(FillMosaicTable, &mosaic_hash);
+	BenchReport("raster table, mosaic", ms, mosaic_hash, 0);
+
+	TLN_EnableDirtyTracking(true);
+	ms = RenderFrames(FillMosaicTable, &hash);
+	failed |= BenchReport("mosaic, dirty", ms, hash, mosaic_hash);
+
+	TLN_Deinit();
+	return failed;
+}
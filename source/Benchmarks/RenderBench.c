@@ -0,0 +1,201 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/* Frame rendering benchmark. A 640x480 scene with four scrolling tiled layers, one blended and
+ * one with mosaic, and 64 sprites with flips, priority, scaling, blending and collisions is
+ * rendered on the calling thread and on render threads. Both must produce the reference frames
+ * and sprite collisions. */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include "Bench.h"
+#include "Tilengine.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+#define BENCH_WIDTH		640			/* Framebuffer width. */
+#define BENCH_HEIGHT	480			/* Framebuffer height. */
+#define BENCH_LAYERS	4			/* Tiled layers. */
+#define BENCH_SPRITES	64			/* Sprites. */
+#define BENCH_FRAMES	200			/* Frames rendered per pass. */
+#define BENCH_WARMUP	10			/* Frames rendered before timing starts. */
+#define BENCH_THREADS	4			/* Render threads of the threaded pass. */
+#define BENCH_REFERENCE	0xc764ba8bu	/* Hash of every frame and collision of a pass. */
+
+/**************************************************************************************************
+ * Benchmark Context
+ *************************************************************************************************/
+
+static uint32_t framebuffer[BENCH_WIDTH * BENCH_HEIGHT];
+static TLN_Palette palette;
+
+/**************************************************************************************************
+ * Scene Setup
+ *************************************************************************************************/
+
+/* Creates a 64x64 tilemap of 16x16 tiles, with flips and some priority tiles on layer 2. */
+static TLN_Tilemap CreateTilemap(int seed)
+{
+	TLN_Tileset tileset = TLN_CreateTileset(33, 16, 16, palette, NULL, NULL);
+	TLN_Tilemap tilemap;
+	TLN_Tile tiles;
+	uint8_t pixels[16 * 16];
+	int t, i;
+
+	for (t = 1; t < 33; t++)
+	{
+		for (i = 0; i < 16 * 16; i++)
+		{
+			const int value = (i * 7 + t * 13 + seed) % 40;
+			pixels[i] = value < 8 ? 0 : (uint8_t)(1 + (value + t) % 254);
+		}
+		TLN_SetTilesetPixels(tileset, t, pixels, 16);
+	}
+
+	tiles = (TLN_Tile)calloc(64 * 64, sizeof(*tiles));
+	for (i = 0; i < 64 * 64; i++)
+	{
+		const uint32_t random = ((uint32_t)i * 2654435761u + (uint32_t)seed) >> 7;
+
+		tiles[i].index = random % 5 == 0 ? 0 : (uint16_t)(1 + random % 32);
+		if (random % 11 == 0)
+			tiles[i].flags |= FLAG_FLIPX;
+		if (random % 13 == 0)
+			tiles[i].flags |= FLAG_FLIPY;
+		if (seed == 2 && random % 17 == 0)
+			tiles[i].flags |= FLAG_PRIORITY;
+	}
+
+	tilemap = TLN_CreateTilemap(64, 64, tiles, 0, tileset);
+	free(tiles);
+	return tilemap;
+}
+
+/* Creates a spriteset of eight 32x32 discs. */
+static TLN_Spriteset CreateSpriteset(void)
+{
+	TLN_Bitmap bitmap = TLN_CreateBitmap(32 * 8, 32, 8);
+	TLN_SpriteData data[8];
+	int x, y, i;
+
+	TLN_SetBitmapPalette(bitmap, palette);
+	for (y = 0; y < 32; y++)
+	{
+		for (x = 0; x < 32 * 8; x++)
+		{
+			const int dx = x % 32 - 16;
+			const int dy = y - 16;
+
+			*TLN_GetBitmapPtr(bitmap, x, y) = dx * dx + dy * dy < 200 ? (uint8_t)(1 + (x / 32) * 30 + y) : 0;
+		}
+	}
+
+	for (i = 0; i < 8; i++)
+	{
+		snprintf(data[i].name, sizeof(data[i].name), "disc%d", i);
+		data[i].x = i * 32;
+		data[i].y = 0;
+		data[i].w = 32;
+		data[i].h = 32;
+	}
+	return TLN_CreateSpriteset(bitmap, data, 8);
+}
+
+/* Sets up layers and sprites. */
+static void CreateScene(void)
+{
+	TLN_Spriteset spriteset;
+	int i;
+
+	palette = TLN_CreatePalette(256);
+	for (i = 0; i < 256; i++)
+		TLN_SetPaletteColor(palette, i, (uint8_t)i, (uint8_t)(i * 3), (uint8_t)(i * 7));
+
+	for (i = 0; i < BENCH_LAYERS; i++)
+		TLN_SetLayerTilemap(i, CreateTilemap(i));
+	TLN_SetLayerBlendMode(1, BLEND_MIX50, 0);
+	TLN_SetLayerMosaic(3, 4, 6);
+
+	spriteset = CreateSpriteset();
+	for (i = 0; i < BENCH_SPRITES; i++)
+	{
+		TLN_ConfigSprite(i, spriteset, i % 7 == 0 ? FLAG_PRIORITY : (i % 5 == 0 ? FLAG_FLIPX : 0));
+		TLN_SetSpritePicture(i, i % 8);
+		if (i % 3 == 0)
+			TLN_EnableSpriteCollision(i, true);
+		if (i % 9 == 0)
+			TLN_SetSpriteScaling(i, 1.5f, 1.25f);
+		if (i % 10 == 0)
+			TLN_SetSpriteBlendMode(i, BLEND_ADD, 0);
+	}
+}
+
+/**************************************************************************************************
+ * Benchmark
+ *************************************************************************************************/
+
+/* Renders every frame of a pass, returns the milliseconds per frame after the warm up frames. */
+static double RenderFrames(uint32_t* hash)
+{
+	double start = 0.0;
+	int frame, i;
+
+	*hash = BENCH_HASH_SEED;
+	for (frame = 0; frame < BENCH_FRAMES; frame++)
+	{
+		for (i = 0; i < BENCH_LAYERS; i++)
+			TLN_SetLayerPosition(i, frame * (i + 1), frame * i / 2);
+		for (i = 0; i < BENCH_SPRITES; i++)
+			TLN_SetSpritePosition(i, 100 + (i * 5 + frame) % 200, (i * 9 + frame) % 460);
+
+		if (frame == BENCH_WARMUP)
+			start = BenchTime();
+		TLN_UpdateFrame(frame);
+
+		*hash = BenchHash(*hash, framebuffer, sizeof(framebuffer));
+		for (i = 0; i < BENCH_SPRITES; i++)
+		{
+			const uint8_t collision = TLN_GetSpriteCollision(i);
+			*hash = BenchHash(*hash, &collision, sizeof(collision));
+		}
+	}
+
+	return (BenchTime() - start) / (BENCH_FRAMES - BENCH_WARMUP);
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t serial_hash, threaded_hash;
+	double serial_ms, threaded_ms;
+	int failed;
+
+	TLN_Init(BENCH_WIDTH, BENCH_HEIGHT, BENCH_LAYERS, BENCH_SPRITES, 0);
+	TLN_SetLogLevel(TLN_LOG_NONE);
+	TLN_SetRenderTarget((uint8_t*)framebuffer, BENCH_WIDTH * sizeof(uint32_t));
+	CreateScene();
+
+	printf("frame rendering, %dx%d, %d layers, %d sprites, %d frames\n",
+		BENCH_WIDTH, BENCH_HEIGHT, BENCH_LAYERS, BENCH_SPRITES, BENCH_FRAMES);
+
+	serial_ms = RenderFrames(&serial_hash);
+	failed = BenchReport("1 thread", serial_ms, serial_hash, BENCH_REFERENCE);
+
+	TLN_SetRenderThreads(BENCH_THREADS);
+	threaded_ms = RenderFrames(&threaded_hash);
+	failed |= BenchReport("4 threads", threaded_ms, threaded_hash, BENCH_REFERENCE);
+
+	TLN_Deinit();
+	return failed;
+}
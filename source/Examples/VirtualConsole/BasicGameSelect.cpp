@@ -45,6 +45,7 @@ BasicGameSelect::BasicGameSelect(int optionsPerPage, int rowPosition, int column
 	m_rowPosition = rowPosition;
 	m_columnPosition = columnPosition;
 	m_lastInput = LMC_INPUT_NONE;
+	m_prefetchedOption = -1;
 }
 
 BasicGameSelect::~BasicGameSelect(void)
@@ -264,6 +265,15 @@ void BasicGameSelect::UpdateActiveOption(void)
 		!LMC_GetInput(LMC_INPUT_RIGHT))
 		m_lastInput = LMC_INPUT_NONE;
 
+	// Prefetch the highlighted game, it starts once the selection rests and is cancelled
+	// when the selection moves on.
+	if (m_activeMenuOption != m_prefetchedOption && m_totalMenuOptions > 0)
+	{
+		LMC_PrefetchContent(m_games[m_activeMenuOption]->GetCorePath().c_str(),
+			m_games[m_activeMenuOption]->GetContentPath().c_str());
+		m_prefetchedOption = m_activeMenuOption;
+	}
+
 	if (LMC_GetInput(LMC_INPUT_START))
 	{
 		m_gameRunning = true;
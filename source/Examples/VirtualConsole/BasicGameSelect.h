@@ -53,6 +53,7 @@ private:
 	int m_rowPosition;
 	int m_columnPosition;
 	int m_lastInput;
+	int m_prefetchedOption;
 	bool m_gameRunning;
 
 public:
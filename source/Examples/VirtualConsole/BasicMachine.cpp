@@ -52,6 +52,9 @@ bool BasicMachine::Initialize(int cwfFlag)
 		return false;
 	}
 
+	// Keep cores loaded when a game closes, so switching games only swaps the content.
+	LMC_SetCoreCacheSize(CONSOLE_CORE_CACHE_SIZE);
+
 	m_systemState = Startup;
 
 	m_currentFrame = 0;
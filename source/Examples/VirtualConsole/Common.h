@@ -29,6 +29,7 @@
 #define CONSOLE_MAX_SPRITES 64			// Console's maximum number of sprites.
 #define CONSOLE_MAX_NAME_LENGTH 26		// Console's maximum length of a game's name in selection list.
 #define CONSOLE_BOOT_FRAME_TIME 256		// Console's splash screen display time in frames.
+#define CONSOLE_CORE_CACHE_SIZE 2		// Console cores kept loaded between games, the game list may use several.
 
 //-------------------------------------------------------------------------------------------------
 // Enumerations
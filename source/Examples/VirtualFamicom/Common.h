@@ -31,6 +31,8 @@
 #define FC_MAX_TILE_COLORS 4		// Famicom's maximum number of colors per tile.
 #define FC_MAX_NAME_LENGTH 22		// Famicom's maximum length of a game's name in selection list.
 #define FC_BOOT_FRAME_TIME 256		// Famicom's splash screen display time in frames.
+#define FC_CONTENT_EXTENSIONS "nes|fds|unf|unif|zip"	// Famicom content scanned into the library.
+#define FC_CORE_CACHE_SIZE 1		// Famicom cores kept loaded between games, every game runs on the same one.
 
 //-------------------------------------------------------------------------------------------------
 // Enumerations
@@ -19,6 +19,7 @@
 //-------------------------------------------------------------------------------------------------
 // Includes
 //-------------------------------------------------------------------------------------------------
+#include <cctype>
 #include <cstring>
 #include <sstream>
 
@@ -45,6 +46,8 @@ FamicomGameSelect::FamicomGameSelect(int optionsPerPage, int rowPosition, int co
 	m_rowPosition = rowPosition;
 	m_columnPosition = columnPosition;
 	m_lastInput = LMC_INPUT_NONE;
+	m_prefetchedOption = -1;
+	m_libraryScanning = false;
 
 	m_zapperIcon = new FamicomGameIcon(1, 123, 1, 1, 1);
 	m_zapperIconSelected = new FamicomGameIcon(475, 123, 1, 1, 1);
@@ -65,6 +68,9 @@ FamicomGameSelect::~FamicomGameSelect(void)
 // Initialize game list from lines in provided csv file located in the 
 // settings folder. Format should be: Display Name, LibRetro Core File, 
 // LibRetro Content File, Number of Players supported by content.
+// Games are listed from the content library when there is one, the csv file then
+// provides the details of the content it lists and its first core is used for the rest.
+// The content directory is rescanned in the background and the list rebuilt after.
 bool FamicomGameSelect::IntializeGameList(const char* fileName)
 {
 	string filePath = string(LMC_GetPath(LMC_SETTING_PATH)) + "/" + fileName;
@@ -77,17 +83,11 @@ bool FamicomGameSelect::IntializeGameList(const char* fileName)
 	}
 
 	string line;
-	int displayNumber = 1;
-	int tileRow = m_rowPosition;
-	int tileColumn = m_columnPosition;
-	int maxRow = m_rowPosition + m_optionsPerPage - 1;
 
 	while (getline(gameListFile, line))
 	{
 		istringstream stringStream(line);
 
-		string displayText;
-		string displayTemp;
 		string subString;
 		vector<string> subStrings;
 
@@ -96,48 +96,130 @@ bool FamicomGameSelect::IntializeGameList(const char* fileName)
 			subStrings.push_back(subString);
 		}
 
-		if (tileRow > maxRow)
-			tileRow = m_rowPosition;
+		if (subStrings.size() < 4)
+			continue;
 
-		if (displayNumber < 10)
-			displayText = " " + to_string(displayNumber) + "_ " + subStrings[0];
-		else
-			displayText = to_string(displayNumber) + "_ " + subStrings[0];
+		m_gameInfo.push_back({ subStrings[0], subStrings[1], subStrings[2], stoi(subStrings[3]) });
+	}
+
+	while (m_clearLine.length() < FC_MAX_NAME_LENGTH + 3)
+	{
+		m_clearLine += " ";
+	}
+
+	LMC_LoadLibrary();
+	BuildGameList();
+
+	m_libraryScanning = LMC_ScanLibrary(FC_CONTENT_EXTENSIONS, NULL);
+
+	return true;
+}
+
+// Finds the csv file details of a content file.
+const FamicomGameSelect::GameInfo* FamicomGameSelect::FindGameInfo(const string& content)
+{
+	for (unsigned int i = 0; i < m_gameInfo.size(); i++)
+	{
+		if (m_gameInfo[i].content == content)
+			return &m_gameInfo[i];
+	}
+
+	return NULL;
+}
+
+// Adds a game to the end of the list, numbered and padded for display.
+void FamicomGameSelect::AddGame(const string& name, const string& core, const string& content, int players)
+{
+	int displayNumber = m_games.size() + 1;
+	int tileRow = m_rowPosition + m_games.size() % m_optionsPerPage;
+	int tileColumn = m_columnPosition;
+	string displayText;
+	string displayTemp;
+
+	if (displayNumber < 10)
+		displayText = " " + to_string(displayNumber) + "_ " + name;
+	else
+		displayText = to_string(displayNumber) + "_ " + name;
 
-		if (displayText.length() < FC_MAX_NAME_LENGTH)
+	if (displayText.length() < FC_MAX_NAME_LENGTH)
+	{
+		int nameLength = displayText.length();
+
+		if (nameLength == (FC_MAX_NAME_LENGTH - 1))
+			displayText += "_";
+		else
 		{
-			int nameLength = displayText.length();
+			displayText += " ";
+			nameLength++;
 
-			if (nameLength == (FC_MAX_NAME_LENGTH - 1))
-				displayText += "_";
-			else
+			while (nameLength < FC_MAX_NAME_LENGTH)
 			{
-				displayText += " ";
+				displayText += "_";
 				nameLength++;
-
-				while (nameLength < FC_MAX_NAME_LENGTH)
-				{
-					displayText += "_";
-					nameLength++;
-				}
 			}
 		}
+	}
 
-		if (displayText.length() > FC_MAX_NAME_LENGTH)
-		{
-			displayTemp = displayText;
-			displayText = displayTemp.substr(0, FC_MAX_NAME_LENGTH);
-		}
+	if (displayText.length() > FC_MAX_NAME_LENGTH)
+	{
+		displayTemp = displayText;
+		displayText = displayTemp.substr(0, FC_MAX_NAME_LENGTH);
+	}
 
-		m_games.push_back(new ContentOption(displayText, subStrings[1], subStrings[2], stoi(subStrings[3]), tileRow, tileColumn));
+	m_games.push_back(new ContentOption(displayText, core, content, players, tileRow, tileColumn));
+}
+
+// Builds the game list from the content library, or from the csv file without one.
+void FamicomGameSelect::BuildGameList(void)
+{
+	int entryCount = LMC_GetLibraryEntryCount();
 
-		displayNumber++;
-		tileRow++;
+	for (unsigned int i = 0; i < m_games.size(); i++)
+	{
+		delete m_games[i];
 	}
+	m_games.clear();
 
-	while (m_clearLine.length() < FC_MAX_NAME_LENGTH + 3)
+	if (entryCount == 0 || m_gameInfo.empty())
 	{
-		m_clearLine += " ";
+		for (unsigned int i = 0; i < m_gameInfo.size(); i++)
+		{
+			AddGame(m_gameInfo[i].name, m_gameInfo[i].core, m_gameInfo[i].content, m_gameInfo[i].players);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < entryCount; i++)
+		{
+			LMC_LibraryEntry entry;
+
+			if (!LMC_GetLibraryEntry(i, &entry))
+				continue;
+
+			string fileName = entry.path;
+			size_t separator = fileName.find_last_of("/\\");
+
+			if (separator != string::npos)
+				fileName = fileName.substr(separator + 1);
+
+			const GameInfo* gameInfo = FindGameInfo(fileName);
+
+			if (gameInfo)
+			{
+				AddGame(gameInfo->name, gameInfo->core, entry.path, gameInfo->players);
+			}
+			else
+			{
+				string name = entry.name;
+
+				for (unsigned int j = 0; j < name.length(); j++)
+				{
+					name[j] = toupper((unsigned char)name[j]);
+				}
+
+				AddGame(name, m_gameInfo[0].core, entry.path, 1);
+			}
+		}
 	}
 
 	m_totalMenuOptions = m_games.size();
@@ -199,6 +281,18 @@ void FamicomGameSelect::LoadGame(void)
 // selected game.
 void FamicomGameSelect::Update(void)
 {
+	// Rebuild the list once a library scan has replaced the content library.
+	if (m_libraryScanning && !LMC_IsLibraryScanning())
+	{
+		ClearText();
+		ClearIcon();
+		BuildGameList();
+		m_libraryScanning = false;
+		m_pageNumber = 0;
+		m_activeMenuOption = 0;
+		m_prefetchedOption = -1;
+	}
+
 	unsigned int listStart = m_pageNumber * m_optionsPerPage;
 	unsigned int listEnd = listStart + m_optionsPerPage;
 
@@ -361,6 +455,15 @@ void FamicomGameSelect::UpdateActiveOption(void)
 		!LMC_GetInput(LMC_INPUT_RIGHT))
 		m_lastInput = LMC_INPUT_NONE;
 
+	// Prefetch the highlighted game, it starts once the selection rests and is cancelled
+	// when the selection moves on.
+	if (m_activeMenuOption != m_prefetchedOption && m_totalMenuOptions > 0)
+	{
+		LMC_PrefetchContent(m_games[m_activeMenuOption]->GetCorePath().c_str(),
+			m_games[m_activeMenuOption]->GetContentPath().c_str());
+		m_prefetchedOption = m_activeMenuOption;
+	}
+
 	if (LMC_GetInput(LMC_INPUT_START))
 	{
 		m_gameRunning = true;
@@ -43,8 +43,18 @@ using std::string;
 class FamicomGameSelect : public FamicomScreen
 {
 private:
+	// Game details listed in the settings csv file.
+	struct GameInfo
+	{
+		string name;
+		string core;
+		string content;
+		int players;
+	};
+
 	// Member Variables
 
+	vector<GameInfo> m_gameInfo;
 	vector<ContentOption*> m_games;
 	string m_clearLine;
 	int m_activeMenuOption;
@@ -54,7 +64,9 @@ private:
 	int m_rowPosition;
 	int m_columnPosition;
 	int m_lastInput;
+	int m_prefetchedOption;
 	bool m_gameRunning;
+	bool m_libraryScanning;
 
 	FamicomGameIcon* m_zapperIcon;
 	FamicomGameIcon* m_zapperIconSelected;
@@ -62,6 +74,12 @@ private:
 	FamicomGameIcon* m_twoPlayerIcon;
 	FamicomGameIcon* m_clearIcon;
 
+	// Helper Methods
+
+	const GameInfo* FindGameInfo(const string& content);
+	void AddGame(const string& name, const string& core, const string& content, int players);
+	void BuildGameList(void);
+
 public:
 	// Constructor(s) / Destructor
 
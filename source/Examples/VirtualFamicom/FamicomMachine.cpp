@@ -52,6 +52,9 @@ bool FamicomMachine::Initialize(int cwfFlag)
 		return false;
 	}
 
+	// Keep the core loaded when a game closes, so switching games only swaps the content.
+	LMC_SetCoreCacheSize(FC_CORE_CACHE_SIZE);
+
 	m_systemState = Startup;
 
 	m_currentFrame = 0;
@@ -0,0 +1,610 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libchdr/chd.h>
+#include <retro_endianness.h>
+#include <retro_miscellaneous.h>
+#include <string/stdstring.h>
+#include <compat/strl.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "ChdImage.h"
+#include "Logging.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define CHD_SECTOR_SIZE		2352
+#define CHD_TRACK_PAD		4
+
+/**************************************************************************************************
+ * ChdImage Structures
+ *************************************************************************************************/
+
+typedef enum
+{
+	CHD_HUNK_EMPTY,
+	CHD_HUNK_LOADING,
+	CHD_HUNK_READY
+}
+ChdHunkState;
+
+/* Decompressed hunk held in the cache. */
+typedef struct ChdHunk
+{
+	uint8_t*		data;			/* Decompressed hunk, allocated on first use. */
+	uint32_t		number;			/* Hunk number in the image. */
+	uint32_t		last_used;		/* Cache clock at the last access. */
+	ChdHunkState	state;			/* Whether the hunk is being decompressed or ready. */
+}
+ChdHunk;
+
+/* CD track metadata, as stored by chdman. */
+typedef struct ChdTrack
+{
+	uint32_t	number;
+	uint32_t	frames;
+	uint32_t	pregap;
+	uint32_t	frame_offset;		/* First frame of the track in the image. */
+	char		type[64];
+	char		subtype[32];
+	char		pgtype[32];
+	char		pgsub[32];
+	uint32_t	postgap;
+}
+ChdTrack;
+
+/* One track of a CHD image, read through a decompressed hunk cache. */
+struct ChdImage
+{
+	chd_file*	chd;
+	ChdHunk*	hunks;				/* Hunk cache. */
+	unsigned	hunk_count;			/* Hunks the cache holds. */
+	uint32_t	hunk_bytes;			/* Size of a decompressed hunk. */
+	uint32_t	unit_bytes;			/* Size of a frame inside a hunk, subcode included. */
+	uint32_t	total_hunks;		/* Hunks in the image. */
+	uint32_t	frames_per_hunk;
+	uint32_t	frame_size;			/* Bytes of each frame the track exposes. */
+	uint32_t	track_frame;		/* First frame of the track in the image. */
+	int64_t		track_start;		/* Byte offset where track data starts, after the pregap. */
+	int64_t		track_end;			/* Byte offset where track data ends. */
+	uint32_t	clock;				/* Cache clock, ticks on every hunk access. */
+	uint32_t	last_hunk;			/* Hunk of the previous read. */
+	unsigned	sequential;			/* Consecutive hunks read in order. */
+	unsigned	prefetch;			/* Hunks to decompress ahead of sequential reads. */
+	uint32_t	prefetch_next;		/* Next hunk for the worker to decompress. */
+	uint32_t	prefetch_end;		/* Hunk after the last one to prefetch. */
+	bool		swab;				/* Audio tracks are stored byte swapped. */
+#ifdef HAVE_THREADS
+	slock_t*	lock;				/* Guards the cache and prefetch range. */
+	slock_t*	chd_lock;			/* libchdr reads aren't reentrant. */
+	scond_t*	cond;				/* Signalled when a hunk is ready or prefetching is asked for. */
+	sthread_t*	worker;				/* Prefetch thread. */
+	bool		quit;				/* Tells the prefetch thread to exit. */
+#endif
+};
+
+/**************************************************************************************************
+ * Local Locking Functions
+ *************************************************************************************************/
+
+static void LockImage(ChdImage* image)
+{
+#ifdef HAVE_THREADS
+	slock_lock(image->lock);
+#endif
+}
+
+static void UnlockImage(ChdImage* image)
+{
+#ifdef HAVE_THREADS
+	slock_unlock(image->lock);
+#endif
+}
+
+/* Waits for another thread to finish a hunk, only reachable with a prefetch thread. */
+static void WaitImage(ChdImage* image)
+{
+#ifdef HAVE_THREADS
+	scond_wait(image->cond, image->lock);
+#endif
+}
+
+static void SignalImage(ChdImage* image)
+{
+#ifdef HAVE_THREADS
+	scond_broadcast(image->cond);
+#endif
+}
+
+/**************************************************************************************************
+ * Local Track Functions
+ *************************************************************************************************/
+
+/* Number of padding frames chdman adds after a track. */
+static uint32_t GetTrackPadding(uint32_t frames)
+{
+	return ((frames + CHD_TRACK_PAD - 1) & ~(CHD_TRACK_PAD - 1)) - frames;
+}
+
+/* Reads the metadata of the track at an index, in any of the CD or GD-ROM formats. */
+static bool GetTrackMetadata(chd_file* chd, int index, ChdTrack* track)
+{
+	char meta[256];
+	uint32_t pad = 0;
+
+	memset(track, 0, sizeof(*track));
+	meta[0] = '\0';
+
+	if (chd_get_metadata(chd, CDROM_TRACK_METADATA2_TAG, index, meta, sizeof(meta), NULL, NULL, NULL) == CHDERR_NONE)
+		sscanf(meta, CDROM_TRACK_METADATA2_FORMAT, &track->number, track->type, track->subtype,
+			&track->frames, &track->pregap, track->pgtype, track->pgsub, &track->postgap);
+	else if (chd_get_metadata(chd, CDROM_TRACK_METADATA_TAG, index, meta, sizeof(meta), NULL, NULL, NULL) == CHDERR_NONE)
+		sscanf(meta, CDROM_TRACK_METADATA_FORMAT, &track->number, track->type, track->subtype, &track->frames);
+	else if (chd_get_metadata(chd, GDROM_TRACK_METADATA_TAG, index, meta, sizeof(meta), NULL, NULL, NULL) == CHDERR_NONE)
+		sscanf(meta, GDROM_TRACK_METADATA_FORMAT, &track->number, track->type, track->subtype,
+			&track->frames, &pad, &track->pregap, track->pgtype, track->pgsub, &track->postgap);
+	else
+		return false;
+
+	return true;
+}
+
+/* Finds a track by number and where its frames start in the image. */
+static bool FindTrack(chd_file* chd, uint32_t number, ChdTrack* track)
+{
+	uint32_t frame_offset = 0;
+	int i;
+
+	for (i = 0; GetTrackMetadata(chd, i, track); i++)
+	{
+		if (track->number == number)
+		{
+			track->frame_offset = frame_offset;
+			return true;
+		}
+		frame_offset += track->frames + GetTrackPadding(track->frames);
+	}
+
+	return false;
+}
+
+/**************************************************************************************************
+ * Local Cache Functions
+ *************************************************************************************************/
+
+/* Finds a hunk in the cache, called with the lock held. */
+static ChdHunk* FindHunk(ChdImage* image, uint32_t number)
+{
+	unsigned i;
+
+	for (i = 0; i < image->hunk_count; i++)
+	{
+		if (image->hunks[i].state != CHD_HUNK_EMPTY && image->hunks[i].number == number)
+			return &image->hunks[i];
+	}
+
+	return NULL;
+}
+
+/* Claims the least recently used hunk that isn't being decompressed, called with the lock held. */
+static ChdHunk* ClaimHunk(ChdImage* image, uint32_t number)
+{
+	ChdHunk* victim = NULL;
+	unsigned i;
+
+	for (i = 0; i < image->hunk_count; i++)
+	{
+		ChdHunk* hunk = &image->hunks[i];
+
+		if (hunk->state == CHD_HUNK_LOADING)
+			continue;
+		if (hunk->state == CHD_HUNK_EMPTY)
+		{
+			victim = hunk;
+			break;
+		}
+		if (!victim || (uint32_t)(image->clock - hunk->last_used) > (uint32_t)(image->clock - victim->last_used))
+			victim = hunk;
+	}
+
+	if (!victim)
+		return NULL;
+
+	if (!victim->data)
+	{
+		victim->data = (uint8_t*)malloc(image->hunk_bytes);
+		if (!victim->data)
+			return NULL;
+	}
+
+	victim->number = number;
+	victim->state = CHD_HUNK_LOADING;
+	return victim;
+}
+
+/* Decompresses a claimed hunk with the lock released, then marks it ready. */
+static bool LoadHunk(ChdImage* image, ChdHunk* hunk)
+{
+	chd_error err;
+
+	UnlockImage(image);
+
+#ifdef HAVE_THREADS
+	slock_lock(image->chd_lock);
+#endif
+	err = chd_read(image->chd, hunk->number, hunk->data);
+#ifdef HAVE_THREADS
+	slock_unlock(image->chd_lock);
+#endif
+
+	if (err == CHDERR_NONE && image->swab)
+	{
+		uint16_t* samples = (uint16_t*)hunk->data;
+		uint32_t i;
+
+		for (i = 0; i < image->hunk_bytes / 2; i++)
+			samples[i] = SWAP16(samples[i]);
+	}
+
+	LockImage(image);
+
+	hunk->state = err == CHDERR_NONE ? CHD_HUNK_READY : CHD_HUNK_EMPTY;
+	hunk->last_used = ++image->clock;
+	SignalImage(image);
+
+	if (err != CHDERR_NONE)
+		lmc_core_log(RETRO_LOG_ERROR, "Failed to read CHD hunk %u: %s", hunk->number, chd_error_string(err));
+	return err == CHDERR_NONE;
+}
+
+/* Gets a decompressed hunk, waiting for the prefetch thread or decompressing it here. Called
+ * with the lock held, the hunk stays valid until the lock is released. */
+static ChdHunk* AcquireHunk(ChdImage* image, uint32_t number, uint32_t* misses)
+{
+	ChdHunk* hunk;
+
+	for (;;)
+	{
+		hunk = FindHunk(image, number);
+
+		if (hunk && hunk->state == CHD_HUNK_READY)
+		{
+			hunk->last_used = ++image->clock;
+			return hunk;
+		}
+
+		/* The prefetch thread is on it already. */
+		if (hunk)
+		{
+			WaitImage(image);
+			continue;
+		}
+
+		hunk = ClaimHunk(image, number);
+		if (!hunk)
+			return NULL;
+
+		if (misses)
+			(*misses)++;
+		if (!LoadHunk(image, hunk))
+			return NULL;
+	}
+}
+
+/* Watches for sequential reads and moves the prefetch window ahead of them. */
+static void UpdatePrefetch(ChdImage* image, uint32_t number)
+{
+	if (number == image->last_hunk + 1)
+		image->sequential++;
+	else if (number != image->last_hunk)
+		image->sequential = 0;
+	image->last_hunk = number;
+
+	if (image->prefetch == 0 || image->sequential < CHD_SEQUENTIAL_HUNKS)
+		return;
+
+	if (image->prefetch_next <= number || image->prefetch_next > number + image->prefetch)
+		image->prefetch_next = number + 1;
+	image->prefetch_end = MIN(number + 1 + image->prefetch, image->total_hunks);
+	SignalImage(image);
+}
+
+#ifdef HAVE_THREADS
+
+/* Prefetch thread, decompresses the hunks ahead of sequential reads. */
+static void ChdPrefetchThread(void* data)
+{
+	ChdImage* image = (ChdImage*)data;
+	ChdHunk* hunk;
+	uint32_t number;
+
+	LockImage(image);
+
+	while (!image->quit)
+	{
+		if (image->prefetch_next >= image->prefetch_end)
+		{
+			WaitImage(image);
+			continue;
+		}
+
+		number = image->prefetch_next++;
+		if (FindHunk(image, number))
+			continue;
+
+		hunk = ClaimHunk(image, number);
+		if (hunk)
+			LoadHunk(image, hunk);
+	}
+
+	UnlockImage(image);
+}
+
+#endif
+
+/* Checks that this build can decompress every codec the image uses. libchdr leaves codecs it
+ * wasn't built with unset and would fail on the first hunk using one. */
+static bool CheckChdCodecs(const chd_header* header, const char* path)
+{
+	int i;
+
+	if (header->version < 5)
+		return true;
+
+	for (i = 0; i < 4; i++)
+	{
+		const uint32_t codec = header->compression[i];
+
+		switch (codec)
+		{
+		case 0:
+		case CHD_CODEC_ZLIB:
+		case CHD_CODEC_CD_ZLIB:
+#ifdef HAVE_7ZIP
+		case CHD_CODEC_CD_LZMA:
+#endif
+#ifdef HAVE_FLAC
+		case CHD_CODEC_CD_FLAC:
+#endif
+			break;
+		default:
+			lmc_core_log(RETRO_LOG_ERROR, "%s uses the '%c%c%c%c' codec, only zlib compressed "
+				"CHD images are supported (cdlz needs HAVE_7ZIP, cdfl needs HAVE_FLAC)", path,
+				(char)(codec >> 24), (char)(codec >> 16), (char)(codec >> 8), (char)codec);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**************************************************************************************************
+ * ChdImage Functions
+ *************************************************************************************************/
+
+/* Checks for a CHD track path, "image.chd#track". */
+bool IsChdTrackPath(const char* path)
+{
+	const char* hash = strrchr(path, '#');
+	const char* digit;
+	char ext[5];
+
+	if (!hash || hash - path < 4 || hash[1] == '\0')
+		return false;
+
+	strlcpy(ext, hash - 4, sizeof(ext));
+	string_to_lower(ext);
+	if (!string_is_equal(ext, ".chd"))
+		return false;
+
+	for (digit = hash + 1; *digit; digit++)
+	{
+		if (*digit < '0' || *digit > '9')
+			return false;
+	}
+
+	return true;
+}
+
+/* Opens a track of a CHD image from an "image.chd#track" path. */
+ChdImage* OpenChdImage(const char* path, size_t cache_size)
+{
+	char chd_path[PATH_MAX_LENGTH];
+	const chd_header* header;
+	ChdImage* image;
+	ChdTrack track;
+	chd_error err;
+	const char* hash = strrchr(path, '#');
+	uint32_t pregap = 0;
+
+	if (!hash || (size_t)(hash - path) >= sizeof(chd_path))
+		return NULL;
+	strlcpy(chd_path, path, (size_t)(hash - path) + 1);
+
+	image = (ChdImage*)calloc(1, sizeof(ChdImage));
+	if (!image)
+		return NULL;
+
+	err = chd_open(chd_path, CHD_OPEN_READ, NULL, &image->chd);
+	if (err != CHDERR_NONE)
+	{
+		lmc_core_log(RETRO_LOG_ERROR, "Failed to open %s: %s", chd_path, chd_error_string(err));
+		free(image);
+		return NULL;
+	}
+
+	header = chd_get_header(image->chd);
+	if (!CheckChdCodecs(header, chd_path))
+	{
+		CloseChdImage(image);
+		return NULL;
+	}
+
+	if (!FindTrack(image->chd, (uint32_t)strtoul(hash + 1, NULL, 10), &track))
+	{
+		lmc_core_log(RETRO_LOG_ERROR, "No track %s in %s", hash + 1, chd_path);
+		CloseChdImage(image);
+		return NULL;
+	}
+
+	image->hunk_bytes = header->hunkbytes;
+	image->unit_bytes = header->unitbytes;
+	image->total_hunks = header->totalhunks;
+	image->frames_per_hunk = header->hunkbytes / header->unitbytes;
+
+	if (string_is_equal(track.type, "MODE1_RAW") || string_is_equal(track.type, "MODE2_RAW"))
+		image->frame_size = CHD_SECTOR_SIZE;
+	else if (string_is_equal(track.type, "AUDIO"))
+	{
+		image->frame_size = CHD_SECTOR_SIZE;
+		image->swab = true;
+	}
+	else
+		image->frame_size = header->unitbytes;
+
+	/* Only include the pregap if it was in the track file. */
+	if (track.pgtype[0] != 'V')
+		pregap = track.pregap;
+
+	image->track_frame = track.frame_offset;
+	image->track_start = (int64_t)pregap * image->frame_size;
+	image->track_end = image->track_start + (int64_t)track.frames * image->frame_size;
+	image->last_hunk = UINT32_MAX - 1;
+
+	/* The cache always holds the prefetch window plus the hunk being read. */
+	image->hunk_count = (unsigned)MAX(cache_size / image->hunk_bytes, CHD_PREFETCH_HUNKS * 2);
+	image->hunks = (ChdHunk*)calloc(image->hunk_count, sizeof(ChdHunk));
+	if (!image->hunks)
+	{
+		CloseChdImage(image);
+		return NULL;
+	}
+
+#ifdef HAVE_THREADS
+	image->lock = slock_new();
+	image->chd_lock = slock_new();
+	image->cond = scond_new();
+	if (image->lock && image->chd_lock && image->cond)
+		image->worker = sthread_create(ChdPrefetchThread, image);
+
+	/* Without the thread every hunk is decompressed on demand. */
+	if (image->worker)
+		image->prefetch = CHD_PREFETCH_HUNKS;
+#endif
+
+	return image;
+}
+
+/* Stops prefetching and closes the image. */
+void CloseChdImage(ChdImage* image)
+{
+	unsigned i;
+
+	if (!image)
+		return;
+
+#ifdef HAVE_THREADS
+	if (image->worker)
+	{
+		LockImage(image);
+		image->quit = true;
+		SignalImage(image);
+		UnlockImage(image);
+		sthread_join(image->worker);
+	}
+	if (image->cond)
+		scond_free(image->cond);
+	if (image->chd_lock)
+		slock_free(image->chd_lock);
+	if (image->lock)
+		slock_free(image->lock);
+#endif
+
+	if (image->hunks)
+	{
+		for (i = 0; i < image->hunk_count; i++)
+			free(image->hunks[i].data);
+		free(image->hunks);
+	}
+
+	if (image->chd)
+		chd_close(image->chd);
+	free(image);
+}
+
+/* Gets the size of the track's data. */
+int64_t GetChdImageSize(const ChdImage* image)
+{
+	return image->track_end;
+}
+
+/* Reads track data, counting hunks that had to be decompressed on the calling thread. */
+int64_t ReadChdImage(ChdImage* image, int64_t offset, void* data, uint64_t len, uint32_t* misses)
+{
+	uint8_t* out = (uint8_t*)data;
+	uint64_t total = 0;
+
+	if (offset < 0)
+		return -1;
+	if (offset >= image->track_end)
+		return 0;
+
+	len = MIN(len, (uint64_t)(image->track_end - offset));
+
+	LockImage(image);
+
+	while (total < len)
+	{
+		uint32_t frame_offset = (uint32_t)(offset % image->frame_size);
+		uint32_t amount = (uint32_t)MIN((uint64_t)(image->frame_size - frame_offset), len - total);
+
+		if (offset < image->track_start)
+			memset(out, 0, amount);
+		else
+		{
+			uint32_t frame = image->track_frame + (uint32_t)((offset - image->track_start) / image->frame_size);
+			uint32_t number = frame / image->frames_per_hunk;
+			uint32_t hunk_offset = (frame % image->frames_per_hunk) * image->unit_bytes;
+			ChdHunk* hunk;
+
+			UpdatePrefetch(image, number);
+
+			hunk = AcquireHunk(image, number, misses);
+			if (!hunk)
+			{
+				UnlockImage(image);
+				return total > 0 ? (int64_t)total : -1;
+			}
+
+			memcpy(out, hunk->data + hunk_offset + frame_offset, amount);
+		}
+
+		out += amount;
+		offset += amount;
+		total += amount;
+	}
+
+	UnlockImage(image);
+	return (int64_t)total;
+}
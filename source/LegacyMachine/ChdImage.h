@@ -0,0 +1,49 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _CHD_IMAGE_H
+#define _CHD_IMAGE_H
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define CHD_PREFETCH_HUNKS		8					/* Hunks decompressed ahead of sequential reads. */
+#define CHD_SEQUENTIAL_HUNKS	2					/* Consecutive hunks that start prefetching. */
+
+typedef struct ChdImage ChdImage;
+
+/**************************************************************************************************
+ * ChdImage Prototypes
+ *************************************************************************************************/
+
+RETRO_BEGIN_DECLS
+
+bool IsChdTrackPath(const char* path);
+ChdImage* OpenChdImage(const char* path, size_t cache_size);
+void CloseChdImage(ChdImage* image);
+int64_t GetChdImageSize(const ChdImage* image);
+int64_t ReadChdImage(ChdImage* image, int64_t offset, void* data, uint64_t len, uint32_t* misses);
+
+RETRO_END_DECLS
+
+#endif
@@ -0,0 +1,92 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <memmap.h>
+
+#include "FileMap.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#ifndef PROT_READ
+#define PROT_READ	0x1
+#endif
+
+#ifndef MAP_PRIVATE
+#define MAP_PRIVATE	0x2
+#endif
+
+#ifndef MAP_FAILED
+#define MAP_FAILED	((void*)-1)
+#endif
+
+#ifdef _WIN32
+#define MapOpen(path)		_open(path, _O_RDONLY | _O_BINARY)
+#define MapSize(fd)			_lseeki64(fd, 0, SEEK_END)
+#define MapClose(fd)		_close(fd)
+#else
+#define MapOpen(path)		open(path, O_RDONLY)
+#define MapSize(fd)			lseek(fd, 0, SEEK_END)
+#define MapClose(fd)		close(fd)
+#endif
+
+/**************************************************************************************************
+ * FileMap Functions
+ *************************************************************************************************/
+
+/* Maps a whole file read-only, pages are only read in as they are touched. Empty files fail. */
+void* MapFileReadOnly(const char* path, size_t* size)
+{
+	int64_t file_size;
+	void* data;
+	int fd = MapOpen(path);
+
+	if (fd < 0)
+		return NULL;
+
+	file_size = MapSize(fd);
+	if (file_size <= 0 || (uint64_t)file_size > SIZE_MAX)
+	{
+		MapClose(fd);
+		return NULL;
+	}
+
+	data = mmap(NULL, (size_t)file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	/* The mapping holds its own reference to the file. */
+	MapClose(fd);
+
+	if (data == MAP_FAILED || data == NULL)
+		return NULL;
+
+	*size = (size_t)file_size;
+	return data;
+}
+
+/* Unmaps a file mapped with MapFileReadOnly(). */
+void UnmapFileReadOnly(void* data, size_t size)
+{
+	if (data != NULL)
+		munmap(data, size);
+}
@@ -0,0 +1,36 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef __FILE_MAP_H_
+#define __FILE_MAP_H_
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+
+#include <retro_common_api.h>
+
+/**************************************************************************************************
+ * FileMap Prototypes
+ *************************************************************************************************/
+
+RETRO_BEGIN_DECLS
+
+void* MapFileReadOnly(const char* path, size_t* size);
+void UnmapFileReadOnly(void* data, size_t size);
+
+RETRO_END_DECLS
+
+#endif
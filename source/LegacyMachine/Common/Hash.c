@@ -0,0 +1,51 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <string.h>
+
+#include "Hash.h"
+
+/**************************************************************************************************
+ * Hash Functions
+ *************************************************************************************************/
+
+/* Computes a fast, non-cryptographic 64-bit hash of a memory region, eight bytes at a time. */
+uint64_t HashMemory64(const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint64_t hash = 0xCBF29CE484222325ull ^ (uint64_t)size;
+	uint64_t word;
+
+	while (size >= sizeof(word))
+	{
+		memcpy(&word, bytes, sizeof(word));
+		hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+		hash ^= hash >> 32;
+		bytes += sizeof(word);
+		size -= sizeof(word);
+	}
+
+	while (size--)
+	{
+		hash = (hash ^ *bytes++) * 0x100000001B3ull;
+	}
+
+	hash ^= hash >> 29;
+	hash *= 0xBF58476D1CE4E5B9ull;
+	hash ^= hash >> 32;
+
+	return hash;
+}
@@ -0,0 +1,951 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#include <compat/strl.h>
+#include <compat/posix_string.h>
+#include <features/features_cpu.h>
+#ifdef HAVE_COMPRESSION
+#include <file/archive_file.h>
+#include <streams/trans_stream.h>
+#include <encodings/crc32.h>
+#endif
+
+#include "ContentManager.h"
+#include "Logging.h"
+#include "Common/FileMap.h"
+#ifdef HAVE_CHD
+#include "ChdImage.h"
+#endif
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define ZIP_LOCAL_HEADER_SIGNATURE	0x04034b50
+#define ZIP_LOCAL_HEADER_SIZE		30
+#define ZIP_MODE_STORED				0
+#define ZIP_MODE_DEFLATED			8
+#define ZIP_WINDOW_BITS				15
+
+/**************************************************************************************************
+ * Content Archive Structures
+ *************************************************************************************************/
+
+#ifdef HAVE_COMPRESSION
+
+/* Archive member located while walking an archive's directory. */
+typedef struct ArchiveMember
+{
+	const char*	wanted;					/* Requested member, NULL picks the first suitable one. */
+	const char*	valid_exts;				/* Extensions the core accepts. */
+	char		name[PATH_MAX_LENGTH];	/* Member path inside the archive. */
+	size_t		offset;					/* Local header offset (zip). */
+	uint32_t	csize;					/* Compressed size. */
+	uint32_t	size;					/* Uncompressed size. */
+	uint32_t	crc;					/* CRC32 recorded in the archive. */
+	unsigned	cmode;					/* Compression method. */
+	bool		found;					/* A member was found. */
+}
+ArchiveMember;
+
+/* Zip member being decompressed into the content buffer. */
+typedef struct ArchiveInflate
+{
+	void*			stream;				/* Inflate stream, NULL for stored members. */
+	const uint8_t*	in;					/* Next stored bytes to checksum. */
+	uint8_t*		out;				/* Next byte of the content buffer to fill. */
+	size_t			remaining;			/* Bytes left to decompress. */
+	uint32_t		crc;				/* Running CRC32 of the decompressed bytes. */
+	uint32_t		expected_crc;		/* CRC32 recorded in the archive. */
+}
+ArchiveInflate;
+
+#endif
+
+/* Core and content read ahead on a background task. */
+typedef struct PrefetchTask
+{
+	char		core_path[PATH_MAX_LENGTH];
+	char		content_path[PATH_MAX_LENGTH];
+	dylib_t		core;					/* Core opened by the task. */
+	RFILE*		file;					/* Content being read ahead. */
+	uint8_t*	buffer;					/* Scratch buffer the content is read into. */
+	int64_t		remaining;				/* Content bytes left to read. */
+	bool		core_done;				/* Core has been opened or there's none to open. */
+}
+PrefetchTask;
+
+/**************************************************************************************************
+ * ContentManager Context
+ *************************************************************************************************/
+
+static ContentManager content_manager = { 0 };
+
+/**************************************************************************************************
+ * Local Content Functions
+ *************************************************************************************************/
+
+/* Checks whether a '|' separated extension list contains a lowercase extension. */
+static bool MatchExtension(const char* extensions, const char* ext)
+{
+	char extension[CONTENT_EXT_LENGTH];
+
+	while (extensions && *extensions)
+	{
+		const char* next = strchr(extensions, '|');
+		size_t length = next ? (size_t)(next - extensions) : strlen(extensions);
+
+		if (length < sizeof(extension))
+		{
+			memcpy(extension, extensions, length);
+			extension[length] = '\0';
+			if (string_is_equal(string_to_lower(extension), ext))
+				return true;
+		}
+
+		extensions = next ? next + 1 : NULL;
+	}
+	return false;
+}
+
+/* Applies the core's content info override for the content's extension, if any. */
+static void ApplyContentOverride(bool* need_fullpath)
+{
+	const struct retro_system_content_info_override* override = content_manager.overrides;
+
+	content_manager.persistent = false;
+	content_manager.persistent_requested = false;
+
+	for (; override && override->extensions; override++)
+	{
+		if (MatchExtension(override->extensions, content_manager.ext))
+		{
+			*need_fullpath = override->need_fullpath;
+			content_manager.persistent = override->persistent_data;
+			content_manager.persistent_requested = override->persistent_data;
+			return;
+		}
+	}
+}
+
+/* Fills in the content's name, extension and directory from a path. */
+static void SetContentNames(const char* path, const char* dir_path)
+{
+	size_t length;
+
+	fill_pathname_basedir(content_manager.dir, dir_path, sizeof(content_manager.dir));
+	fill_pathname_base(content_manager.name, path, sizeof(content_manager.name));
+	path_remove_extension(content_manager.name);
+	strlcpy(content_manager.ext, path_get_extension(path), sizeof(content_manager.ext));
+	string_to_lower(content_manager.ext);
+
+	/* Strip the trailing slash cores don't expect in the content directory. */
+	length = strlen(content_manager.dir);
+	if (length > 1 && (content_manager.dir[length - 1] == '/' || content_manager.dir[length - 1] == '\\'))
+		content_manager.dir[length - 1] = '\0';
+}
+
+/* Maps a file read-only, pages are only read in as they are touched. */
+static bool MapFile(const char* path)
+{
+	size_t size = 0;
+	void* data = MapFileReadOnly(path, &size);
+
+	if (data == NULL)
+		return false;
+
+	content_manager.map = data;
+	content_manager.map_size = size;
+	return true;
+}
+
+/* Unmaps the file backing the content, if any. */
+static void UnmapFile(void)
+{
+	UnmapFileReadOnly(content_manager.map, content_manager.map_size);
+	content_manager.map = NULL;
+	content_manager.map_size = 0;
+}
+
+/* Checks whether the content data lives in the file mapping rather than its own buffer. */
+static bool IsContentMapped(void)
+{
+	const uint8_t* data = (const uint8_t*)content_manager.data;
+	const uint8_t* map = (const uint8_t*)content_manager.map;
+
+	return map != NULL && data >= map && data < map + content_manager.map_size;
+}
+
+/* Frees or unmaps the content data. */
+static void FreeContentData(void)
+{
+	if (content_manager.data != NULL && !IsContentMapped())
+		free(content_manager.data);
+	UnmapFile();
+	content_manager.data = NULL;
+	content_manager.size = 0;
+}
+
+/* Reads the whole content file into memory. */
+static bool ReadContent(void)
+{
+	void* data = NULL;
+	int64_t size = 0;
+
+	if (!filestream_read_file(content_manager.path, &data, &size) || size < 0)
+	{
+		free(data);
+		return false;
+	}
+
+	content_manager.data = data;
+	content_manager.size = (size_t)size;
+	return true;
+}
+
+/* Loads a plain content file, mapping it where possible. */
+static bool LoadContentFile(void)
+{
+	if (MapFile(content_manager.path))
+	{
+		content_manager.data = content_manager.map;
+		content_manager.size = content_manager.map_size;
+	}
+	else if (!ReadContent())
+		return false;
+
+	lmc_trace(LMC_LOG_VERBOSE, "Content %s %s (%u bytes)", content_manager.map ? "mapped" : "read",
+		content_manager.path, (unsigned)content_manager.size);
+	return true;
+}
+
+#ifdef HAVE_CHD
+
+/* Reads a CHD track into memory, the data is the raw track a .bin file would hold. */
+static bool ReadChdTrack(void)
+{
+	ChdImage* image = OpenChdImage(content_manager.path, 0);
+	int64_t size;
+	void* data;
+
+	if (image == NULL)
+		return false;
+
+	size = GetChdImageSize(image);
+	data = size > 0 ? malloc((size_t)size) : NULL;
+	if (data == NULL || ReadChdImage(image, 0, data, (uint64_t)size, NULL) != size)
+	{
+		free(data);
+		CloseChdImage(image);
+		return false;
+	}
+	CloseChdImage(image);
+
+	content_manager.data = data;
+	content_manager.size = (size_t)size;
+	lmc_trace(LMC_LOG_VERBOSE, "Content read from CHD track %s (%u bytes)", content_manager.path,
+		(unsigned)content_manager.size);
+	return true;
+}
+
+#endif
+
+/* Fills in the extended content info reported to cores. */
+static void UpdateContentInfo(void)
+{
+	struct retro_game_info_ext* info_ext = &content_manager.info_ext;
+
+	memset(info_ext, 0, sizeof(*info_ext));
+	info_ext->full_path = content_manager.path;
+	info_ext->dir = content_manager.dir;
+	info_ext->name = content_manager.name;
+	info_ext->ext = content_manager.ext;
+	info_ext->meta = "";
+	info_ext->data = content_manager.data;
+	info_ext->size = content_manager.size;
+	info_ext->file_in_archive = content_manager.in_archive;
+	info_ext->persistent_data = content_manager.persistent;
+	if (content_manager.in_archive)
+	{
+		info_ext->archive_path = content_manager.archive_path;
+		info_ext->archive_file = content_manager.archive_file;
+	}
+}
+
+/* Marks the content ready and hands it to the callback. */
+static void FinishContent(bool loaded)
+{
+	ContentCallback cb_loaded = content_manager.cb_loaded;
+
+	content_manager.loading = false;
+	content_manager.cb_loaded = NULL;
+
+	/* Mapped data costs nothing to keep, so it stays valid for the session either way. */
+	if (loaded && IsContentMapped())
+		content_manager.persistent = true;
+
+	UpdateContentInfo();
+
+	if (cb_loaded)
+		cb_loaded(loaded);
+}
+
+/**************************************************************************************************
+ * Local Archive Functions
+ *************************************************************************************************/
+
+#ifdef HAVE_COMPRESSION
+
+/* Reads a little endian value from a zip header. */
+static uint32_t ReadZip(const uint8_t* data, unsigned size)
+{
+	uint32_t value = 0;
+	unsigned i;
+
+	for (i = 0; i < size; i++)
+		value |= (uint32_t)data[i] << (i * 8);
+	return value;
+}
+
+/* Archive walk callback, picks the requested member or the first one the core accepts. */
+static int FindArchiveMember(const char* name, const char* valid_exts, const uint8_t* cdata,
+	unsigned cmode, uint32_t csize, uint32_t size, uint32_t crc32, struct archive_extract_userdata* userdata)
+{
+	ArchiveMember* member = (ArchiveMember*)userdata->cb_data;
+	size_t length = strlen(name);
+	char ext[CONTENT_EXT_LENGTH];
+	bool suitable;
+
+	/* Skip directories. */
+	if (length == 0 || name[length - 1] == '/' || name[length - 1] == '\\')
+		return 1;
+
+	if (member->wanted)
+		suitable = string_is_equal(name, member->wanted);
+	else
+	{
+		strlcpy(ext, path_get_extension(name), sizeof(ext));
+		suitable = member->valid_exts == NULL || MatchExtension(member->valid_exts, string_to_lower(ext));
+	}
+
+	/* Fall back on the first file when none has an extension the core accepts. */
+	if (suitable || (!member->found && !member->wanted))
+	{
+		strlcpy(member->name, name, sizeof(member->name));
+		member->offset = (size_t)cdata;
+		member->cmode = cmode;
+		member->csize = csize;
+		member->size = size;
+		member->crc = crc32;
+		member->found = true;
+	}
+
+	return suitable ? 0 : 1;
+}
+
+/* Decompresses the next slice of a zip member, checksumming each chunk while it's hot in cache.
+ * Returns 1 when done, 0 when there is more to do and -1 on error. */
+static int StepArchiveInflate(ArchiveInflate* inflate)
+{
+	size_t slice = 0;
+
+	while (inflate->remaining > 0 && slice < ARCHIVE_SLICE_SIZE)
+	{
+		uint32_t chunk = (uint32_t)MIN(inflate->remaining, ARCHIVE_CHUNK_SIZE);
+		uint32_t rd = 0;
+		uint32_t wn = chunk;
+		enum trans_stream_error error = TRANS_STREAM_ERROR_NONE;
+
+		if (inflate->stream)
+		{
+			zlib_inflate_backend.set_out(inflate->stream, inflate->out, chunk);
+			if (!zlib_inflate_backend.trans(inflate->stream, false, &rd, &wn, &error) &&
+				error != TRANS_STREAM_ERROR_BUFFER_FULL)
+				return -1;
+
+			/* Stream ended or stalled short of the recorded size. */
+			if (wn == 0)
+				return -1;
+
+			inflate->crc = encoding_crc32(inflate->crc, inflate->out, wn);
+			inflate->out += wn;
+		}
+		else
+		{
+			inflate->crc = encoding_crc32(inflate->crc, inflate->in, wn);
+			inflate->in += wn;
+		}
+
+		inflate->remaining -= wn;
+		slice += wn;
+	}
+
+	if (inflate->remaining > 0)
+		return 0;
+
+	return inflate->crc == inflate->expected_crc ? 1 : -1;
+}
+
+/* Releases the decompression state, the archive mapping is only kept for stored members. */
+static void EndArchiveInflate(ArchiveInflate* inflate, bool loaded)
+{
+	if (inflate->stream)
+	{
+		zlib_inflate_backend.stream_free(inflate->stream);
+
+		/* The content lives in its own buffer now. */
+		UnmapFile();
+	}
+
+	if (!loaded)
+		FreeContentData();
+
+	free(inflate);
+}
+
+/* Background task handler, decompresses one slice per step. */
+static void ArchiveTaskHandler(retro_task_t* task)
+{
+	ArchiveInflate* inflate = (ArchiveInflate*)task->state;
+	int ret = task_get_cancelled(task) ? -1 : StepArchiveInflate(inflate);
+
+	if (ret == 0)
+	{
+		task_set_progress(task, (int8_t)(100 - (inflate->remaining * 100) / content_manager.size));
+		return;
+	}
+
+	if (ret < 0 && !task_get_cancelled(task))
+		task_set_error(task, strdup("Failed to decompress archived content"));
+
+	task_set_progress(task, 100);
+	task_set_finished(task, true);
+}
+
+/* Background task callback, runs on the main loop once the member is decompressed. */
+static void ArchiveTaskCallback(retro_task_t* task, void* task_data, void* user_data, const char* error)
+{
+	ArchiveInflate* inflate = (ArchiveInflate*)task->state;
+	bool cancelled = task_get_cancelled(task);
+	bool loaded = error == NULL && !cancelled;
+
+	task->state = NULL;
+	content_manager.task = NULL;
+	EndArchiveInflate(inflate, loaded);
+
+	if (cancelled)
+		return;
+
+	if (!loaded)
+		lmc_core_log(RETRO_LOG_ERROR, "Failed to decompress %s", content_manager.path);
+	FinishContent(loaded);
+}
+
+/* Checks whether a background archive load is still pending. */
+static bool IsArchiveTaskPending(void* data)
+{
+	return content_manager.task != NULL;
+}
+
+/* Starts decompressing a zip member straight into the content buffer. */
+static bool LoadZipMember(const ArchiveMember* member)
+{
+	ArchiveInflate* inflate;
+	const uint8_t* header;
+	const uint8_t* source;
+	size_t offset;
+
+	/* The archive is mapped so compressed data is only read as it's consumed. */
+	if (!MapFile(content_manager.archive_path))
+		return false;
+
+	header = (const uint8_t*)content_manager.map + member->offset;
+	if (member->offset + ZIP_LOCAL_HEADER_SIZE > content_manager.map_size ||
+		ReadZip(header, 4) != ZIP_LOCAL_HEADER_SIGNATURE)
+		return false;
+
+	offset = member->offset + ZIP_LOCAL_HEADER_SIZE + ReadZip(header + 26, 2) + ReadZip(header + 28, 2);
+	if (offset + member->csize > content_manager.map_size)
+		return false;
+	source = (const uint8_t*)content_manager.map + offset;
+
+	inflate = (ArchiveInflate*)calloc(1, sizeof(ArchiveInflate));
+	if (!inflate)
+		return false;
+
+	inflate->in = source;
+	inflate->remaining = member->size;
+	inflate->expected_crc = member->crc;
+
+	switch (member->cmode)
+	{
+	case ZIP_MODE_STORED:
+		/* Stored members are handed to the core straight from the archive mapping. */
+		if (member->csize != member->size)
+			break;
+		content_manager.data = (void*)source;
+		content_manager.size = member->size;
+		break;
+
+	case ZIP_MODE_DEFLATED:
+		content_manager.data = malloc(member->size ? member->size : 1);
+		content_manager.size = member->size;
+		inflate->out = (uint8_t*)content_manager.data;
+		inflate->stream = zlib_inflate_backend.stream_new();
+		if (!content_manager.data || !inflate->stream)
+			break;
+		zlib_inflate_backend.define(inflate->stream, "window_bits", (uint32_t)-ZIP_WINDOW_BITS);
+		zlib_inflate_backend.set_in(inflate->stream, source, member->csize);
+		break;
+	}
+
+	if (content_manager.data == NULL || (member->cmode == ZIP_MODE_DEFLATED && inflate->stream == NULL))
+	{
+		EndArchiveInflate(inflate, false);
+		return false;
+	}
+
+	/* Large members decompress on a task so the menu keeps running meanwhile. */
+	if (member->size >= ARCHIVE_TASK_SIZE)
+	{
+		retro_task_t* task = task_init();
+
+		if (task)
+		{
+			task->handler = ArchiveTaskHandler;
+			task->callback = ArchiveTaskCallback;
+			task->state = inflate;
+			task->mute = true;
+			content_manager.task = task;
+			content_manager.loading = true;
+			if (task_queue_push(task))
+				return true;
+			content_manager.task = NULL;
+			content_manager.loading = false;
+			free(task);
+		}
+	}
+
+	for (;;)
+	{
+		int ret = StepArchiveInflate(inflate);
+
+		if (ret != 0)
+		{
+			EndArchiveInflate(inflate, ret > 0);
+			if (ret < 0)
+			{
+				lmc_core_log(RETRO_LOG_ERROR, "Failed to decompress %s", content_manager.path);
+				return false;
+			}
+			break;
+		}
+	}
+
+	FinishContent(true);
+	return true;
+}
+
+/* Loads an archive member, content paths name the member as "archive#member". */
+static bool LoadArchiveMember(const char* path, const struct retro_system_info* system_info)
+{
+	struct archive_extract_userdata userdata = { 0 };
+	file_archive_transfer_t transfer = { 0 };
+	ArchiveMember member = { 0 };
+	const char* delim = path_get_archive_delim(path);
+	bool need_fullpath = system_info->need_fullpath;
+	bool ok = true;
+
+	strlcpy(content_manager.archive_path, path, sizeof(content_manager.archive_path));
+	if (delim)
+	{
+		content_manager.archive_path[delim - path] = '\0';
+		member.wanted = delim + 1;
+	}
+	member.valid_exts = system_info->valid_extensions;
+
+	/* Walk the archive directory with the bundled backends. */
+	userdata.cb_data = &member;
+	transfer.type = ARCHIVE_TRANSFER_INIT;
+	while (file_archive_parse_file_iterate(&transfer, &ok, content_manager.archive_path, NULL,
+		FindArchiveMember, &userdata) == 0)
+		;
+
+	if (!ok || !member.found)
+	{
+		lmc_core_log(RETRO_LOG_ERROR, "No suitable content found in %s", content_manager.archive_path);
+		return false;
+	}
+
+	strlcpy(content_manager.archive_file, member.name, sizeof(content_manager.archive_file));
+	snprintf(content_manager.path, sizeof(content_manager.path), "%s#%s", content_manager.archive_path, member.name);
+	SetContentNames(member.name, content_manager.archive_path);
+	content_manager.in_archive = true;
+	content_manager.crc = member.crc;
+
+	ApplyContentOverride(&need_fullpath);
+	if (need_fullpath)
+	{
+		lmc_core_log(RETRO_LOG_ERROR, "The core needs a file path, archived content is not supported");
+		return false;
+	}
+
+#ifdef HAVE_7ZIP
+	/* The 7z decoder extracts whole members and checks their CRC itself. */
+	if (string_is_equal_noncase(path_get_extension(content_manager.archive_path), "7z"))
+	{
+		void* data = NULL;
+		int64_t size = 0;
+
+		if (!file_archive_compressed_read(content_manager.path, &data, NULL, &size) || size < 0)
+		{
+			free(data);
+			return false;
+		}
+
+		content_manager.data = data;
+		content_manager.size = (size_t)size;
+		FinishContent(true);
+		return true;
+	}
+#endif
+
+	return LoadZipMember(&member);
+}
+
+#endif
+
+/**************************************************************************************************
+ * Content Prefetch Functions
+ *************************************************************************************************/
+
+/* Background task handler, opens the core then reads the content a chunk per step. */
+static void PrefetchTaskHandler(retro_task_t* task)
+{
+	PrefetchTask* prefetch = (PrefetchTask*)task->state;
+	int64_t read;
+
+	if (task_get_cancelled(task))
+	{
+		task_set_finished(task, true);
+		return;
+	}
+
+	/* Opening the core runs its loader and constructors away from the main loop. */
+	if (!prefetch->core_done)
+	{
+		if (prefetch->core_path[0] != '\0')
+			prefetch->core = dylib_load(prefetch->core_path);
+		prefetch->core_done = true;
+		return;
+	}
+
+	/* The content is read and discarded so mapping it on load finds it in the page cache. */
+	if (!prefetch->file)
+	{
+		int64_t size;
+
+		if (prefetch->content_path[0] != '\0')
+			prefetch->file = filestream_open(prefetch->content_path, RETRO_VFS_FILE_ACCESS_READ,
+				RETRO_VFS_FILE_ACCESS_HINT_NONE);
+		prefetch->buffer = (uint8_t*)malloc(PREFETCH_CHUNK_SIZE);
+		if (!prefetch->file || !prefetch->buffer)
+		{
+			task_set_finished(task, true);
+			return;
+		}
+		size = filestream_get_size(prefetch->file);
+		prefetch->remaining = size < PREFETCH_MAX_SIZE ? size : PREFETCH_MAX_SIZE;
+	}
+
+	read = filestream_read(prefetch->file, prefetch->buffer,
+		prefetch->remaining < PREFETCH_CHUNK_SIZE ? prefetch->remaining : PREFETCH_CHUNK_SIZE);
+	if (read > 0)
+		prefetch->remaining -= read;
+	if (read <= 0 || prefetch->remaining <= 0)
+		task_set_finished(task, true);
+}
+
+/* Background task callback, keeps the opened core unless the selection moved on. */
+static void PrefetchTaskCallback(retro_task_t* task, void* task_data, void* user_data, const char* error)
+{
+	PrefetchTask* prefetch = (PrefetchTask*)task->state;
+	ContentPrefetch* state = &content_manager.prefetch;
+	bool current = task == state->task && !task_get_cancelled(task);
+
+	if (task == state->task)
+		state->task = NULL;
+	state->tasks--;
+
+	if (prefetch->core && current)
+	{
+		if (state->core)
+			dylib_close(state->core);
+		state->core = prefetch->core;
+		strlcpy(state->core_loaded, prefetch->core_path, sizeof(state->core_loaded));
+	}
+	else if (prefetch->core)
+		dylib_close(prefetch->core);
+
+	if (prefetch->file)
+		filestream_close(prefetch->file);
+	free(prefetch->buffer);
+	free(prefetch);
+	task->state = NULL;
+}
+
+/* Checks whether any prefetch is still pending. */
+static bool IsPrefetchPending(void* data)
+{
+	return content_manager.prefetch.tasks > 0;
+}
+
+/**************************************************************************************************
+ * ContentManager Functions
+ *************************************************************************************************/
+
+/* Returns the current content manager context. */
+ContentManager* GetContentManagerContext(void)
+{
+	return &content_manager;
+}
+
+/* Opens content for the core, loading its data unless the core reads it from the path itself. */
+bool OpenContent(const char* path, const struct retro_system_info* system_info, ContentCallback cb_loaded)
+{
+	bool need_fullpath = system_info->need_fullpath;
+
+	CloseContent();
+
+	content_manager.cb_loaded = cb_loaded;
+	content_manager.loaded = true;
+	content_manager.in_archive = false;
+	content_manager.crc = 0;
+	strlcpy(content_manager.path, path, sizeof(content_manager.path));
+	SetContentNames(path, path);
+
+#ifdef HAVE_COMPRESSION
+	/* Archives are extracted unless the core takes them as they are. */
+	if (path_contains_compressed_file(path) || (path_is_compressed_file(path) &&
+		!(system_info->valid_extensions && MatchExtension(system_info->valid_extensions, content_manager.ext))))
+	{
+		if (!LoadArchiveMember(path, system_info))
+		{
+			CloseContent();
+			return false;
+		}
+		return true;
+	}
+#endif
+
+	ApplyContentOverride(&need_fullpath);
+
+#ifdef HAVE_CHD
+	/* CHD tracks are named "image.chd#track". Cores that need a path get it unchanged and
+	 * open it through the VFS interface, which decompresses the track as it's read. */
+	if (IsChdTrackPath(path))
+	{
+		strlcpy(content_manager.ext, "bin", sizeof(content_manager.ext));
+		if (!need_fullpath && !ReadChdTrack())
+		{
+			lmc_core_log(RETRO_LOG_ERROR, "Failed to load %s", path);
+			CloseContent();
+			return false;
+		}
+
+		FinishContent(true);
+		return true;
+	}
+#endif
+
+	/* Mapping avoids reading and copying the whole file up front, fall back to a read. */
+	if (!need_fullpath && !LoadContentFile())
+	{
+		lmc_core_log(RETRO_LOG_ERROR, "Failed to load %s", path);
+		CloseContent();
+		return false;
+	}
+
+	FinishContent(true);
+	return true;
+}
+
+/* Frees content data the core has no further use for once it's loaded. */
+void ReleaseContentData(void)
+{
+	if (content_manager.data == NULL || content_manager.persistent || content_manager.loading)
+		return;
+
+	FreeContentData();
+	content_manager.info_ext.data = NULL;
+	content_manager.info_ext.size = 0;
+}
+
+/* Closes the content, unmapping or freeing its data. */
+void CloseContent(void)
+{
+#ifdef HAVE_COMPRESSION
+	/* Cancel a background load and let its callback clean up, the wait can return while
+	 * the task moves to the finished queue so keep gathering until the callback ran. */
+	if (content_manager.task != NULL)
+	{
+		task_set_cancelled(content_manager.task, true);
+		while (content_manager.task != NULL)
+			task_queue_wait(IsArchiveTaskPending, NULL);
+	}
+#endif
+
+	FreeContentData();
+
+	content_manager.cb_loaded = NULL;
+	content_manager.persistent = false;
+	content_manager.persistent_requested = false;
+	content_manager.in_archive = false;
+	content_manager.loading = false;
+	content_manager.loaded = false;
+	content_manager.archive_path[0] = '\0';
+	content_manager.archive_file[0] = '\0';
+	memset(&content_manager.info_ext, 0, sizeof(content_manager.info_ext));
+}
+
+/* Hands the file mapping backing the content data to the caller, who unmaps it with
+ * UnmapFileReadOnly(). Returns false if the data isn't mapped. */
+bool DetachContentMapping(void** map, size_t* size)
+{
+	if (!IsContentMapped())
+		return false;
+
+	*map = content_manager.map;
+	*size = content_manager.map_size;
+	content_manager.map = NULL;
+	content_manager.map_size = 0;
+	content_manager.data = NULL;
+	content_manager.size = 0;
+	return true;
+}
+
+/* Queues the core and content to prefetch once the selection has rested, replacing any
+ * earlier request. Empty paths skip the core or the content. */
+void PrefetchContent(const char* core_path, const char* content_path)
+{
+	ContentPrefetch* state = &content_manager.prefetch;
+	const char* delim;
+
+	CancelPrefetch(false);
+
+	/* A core that's already prefetched is kept, archives are read ahead as a whole. */
+	state->core_path[0] = '\0';
+	if (core_path && !string_is_equal(core_path, state->core_loaded))
+		strlcpy(state->core_path, core_path, sizeof(state->core_path));
+
+	state->content_path[0] = '\0';
+	if (content_path)
+	{
+		delim = path_get_archive_delim(content_path);
+		strlcpy(state->content_path, content_path,
+			delim && (size_t)(delim - content_path) < sizeof(state->content_path) ?
+				(size_t)(delim - content_path) + 1 : sizeof(state->content_path));
+	}
+
+	state->start_time = cpu_features_get_time_usec() + PREFETCH_DELAY_USEC;
+	state->pending = state->core_path[0] != '\0' || state->content_path[0] != '\0';
+}
+
+/* Starts a queued prefetch once its selection has rested long enough. */
+void UpdatePrefetch(void)
+{
+	ContentPrefetch* state = &content_manager.prefetch;
+	PrefetchTask* prefetch;
+	retro_task_t* task;
+
+	if (!state->pending || cpu_features_get_time_usec() < state->start_time)
+		return;
+
+	state->pending = false;
+
+	prefetch = (PrefetchTask*)calloc(1, sizeof(PrefetchTask));
+	task = task_init();
+	if (!prefetch || !task)
+	{
+		free(prefetch);
+		free(task);
+		return;
+	}
+
+	strlcpy(prefetch->core_path, state->core_path, sizeof(prefetch->core_path));
+	strlcpy(prefetch->content_path, state->content_path, sizeof(prefetch->content_path));
+
+	task->handler = PrefetchTaskHandler;
+	task->callback = PrefetchTaskCallback;
+	task->state = prefetch;
+	task->mute = true;
+	state->task = task;
+	state->tasks++;
+	if (!task_queue_push(task))
+	{
+		state->task = NULL;
+		state->tasks--;
+		free(prefetch);
+		free(task);
+	}
+}
+
+/* Hands over the prefetched core if it's the one requested, NULL otherwise. */
+dylib_t TakePrefetchedCore(const char* core_path)
+{
+	ContentPrefetch* state = &content_manager.prefetch;
+	dylib_t core = NULL;
+
+	if (state->core && string_is_equal(core_path, state->core_loaded))
+	{
+		core = state->core;
+		state->core = NULL;
+		state->core_loaded[0] = '\0';
+	}
+
+	return core;
+}
+
+/* Cancels a queued or running prefetch. Releasing also waits for cancelled prefetches to wind
+ * down and closes the prefetched core. */
+void CancelPrefetch(bool release)
+{
+	ContentPrefetch* state = &content_manager.prefetch;
+
+	state->pending = false;
+	if (state->task != NULL)
+	{
+		task_set_cancelled(state->task, true);
+		state->task = NULL;
+	}
+
+	if (!release)
+		return;
+
+	while (state->tasks > 0)
+		task_queue_wait(IsPrefetchPending, NULL);
+
+	if (state->core)
+		dylib_close(state->core);
+	state->core = NULL;
+	state->core_loaded[0] = '\0';
+}
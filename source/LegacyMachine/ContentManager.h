@@ -0,0 +1,107 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _CONTENT_MANAGER_H
+#define _CONTENT_MANAGER_H
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <retro_miscellaneous.h>
+#include <queues/task_queue.h>
+
+#include "LegacyMachine.h"
+#include "CoreLibrary.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define CONTENT_EXT_LENGTH		32					/* Longest content file extension. */
+#define ARCHIVE_CHUNK_SIZE		(256 * 1024)		/* Bytes decompressed between CRC updates. */
+#define ARCHIVE_SLICE_SIZE		(8 * 1024 * 1024)	/* Bytes decompressed per task step. */
+#define ARCHIVE_TASK_SIZE		(16 * 1024 * 1024)	/* Members at least this large load in the background. */
+#define PREFETCH_DELAY_USEC		(250 * 1000)		/* Time a menu selection rests before it's prefetched. */
+#define PREFETCH_CHUNK_SIZE		(1024 * 1024)		/* Content bytes read per prefetch step. */
+#define PREFETCH_MAX_SIZE		(128 * 1024 * 1024)	/* Most content bytes read ahead. */
+
+/* Called once content data is ready, straight away or from the main loop for background loads. */
+typedef void (*ContentCallback)(bool loaded);
+
+/**************************************************************************************************
+ * ContentPrefetch Structure
+ *************************************************************************************************/
+
+/* Core and content highlighted in a menu, opened and read ahead on a background task. */
+typedef struct ContentPrefetch
+{
+	char			core_path[PATH_MAX_LENGTH];		/* Core waiting to be prefetched. */
+	char			content_path[PATH_MAX_LENGTH];	/* File waiting to be read ahead. */
+	char			core_loaded[PATH_MAX_LENGTH];	/* Path of the prefetched core. */
+	dylib_t			core;							/* Prefetched core library. */
+	retro_time_t	start_time;						/* When the prefetch task is started. */
+	retro_task_t*	task;							/* Latest prefetch in progress. */
+	unsigned		tasks;							/* Prefetches in progress, cancelled ones included. */
+	bool			pending;						/* Waiting for the selection to rest. */
+}
+ContentPrefetch;
+
+/**************************************************************************************************
+ * ContentManager Structure
+ *************************************************************************************************/
+
+typedef struct ContentManager
+{
+	struct retro_game_info_ext	info_ext;					/* Extended content info for cores. */
+	const struct retro_system_content_info_override* overrides;	/* Core content info overrides. */
+	char			path[PATH_MAX_LENGTH];		/* Full content path, "archive#member" for archives. */
+	char			archive_path[PATH_MAX_LENGTH];	/* Archive containing the content. */
+	char			archive_file[PATH_MAX_LENGTH];	/* Content's path inside the archive. */
+	char			dir[PATH_MAX_LENGTH];		/* Directory containing the content. */
+	char			name[PATH_MAX_LENGTH];		/* Content name without directory or extension. */
+	char			ext[CONTENT_EXT_LENGTH];	/* Lowercase content extension. */
+	void*			data;						/* Content data, mapped or allocated. */
+	size_t			size;						/* Size of the content data. */
+	void*			map;						/* File mapping backing the data, if any. */
+	size_t			map_size;					/* Size of the file mapping. */
+	uint32_t		crc;						/* CRC32 of archived content, computed while decompressing. */
+	retro_task_t*	task;						/* Background archive load in progress. */
+	ContentCallback	cb_loaded;					/* Called once content data is ready. */
+	ContentPrefetch	prefetch;					/* Menu selection being prefetched. */
+	bool			in_archive;					/* Content is an archive member. */
+	bool			persistent;					/* Data stays valid until the content is closed. */
+	bool			persistent_requested;		/* Core's override asked for persistent data. */
+	bool			loading;					/* Data is still being decompressed. */
+	bool			loaded;						/* Content is open. */
+}
+ContentManager;
+
+/**************************************************************************************************
+ * ContentManager Prototypes
+ *************************************************************************************************/
+
+RETRO_BEGIN_DECLS
+
+ContentManager* GetContentManagerContext(void);
+bool OpenContent(const char* path, const struct retro_system_info* system_info, ContentCallback cb_loaded);
+void ReleaseContentData(void);
+void CloseContent(void);
+bool DetachContentMapping(void** map, size_t* size);
+void PrefetchContent(const char* core_path, const char* content_path);
+void UpdatePrefetch(void);
+dylib_t TakePrefetchedCore(const char* core_path);
+void CancelPrefetch(bool release);
+
+RETRO_END_DECLS
+
+#endif
@@ -21,6 +21,22 @@
 
 #include "LegacyMachine.h"
 
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+/* Frontend specific environment calls shared with RetroArch. */
+#ifndef RETRO_ENVIRONMENT_RETROARCH_START_BLOCK
+#define RETRO_ENVIRONMENT_RETROARCH_START_BLOCK	0x800000
+#endif
+
+#ifndef RETRO_ENVIRONMENT_POLL_TYPE_OVERRIDE
+#define RETRO_ENVIRONMENT_POLL_TYPE_OVERRIDE	(4 | RETRO_ENVIRONMENT_RETROARCH_START_BLOCK)
+#endif
+
+/* Core poll type overrides (0 lets the frontend decide, otherwise LMC_PollType + 1). */
+#define POLL_TYPE_OVERRIDE_DONTCARE	0
+
 /**************************************************************************************************
  * CoreLibrary Structure
  *************************************************************************************************/
@@ -39,6 +55,12 @@ typedef struct
 	void (*retro_run)(void);
 	bool (*retro_load_game)(const struct retro_game_info* game);
 	void (*retro_unload_game)(void);
+	size_t (*retro_serialize_size)(void);
+	bool (*retro_serialize)(void* data, size_t size);
+	bool (*retro_unserialize)(const void* data, size_t size);
+	void* (*retro_get_memory_data)(unsigned id);
+	size_t (*retro_get_memory_size)(unsigned id);
+	retro_time_t load_time;		/* Time taken to load and initialize the core. */
 	unsigned poll_type;
 	bool initialized;
 	bool running;
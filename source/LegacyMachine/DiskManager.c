@@ -0,0 +1,350 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <formats/m3u_file.h>
+#include <string/stdstring.h>
+#include <compat/strl.h>
+
+#include "DiskManager.h"
+#include "Logging.h"
+#include "Common/FileMap.h"
+
+/**************************************************************************************************
+ * DiskManager Context
+ *************************************************************************************************/
+
+static DiskManager disk_manager = { 0 };
+
+/**************************************************************************************************
+ * Local Disk Functions
+ *************************************************************************************************/
+
+#ifdef HAVE_THREADS
+#define LockDiskImages()	slock_lock(disk_manager.lock)
+#define UnlockDiskImages()	slock_unlock(disk_manager.lock)
+#else
+#define LockDiskImages()
+#define UnlockDiskImages()
+#endif
+
+/* Checks whether a '|' separated extension list contains an extension. */
+static bool HasExtension(const char* extensions, const char* ext)
+{
+	size_t len = strlen(ext);
+	const char* p = extensions;
+
+	while (p && *p)
+	{
+		const char* end = strchr(p, '|');
+		size_t n = end ? (size_t)(end - p) : strlen(p);
+		char token[16];
+
+		if (n == len && n < sizeof(token))
+		{
+			memcpy(token, p, n);
+			token[n] = '\0';
+			if (string_is_equal_noncase(token, ext))
+				return true;
+		}
+		p = end ? end + 1 : NULL;
+	}
+	return false;
+}
+
+/* Adds an image to the current content. */
+static bool AddDiskImage(const char* path, const char* label)
+{
+	DiskImage* image;
+
+	if (disk_manager.count >= DISK_MAX_IMAGES)
+		return false;
+
+	image = (DiskImage*)calloc(1, sizeof(DiskImage));
+	if (!image)
+		return false;
+
+	strlcpy(image->path, path, sizeof(image->path));
+	if (label)
+		strlcpy(image->label, label, sizeof(image->label));
+
+	LockDiskImages();
+	disk_manager.images[disk_manager.count++] = image;
+	UnlockDiskImages();
+	return true;
+}
+
+/* Maps an image if it isn't mapped yet, called with the images locked. */
+static bool MapDiskImage(DiskImage* image)
+{
+	if (!image->map)
+		image->map = (uint8_t*)MapFileReadOnly(image->path, &image->size);
+	return image->map != NULL;
+}
+
+/* Unmaps and frees an image, called with the images locked. */
+static void FreeDiskImage(DiskImage* image)
+{
+	UnmapFileReadOnly(image->map, image->size);
+	free(image);
+}
+
+/* Background task handler, maps each image and reads its start into the page cache. */
+static void DiskTaskHandler(retro_task_t* task)
+{
+	DiskImage* image;
+	const volatile uint8_t* data;
+	size_t end;
+	size_t offset;
+	uint8_t sum = 0;
+
+	if (task_get_cancelled(task) || disk_manager.preload_image >= disk_manager.count)
+	{
+		task_set_finished(task, true);
+		return;
+	}
+
+	/* Images are only removed once this task has finished, so the mapping stays put. */
+	image = disk_manager.images[disk_manager.preload_image];
+	LockDiskImages();
+	MapDiskImage(image);
+	UnlockDiskImages();
+
+	end = image->size < DISK_PRELOAD_SIZE ? image->size : DISK_PRELOAD_SIZE;
+	if (image->map && disk_manager.preload_offset < end)
+	{
+		/* Touching a byte per page faults the pages in. */
+		offset = disk_manager.preload_offset;
+		data = image->map;
+		disk_manager.preload_offset = offset + DISK_PRELOAD_STEP < end ? offset + DISK_PRELOAD_STEP : end;
+		for (; offset < disk_manager.preload_offset; offset += DISK_PAGE_SIZE)
+			sum += data[offset];
+		(void)sum;
+	}
+
+	if (!image->map || disk_manager.preload_offset >= end)
+	{
+		disk_manager.preload_image++;
+		disk_manager.preload_offset = 0;
+	}
+
+	task_set_progress(task, (int8_t)((disk_manager.preload_image * 100) / disk_manager.count));
+}
+
+/* Background task callback. */
+static void DiskTaskCallback(retro_task_t* task, void* task_data, void* user_data, const char* error)
+{
+	disk_manager.task = NULL;
+}
+
+/* Checks whether the read ahead is still pending. */
+static bool IsDiskTaskPending(void* data)
+{
+	return disk_manager.task != NULL;
+}
+
+/**************************************************************************************************
+ * DiskManager Functions
+ *************************************************************************************************/
+
+/* Returns the current disk manager context. */
+DiskManager* GetDiskManagerContext(void)
+{
+	return &disk_manager;
+}
+
+/* Lists the disc images of content, an M3U playlist or a single image, and reads them ahead in
+ * the background. Gets the path to hand the core, the first image when it can't read playlists. */
+bool OpenDiskImages(const char* path, const char* valid_extensions, char* content_path, size_t size)
+{
+	retro_task_t* task;
+
+	CloseDiskImages();
+	if (content_path != path)
+		strlcpy(content_path, path, size);
+
+#ifdef HAVE_THREADS
+	if (!disk_manager.lock && (disk_manager.lock = slock_new()) == NULL)
+		return false;
+#endif
+
+	if (m3u_file_is_m3u(path))
+	{
+		m3u_file_t* m3u = m3u_file_init(path);
+		size_t i;
+
+		if (!m3u)
+		{
+			lmc_core_log(RETRO_LOG_ERROR, "Failed to read playlist %s", path);
+			return false;
+		}
+
+		for (i = 0; i < m3u_file_get_size(m3u); i++)
+		{
+			m3u_file_entry_t* entry = NULL;
+
+			if (m3u_file_get_entry(m3u, i, &entry) && !string_is_empty(entry->full_path) &&
+				!AddDiskImage(entry->full_path, entry->label))
+				break;
+		}
+		m3u_file_free(m3u);
+
+		if (disk_manager.count == 0)
+		{
+			lmc_core_log(RETRO_LOG_ERROR, "Playlist %s lists no images", path);
+			return false;
+		}
+
+		/* Cores that don't read playlists start on the first image and get the rest once loaded. */
+		if (!HasExtension(valid_extensions, M3U_FILE_EXT))
+		{
+			strlcpy(content_path, disk_manager.images[0]->path, size);
+			disk_manager.append = true;
+		}
+	}
+	else if (!path_contains_compressed_file(path))
+		AddDiskImage(path, NULL);
+
+	if (disk_manager.count == 0)
+		return true;
+
+	task = task_init();
+	if (task)
+	{
+		task->handler = DiskTaskHandler;
+		task->callback = DiskTaskCallback;
+		task->mute = true;
+		disk_manager.task = task;
+		if (!task_queue_push(task))
+		{
+			disk_manager.task = NULL;
+			free(task);
+		}
+	}
+	return true;
+}
+
+/* Adds the rest of a playlist to a core that was started on its first image. */
+void AppendDiskImages(void)
+{
+	unsigned i;
+
+	if (!disk_manager.append)
+		return;
+	disk_manager.append = false;
+
+	if (!disk_manager.cb.add_image_index || !disk_manager.cb.replace_image_index ||
+		!disk_manager.cb.get_num_images)
+	{
+		lmc_core_log(RETRO_LOG_WARN, "The core can't add disc images, only the first one is available");
+		return;
+	}
+
+	for (i = disk_manager.cb.get_num_images(); i < disk_manager.count; i++)
+	{
+		struct retro_game_info info = { 0 };
+
+		info.path = disk_manager.images[i]->path;
+		if (!disk_manager.cb.add_image_index() || !disk_manager.cb.replace_image_index(i, &info))
+		{
+			lmc_core_log(RETRO_LOG_WARN, "Failed to add disc image %s", info.path);
+			break;
+		}
+	}
+}
+
+/* Drops the current content's images, mappings in use by core files go with the last file. */
+void CloseDiskImages(void)
+{
+	unsigned i;
+
+	if (disk_manager.task != NULL)
+	{
+		task_set_cancelled(disk_manager.task, true);
+		while (disk_manager.task != NULL)
+			task_queue_wait(IsDiskTaskPending, NULL);
+	}
+
+	LockDiskImages();
+	for (i = 0; i < disk_manager.count; i++)
+	{
+		DiskImage* image = disk_manager.images[i];
+
+		if (image->refs == 0)
+			FreeDiskImage(image);
+		else
+			image->closed = true;
+		disk_manager.images[i] = NULL;
+	}
+	disk_manager.count = 0;
+	UnlockDiskImages();
+
+	disk_manager.preload_image = 0;
+	disk_manager.preload_offset = 0;
+	disk_manager.append = false;
+}
+
+/* Gets the mapping of a listed image for a core file, NULL if the path isn't listed. */
+DiskImage* AcquireDiskImage(const char* path)
+{
+	DiskImage* image = NULL;
+	unsigned i;
+
+#ifdef HAVE_THREADS
+	if (!disk_manager.lock)
+		return NULL;
+#endif
+
+	LockDiskImages();
+	for (i = 0; i < disk_manager.count; i++)
+	{
+		if (string_is_equal(disk_manager.images[i]->path, path))
+		{
+			if (MapDiskImage(disk_manager.images[i]))
+			{
+				image = disk_manager.images[i];
+				image->refs++;
+			}
+			break;
+		}
+	}
+	UnlockDiskImages();
+	return image;
+}
+
+/* Releases a core file's use of an image mapping. */
+void ReleaseDiskImage(DiskImage* image)
+{
+	LockDiskImages();
+	if (--image->refs == 0 && image->closed)
+		FreeDiskImage(image);
+	UnlockDiskImages();
+}
+
+/* Drops the images and frees the lock. */
+void DeinitDiskManager(void)
+{
+	CloseDiskImages();
+	memset(&disk_manager.cb, 0, sizeof(disk_manager.cb));
+#ifdef HAVE_THREADS
+	if (disk_manager.lock)
+		slock_free(disk_manager.lock);
+	disk_manager.lock = NULL;
+#endif
+}
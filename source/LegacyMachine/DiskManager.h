@@ -0,0 +1,85 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _DISK_MANAGER_H
+#define _DISK_MANAGER_H
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <retro_miscellaneous.h>
+#include <queues/task_queue.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "LegacyMachine.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define DISK_MAX_IMAGES		16					/* Most disc images listed by a playlist. */
+#define DISK_PRELOAD_SIZE	(32 * 1024 * 1024)	/* Bytes of each disc image read ahead. */
+#define DISK_PRELOAD_STEP	(4 * 1024 * 1024)	/* Bytes read ahead per task step. */
+#define DISK_PAGE_SIZE		4096
+
+/**************************************************************************************************
+ * DiskManager Structures
+ *************************************************************************************************/
+
+/* Disc image kept mapped for the session so swapping to it doesn't reopen the file. */
+typedef struct DiskImage
+{
+	char		path[PATH_MAX_LENGTH];
+	char		label[NAME_MAX_LENGTH];		/* Playlist label, empty if none. */
+	uint8_t*	map;						/* Read-only mapping of the image, NULL until indexed. */
+	size_t		size;
+	unsigned	refs;						/* Core files reading through the mapping. */
+	bool		closed;						/* Content closed, unmapped once the last file closes. */
+}
+DiskImage;
+
+typedef struct DiskManager
+{
+	struct retro_disk_control_ext_callback	cb;		/* Core's disk control, extended calls NULL for version 0. */
+	DiskImage*		images[DISK_MAX_IMAGES];		/* Images of the current content. */
+	unsigned		count;							/* Number of images. */
+	unsigned		preload_image;					/* Image being read ahead. */
+	size_t			preload_offset;					/* Next offset to read ahead. */
+	retro_task_t*	task;							/* Background read ahead. */
+	char			label[NAME_MAX_LENGTH];			/* Last label returned by LMC_GetDiskLabel(). */
+#ifdef HAVE_THREADS
+	slock_t*		lock;							/* Guards images against core file threads. */
+#endif
+	bool			append;							/* Playlist images are added to the core after loading. */
+}
+DiskManager;
+
+/**************************************************************************************************
+ * DiskManager Prototypes
+ *************************************************************************************************/
+
+RETRO_BEGIN_DECLS
+
+DiskManager* GetDiskManagerContext(void);
+bool OpenDiskImages(const char* path, const char* valid_extensions, char* content_path, size_t size);
+void AppendDiskImages(void);
+void CloseDiskImages(void);
+DiskImage* AcquireDiskImage(const char* path);
+void ReleaseDiskImage(DiskImage* image);
+void DeinitDiskManager(void);
+
+RETRO_END_DECLS
+
+#endif
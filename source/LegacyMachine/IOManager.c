@@ -0,0 +1,327 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include <file/nbio.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#include <compat/strl.h>
+
+#include "IOManager.h"
+#include "Logging.h"
+
+/**************************************************************************************************
+ * IOManager Context
+ *************************************************************************************************/
+
+static IOManager io_manager = { 0 };
+
+/**************************************************************************************************
+ * Local I/O Functions
+ *************************************************************************************************/
+
+/* Frees a request and its nbio handle. */
+static void FreeFileRequest(IORequest* request)
+{
+	if (request->nbio)
+		nbio_free(request->nbio);
+	free(request->data);
+	free(request);
+}
+
+/* Unlinks a request from a list, returns false if it isn't on the list. */
+static bool UnlinkFileRequest(IORequest** list, IORequest* request)
+{
+	for (; *list; list = &(*list)->next)
+	{
+		if (*list == request)
+		{
+			*list = request->next;
+			request->next = NULL;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Finds a request by handle on a list. */
+static IORequest* FindFileRequest(IORequest* list, int id)
+{
+	for (; list; list = list->next)
+	{
+		if (list->id == id)
+			return list;
+	}
+	return NULL;
+}
+
+/* Writes a request in one go, nbio can't report a failed resize or a short write. */
+static bool WriteFileRequest(IORequest* request)
+{
+	RFILE* file = filestream_open(request->path, RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+	bool ok;
+
+	if (!file)
+		return false;
+
+	ok = request->size == 0 || filestream_write(file, request->data, (int64_t)request->size) == (int64_t)request->size;
+	ok = filestream_flush(file) == 0 && ok;
+	ok = filestream_close(file) == 0 && ok;
+	return ok;
+}
+
+/* Background task handler. Writes run in one step, reads open the file on the first step and
+ * poll nbio on the next ones, until the whole file came in. */
+static void IOTaskHandler(retro_task_t* task)
+{
+	IORequest* request = (IORequest*)task->state;
+	size_t size = 0;
+
+	if (task_get_cancelled(task))
+	{
+		if (request->nbio)
+			nbio_cancel(request->nbio);
+		task_set_finished(task, true);
+		return;
+	}
+
+	if (request->write)
+	{
+		request->ok = WriteFileRequest(request);
+		free(request->data);
+		request->data = NULL;
+		task_set_finished(task, true);
+		return;
+	}
+
+	if (!request->nbio)
+	{
+		request->nbio = nbio_open(request->path, NBIO_READ);
+		if (!request->nbio)
+		{
+			task_set_finished(task, true);
+			return;
+		}
+
+		/* the file size, checked against the bytes read once done */
+		nbio_get_ptr(request->nbio, &request->size);
+		nbio_begin_read(request->nbio);
+		return;
+	}
+
+	if (!nbio_iterate(request->nbio))
+		return;
+
+	nbio_get_ptr(request->nbio, &size);
+	request->ok = size == request->size;
+	task_set_finished(task, true);
+}
+
+/* Background task callback, moves the request over to the completed list. */
+static void IOTaskCallback(retro_task_t* task, void* task_data, void* user_data, const char* error)
+{
+	IORequest* request = (IORequest*)user_data;
+	IORequest** tail = &io_manager.completed;
+
+	UnlinkFileRequest(&io_manager.running, request);
+	request->task = NULL;
+	io_manager.in_flight--;
+
+	while (*tail)
+		tail = &(*tail)->next;
+	*tail = request;
+}
+
+/* Checks whether requests are still on the task queue. */
+static bool HasRunningFileRequests(void* data)
+{
+	return io_manager.in_flight > 0;
+}
+
+/* Hands queued requests to the task queue while slots are free. */
+static void StartFileRequests(void)
+{
+	while (io_manager.queued && io_manager.in_flight < io_manager.max_in_flight)
+	{
+		IORequest* request = io_manager.queued;
+		retro_task_t* task = task_init();
+
+		if (!task)
+			return;
+
+		io_manager.queued = request->next;
+		request->next = io_manager.running;
+		io_manager.running = request;
+		io_manager.in_flight++;
+
+		task->handler = IOTaskHandler;
+		task->callback = IOTaskCallback;
+		task->state = request;
+		task->user_data = request;
+		task->mute = true;
+		request->task = task;
+
+		if (!task_queue_push(task))
+		{
+			free(task);
+			IOTaskCallback(NULL, NULL, request, NULL);
+		}
+	}
+}
+
+/**************************************************************************************************
+ * IOManager Functions
+ *************************************************************************************************/
+
+/* Returns the current I/O manager context. */
+IOManager* GetIOManagerContext(void)
+{
+	return &io_manager;
+}
+
+/* Queues a whole file read or write behind requests of the same or higher priority. */
+int QueueFileRequest(const char* path, bool write, const void* data, size_t size,
+	LMC_FilePriority priority, LMC_FileCallback callback, void* user_data)
+{
+	IORequest* request;
+	IORequest** link;
+
+	request = (IORequest*)calloc(1, sizeof(IORequest));
+	if (!request)
+		return -1;
+
+	if (write && size > 0)
+	{
+		/* The caller's buffer only has to live until this returns. */
+		request->data = (uint8_t*)malloc(size);
+		if (!request->data)
+		{
+			free(request);
+			return -1;
+		}
+		memcpy(request->data, data, size);
+	}
+
+	strlcpy(request->path, path, sizeof(request->path));
+	request->write = write;
+	request->size = size;
+	request->priority = priority;
+	request->callback = callback;
+	request->user_data = user_data;
+
+	if (io_manager.next_id == INT_MAX || io_manager.next_id <= 0)
+		io_manager.next_id = 1;
+	request->id = io_manager.next_id++;
+
+	link = &io_manager.queued;
+	while (*link && (*link)->priority <= priority)
+		link = &(*link)->next;
+	request->next = *link;
+	*link = request;
+
+	StartFileRequests();
+	return request->id;
+}
+
+/* Cancels a request, its callback is never called. */
+bool CancelFileRequest(int id)
+{
+	IORequest* request;
+
+	if ((request = FindFileRequest(io_manager.queued, id)) != NULL)
+	{
+		UnlinkFileRequest(&io_manager.queued, request);
+		FreeFileRequest(request);
+		return true;
+	}
+
+	if ((request = FindFileRequest(io_manager.running, id)) != NULL)
+	{
+		request->cancelled = true;
+		task_set_cancelled(request->task, true);
+		return true;
+	}
+
+	if ((request = FindFileRequest(io_manager.completed, id)) != NULL)
+	{
+		request->cancelled = true;
+		return true;
+	}
+
+	return false;
+}
+
+/* Calls back completed requests and starts queued ones, called once per frame. */
+void UpdateFileRequests(void)
+{
+	IORequest* request = io_manager.completed;
+
+	/* Callbacks may queue or cancel requests, work on a detached list. */
+	io_manager.completed = NULL;
+
+	while (request)
+	{
+		IORequest* next = request->next;
+
+		if (!request->cancelled && request->callback)
+		{
+			const void* data = NULL;
+			size_t size = request->size;
+
+			if (request->ok && !request->write)
+				data = nbio_get_ptr(request->nbio, &size);
+			if (!request->ok)
+				lmc_core_log(RETRO_LOG_WARN, "Failed to %s %s", request->write ? "write" : "read", request->path);
+
+			request->callback(request->id, data, request->ok ? size : 0, request->ok, request->user_data);
+		}
+
+		FreeFileRequest(request);
+		request = next;
+	}
+
+	StartFileRequests();
+}
+
+/* Cancels every request and waits for the running ones to stop. */
+void DeinitIOManager(void)
+{
+	IORequest* request;
+
+	while ((request = io_manager.queued) != NULL)
+	{
+		io_manager.queued = request->next;
+		FreeFileRequest(request);
+	}
+
+	for (request = io_manager.running; request; request = request->next)
+	{
+		request->cancelled = true;
+		task_set_cancelled(request->task, true);
+	}
+
+	while (io_manager.in_flight > 0)
+		task_queue_wait(HasRunningFileRequests, NULL);
+
+	while ((request = io_manager.completed) != NULL)
+	{
+		io_manager.completed = request->next;
+		FreeFileRequest(request);
+	}
+}
@@ -0,0 +1,81 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _IO_MANAGER_H
+#define _IO_MANAGER_H
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <retro_miscellaneous.h>
+#include <queues/task_queue.h>
+
+#include "LegacyMachine.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define IO_MAX_IN_FLIGHT	4		/* Default number of requests reading or writing at once. */
+#define IO_MAX_IN_FLIGHT_LIMIT	16	/* Most requests LMC_SetFileRequestLimit() allows at once. */
+
+/**************************************************************************************************
+ * IOManager Structures
+ *************************************************************************************************/
+
+/* Asynchronous whole file read or write. */
+typedef struct IORequest
+{
+	char				path[PATH_MAX_LENGTH];
+	int					id;					/* Handle returned to the caller. */
+	LMC_FilePriority	priority;
+	bool				write;
+	uint8_t*			data;				/* Copy of the data to write, freed once written. */
+	size_t				size;
+	void*				nbio;				/* nbio handle of a read, opened on the task thread. */
+	bool				ok;					/* Set by the task once every byte was read or written. */
+	bool				cancelled;			/* Completes without calling back. */
+	LMC_FileCallback	callback;
+	void*				user_data;
+	retro_task_t*		task;				/* Task running the request, NULL while queued. */
+	struct IORequest*	next;
+}
+IORequest;
+
+typedef struct IOManager
+{
+	IORequest*	queued;				/* Requests waiting for a slot, highest priority first. */
+	IORequest*	running;			/* Requests on the task queue. */
+	IORequest*	completed;			/* Requests waiting for their callback, in completion order. */
+	unsigned	in_flight;			/* Requests on the task queue. */
+	unsigned	max_in_flight;		/* Requests allowed on the task queue at once. */
+	int			next_id;
+}
+IOManager;
+
+/**************************************************************************************************
+ * IOManager Prototypes
+ *************************************************************************************************/
+
+RETRO_BEGIN_DECLS
+
+IOManager* GetIOManagerContext(void);
+int QueueFileRequest(const char* path, bool write, const void* data, size_t size,
+	LMC_FilePriority priority, LMC_FileCallback callback, void* user_data);
+bool CancelFileRequest(int id);
+void UpdateFileRequests(void);
+void DeinitIOManager(void);
+
+RETRO_END_DECLS
+
+#endif
@@ -28,6 +28,38 @@ SDL_Joystick* joystick[MAX_PLAYERS];
 
 static JoypadDriver joypad = { 0 };
 
+/* Joypad hotplug progress. */
+typedef enum
+{
+	HOTPLUG_IDLE,		/* Slot is free. */
+	HOTPLUG_PENDING,	/* Waiting for the hotplug thread to open and configure the device. */
+	HOTPLUG_READY		/* Configured, waiting to be published on the emulation thread. */
+}
+HotplugStatus;
+
+/* A joypad being connected on behalf of a player. */
+typedef struct JoypadHotplug
+{
+	JoypadInputState state;		/* Staged input state, configured off the emulation thread. */
+	SDL_Joystick*	 joystick;	/* Device opened by the hotplug thread. */
+	SDL_JoystickID	 instance;	/* Instance id of the device being connected. */
+	int				 device;	/* Device index of the device being connected. */
+	bool			 configured;	/* Auto-configuration callback mapped the staged state. */
+	SDL_atomic_t	 removed;	/* Device was removed before being published. */
+	SDL_atomic_t	 status;	/* HotplugStatus. */
+}
+JoypadHotplug;
+
+/* Joypad hotplug variables */
+
+static JoypadHotplug	hotplug[MAX_PLAYERS];
+static SDL_Thread*		hotplug_thread = NULL;
+static SDL_mutex*		hotplug_lock = NULL;
+static SDL_cond*		hotplug_cond = NULL;
+static SDL_threadID		hotplug_thread_id = 0;
+static bool				hotplug_running = false;
+static int				hotplug_player = -1;
+
 /**************************************************************************************************
  * Prototypes
  *************************************************************************************************/
@@ -36,8 +68,8 @@ static JoypadDriver joypad = { 0 };
 
 static void SDL2_InitializeJoypad(void);
 static void SDL2_DeinitializeJoypad(LMC_Player player);
-static void SDL2_ConnectJoypad(LMC_Player player);
-static void SDL2_DisconnectJoypad(LMC_Player player);
+static void SDL2_ConnectJoypad(int device);
+static void SDL2_DisconnectJoypad(int instance);
 
 /**************************************************************************************************
  * Local Joypad Functions
@@ -49,6 +81,97 @@ static JoypadInputState* GetJoypadInputState(LMC_Player player)
 	return &legacy_machine->input->joypad->state[player];
 }
 
+/* Open a staged joypad and let the frontend configure it, runs on the hotplug thread. */
+static void OpenHotplugJoypad(LMC_Player player)
+{
+	JoypadHotplug* slot = &hotplug[player];
+	JoypadInputState* joypad_state = &slot->state;
+
+	slot->joystick = SDL_JoystickOpen(slot->device);
+
+	/* Device indices shift as devices come and go, make sure we got the one that was added. */
+	if (slot->joystick != NULL && SDL_JoystickInstanceID(slot->joystick) != slot->instance)
+	{
+		SDL_JoystickClose(slot->joystick);
+		slot->joystick = NULL;
+	}
+
+	if (slot->joystick == NULL)
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Couldn't open joystick #%i: %s\n", slot->device, SDL_GetError());
+		return;
+	}
+
+	joypad_state->identifier = slot->instance;
+	joypad_state->vendor = SDL_JoystickGetVendor(slot->joystick);
+	joypad_state->product = SDL_JoystickGetProduct(slot->joystick);
+	joypad_state->name = SDL_JoystickName(slot->joystick);
+
+	joypad_state->buttons = SDL_JoystickNumButtons(slot->joystick);
+	joypad_state->axes = SDL_JoystickNumAxes(slot->joystick);
+	joypad_state->hats = SDL_JoystickNumHats(slot->joystick);
+
+	/* The analog response table is shared with the live state, a reconfigured one gets its own. */
+	joypad_state->analog_response = NULL;
+
+	if (legacy_machine->input->cb_auto_config != NULL)
+	{
+		hotplug_player = player;
+		legacy_machine->input->cb_auto_config(player, joypad_state->name, joypad_state->vendor, joypad_state->product);
+		hotplug_player = -1;
+		slot->configured = true;
+	}
+
+	lmc_trace(LMC_LOG_VERBOSE, "Joypad initialized (name: %s, vendor id: %i, product id: %i, buttons: %i, hats: %i, axes: %i)",
+		joypad_state->name, joypad_state->vendor, joypad_state->product, joypad_state->buttons, joypad_state->hats, joypad_state->axes);
+
+	joypad_state->connected = true;
+}
+
+/* Hotplug thread, opens and configures joypads so the emulation thread never waits on a device. */
+static int HotplugThread(void* data)
+{
+	unsigned i;
+
+	SDL_LockMutex(hotplug_lock);
+	while (hotplug_running)
+	{
+		for (i = 0; i < MAX_PLAYERS; i++)
+		{
+			if (SDL_AtomicGet(&hotplug[i].status) == HOTPLUG_PENDING)
+				break;
+		}
+
+		if (i == MAX_PLAYERS)
+		{
+			SDL_CondWait(hotplug_cond, hotplug_lock);
+			continue;
+		}
+
+		SDL_UnlockMutex(hotplug_lock);
+		OpenHotplugJoypad((LMC_Player)i);
+		SDL_AtomicSet(&hotplug[i].status, HOTPLUG_READY);
+		SDL_LockMutex(hotplug_lock);
+	}
+	SDL_UnlockMutex(hotplug_lock);
+
+	return 0;
+}
+
+/* Get the state mapping changes apply to for a given player. */
+static JoypadInputState* SDL2_GetJoypadConfigState(LMC_Player player)
+{
+	/* Without a hotplug thread the joypad is configured synchronously on the calling thread. */
+	if (hotplug_thread == NULL)
+	{
+		if (hotplug_player == (int)player)
+			return &hotplug[player].state;
+	}
+	else if (SDL_ThreadID() == hotplug_thread_id && hotplug_player == (int)player)
+		return &hotplug[player].state;
+	return GetJoypadInputState(player);
+}
+
 /**************************************************************************************************
  * SDL Joypad Functions
  *************************************************************************************************/
@@ -71,6 +194,22 @@ static void SDL2_InitializeJoypad(void)
 			return;
 	}
 
+	for (i = 0; i < MAX_PLAYERS; i++)
+		SDL_AtomicSet(&hotplug[i].status, HOTPLUG_IDLE);
+
+	/* Without a hotplug thread joypads are still connected, just synchronously. */
+	hotplug_lock = SDL_CreateMutex();
+	hotplug_cond = SDL_CreateCond();
+	if (hotplug_lock != NULL && hotplug_cond != NULL)
+	{
+		hotplug_running = true;
+		hotplug_thread = SDL_CreateThread(HotplugThread, "JoypadHotplug", NULL);
+		if (hotplug_thread != NULL)
+			hotplug_thread_id = SDL_GetThreadID(hotplug_thread);
+		else
+			hotplug_running = false;
+	}
+
 	num_joysticks = SDL_NumJoysticks();
 	if (num_joysticks > MAX_PLAYERS)
 		num_joysticks = MAX_PLAYERS;
@@ -87,6 +226,8 @@ static void SDL2_DeinitializeJoypad(LMC_Player player)
 	JoypadInputState* joypad_state = GetJoypadInputState(player);
 
 	memset(&joypad_state->button_map, 0, MAX_INPUTS);
+	memset(&joypad_state->axis_values, 0, sizeof(joypad_state->axis_values));
+	UpdateInputLookups(player);
 	joypad_state->name = NULL;
 	joypad_state->inputs = 0;
 	joypad_state->product = 0;
@@ -94,65 +235,155 @@ static void SDL2_DeinitializeJoypad(LMC_Player player)
 	joypad_state->buttons = 0;
 	joypad_state->axes = 0;
 	joypad_state->hats = 0;
-	joypad_state->identifier = 0;
+	joypad_state->identifier = -1;
 	joypad_state->connected = false;
 	joystick[player] = NULL;
 }
 
-/* Get the human readable text name of a given player's joypad. */
-static const char* SDL2_GetJoypadName(LMC_Player player)
+/* Copies the device and its auto-configured joypad mapping from a staged state to the live one.
+ * Keyboard mapping and mappings defined while the device was being opened stay as they are. */
+static void PublishJoypad(LMC_Player player, JoypadHotplug* slot)
 {
-	if ((player >= MAX_PLAYERS) || (joystick[player] == NULL))
-		return NULL;
-	return SDL_JoystickNameForIndex(player);
+	JoypadInputState* joypad_state = GetJoypadInputState(player);
+	const JoypadInputState* staged = &slot->state;
+
+	joypad_state->identifier = staged->identifier;
+	joypad_state->vendor = staged->vendor;
+	joypad_state->product = staged->product;
+	joypad_state->name = staged->name;
+	joypad_state->buttons = staged->buttons;
+	joypad_state->axes = staged->axes;
+	joypad_state->hats = staged->hats;
+	memset(joypad_state->axis_values, 0, sizeof(joypad_state->axis_values));
+
+	if (slot->configured)
+	{
+		memcpy(joypad_state->button_map, staged->button_map, sizeof(joypad_state->button_map));
+		memcpy(joypad_state->hat_map, staged->hat_map, sizeof(joypad_state->hat_map));
+		memcpy(joypad_state->axis_map, staged->axis_map, sizeof(joypad_state->axis_map));
+		memcpy(joypad_state->analog_map, staged->analog_map, sizeof(joypad_state->analog_map));
+		joypad_state->analog_deadzone = staged->analog_deadzone;
+		joypad_state->analog_sensitivity = staged->analog_sensitivity;
+		joypad_state->analog_curve = staged->analog_curve;
+	}
+
+	/* Keep the live response table unless auto-configuration built a new one. */
+	if (staged->analog_response != NULL)
+	{
+		free(joypad_state->analog_response);
+		joypad_state->analog_response = staged->analog_response;
+	}
+
+	UpdateInputLookups(player);
+	joypad_state->connected = true;
 }
 
-/* Initialize a given player's joypad when connected. */
-static void SDL2_ConnectJoypad(LMC_Player player)
+/* Publish joypads configured by the hotplug thread, runs on the emulation thread between frames. */
+static void SDL2_UpdateJoypad(void)
 {
-	JoypadInputState* joypad_state = GetJoypadInputState(player);
-	bool ok = false;
-
-	joystick[player] = SDL_JoystickOpen(player);
-	ok = joystick[player] != NULL;
+	unsigned i;
 
-	if (!ok)
+	for (i = 0; i < MAX_PLAYERS; i++)
 	{
-		lmc_trace(LMC_LOG_ERRORS, "Couldn't open joystick #%u: %s\n", player, SDL_GetError());
+		JoypadHotplug* slot = &hotplug[i];
 
-		if (joystick[player])
-			SDL_JoystickClose(joystick[player]);
+		if (SDL_AtomicGet(&slot->status) != HOTPLUG_READY)
+			continue;
 
-		joystick[player] = NULL;
+		if (slot->joystick == NULL || SDL_AtomicGet(&slot->removed))
+		{
+			if (slot->joystick != NULL)
+				SDL_JoystickClose(slot->joystick);
+			free(slot->state.analog_response);
+		}
+		else
+		{
+			PublishJoypad((LMC_Player)i, slot);
+			joystick[i] = slot->joystick;
+		}
 
-		return;
+		slot->joystick = NULL;
+		SDL_AtomicSet(&slot->status, HOTPLUG_IDLE);
 	}
+}
 
-	joypad_state->vendor = SDL_JoystickGetDeviceVendor(player);
-	joypad_state->product = SDL_JoystickGetDeviceProduct(player);
-	joypad_state->name = SDL2_GetJoypadName(player);
+/* Connect a newly added joypad device to the first free player. */
+static void SDL2_ConnectJoypad(int device)
+{
+	SDL_JoystickID instance = SDL_JoystickGetDeviceInstanceID(device);
+	int player = -1;
+	unsigned i;
 
-	joypad_state->buttons = SDL_JoystickNumButtons(joystick[player]);
-	joypad_state->axes = SDL_JoystickNumAxes(joystick[player]);
-	joypad_state->hats = SDL_JoystickNumHats(joystick[player]);
+	if (instance < 0)
+		return;
 
-	lmc_trace(LMC_LOG_VERBOSE, "Joypad initialized (name: %s, vendor id: %i, product id: %i, buttons: %i, hats: %i, axes: %i)",
-		joypad_state->name, joypad_state->vendor, joypad_state->product, joypad_state->buttons, joypad_state->hats, joypad_state->axes);
+	/* Devices present at startup are enumerated and also reported as added. */
+	for (i = 0; i < MAX_PLAYERS; i++)
+	{
+		JoypadInputState* joypad_state = GetJoypadInputState((LMC_Player)i);
 
-	joypad_state->connected = true;
+		if (SDL_AtomicGet(&hotplug[i].status) != HOTPLUG_IDLE)
+		{
+			if (hotplug[i].instance == instance && !SDL_AtomicGet(&hotplug[i].removed))
+				return;
+		}
+		else if (joypad_state->connected || joystick[i] != NULL)
+		{
+			if (joypad_state->identifier == instance)
+				return;
+		}
+		else if (player < 0)
+			player = i;
+	}
+
+	if (player < 0)
+	{
+		lmc_trace(LMC_LOG_VERBOSE, "No free player for joystick #%i\n", device);
+		return;
+	}
+
+	/* Stage a copy of the player's mappings, the hotplug thread fills in the device. */
+	hotplug[player].state = *GetJoypadInputState((LMC_Player)player);
+	hotplug[player].joystick = NULL;
+	hotplug[player].configured = false;
+	hotplug[player].instance = instance;
+	hotplug[player].device = device;
+	SDL_AtomicSet(&hotplug[player].removed, 0);
+	SDL_AtomicSet(&hotplug[player].status, HOTPLUG_PENDING);
+
+	if (hotplug_thread != NULL)
+	{
+		SDL_LockMutex(hotplug_lock);
+		SDL_CondSignal(hotplug_cond);
+		SDL_UnlockMutex(hotplug_lock);
+	}
+	else
+	{
+		OpenHotplugJoypad((LMC_Player)player);
+		SDL_AtomicSet(&hotplug[player].status, HOTPLUG_READY);
+		SDL2_UpdateJoypad();
+	}
 }
 
-/* Deinitialize a given player's joypad when disconnected. */
-static void SDL2_DisconnectJoypad(LMC_Player player)
+/* Disconnect a removed joypad device from its player. */
+static void SDL2_DisconnectJoypad(int instance)
 {
-	JoypadInputState* joypad_state = GetJoypadInputState(player);
+	unsigned i;
 
-	if (joystick[player])
+	for (i = 0; i < MAX_PLAYERS; i++)
 	{
-		SDL_JoystickClose(joystick[player]);
+		JoypadInputState* joypad_state = GetJoypadInputState((LMC_Player)i);
+
+		/* Still being connected, discard it once the hotplug thread is done. */
+		if (SDL_AtomicGet(&hotplug[i].status) != HOTPLUG_IDLE && hotplug[i].instance == instance)
+			SDL_AtomicSet(&hotplug[i].removed, 1);
+
+		if (joystick[i] != NULL && joypad_state->identifier == instance)
+		{
+			SDL_JoystickClose(joystick[i]);
+			SDL2_DeinitializeJoypad((LMC_Player)i);
+		}
 	}
-	SDL2_DeinitializeJoypad(player);
-	joypad_state->connected = false;
 }
 
 /* Assign input to a player's joypad. */
@@ -168,23 +399,15 @@ static void SDL2_AssignInputJoypad(LMC_Player player, int index)
 	if (index >= 0)
 	{
 		joystick[player] = SDL_JoystickOpen(index);
-		joypad_state->identifier = SDL_JoystickInstanceID(joystick[player]);
+		if (joystick[player] != NULL)
+			joypad_state->identifier = SDL_JoystickInstanceID(joystick[player]);
 	}
 }
 
 /* Process keyboard input. */
 static void SDL2_ProcessJoypadKeycodeInput(LMC_Player player, int32_t keycode, uint8_t state)
 {
-	JoypadInputState* joypad_state = GetJoypadInputState(player);
-	LMC_Input input = LMC_INPUT_NONE;
-	int i;
-
-	/* Search input. */
-	for (i = LMC_INPUT_B; i < MAX_INPUTS && input == LMC_INPUT_NONE; i++)
-	{
-		if (joypad_state->key_map[i] == (SDL_Keycode)keycode)
-			input = (LMC_Input)i;
-	}
+	LMC_Input input = GetKeyInput(player, (uint32_t)keycode);
 
 	/* Update. */
 	if (input != LMC_INPUT_NONE)
@@ -200,15 +423,7 @@ static void SDL2_ProcessJoypadKeycodeInput(LMC_Player player, int32_t keycode, u
 static void SDL2_ProcessJoypadButtonInput(LMC_Player player, uint8_t button, uint8_t state)
 {
 	JoypadInputState* joypad_state = GetJoypadInputState(player);
-	LMC_Input input = LMC_INPUT_NONE;
-	int i;
-
-	/* Search input. */
-	for (i = LMC_INPUT_B; i < MAX_INPUTS && input == LMC_INPUT_NONE; i++)
-	{
-		if (joypad_state->button_map[i] == button)
-			input = (LMC_Input)i;
-	}
+	LMC_Input input = (LMC_Input)joypad_state->button_lookup[button];
 
 	/* Update. */
 	if (input != LMC_INPUT_NONE)
@@ -252,6 +467,7 @@ static void SDL2_ProcessJoypadAxisInput(LMC_Player player, uint8_t axis, int val
 
 	if (axis < MAX_AXES)
 	{
+		joypad_state->axis_values[axis] = (int16_t)value;
 		ClearInput(player, joypad_state->axis_map[axis][LMC_AXIS_POS]);
 		ClearInput(player, joypad_state->axis_map[axis][LMC_AXIS_NEG]);
 		if (value > 1000)
@@ -264,31 +480,180 @@ static void SDL2_ProcessJoypadAxisInput(LMC_Player player, uint8_t axis, int val
 /* Poll all joypad input. */
 static void SDL2_PollJoypadInput(void)
 {
-	/* All input polling is currently handled in the event handler. */
+	const Uint8* keyboard = SDL_GetKeyboardState(NULL);
+	unsigned player;
+	int i, j;
+
+	/* Rebuild each player's inputs from the current device state, mirroring the event handlers. */
+	for (player = LMC_PLAYER1; player < MAX_PLAYERS; player++)
+	{
+		JoypadInputState* joypad_state = GetJoypadInputState((LMC_Player)player);
+		uint32_t inputs = 0;
+
+		if (joypad_state->keyboard_enabled)
+		{
+			for (i = LMC_INPUT_B; i < MAX_INPUTS; i++)
+			{
+				if (joypad_state->key_map[i] && keyboard[SDL_GetScancodeFromKey((SDL_Keycode)joypad_state->key_map[i])])
+					inputs |= (1 << i);
+			}
+		}
+
+		if (joypad_state->connected && joystick[player] != NULL)
+		{
+			for (j = 0; j < joypad_state->buttons; j++)
+			{
+				if (SDL_JoystickGetButton(joystick[player], j))
+					inputs |= (1 << joypad_state->button_lookup[j]);
+			}
+
+			for (j = 0; j < joypad_state->hats && j < MAX_HATS; j++)
+			{
+				switch (SDL_JoystickGetHat(joystick[player], j))
+				{
+				case SDL_HAT_UP:
+					inputs |= (1 << joypad_state->hat_map[j][LMC_HAT_UP]);
+					break;
+				case SDL_HAT_RIGHT:
+					inputs |= (1 << joypad_state->hat_map[j][LMC_HAT_RIGHT]);
+					break;
+				case SDL_HAT_DOWN:
+					inputs |= (1 << joypad_state->hat_map[j][LMC_HAT_DOWN]);
+					break;
+				case SDL_HAT_LEFT:
+					inputs |= (1 << joypad_state->hat_map[j][LMC_HAT_LEFT]);
+					break;
+				}
+			}
+
+			for (j = 0; j < joypad_state->axes && j < MAX_AXES; j++)
+			{
+				Sint16 value = SDL_JoystickGetAxis(joystick[player], j);
+				joypad_state->axis_values[j] = value;
+				if (value > 1000)
+					inputs |= (1 << joypad_state->axis_map[j][LMC_AXIS_POS]);
+				else if (value < -1000)
+					inputs |= (1 << joypad_state->axis_map[j][LMC_AXIS_NEG]);
+			}
+		}
+
+		/* Unmapped buttons, hats and axes resolve to LMC_INPUT_NONE. */
+		inputs &= ~(1 << LMC_INPUT_NONE);
+
+		/* Report newly pressed inputs the same way the event handlers do. */
+		for (i = LMC_INPUT_B; i < MAX_INPUTS; i++)
+		{
+			if ((inputs & ~joypad_state->inputs) & (1 << i))
+				legacy_machine->input->last_input = i;
+		}
+
+		joypad_state->inputs = inputs;
+	}
 }
 
 /* Get joypad's state on a given port. */
 static int16_t SDL2_JoypadState(unsigned port, unsigned device, unsigned index, unsigned id)
 {
-	JoypadInputState* joypad_state = GetJoypadInputState((LMC_Player)port);
+	JoypadInputState* joypad_state;
 
 	if (port >= MAX_PLAYERS)
 		return 0;
 
+	joypad_state = GetJoypadInputState((LMC_Player)port);
+
+	/* All buttons at once, LMC_INPUT_B (bit 1) lines up with RETRO_DEVICE_ID_JOYPAD_B (bit 0). */
+	if (id == RETRO_DEVICE_ID_JOYPAD_MASK)
+		return (int16_t)((joypad_state->inputs >> 1) & 0xFFFF);
+
 	return (int16_t)(joypad_state->inputs & (1 << ((id + 1) & INPUT_MASK)));
 }
 
+/* Get the analog stick state on a given port. */
+static int16_t SDL2_AnalogState(unsigned port, unsigned index, unsigned id)
+{
+	JoypadInputState* joypad_state;
+
+	if (port >= MAX_PLAYERS)
+		return 0;
+
+	joypad_state = GetJoypadInputState((LMC_Player)port);
+
+	/* Analog buttons report full pressure for digital inputs. */
+	if (index == RETRO_DEVICE_INDEX_ANALOG_BUTTON)
+		return (joypad_state->inputs & (1 << ((id + 1) & INPUT_MASK))) ? 0x7FFF : 0;
+
+	if (index >= MAX_ANALOG_STICKS || id >= MAX_ANALOG_AXES)
+		return 0;
+
+	/* Deadzone, sensitivity and curve are baked into the response table. */
+	return joypad_state->analog_response[(uint16_t)joypad_state->axis_values[joypad_state->analog_map[index][id]]];
+}
+
 /* Close all joypads. */
 static void SDL2_CloseJoypad(void)
 {
 	unsigned i;
+
+	if (hotplug_thread != NULL)
+	{
+		SDL_LockMutex(hotplug_lock);
+		hotplug_running = false;
+		SDL_CondSignal(hotplug_cond);
+		SDL_UnlockMutex(hotplug_lock);
+		SDL_WaitThread(hotplug_thread, NULL);
+		hotplug_thread = NULL;
+	}
+
+	/* Drop joypads that were never published. */
+	for (i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (SDL_AtomicGet(&hotplug[i].status) != HOTPLUG_IDLE)
+			SDL_AtomicSet(&hotplug[i].removed, 1);
+	}
+	SDL2_UpdateJoypad();
+
 	for (i = 0; i < MAX_PLAYERS; i++)
-		SDL2_DisconnectJoypad(i);
+	{
+		if (joystick[i] != NULL)
+			SDL_JoystickClose(joystick[i]);
+		SDL2_DeinitializeJoypad((LMC_Player)i);
+	}
+
+	if (hotplug_cond != NULL)
+		SDL_DestroyCond(hotplug_cond);
+	if (hotplug_lock != NULL)
+		SDL_DestroyMutex(hotplug_lock);
+	hotplug_cond = NULL;
+	hotplug_lock = NULL;
 }
 
 /* Input initialization. */
 static void SDL2_InitializeInput(void)
 {
+	unsigned i;
+
+	/* Start every player with lookup tables that match their (empty) input maps. */
+	for (i = LMC_PLAYER1; i < MAX_PLAYERS; i++)
+	{
+		JoypadInputState* joypad_state = GetJoypadInputState((LMC_Player)i);
+
+		UpdateInputLookups((LMC_Player)i);
+
+		/* Default to a raw linear analog response with XInput style stick axes, unless the
+		 * frontend already configured one. */
+		if (joypad_state->analog_response == NULL)
+		{
+			joypad_state->analog_deadzone = 0.0f;
+			joypad_state->analog_sensitivity = 1.0f;
+			joypad_state->analog_curve = LMC_ANALOG_LINEAR;
+			joypad_state->analog_map[LMC_ANALOG_LEFT][LMC_ANALOG_X] = 0;
+			joypad_state->analog_map[LMC_ANALOG_LEFT][LMC_ANALOG_Y] = 1;
+			joypad_state->analog_map[LMC_ANALOG_RIGHT][LMC_ANALOG_X] = 3;
+			joypad_state->analog_map[LMC_ANALOG_RIGHT][LMC_ANALOG_Y] = 4;
+			UpdateAnalogResponse((LMC_Player)i);
+		}
+	}
+
 	/* Enable keyboard input for PLAYER 1 by default. */
 	LMC_EnableKeyboardAsJoypadInput(LMC_PLAYER1, true);
 
@@ -314,7 +679,10 @@ static void SDL2_InitializeInput(void)
 /* Poll all input. */
 static void SDL2_PollInput(void)
 {
-	/* All input polling is currently handled in the event handler. */
+	/* Pump the event loop so keyboard and joystick state is current, leaving events queued for
+	 * the window driver. */
+	SDL_PumpEvents();
+	legacy_machine->input->joypad->cb_poll();
 }
 
 /* Get the input state on a given port. */
@@ -325,6 +693,9 @@ static int16_t SDL2_InputState(unsigned port, unsigned device, unsigned index, u
 	case RETRO_DEVICE_JOYPAD:
 		return SDL2_JoypadState(port, device, index, id);
 		break;
+	case RETRO_DEVICE_ANALOG:
+		return SDL2_AnalogState(port, index, id);
+		break;
 	}
 	return 0;
 }
@@ -332,7 +703,17 @@ static int16_t SDL2_InputState(unsigned port, unsigned device, unsigned index, u
 /* Close all input. */
 static void SDL2_CloseInput(void)
 {
+	unsigned i;
+
 	SDL2_CloseJoypad();
+
+	for (i = LMC_PLAYER1; i < MAX_PLAYERS; i++)
+	{
+		JoypadInputState* joypad_state = GetJoypadInputState((LMC_Player)i);
+
+		free(joypad_state->analog_response);
+		joypad_state->analog_response = NULL;
+	}
 }
 
 /**************************************************************************************************
@@ -350,6 +731,8 @@ JoypadDriver sdl2_joypad_driver = {
 	SDL2_AssignInputJoypad,
 	SDL2_ConnectJoypad,
 	SDL2_DisconnectJoypad,
+	SDL2_UpdateJoypad,
+	SDL2_GetJoypadConfigState,
 	SDL2_CloseJoypad,
 	0,
 	false
@@ -362,7 +745,10 @@ InputDriver sdl2_input_driver = {
 	SDL2_InputState,
 	SDL2_CloseInput,
 	NULL,
+	(1 << RETRO_DEVICE_JOYPAD) | (1 << RETRO_DEVICE_ANALOG),
 	0,
 	0,
+	LMC_POLL_NORMAL,
+	false,
 	false
 };
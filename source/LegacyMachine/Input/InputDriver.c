@@ -14,6 +14,10 @@
 /**************************************************************************************************
  * Includes
  *************************************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
 #include "InputDriver.h"
 #include "../MainEngine.h"
 
@@ -41,12 +45,132 @@ InputDriver* InitializeInputDriver(void)
 /* Marks input as pressed. */
 void SetInput(LMC_Player player, LMC_Input input)
 {
-	legacy_machine->input->joypad->state->inputs |= (1 << input);
+	legacy_machine->input->joypad->state[player].inputs |= (1 << input);
 	legacy_machine->input->last_input = input;
 }
 
 /* Marks input as unpressed. */
 void ClearInput(LMC_Player player, LMC_Input input)
 {
-	legacy_machine->input->joypad->state->inputs &= ~(1 << input);
-}
\ No newline at end of file
+	legacy_machine->input->joypad->state[player].inputs &= ~(1 << input);
+}
+
+/* Gets the state mapping changes apply to, a staged copy while the player's joypad is being
+ * auto-configured off the emulation thread. */
+JoypadInputState* GetJoypadConfigState(LMC_Player player)
+{
+	JoypadDriver* joypad = legacy_machine->input->joypad;
+
+	if (joypad->cb_get_config != NULL)
+		return joypad->cb_get_config(player);
+	return &joypad->state[player];
+}
+
+/**************************************************************************************************
+ * InputDriver Lookup Tables
+ *************************************************************************************************/
+
+/* Hashes a keycode into the keycode lookup table. */
+static unsigned HashKeycode(uint32_t keycode)
+{
+	return (keycode * 2654435761u) >> 26 & KEY_LOOKUP_MASK;
+}
+
+/* Rebuilds a player's keycode and button reverse lookup tables from the input maps. */
+void UpdateInputLookups(LMC_Player player)
+{
+	JoypadInputState* joypad_state = GetJoypadConfigState(player);
+	int i;
+
+	memset(joypad_state->key_lookup, 0, sizeof(joypad_state->key_lookup));
+	memset(joypad_state->button_lookup, LMC_INPUT_NONE, sizeof(joypad_state->button_lookup));
+
+	/* Walk backwards so the lowest input wins when several share a key or button. */
+	for (i = MAX_INPUTS - 1; i >= LMC_INPUT_B; i--)
+	{
+		uint32_t keycode = joypad_state->key_map[i];
+
+		joypad_state->button_lookup[joypad_state->button_map[i]] = (uint8_t)i;
+
+		if (keycode != 0)
+		{
+			unsigned slot = HashKeycode(keycode);
+
+			while (joypad_state->key_lookup[slot].keycode != 0 &&
+				joypad_state->key_lookup[slot].keycode != keycode)
+				slot = (slot + 1) & KEY_LOOKUP_MASK;
+
+			joypad_state->key_lookup[slot].keycode = keycode;
+			joypad_state->key_lookup[slot].input = (uint8_t)i;
+		}
+	}
+}
+
+/* Gets the input a keycode is mapped to for a given player. */
+LMC_Input GetKeyInput(LMC_Player player, uint32_t keycode)
+{
+	const KeyLookup* key_lookup = legacy_machine->input->joypad->state[player].key_lookup;
+	unsigned slot = HashKeycode(keycode);
+
+	if (keycode == 0)
+		return LMC_INPUT_NONE;
+
+	while (key_lookup[slot].keycode != 0)
+	{
+		if (key_lookup[slot].keycode == keycode)
+			return (LMC_Input)key_lookup[slot].input;
+		slot = (slot + 1) & KEY_LOOKUP_MASK;
+	}
+
+	return LMC_INPUT_NONE;
+}
+
+/* Rebuilds a player's analog response table from its deadzone, sensitivity and curve. */
+bool UpdateAnalogResponse(LMC_Player player)
+{
+	JoypadInputState* joypad_state = GetJoypadConfigState(player);
+	const float deadzone = joypad_state->analog_deadzone;
+	int value;
+
+	if (joypad_state->analog_response == NULL)
+	{
+		joypad_state->analog_response = (int16_t*)malloc(ANALOG_RESPONSE_SIZE * sizeof(int16_t));
+		if (joypad_state->analog_response == NULL)
+			return false;
+	}
+
+	/* Entries are indexed by the raw axis value reinterpreted as unsigned. */
+	for (value = -32768; value <= 32767; value++)
+	{
+		float magnitude = fabsf((float)value) / 32767.0f;
+
+		if (magnitude > 1.0f)
+			magnitude = 1.0f;
+
+		if (magnitude <= deadzone)
+			magnitude = 0.0f;
+		else
+			magnitude = (magnitude - deadzone) / (1.0f - deadzone);
+
+		switch (joypad_state->analog_curve)
+		{
+		case LMC_ANALOG_QUADRATIC:
+			magnitude = magnitude * magnitude;
+			break;
+		case LMC_ANALOG_CUBIC:
+			magnitude = magnitude * magnitude * magnitude;
+			break;
+		default:
+			break;
+		}
+
+		magnitude *= joypad_state->analog_sensitivity;
+		if (magnitude > 1.0f)
+			magnitude = 1.0f;
+
+		joypad_state->analog_response[(uint16_t)value] =
+			(int16_t)(value < 0 ? -magnitude * 32767.0f : magnitude * 32767.0f);
+	}
+
+	return true;
+}
@@ -26,7 +26,21 @@
 #define MAX_INPUTS		  32	/* Number of inputs per player. */
 #define MAX_HATS		   2	/* Number of hats per player. */
 #define MAX_AXES		   8	/* Number of axes per player. */
+#define MAX_BUTTONS		 256	/* Number of addressable buttons per joypad. */
+#define KEY_LOOKUP_SIZE	  64	/* Number of keycode lookup slots per player (power of two). */
 #define INPUT_MASK	(MAX_INPUTS - 1)
+#define KEY_LOOKUP_MASK	(KEY_LOOKUP_SIZE - 1)
+#define ANALOG_RESPONSE_SIZE	65536	/* One analog response entry per raw axis value. */
+
+/**************************************************************************************************
+ * KeyLookup Structure
+ *************************************************************************************************/
+typedef struct KeyLookup
+{
+	uint32_t keycode;	/* Mapped keycode, 0 marks an empty slot. */
+	uint8_t input;		/* Input the keycode is mapped to. */
+}
+KeyLookup;
 
 /**************************************************************************************************
  * JoypadInputState Structure
@@ -34,16 +48,24 @@
 typedef struct JoypadInputState
 {
 	uint32_t key_map[MAX_INPUTS];
+	KeyLookup key_lookup[KEY_LOOKUP_SIZE];
 	uint32_t inputs;
 	int32_t product;
 	int32_t vendor;
 	uint8_t button_map[MAX_INPUTS];
+	uint8_t button_lookup[MAX_BUTTONS];
 	uint8_t hat_map[MAX_HATS][MAX_HAT_INPUTS];
 	uint8_t axis_map[MAX_AXES][MAX_AXIS_INPUTS];
+	uint8_t analog_map[MAX_ANALOG_STICKS][MAX_ANALOG_AXES];
+	int16_t axis_values[MAX_AXES];
+	int16_t* analog_response;
+	float analog_deadzone;
+	float analog_sensitivity;
+	LMC_AnalogCurve analog_curve;
 	uint8_t buttons;
 	uint8_t axes;
 	uint8_t hats;
-	uint8_t identifier;
+	int32_t identifier;
 	const char* name;
 	bool keyboard_enabled;
 	bool connected;
@@ -63,8 +85,10 @@ typedef struct JoypadDriver
 	void			 (*cb_poll)(void);
 	int16_t			 (*cb_get_state)(void);
 	void			 (*cb_assign_player)(LMC_Player, int);
-	void			 (*cb_connect)(LMC_Player);
-	void			 (*cb_disconnect)(LMC_Player);
+	void			 (*cb_connect)(int);
+	void			 (*cb_disconnect)(int);
+	void			 (*cb_update)(void);
+	JoypadInputState* (*cb_get_config)(LMC_Player);
 	void			 (*cb_deinit)(void);
 	JoypadInputState state[MAX_PLAYERS];
 	bool			 initialized;
@@ -81,9 +105,12 @@ typedef struct InputDriver
 	void		(*cb_poll)(void);
 	int16_t		(*cb_get_state)(unsigned, unsigned, unsigned, unsigned);
 	void		(*cb_deinit)(void);
-	void		(*cb_auto_config)(void);
+	LMC_AutoConfigureJoypadCallback cb_auto_config;
+	uint64_t	capabilities;
 	int			last_input;
 	int			last_key;
+	LMC_PollType poll_type;
+	bool		poll_pending;
 	bool		initialized;
 }
 InputDriver;
@@ -109,6 +136,10 @@ RETRO_BEGIN_DECLS
 InputDriver* InitializeInputDriver(void);
 void SetInput(LMC_Player player, LMC_Input input);
 void ClearInput(LMC_Player player, LMC_Input input);
+JoypadInputState* GetJoypadConfigState(LMC_Player player);
+void UpdateInputLookups(LMC_Player player);
+LMC_Input GetKeyInput(LMC_Player player, uint32_t keycode);
+bool UpdateAnalogResponse(LMC_Player player);
 
 RETRO_END_DECLS
 
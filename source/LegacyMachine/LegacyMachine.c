@@ -21,12 +21,15 @@
 #include <features/features_cpu.h>
 #include <file/file_path.h>
 #include <streams/file_stream.h>
+#include <string/stdstring.h>
 #include <dynamic/dylib.h>
 #include <compat/strl.h>
+#include <queues/task_queue.h>
 
 #include "LegacyMachine.h"
 #include "MainEngine.h"
 #include "Logging.h"
+#include "Common/FileMap.h"
 
 /**************************************************************************************************
  * Definitions
@@ -52,6 +55,10 @@
 LMC_Engine					  legacy_machine;					/* LegacyMachine context. */
 
 static struct retro_variable* retro_variables = NULL;		/* LibRetro core variables. */
+
+static void FreeRetroVariables(struct retro_variable* variables);
+static void FlushCoreCache(SystemManager* system, unsigned keep);
+
 #if defined HAVE_MENU
 /*!
  * \brief
@@ -272,6 +279,63 @@ LMC_Engine LMC_Init(void)
 		LMC_SetLastError(LMC_ERR_OUT_OF_MEMORY);
 		return NULL;
 	}
+	context->movie = GetMovieManagerContext();
+	if (!context->movie)
+	{
+		LMC_DeleteContext(context);
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return NULL;
+	}
+	context->movie->desync_frame = -1;
+	context->content = GetContentManagerContext();
+	if (!context->content)
+	{
+		LMC_DeleteContext(context);
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return NULL;
+	}
+	context->vfs = GetVFSManagerContext();
+	if (!context->vfs)
+	{
+		LMC_DeleteContext(context);
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return NULL;
+	}
+	context->vfs->read_ahead = VFS_READ_AHEAD_SIZE;
+	context->vfs->chd_cache_size = VFS_CHD_CACHE_SIZE;
+	context->library = GetLibraryManagerContext();
+	if (!context->library)
+	{
+		LMC_DeleteContext(context);
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return NULL;
+	}
+	context->save = GetSaveManagerContext();
+	if (!context->save)
+	{
+		LMC_DeleteContext(context);
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return NULL;
+	}
+	context->save->interval = SAVE_CHECK_INTERVAL;
+	context->disk = GetDiskManagerContext();
+	if (!context->disk)
+	{
+		LMC_DeleteContext(context);
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return NULL;
+	}
+	context->io = GetIOManagerContext();
+	if (!context->io)
+	{
+		LMC_DeleteContext(context);
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return NULL;
+	}
+	context->io->max_in_flight = IO_MAX_IN_FLIGHT;
+
+	/* Background work such as archive decompression runs on the task queue. */
+	task_queue_init(true, NULL);
 
 	/* Set internal program name (required for environment initialization). */
 	strlcpy(context->settings->program_name, program_name, NAME_MAX_LENGTH);
@@ -302,6 +366,9 @@ LMC_Engine LMC_Init(void)
 	TLN_SetTargetFps((int)fps);
 	TLN_SetLoadPath(context->settings->asset_directory);
 	TLN_SetRenderTarget(context->menu->framebuffer.data, context->menu->framebuffer.pitch);
+
+	/* Menus are mostly static, only redraw the scanlines that change. */
+	TLN_EnableDirtyTracking(true);
 #endif
 
 #ifdef _DEBUG
@@ -394,6 +461,8 @@ bool LMC_DeleteContext(LMC_Engine context)
 	}
 
 	/* TODO: Free necessary "engine" members. */
+	if (context->system)
+		FlushCoreCache(context->system, 0);
 	if (context->system->current_core)
 		free(context->system->current_core);
 #ifdef HAVE_MENU
@@ -406,6 +475,38 @@ bool LMC_DeleteContext(LMC_Engine context)
 #endif
 	if (context->system)
 		context->system = NULL;
+	if (context->movie)
+		context->movie = NULL;
+	if (context->save)
+	{
+		DeinitSaveManager();
+		context->save = NULL;
+	}
+	if (context->disk)
+	{
+		DeinitDiskManager();
+		context->disk = NULL;
+	}
+	if (context->io)
+	{
+		DeinitIOManager();
+		context->io = NULL;
+	}
+	if (context->library)
+	{
+		CancelLibraryScan();
+		FreeLibraryIndex(&context->library->index);
+		context->library = NULL;
+	}
+	if (context->content)
+	{
+		CancelPrefetch(true);
+		CloseContent();
+		task_queue_deinit();
+		context->content = NULL;
+	}
+	if (context->vfs)
+		context->vfs = NULL;
 	if (context->input)
 		context->input = NULL;
 	if (context->audio)
@@ -560,6 +661,13 @@ bool LMC_SetMenuTileEngineContext(TLN_Engine context)
  * \brief
  * Sets the function for custom input configuration.
  *
+ * \param callback
+ * Function called with the player, name, vendor id and product id of each newly connected
+ * joypad, or NULL to disable.
+ *
+ * The callback runs on the joypad hotplug thread rather than the emulation thread. Mapping
+ * changes it makes for the given player (LMC_DefineJoypadInputButton() and friends) apply to
+ * a staged copy of that player's input state, which is published in one step between frames.
  */
 void LMC_SetAutoConfigureJoypadCallback(LMC_AutoConfigureJoypadCallback callback)
 {
@@ -608,6 +716,263 @@ const char* LMC_GetPath(LMC_Path path_type)
 	return "";
 }
 
+/**************************************************************************************************
+ * LegacyMachine File I/O Management
+ *************************************************************************************************/
+
+/*!
+ * \brief
+ * Sets the read-ahead buffer size for files cores open read-only through the VFS interface.
+ *
+ * \param size
+ * Buffer size in bytes, 0 passes every read straight to the file. Files that can be memory
+ * mapped don't use the buffer.
+ *
+ * Applies to files opened afterwards.
+ */
+void LMC_SetFileReadAhead(int size)
+{
+	if (size < 0)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return;
+	}
+
+	legacy_machine->vfs->read_ahead = (size_t)size;
+}
+
+/*!
+ * \brief
+ * Sets the decompressed hunk cache size for CHD tracks cores open through the VFS interface.
+ *
+ * \param size
+ * Cache size in bytes for each open track, at least a few hunks are always cached.
+ *
+ * Cores read CHD tracks as plain files through the VFS interface with "image.chd#track" paths,
+ * see LMC_LoadContent(). Sequential reads are
+ * decompressed ahead on a worker thread, so streaming audio and video doesn't stall the core.
+ * Applies to tracks opened afterwards.
+ */
+void LMC_SetChdCacheSize(int size)
+{
+	if (size < 0)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return;
+	}
+
+	legacy_machine->vfs->chd_cache_size = (size_t)size;
+}
+
+/*!
+ * \brief
+ * Gets the number of files with I/O statistics.
+ *
+ * \returns
+ * Number of files the current core has opened through the VFS interface.
+ */
+int LMC_GetFileStatsCount(void)
+{
+	int count = 0;
+	int i;
+
+	for (i = 0; i < VFS_MAX_FILE_STATS; i++)
+	{
+		if (legacy_machine->vfs->files[i].path[0] != '\0')
+			count++;
+	}
+
+	return count;
+}
+
+/*!
+ * \brief
+ * Gets the I/O statistics of a file the current core opened through the VFS interface.
+ *
+ * \param index
+ * File index, from 0 to LMC_GetFileStatsCount() - 1.
+ *
+ * \param stats
+ * Pointer to the statistics to fill. The path stays valid until the next core is loaded.
+ *
+ * \returns
+ * True if the file exists and false otherwise.
+ */
+bool LMC_GetFileStats(int index, LMC_FileStats* stats)
+{
+	if (!stats)
+	{
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return false;
+	}
+
+	if (!GetVFSStats(index, stats))
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return false;
+	}
+
+	return true;
+}
+
+/**************************************************************************************************
+ * LegacyMachine Library Management
+ *************************************************************************************************/
+
+/* Gets the path of the library index in the settings directory. */
+static void GetLibraryIndexPath(char* path, size_t size)
+{
+	fill_pathname_join(path, legacy_machine->settings->setting_directory, LIBRARY_INDEX_FILE, size);
+}
+
+/*!
+ * \brief
+ * Loads the content library saved by the last scan.
+ *
+ * \returns
+ * True if the library index was read and false if there is none or it's out of date.
+ */
+bool LMC_LoadLibrary(void)
+{
+	char index_path[PATH_MAX_LENGTH];
+
+	LMC_SetLastError(LMC_ERR_OK);
+	GetLibraryIndexPath(index_path, sizeof(index_path));
+	if (!LoadLibraryIndex(index_path))
+	{
+		LMC_SetLastError(LMC_ERR_INV_PATH);
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * \brief
+ * Scans the content directory for the content library in the background.
+ *
+ * \param extensions
+ * Content extensions to include separated by '|', NULL includes every file.
+ *
+ * \param dat_file
+ * Optional Logiqx XML DAT file used to identify content, looked up in the settings directory
+ * when it isn't a valid path.
+ *
+ * \returns
+ * True if the scan started and false otherwise.
+ *
+ * Files are hashed on worker threads, files with the same size and modification time as in the
+ * current library keep their hashes. The library is replaced and saved to the settings directory
+ * once the scan completes, see LMC_IsLibraryScanning().
+ */
+bool LMC_ScanLibrary(const char* extensions, const char* dat_file)
+{
+	char index_path[PATH_MAX_LENGTH];
+	char dat_path[PATH_MAX_LENGTH] = "";
+
+	if (legacy_machine->library->task != NULL)
+	{
+		LMC_SetLastError(LMC_ERR_UNSUPPORTED);
+		return false;
+	}
+
+	if (!path_is_valid(legacy_machine->settings->content_directory))
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Content directory does not exist");
+		LMC_SetLastError(LMC_ERR_INV_PATH);
+		return false;
+	}
+
+	if (!string_is_empty(dat_file))
+	{
+		if (path_is_valid(dat_file))
+			strlcpy(dat_path, dat_file, sizeof(dat_path));
+		else
+			fill_pathname_join(dat_path, legacy_machine->settings->setting_directory, dat_file, sizeof(dat_path));
+	}
+
+	GetLibraryIndexPath(index_path, sizeof(index_path));
+	if (!StartLibraryScan(legacy_machine->settings->content_directory, extensions, dat_path, index_path))
+	{
+		LMC_SetLastError(LMC_ERR_OUT_OF_MEMORY);
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * \brief
+ * Checks whether a library scan is still running.
+ *
+ * \returns
+ * True while a scan started by LMC_ScanLibrary() is running.
+ */
+bool LMC_IsLibraryScanning(void)
+{
+	return legacy_machine->library->task != NULL;
+}
+
+/*!
+ * \brief
+ * Gets the number of entries in the content library.
+ *
+ * \returns
+ * Number of content files in the library.
+ */
+int LMC_GetLibraryEntryCount(void)
+{
+	return (int)legacy_machine->library->index.count;
+}
+
+/*!
+ * \brief
+ * Gets an entry of the content library, entries are sorted by path.
+ *
+ * \param index
+ * Entry index, from 0 to LMC_GetLibraryEntryCount() - 1.
+ *
+ * \param entry
+ * Pointer to the entry to fill. Its strings stay valid until the library is reloaded or rescanned.
+ *
+ * \returns
+ * True if the entry exists and false otherwise.
+ */
+bool LMC_GetLibraryEntry(int index, LMC_LibraryEntry* entry)
+{
+	const LibraryIndex* library = &legacy_machine->library->index;
+	const LibraryRecord* record;
+	int i;
+
+	if (!entry)
+	{
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return false;
+	}
+
+	if (index < 0 || (uint32_t)index >= library->count)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return false;
+	}
+
+	record = &library->records[index];
+	entry->path = library->strings + record->path;
+	entry->name = library->strings + record->name;
+	entry->size = record->content_size;
+	entry->crc = record->crc;
+	entry->matched = (record->flags & LIBRARY_FLAG_MATCHED) != 0;
+	entry->unidentified = (record->flags & LIBRARY_FLAG_UNREAD) != 0;
+	entry->sha1[0] = '\0';
+	if (record->flags & LIBRARY_FLAG_SHA1)
+	{
+		for (i = 0; i < LIBRARY_SHA1_SIZE; i++)
+			snprintf(entry->sha1 + i * 2, 3, "%02x", record->sha1[i]);
+	}
+
+	return true;
+}
+
 /**************************************************************************************************
  * LibRetro Core Management
  *************************************************************************************************/
@@ -756,8 +1121,23 @@ static bool CoreEnvironment(unsigned cmd, void* data)
 	}
 	case RETRO_ENVIRONMENT_SET_DISK_CONTROL_INTERFACE:
 	{
-		lmc_core_log(RETRO_LOG_INFO, "[Environment]: SET_DISK_CONTROL_INTERFACE: not implemented");
-		return false;
+		lmc_core_log(RETRO_LOG_INFO, "[Environment]: SET_DISK_CONTROL_INTERFACE");
+
+		const struct retro_disk_control_callback* disk_control =
+			(const struct retro_disk_control_callback*)data;
+		struct retro_disk_control_ext_callback* cb = &legacy_machine->disk->cb;
+
+		/* Version 0 cores leave the extended calls NULL. */
+		memset(cb, 0, sizeof(*cb));
+		cb->set_eject_state = disk_control->set_eject_state;
+		cb->get_eject_state = disk_control->get_eject_state;
+		cb->get_image_index = disk_control->get_image_index;
+		cb->set_image_index = disk_control->set_image_index;
+		cb->get_num_images = disk_control->get_num_images;
+		cb->replace_image_index = disk_control->replace_image_index;
+		cb->add_image_index = disk_control->add_image_index;
+
+		return true;
 	}
 	case RETRO_ENVIRONMENT_SET_HW_RENDER:
 	{
@@ -796,6 +1176,7 @@ static bool CoreEnvironment(unsigned cmd, void* data)
 			total_variables++;
 		}
 
+		FreeRetroVariables(retro_variables);
 		retro_variables = (struct retro_variable*)calloc(total_variables + 1, sizeof(*retro_variables));
 		for (unsigned i = 0; i < total_variables; ++i) {
 			const struct retro_variable* in_variable = &variables[i];
@@ -867,8 +1248,10 @@ static bool CoreEnvironment(unsigned cmd, void* data)
 	}
 	case RETRO_ENVIRONMENT_GET_INPUT_DEVICE_CAPABILITIES:
 	{
-		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_INPUT_DEVICE_CAPABILITIES: not implemented");
-		return false;
+		*(uint64_t*)data = legacy_machine->input->capabilities;
+		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_INPUT_DEVICE_CAPABILITIES: 0x%llx",
+			(unsigned long long)legacy_machine->input->capabilities);
+		return true;
 	}
 	case RETRO_ENVIRONMENT_GET_SENSOR_INTERFACE:
 	{
@@ -1002,8 +1385,17 @@ static bool CoreEnvironment(unsigned cmd, void* data)
 	}
 	case RETRO_ENVIRONMENT_GET_VFS_INTERFACE:
 	{
-		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_VFS_INTERFACE: not implemented");
-		return false;
+		struct retro_vfs_interface_info* info = (struct retro_vfs_interface_info*)data;
+
+		if (!info || !GetVFSInterface(info))
+		{
+			lmc_core_log(RETRO_LOG_WARN, "[Environment]: GET_VFS_INTERFACE: version %u not supported",
+				info ? info->required_interface_version : 0);
+			return false;
+		}
+
+		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_VFS_INTERFACE: version %u", info->required_interface_version);
+		return true;
 	}
 	case RETRO_ENVIRONMENT_GET_LED_INTERFACE:
 	{
@@ -1034,8 +1426,9 @@ static bool CoreEnvironment(unsigned cmd, void* data)
 	}
 	case RETRO_ENVIRONMENT_GET_INPUT_BITMASKS:
 	{
-		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_INPUT_BITMASKS: not implemented");
-		return false;
+		/* Joypad state answers RETRO_DEVICE_ID_JOYPAD_MASK queries. */
+		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_INPUT_BITMASKS: true");
+		return true;
 	}
 	case RETRO_ENVIRONMENT_GET_CORE_OPTIONS_VERSION:
 	{
@@ -1073,13 +1466,21 @@ static bool CoreEnvironment(unsigned cmd, void* data)
 	}
 	case RETRO_ENVIRONMENT_GET_DISK_CONTROL_INTERFACE_VERSION:
 	{
-		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_DISK_CONTROL_INTERFACE_VERSION: not implemented");
-		return false;
+		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_DISK_CONTROL_INTERFACE_VERSION");
+
+		*(unsigned*)data = 1;
+
+		return true;
 	}
 	case RETRO_ENVIRONMENT_SET_DISK_CONTROL_EXT_INTERFACE:
 	{
-		lmc_core_log(RETRO_LOG_INFO, "[Environment]: SET_DISK_CONTROL_EXT_INTERFACE: not implemented");
-		return false;
+		lmc_core_log(RETRO_LOG_INFO, "[Environment]: SET_DISK_CONTROL_EXT_INTERFACE");
+
+		const struct retro_disk_control_ext_callback* disk_control =
+			(const struct retro_disk_control_ext_callback*)data;
+		legacy_machine->disk->cb = *disk_control;
+
+		return true;
 	}
 	case RETRO_ENVIRONMENT_GET_MESSAGE_INTERFACE_VERSION:
 	{
@@ -1113,13 +1514,21 @@ static bool CoreEnvironment(unsigned cmd, void* data)
 	}
 	case RETRO_ENVIRONMENT_SET_CONTENT_INFO_OVERRIDE:
 	{
-		lmc_core_log(RETRO_LOG_INFO, "[Environment]: SET_CONTENT_INFO_OVERRIDE: not implemented");
-		return false;
+		/* A NULL query just checks for support. */
+		if (data)
+			legacy_machine->content->overrides = (const struct retro_system_content_info_override*)data;
+		lmc_core_log(RETRO_LOG_INFO, "[Environment]: SET_CONTENT_INFO_OVERRIDE");
+		return true;
 	}
 	case RETRO_ENVIRONMENT_GET_GAME_INFO_EXT:
 	{
-		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_GAME_INFO_EXT: not implemented");
-		return false;
+		const struct retro_game_info_ext** game_info_ext = (const struct retro_game_info_ext**)data;
+
+		if (!legacy_machine->content->loaded || !game_info_ext)
+			return false;
+
+		*game_info_ext = &legacy_machine->content->info_ext;
+		return true;
 	}
 	case RETRO_ENVIRONMENT_SET_CORE_OPTIONS_V2:
 	{
@@ -1153,6 +1562,15 @@ static bool CoreEnvironment(unsigned cmd, void* data)
 		lmc_core_log(RETRO_LOG_INFO, "[Environment]: GET_THROTTLE_STATE: not implemented");
 		return false;
 	}
+	case RETRO_ENVIRONMENT_POLL_TYPE_OVERRIDE:
+	{
+		legacy_machine->system->current_core->poll_type = *(const unsigned*)data;
+
+		lmc_core_log(RETRO_LOG_INFO, "[Environment]: POLL_TYPE_OVERRIDE: %u",
+			legacy_machine->system->current_core->poll_type);
+
+		return true;
+	}
 	default:
 		lmc_core_log(RETRO_LOG_DEBUG, "[Environment]: Unhandled event: #%u", cmd);
 		return false;
@@ -1180,17 +1598,201 @@ static size_t CoreAudioSampleBatch(const int16_t* data, size_t frames)
 	return legacy_machine->audio->cb_write(data, frames);
 }
 
+/* Gets the input poll type in effect, a core's override takes precedence over the frontend's. */
+static LMC_PollType GetCorePollType(void)
+{
+	unsigned poll_type = legacy_machine->system->current_core->poll_type;
+
+	if (poll_type != POLL_TYPE_OVERRIDE_DONTCARE && poll_type <= LMC_POLL_LATE + 1)
+		return (LMC_PollType)(poll_type - 1);
+
+	return legacy_machine->input->poll_type;
+}
+
 /* Poll input for running core. */
 static void CorePollInput(void)
 {
-	legacy_machine->input->cb_poll;
+	/* Recorded input replaces live input during movie playback. */
+	if (legacy_machine->movie->mode == MOVIE_PLAYBACK)
+		return;
+
+	switch (GetCorePollType())
+	{
+	case LMC_POLL_NORMAL:
+		legacy_machine->input->cb_poll();
+		break;
+	case LMC_POLL_LATE:
+		/* Defer polling until the core first asks for input state. */
+		legacy_machine->input->poll_pending = true;
+		break;
+	default:
+		/* Early polling already happened before the frame was run. */
+		break;
+	}
 }
 
 /* Get input's state for running core. */
 static int16_t CoreGetInputState(unsigned port, unsigned device, unsigned index, unsigned id)
 {
-	return legacy_machine->input->cb_get_state(port, device, index, id);
-}
+	if (legacy_machine->movie->mode == MOVIE_PLAYBACK)
+		return GetMovieInputState(port, device, index, id);
+
+	if (legacy_machine->input->poll_pending)
+	{
+		legacy_machine->input->poll_pending = false;
+		legacy_machine->input->cb_poll();
+	}
+
+	return legacy_machine->input->cb_get_state(port, device, index, id);
+}
+
+/* Frees variables set by a core. */
+static void FreeRetroVariables(struct retro_variable* variables)
+{
+	struct retro_variable* v;
+
+	if (!variables)
+		return;
+
+	for (v = variables; v->key; ++v)
+	{
+		free((char*)v->key);
+		free((char*)v->value);
+	}
+	free(variables);
+}
+
+/* Deinitializes and unloads a cached core. */
+static void EvictCachedCore(CoreCacheEntry* entry)
+{
+	lmc_core_log(RETRO_LOG_INFO, "Unloading cached core %s", entry->path);
+
+	entry->core.retro_deinit();
+	dylib_close(entry->core.handle);
+	UnmapFileReadOnly(entry->content_map, entry->content_map_size);
+	FreeRetroVariables(entry->variables);
+	memset(entry, 0, sizeof(*entry));
+}
+
+/* Unloads cached cores, keeping at most the given number of the most recently closed ones. */
+static void FlushCoreCache(SystemManager* system, unsigned keep)
+{
+	for (;;)
+	{
+		CoreCacheEntry* oldest = NULL;
+		unsigned count = 0;
+		unsigned i;
+
+		for (i = 0; i < CORE_CACHE_MAX; i++)
+		{
+			CoreCacheEntry* entry = &system->core_cache[i];
+
+			if (!entry->core.handle)
+				continue;
+			count++;
+			if (!oldest || entry->last_used < oldest->last_used)
+				oldest = entry;
+		}
+
+		if (count <= keep)
+			break;
+		EvictCachedCore(oldest);
+	}
+}
+
+/* Moves the current core into the cache, unloading the least recently closed core if full. */
+static bool CacheCurrentCore(void)
+{
+	SystemManager* system = legacy_machine->system;
+	CoreCacheEntry* entry = NULL;
+	unsigned i;
+
+	FlushCoreCache(system, system->core_cache_size - 1);
+
+	for (i = 0; i < CORE_CACHE_MAX && entry == NULL; i++)
+	{
+		if (!system->core_cache[i].core.handle)
+			entry = &system->core_cache[i];
+	}
+	if (!entry)
+		return false;
+
+	strlcpy(entry->path, system->core_path, sizeof(entry->path));
+	entry->core = *system->current_core;
+	entry->core.running = false;
+	entry->variables = retro_variables;
+	entry->overrides = legacy_machine->content->overrides;
+	entry->cb_frame_time = system->cb_frame_time;
+	entry->cb_audio = system->cb_audio;
+	entry->cb_disk_control = legacy_machine->disk->cb;
+	DetachContentMapping(&entry->content_map, &entry->content_map_size);
+	entry->last_used = ++system->core_cache_clock;
+	retro_variables = NULL;
+	return true;
+}
+
+/* Makes a cached core current again, restoring the frontend state it set up. */
+static bool TakeCachedCore(const char* path)
+{
+	SystemManager* system = legacy_machine->system;
+	unsigned i;
+
+	for (i = 0; i < CORE_CACHE_MAX; i++)
+	{
+		CoreCacheEntry* entry = &system->core_cache[i];
+
+		if (!entry->core.handle || !string_is_equal(entry->path, path))
+			continue;
+
+		*system->current_core = entry->core;
+		FreeRetroVariables(retro_variables);
+		retro_variables = entry->variables;
+		legacy_machine->content->overrides = entry->overrides;
+		system->cb_frame_time = entry->cb_frame_time;
+		system->cb_audio = entry->cb_audio;
+		legacy_machine->disk->cb = entry->cb_disk_control;
+
+		/* The core unloaded that game before it was cached, the next one brings its own data. */
+		UnmapFileReadOnly(entry->content_map, entry->content_map_size);
+		memset(entry, 0, sizeof(*entry));
+		return true;
+	}
+
+	return false;
+}
+
+/* Checks whether a core is kept in the cache. */
+static bool IsCoreCached(const char* path)
+{
+	unsigned i;
+
+	for (i = 0; i < CORE_CACHE_MAX; i++)
+	{
+		if (legacy_machine->system->core_cache[i].core.handle &&
+			string_is_equal(legacy_machine->system->core_cache[i].path, path))
+			return true;
+	}
+
+	return false;
+}
+
+/* Gets the full path of a core in the core directory. */
+static void GetCorePath(const char* filename, char* path)
+{
+	strlcpy(path, legacy_machine->settings->core_directory, PATH_MAX_LENGTH);
+	fill_pathname_slash(path, PATH_MAX_LENGTH);
+	strlcat(path, filename, PATH_MAX_LENGTH);
+}
+
+/* Gets the full path of content, names that don't resolve as given are looked up in the content directory. */
+static void GetContentPath(const char* filename, char* path)
+{
+	if (path_is_valid(filename) || path_contains_compressed_file(filename) ||
+		legacy_machine->settings->content_directory[0] == '\0')
+		strlcpy(path, filename, PATH_MAX_LENGTH);
+	else
+		fill_pathname_join(path, legacy_machine->settings->content_directory, filename, PATH_MAX_LENGTH);
+}
 
 /*!
  * \brief
@@ -1225,16 +1827,41 @@ bool LMC_LoadCore(const char* filename)
 	void (*set_audio_sample)(retro_audio_sample_t) = NULL;
 	void (*set_audio_sample_batch)(retro_audio_sample_batch_t) = NULL;
 
-	char* fullpath = (char*)malloc(PATH_MAX_LENGTH);
-	strlcpy(fullpath, legacy_machine->settings->core_directory, PATH_MAX_LENGTH);
-	fill_pathname_slash(fullpath, sizeof(fullpath));
-	strlcat(fullpath, filename, PATH_MAX_LENGTH);
+	SystemManager* system = legacy_machine->system;
+	retro_time_t start = cpu_features_get_time_usec();
+	char* fullpath = system->core_path;
 
-	legacy_machine->system->current_core->handle = dylib_load(fullpath);
+	GetCorePath(filename, fullpath);
 
-	if (!legacy_machine->system->current_core->handle)
+	/* A prefetch still running is no longer needed, one that finished may have the core open. */
+	CancelPrefetch(false);
+
+	/* File statistics cover the files this core opens. */
+	ResetVFSStats();
+
+	/* A cached core is already initialized and only needs its frontend state back. */
+	if (TakeCachedCore(fullpath))
+	{
+		retro_time_t elapsed = cpu_features_get_time_usec() - start;
+
+		system->core_stats.load_usec = (uint64_t)elapsed;
+		if (system->current_core->load_time > elapsed)
+			system->core_stats.saved_usec += (uint64_t)(system->current_core->load_time - elapsed);
+		system->core_stats.hits++;
+		system->core_stats.cached = true;
+
+		lmc_core_log(RETRO_LOG_INFO, "%s Core reused in %lld us", filename, (long long)elapsed);
+		return true;
+	}
+
+	system->current_core->handle = TakePrefetchedCore(fullpath);
+	if (!system->current_core->handle)
+		system->current_core->handle = dylib_load(fullpath);
+
+	if (!system->current_core->handle)
 	{
 		lmc_core_log(RETRO_LOG_ERROR, "Failed to load core: %s", dylib_error());
+		system->core_path[0] = '\0';
 		return false;
 	}
 
@@ -1248,6 +1875,11 @@ bool LMC_LoadCore(const char* filename)
 	LoadRetroSymbol(retro_run);
 	LoadRetroSymbol(retro_load_game);
 	LoadRetroSymbol(retro_unload_game);
+	LoadRetroSymbol(retro_serialize_size);
+	LoadRetroSymbol(retro_serialize);
+	LoadRetroSymbol(retro_unserialize);
+	LoadRetroSymbol(retro_get_memory_data);
+	LoadRetroSymbol(retro_get_memory_size);
 
 	LoadSymbol(set_environment, retro_set_environment);
 	LoadSymbol(set_video_refresh, retro_set_video_refresh);
@@ -1266,107 +1898,176 @@ bool LMC_LoadCore(const char* filename)
 	legacy_machine->system->current_core->retro_init();
 	legacy_machine->system->current_core->initialized = true;
 
-	if (fullpath)
-		free(fullpath);
+	system->current_core->load_time = cpu_features_get_time_usec() - start;
+	system->core_stats.load_usec = (uint64_t)system->current_core->load_time;
+	system->core_stats.misses++;
+	system->core_stats.cached = false;
 
-	lmc_core_log(RETRO_LOG_INFO, "%s Core loaded", filename);
+	lmc_core_log(RETRO_LOG_INFO, "%s Core loaded in %lld us", filename, (long long)system->current_core->load_time);
 	return true;
 }
 
+/* Hands opened content to the core, called once content data is ready. */
+static void CoreContentLoaded(bool loaded)
+{
+	struct retro_system_av_info av_info = { 0 };
+	struct retro_system_info system_info = { 0 };
+	struct retro_game_info content_info = { 0 };
+	char window_title[255];
+
+	if (!loaded)
+	{
+		CloseContent();
+		LMC_SetLastError(LMC_ERR_INV_PATH);
+		return;
+	}
+
+	legacy_machine->system->current_core->retro_get_system_info(&system_info);
+
+	content_info.path = legacy_machine->content->path;
+	content_info.meta = "";
+	content_info.data = legacy_machine->content->data;
+	content_info.size = legacy_machine->content->size;
+
+	if (!legacy_machine->system->current_core->retro_load_game(legacy_machine->content->loaded ? &content_info : NULL))
+	{
+		lmc_core_log(RETRO_LOG_ERROR, "The core failed to load the content");
+		CloseContent();
+		LMC_SetLastError(LMC_ERR_LIBRETRO);
+		return;
+	}
+
+	/* Read buffers the core didn't ask to keep are no longer needed, mappings stay. */
+	ReleaseContentData();
+
+	/* The rest of a playlist goes to cores that were started on its first disc. */
+	AppendDiskImages();
+
+	/* Battery saves are loaded once the core has set up its save RAM. */
+	LoadSaveRAM(legacy_machine->settings->save_directory, legacy_machine->content->name);
+
+	legacy_machine->system->current_core->retro_get_system_av_info(&av_info);
+
+	legacy_machine->video->cb_set_geometry_fmt(&av_info.geometry);
+
+	legacy_machine->window->cb_init();
+	legacy_machine->audio->cb_init(av_info.timing.sample_rate);
+
+	/* Now that we have the system info, set the window title. */
+	snprintf(window_title, sizeof(window_title), "LegacyMachine %s %s", system_info.library_name, system_info.library_version);
+	LMC_SetWindowTitle(window_title);
+
+	legacy_machine->system->current_core->running = true;
+}
+
 /*!
  * \brief
  * Loads and initializes a specific libretro core's content.
  *
  * \param filename
- * Path on the filesystem to load content from.
+ * Path on the filesystem to load content from. Zip archives (and 7z archives where supported)
+ * are extracted, "archive.zip#file" selects a specific file inside an archive. "image.chd#track"
+ * selects a track of a CHD image by its number. The track is decompressed and handed over as
+ * raw ".bin" data. Cores that need a path get it unchanged and must open it through the VFS
+ * interface. Only zlib compressed CHD images are read unless built with HAVE_7ZIP or HAVE_FLAC.
  * 
  * \returns
- * True if a core's content loads successfully and false if content loading fails.
+ * True if a core's content loads successfully (or is still loading) and false if content
+ * loading fails.
  * 
+ * Large archived files are decompressed in the background while LMC_UpdateFrame() keeps the
+ * menu running, the core starts once they are ready. Use LMC_IsContentLoading() to check.
  */
 bool LMC_LoadContent(const char* filename)
 {
-	struct retro_system_av_info av_info = { 0 };
 	struct retro_system_info system_info = { 0 };
-	struct retro_game_info content_info = { filename, 0 };
-	char* fullpath = (char*)malloc(PATH_MAX_LENGTH);
+	char* fullpath;
 
-	uint8_t* content_data = NULL;
-	int64_t content_size = 0;
+	LMC_SetLastError(LMC_ERR_OK);
 
-	if (filename) {
-		legacy_machine->system->current_core->retro_get_system_info(&system_info);
+	if (!filename)
+	{
+		CloseContent();
+		CoreContentLoaded(true);
+		return legacy_machine->system->current_core->running;
+	}
 
-		if (!system_info.need_fullpath)
-		{
-			if (!filestream_read_file(filename,
-				(void**)&content_data,
-				content_size))
-			{
-				lmc_core_log(RETRO_LOG_ERROR, "Failed to load %s", filename);
-				return false;
-			}
+	fullpath = (char*)malloc(PATH_MAX_LENGTH);
+	if (!fullpath)
+	{
+		LMC_SetLastError(LMC_ERR_OUT_OF_MEMORY);
+		return false;
+	}
 
-			if (content_size < 0)
-			{
-				lmc_core_log(RETRO_LOG_ERROR, "Failed to query game file size");
-				return false;
-			}
-			content_info.path = filename;
-		}
-		else
-		{
-			strlcpy(fullpath, legacy_machine->settings->content_directory, PATH_MAX_LENGTH);
-			fill_pathname_slash(fullpath, sizeof(fullpath));
-			strlcat(fullpath, filename, PATH_MAX_LENGTH);
-
-			if (!filestream_read_file(fullpath,
-				(void**)&content_data,
-				content_size))
-			{
-				lmc_core_log(RETRO_LOG_ERROR, "Failed to load %s", filename);
-				return false;
-			}
+	legacy_machine->system->current_core->retro_get_system_info(&system_info);
 
-			if (content_size < 0)
-			{
-				lmc_core_log(RETRO_LOG_ERROR, "Failed to query game file size");
-				return false;
-			}	
-			content_info.path = fullpath;
-		}
-		content_info.meta = "";
-		content_info.data = content_data;
-		content_info.size = (size_t)content_size;
-	}
+	GetContentPath(filename, fullpath);
 
-	if (!legacy_machine->system->current_core->retro_load_game(&content_info))
+	/* Disc images are mapped and read ahead so the core's reads and disc swaps don't wait. */
+	if (!OpenDiskImages(fullpath, system_info.valid_extensions, fullpath, PATH_MAX_LENGTH))
 	{
-		lmc_core_log(RETRO_LOG_ERROR, "The core failed to load the content");
+		free(fullpath);
+		LMC_SetLastError(LMC_ERR_INV_PATH);
 		return false;
 	}
 
-	legacy_machine->system->current_core->retro_get_system_av_info(&av_info);
+	/* Content is memory mapped where possible and handed to the core without a copy. */
+	if (!OpenContent(fullpath, &system_info, CoreContentLoaded))
+	{
+		free(fullpath);
+		LMC_SetLastError(LMC_ERR_INV_PATH);
+		return false;
+	}
 
-	legacy_machine->video->cb_set_geometry_fmt(&av_info.geometry);
+	free(fullpath);
 
-	legacy_machine->window->cb_init();
-	legacy_machine->audio->cb_init(av_info.timing.sample_rate);
+	return legacy_machine->content->loading || legacy_machine->system->current_core->running;
+}
 
-	if (content_info.data)
-		free((void*)content_info.data);
+/*!
+ * \brief
+ * Prefetches the core and content highlighted in a menu.
+ *
+ * \param core
+ * Core filename as passed to LMC_LoadCore(), NULL skips the core.
+ *
+ * \param content
+ * Content path as passed to LMC_LoadContent(), NULL skips the content.
+ *
+ * Once the selection has rested for a moment the core is opened and the content read into the
+ * page cache on a background task, so a following LMC_LoadCore() and LMC_LoadContent() don't
+ * wait on the disk. Call it whenever the selection changes, a new call cancels the previous
+ * prefetch and passing NULL for both only cancels it.
+ */
+void LMC_PrefetchContent(const char* core, const char* content)
+{
+	char core_path[PATH_MAX_LENGTH] = "";
+	char content_path[PATH_MAX_LENGTH] = "";
 
-	if (fullpath)
-		free(fullpath);
+	/* The current core and cached cores are open already. */
+	if (!string_is_empty(core))
+	{
+		GetCorePath(core, core_path);
+		if (string_is_equal(core_path, legacy_machine->system->core_path) || IsCoreCached(core_path))
+			core_path[0] = '\0';
+	}
 
-	/* Now that we have the system info, set the window title. */
-	char window_title[255];
-	snprintf(window_title, sizeof(window_title), "LegacyMachine %s %s", system_info.library_name, system_info.library_version);
-	LMC_SetWindowTitle(window_title);
+	if (!string_is_empty(content))
+		GetContentPath(content, content_path);
 
-	legacy_machine->system->current_core->running = true;
+	PrefetchContent(core_path, content_path);
+}
 
-	return true;
+/*!
+ * \brief
+ * Checks whether content is still being loaded in the background.
+ *
+ * \returns
+ * True while archived content started by LMC_LoadContent() is decompressing.
+ */
+bool LMC_IsContentLoading(void)
+{
+	return legacy_machine->content->loading;
 }
 
 /*!
@@ -1376,13 +2077,88 @@ bool LMC_LoadContent(const char* filename)
  */
 void LMC_CloseCore(void)
 {
-	if (legacy_machine->system->current_core->initialized)
-		legacy_machine->system->current_core->retro_deinit();
+	SystemManager* system = legacy_machine->system;
+	bool cached = false;
+
+	EndMovie();
+
+	/* Last SRAM changes are queued while the core's save RAM is still valid. */
+	CloseSaveRAM();
+
+	if (system->current_core->running)
+		system->current_core->retro_unload_game();
+
+	/* Cores stay initialized for the next title unless they asked for content data that outlives
+	 * the game or render through a hardware context tied to the window. Mapped content the core
+	 * was told is persistent goes along with the cached core. */
+	if (system->current_core->initialized && system->core_cache_size > 0 &&
+		!legacy_machine->content->persistent_requested && system->cb_hw_render.context_type == RETRO_HW_CONTEXT_NONE)
+		cached = CacheCurrentCore();
+	else if (system->current_core->initialized)
+		system->current_core->retro_deinit();
+
+	/* Persistent content data must stay valid until retro_deinit() returns. */
+	CloseContent();
+	CloseDiskImages();
+	legacy_machine->content->overrides = NULL;
+
+	if (!cached && system->current_core->handle)
+		dylib_close(system->current_core->handle);
+
+	FreeRetroVariables(retro_variables);
+	retro_variables = NULL;
+	memset(&system->cb_frame_time, 0, sizeof(system->cb_frame_time));
+	memset(&system->cb_audio, 0, sizeof(system->cb_audio));
+	memset(&system->cb_hw_render, 0, sizeof(system->cb_hw_render));
+	memset(&legacy_machine->disk->cb, 0, sizeof(legacy_machine->disk->cb));
+	system->core_path[0] = '\0';
+
+	memset(system->current_core, 0, sizeof(*system->current_core));
+}
 
-	if (legacy_machine->system->current_core->handle)
-		dylib_close(legacy_machine->system->current_core->handle);
+/*!
+ * \brief
+ * Sets how many closed cores are kept initialized for reuse.
+ *
+ * \param size
+ * Number of cores to keep, up to 8. 0 unloads every core when it's closed, which is the default.
+ *
+ * Reopening a kept core with LMC_LoadCore() skips loading the library and retro_init(), titles
+ * are switched with retro_unload_game() and retro_load_game(). The least recently closed core
+ * is unloaded when the cache is full.
+ */
+void LMC_SetCoreCacheSize(int size)
+{
+	if (size < 0 || size > CORE_CACHE_MAX)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return;
+	}
+
+	legacy_machine->system->core_cache_size = (unsigned)size;
+	FlushCoreCache(legacy_machine->system, (unsigned)size);
+}
+
+/*!
+ * \brief
+ * Gets core loading times and core cache usage.
+ *
+ * \param stats
+ * Pointer to the statistics to fill.
+ *
+ * \returns
+ * True if success or false if stats is NULL.
+ */
+bool LMC_GetCoreLoadStats(LMC_CoreLoadStats* stats)
+{
+	if (!stats)
+	{
+		LMC_SetLastError(LMC_ERR_NULL_POINTER);
+		return false;
+	}
 
-	memset(legacy_machine->system->current_core, 0, sizeof(*legacy_machine->system->current_core));
+	*stats = legacy_machine->system->core_stats;
+	return true;
 }
 
 /*!
@@ -1401,6 +2177,11 @@ void LMC_UpdateFrame(int frame)
 	else
 		legacy_machine->frame += 1;
 
+	/* Finish background tasks, a pending content load starts the core from here. */
+	UpdatePrefetch();
+	task_queue_check();
+	UpdateFileRequests();
+
 	if (legacy_machine->system->current_core->running)
 	{
 		/* Update the game loop timer. */
@@ -1419,8 +2200,24 @@ void LMC_UpdateFrame(int frame)
 			legacy_machine->system->cb_audio.callback();
 		}
 
+		/* Load this frame's recorded input when playing back a movie. */
+		UpdateMovieFrame();
+
+		/* Poll input ahead of the frame when early polling is in effect. */
+		if (GetCorePollType() == LMC_POLL_EARLY && legacy_machine->movie->mode != MOVIE_PLAYBACK)
+			legacy_machine->input->cb_poll();
+
 		/* Run a single loop. */
 		legacy_machine->system->current_core->retro_run();
+
+		/* Drop a late poll the core never consumed. */
+		legacy_machine->input->poll_pending = false;
+
+		/* Record or verify the frame that just ran. */
+		FinishMovieFrame();
+
+		/* Check the SRAM for changes, writes happen off the emulation thread. */
+		UpdateSaveRAM();
 	}
 #ifdef HAVE_MENU
 	else
@@ -1445,6 +2242,445 @@ void LMC_UpdateFrame(int frame)
 #endif
 }
 
+/**************************************************************************************************
+ * LegacyMachine Movie Management
+ *************************************************************************************************/
+
+/* Resolves a movie filename, relative names are placed in the state directory. */
+static void GetMoviePath(char* fullpath, const char* filename)
+{
+	if (path_is_absolute(filename))
+		strlcpy(fullpath, filename, PATH_MAX_LENGTH);
+	else
+		fill_pathname_join(fullpath, legacy_machine->settings->state_directory, filename, PATH_MAX_LENGTH);
+}
+
+/*!
+ * \brief
+ * Starts recording the running core's joypad input to a movie file.
+ *
+ * \param filename
+ * Movie file to create. Relative names are placed in the state directory.
+ *
+ * \param from_state
+ * True to anchor the movie to the core's current state, false to reset the core and
+ * record from power-on.
+ *
+ * \param hash_interval
+ * Number of frames between recorded hashes of the serialized state, 0 to record none.
+ *
+ * \returns
+ * True if recording started or false if an error occurs.
+ *
+ * Each frame's per-port joypad bitmasks are run-length encoded, so idle stretches cost a
+ * single record. Recording stops with LMC_StopMovie() or when the core is closed.
+ *
+ * \see
+ * LMC_StartPlayback(), LMC_StopMovie()
+ */
+bool LMC_StartRecording(const char* filename, bool from_state, int hash_interval)
+{
+	char fullpath[PATH_MAX_LENGTH];
+
+	if (!filename || hash_interval < 0)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return false;
+	}
+	if (!LMC_IsCoreRunning())
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Movie recording requires a running core");
+		LMC_SetLastError(LMC_ERR_LIBRETRO);
+		return false;
+	}
+
+	GetMoviePath(fullpath, filename);
+	if (!BeginMovieRecording(fullpath, from_state, (unsigned)hash_interval))
+	{
+		LMC_SetLastError(LMC_ERR_INV_PATH);
+		return false;
+	}
+
+	LMC_SetLastError(LMC_ERR_OK);
+	return true;
+}
+
+/*!
+ * \brief
+ * Starts playing back a movie file in place of live joypad input.
+ *
+ * \param filename
+ * Movie file to play. Relative names are looked up in the state directory.
+ *
+ * \param verify
+ * True to compare the core's state against the hashes recorded in the movie.
+ *
+ * \returns
+ * True if playback started or false if an error occurs.
+ *
+ * The movie's anchor state is restored (or the core is reset for power-on movies) before
+ * the first frame. The whole movie is loaded up front so playback never allocates or reads
+ * from disk while frames run. Live input resumes once the movie ends.
+ *
+ * \see
+ * LMC_StartRecording(), LMC_GetMovieDesyncFrame()
+ */
+bool LMC_StartPlayback(const char* filename, bool verify)
+{
+	char fullpath[PATH_MAX_LENGTH];
+
+	if (!filename)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return false;
+	}
+	if (!LMC_IsCoreRunning())
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Movie playback requires a running core");
+		LMC_SetLastError(LMC_ERR_LIBRETRO);
+		return false;
+	}
+
+	GetMoviePath(fullpath, filename);
+	if (!BeginMoviePlayback(fullpath, verify))
+	{
+		LMC_SetLastError(LMC_ERR_INV_PATH);
+		return false;
+	}
+
+	LMC_SetLastError(LMC_ERR_OK);
+	return true;
+}
+
+/*!
+ * \brief
+ * Stops recording or playing back a movie.
+ *
+ */
+void LMC_StopMovie(void)
+{
+	EndMovie();
+	LMC_SetLastError(LMC_ERR_OK);
+}
+
+/*!
+ * \brief
+ * Checks whether a movie is being recorded or played back.
+ *
+ * \returns
+ * True if a movie is active or false if not.
+ *
+ */
+bool LMC_IsMovieActive(void)
+{
+	return legacy_machine->movie->mode != MOVIE_IDLE;
+}
+
+/*!
+ * \brief
+ * Gets the first frame where a verified movie playback diverged from its recorded hashes.
+ *
+ * \returns
+ * Frame number of the first mismatch or -1 if the last verified playback stayed in sync.
+ *
+ */
+int LMC_GetMovieDesyncFrame(void)
+{
+	return legacy_machine->movie->desync_frame;
+}
+
+/**************************************************************************************************
+ * LegacyMachine Save Management
+ *************************************************************************************************/
+
+/*!
+ * \brief
+ * Sets how often the running content's SRAM is checked for changes.
+ *
+ * \param frames
+ * Frames between checks, 0 only saves when the core is closed or LMC_FlushSave() is called.
+ *
+ * Battery saves are loaded from the save directory when content starts. Changed SRAM is copied
+ * and written on a worker thread to a temporary file that replaces the save once it's on disk.
+ */
+void LMC_SetSaveInterval(int frames)
+{
+	if (frames < 0)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return;
+	}
+
+	legacy_machine->save->interval = (unsigned)frames;
+	legacy_machine->save->frames = 0;
+}
+
+/*!
+ * \brief
+ * Saves the running content's SRAM now if it changed.
+ *
+ * \returns
+ * True if changed SRAM was queued for writing and false if there was nothing to save.
+ */
+bool LMC_FlushSave(void)
+{
+	return FlushSaveRAM();
+}
+
+/**************************************************************************************************
+ * LegacyMachine Disk Control
+ *************************************************************************************************/
+
+/*!
+ * \brief
+ * Gets the number of disc images the running content has.
+ *
+ * \returns
+ * Number of images, 0 if the core has no disk control interface.
+ */
+int LMC_GetDiskCount(void)
+{
+	DiskManager* disk = legacy_machine->disk;
+
+	if (!disk->cb.get_num_images)
+		return 0;
+
+	return (int)disk->cb.get_num_images();
+}
+
+/*!
+ * \brief
+ * Gets the index of the disc image in the drive.
+ *
+ * \returns
+ * Index of the image, -1 if the core has no disk control interface.
+ */
+int LMC_GetDiskIndex(void)
+{
+	DiskManager* disk = legacy_machine->disk;
+
+	if (!disk->cb.get_image_index)
+		return -1;
+
+	return (int)disk->cb.get_image_index();
+}
+
+/*!
+ * \brief
+ * Swaps the disc image in the drive.
+ *
+ * \param index
+ * Index of the image to insert, from 0 to LMC_GetDiskCount() - 1.
+ *
+ * \returns
+ * True if the image was inserted and false if the core refused the swap.
+ *
+ * The tray is opened, the image changed and the tray closed again within the call. Images of an
+ * M3U playlist are mapped and read ahead in the background while the content runs, so a swap
+ * doesn't stall on the disk.
+ */
+bool LMC_SetDiskIndex(int index)
+{
+	DiskManager* disk = legacy_machine->disk;
+
+	if (!disk->cb.set_eject_state || !disk->cb.set_image_index || !disk->cb.get_eject_state)
+	{
+		LMC_SetLastError(LMC_ERR_LIBRETRO);
+		return false;
+	}
+
+	if (index < 0 || index >= LMC_GetDiskCount())
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return false;
+	}
+
+	if (!disk->cb.get_eject_state() && !disk->cb.set_eject_state(true))
+	{
+		LMC_SetLastError(LMC_ERR_LIBRETRO);
+		return false;
+	}
+
+	if (!disk->cb.set_image_index((unsigned)index))
+	{
+		lmc_core_log(RETRO_LOG_ERROR, "The core failed to insert disc %d", index);
+		disk->cb.set_eject_state(false);
+		LMC_SetLastError(LMC_ERR_LIBRETRO);
+		return false;
+	}
+
+	if (!disk->cb.set_eject_state(false))
+	{
+		LMC_SetLastError(LMC_ERR_LIBRETRO);
+		return false;
+	}
+
+	lmc_core_log(RETRO_LOG_INFO, "Inserted disc %d", index);
+	return true;
+}
+
+/*!
+ * \brief
+ * Gets the label of a disc image.
+ *
+ * \param index
+ * Index of the image, from 0 to LMC_GetDiskCount() - 1.
+ *
+ * \returns
+ * The core's label for the image, else the playlist's label, else the image's filename. NULL if
+ * the index isn't valid. The string stays valid until the next call.
+ */
+const char* LMC_GetDiskLabel(int index)
+{
+	DiskManager* disk = legacy_machine->disk;
+
+	if (index < 0 || index >= LMC_GetDiskCount())
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return NULL;
+	}
+
+	disk->label[0] = '\0';
+
+	if (disk->cb.get_image_label)
+		disk->cb.get_image_label((unsigned)index, disk->label, sizeof(disk->label));
+
+	if (string_is_empty(disk->label) && (unsigned)index < disk->count)
+	{
+		if (!string_is_empty(disk->images[index]->label))
+			strlcpy(disk->label, disk->images[index]->label, sizeof(disk->label));
+		else
+			fill_pathname_base(disk->label, disk->images[index]->path, sizeof(disk->label));
+	}
+
+	if (string_is_empty(disk->label) && disk->cb.get_image_path)
+	{
+		char path[PATH_MAX_LENGTH] = "";
+
+		if (disk->cb.get_image_path((unsigned)index, path, sizeof(path)))
+			fill_pathname_base(disk->label, path, sizeof(disk->label));
+	}
+
+	return disk->label;
+}
+
+/**************************************************************************************************
+ * LegacyMachine Asynchronous File I/O
+ *************************************************************************************************/
+
+/*!
+ * \brief
+ * Reads a whole file in the background.
+ *
+ * \param path
+ * File to read.
+ *
+ * \param priority
+ * Priority class, member of the LMC_FilePriority enumeration.
+ *
+ * \param callback
+ * Called from LMC_UpdateFrame() once the read completes. The data is only valid during the call.
+ *
+ * \param user_data
+ * Pointer handed back to the callback.
+ *
+ * \returns
+ * Request handle for LMC_CancelFileRequest(), -1 on failure.
+ *
+ * Requests are opened and read on the task queue through nbio, a few at a time. Queued requests
+ * start by priority class, then in the order they were made.
+ */
+int LMC_ReadFileAsync(const char* path, LMC_FilePriority priority, LMC_FileCallback callback, void* user_data)
+{
+	int request;
+
+	if (string_is_empty(path) || !callback || priority < LMC_FILE_PRIORITY_CONTENT || priority > LMC_FILE_PRIORITY_THUMBNAIL)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return -1;
+	}
+
+	request = QueueFileRequest(path, false, NULL, 0, priority, callback, user_data);
+	if (request < 0)
+		LMC_SetLastError(LMC_ERR_OUT_OF_MEMORY);
+	return request;
+}
+
+/*!
+ * \brief
+ * Writes a whole file in the background.
+ *
+ * \param path
+ * File to create or replace.
+ *
+ * \param data
+ * Data to write, copied before the call returns.
+ *
+ * \param size
+ * Number of bytes to write.
+ *
+ * \param priority
+ * Priority class, member of the LMC_FilePriority enumeration.
+ *
+ * \param callback
+ * Called from LMC_UpdateFrame() once the write completes, NULL for none.
+ *
+ * \param user_data
+ * Pointer handed back to the callback.
+ *
+ * \returns
+ * Request handle for LMC_CancelFileRequest(), -1 on failure.
+ */
+int LMC_WriteFileAsync(const char* path, const void* data, size_t size, LMC_FilePriority priority, LMC_FileCallback callback, void* user_data)
+{
+	int request;
+
+	if (string_is_empty(path) || (!data && size > 0) || priority < LMC_FILE_PRIORITY_CONTENT || priority > LMC_FILE_PRIORITY_THUMBNAIL)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return -1;
+	}
+
+	request = QueueFileRequest(path, true, data, size, priority, callback, user_data);
+	if (request < 0)
+		LMC_SetLastError(LMC_ERR_OUT_OF_MEMORY);
+	return request;
+}
+
+/*!
+ * \brief
+ * Cancels a file request.
+ *
+ * \param request
+ * Handle returned by LMC_ReadFileAsync() or LMC_WriteFileAsync().
+ *
+ * \returns
+ * True if the request was cancelled and false if it already called back. A cancelled request
+ * never calls back, a write may have partly reached the file.
+ */
+bool LMC_CancelFileRequest(int request)
+{
+	return CancelFileRequest(request);
+}
+
+/*!
+ * \brief
+ * Sets how many file requests read or write at once.
+ *
+ * \param count
+ * Number of requests, from 1 to 16. The default is 4.
+ */
+void LMC_SetFileRequestLimit(int count)
+{
+	if (count < 1 || count > IO_MAX_IN_FLIGHT_LIMIT)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return;
+	}
+
+	legacy_machine->io->max_in_flight = (unsigned)count;
+}
+
 /**************************************************************************************************
  * LegacyMachine Logging Functions
  *************************************************************************************************/
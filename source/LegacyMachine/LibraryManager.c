@@ -0,0 +1,982 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <file/file_path.h>
+#include <lists/dir_list.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#include <compat/strl.h>
+#include <compat/posix_string.h>
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
+#include <lrc_hash.h>
+#ifdef HAVE_COMPRESSION
+#include <file/archive_file.h>
+#endif
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "LibraryManager.h"
+#include "Logging.h"
+#include "Common/FileMap.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define LIBRARY_POLL_USEC		(20 * 1000)		/* Delay between checks on a running scan. */
+#define LIBRARY_NAME_LENGTH		256				/* Longest DAT game name kept. */
+
+/**************************************************************************************************
+ * Library Scan Structures
+ *************************************************************************************************/
+
+/* ROM entry from a DAT file. */
+typedef struct DatRom
+{
+	uint64_t	size;
+	uint32_t	crc;
+	uint32_t	name;						/* Offset of the game name in the DAT string pool. */
+	uint8_t		sha1[LIBRARY_SHA1_SIZE];
+	bool		has_sha1;
+}
+DatRom;
+
+/* DAT ROMs sorted by CRC32. */
+typedef struct DatFile
+{
+	DatRom*		roms;
+	char*		strings;
+	uint32_t	count;
+	uint32_t	capacity;
+	uint32_t	strings_size;
+	uint32_t	strings_capacity;
+}
+DatFile;
+
+/* File found by a scan. */
+typedef struct ScanFile
+{
+	const char*		path;						/* Owned by the directory list. */
+	const char*		name;						/* DAT game name, NULL uses the file name. */
+	uint64_t		size;
+	uint64_t		content_size;				/* Size of the content, inside the file for archives. */
+	int64_t			mtime;
+	uint32_t		crc;
+	uint32_t		flags;
+	uint8_t			sha1[LIBRARY_SHA1_SIZE];
+	bool			hashed;						/* CRC32 is known, from the old index or hashing. */
+}
+ScanFile;
+
+/* Scan state shared by the task, the scan thread and the hashing workers. */
+typedef struct LibraryScan
+{
+	char				directory[PATH_MAX_LENGTH];
+	char				extensions[PATH_MAX_LENGTH];
+	char				dat_path[PATH_MAX_LENGTH];
+	char				index_path[PATH_MAX_LENGTH];
+	LibraryIndex		old;					/* Previous index, records are reused for unchanged files. */
+	LibraryIndex		result;					/* New index built by the scan. */
+	uint32_t			strings_capacity;
+	DatFile				dat;
+	struct string_list*	list;
+	ScanFile*			files;
+	size_t				count;
+	size_t				next;					/* Next file to hash. */
+	size_t				hashed;					/* Files hashed by this scan. */
+#ifdef HAVE_THREADS
+	sthread_t*			thread;
+	slock_t*			lock;
+#endif
+	volatile bool		cancel;
+	bool				done;
+	bool				failed;
+}
+LibraryScan;
+
+/**************************************************************************************************
+ * LibraryManager Context
+ *************************************************************************************************/
+
+static LibraryManager library_manager;
+
+/* Returns the library manager context. */
+LibraryManager* GetLibraryManagerContext(void)
+{
+	return &library_manager;
+}
+
+/**************************************************************************************************
+ * Library Index Files
+ *************************************************************************************************/
+
+/* Appends a string to a growing pool, returns its offset or UINT32_MAX on failure. */
+static uint32_t AddString(char** pool, uint32_t* size, uint32_t* capacity, const char* str)
+{
+	size_t len = strlen(str) + 1;
+	uint32_t offset = *size;
+
+	if (*size + len > *capacity)
+	{
+		uint32_t new_capacity = *capacity ? *capacity : 4096;
+		char* new_pool;
+
+		while (*size + len > new_capacity)
+			new_capacity *= 2;
+		new_pool = (char*)realloc(*pool, new_capacity);
+		if (!new_pool)
+			return UINT32_MAX;
+		*pool = new_pool;
+		*capacity = new_capacity;
+	}
+
+	memcpy(*pool + offset, str, len);
+	*size += (uint32_t)len;
+	return offset;
+}
+
+/* Releases an index's records and strings. */
+void FreeLibraryIndex(LibraryIndex* index)
+{
+	free(index->records);
+	free(index->strings);
+	memset(index, 0, sizeof(LibraryIndex));
+}
+
+/* Reads an index file into memory with a single read. */
+static bool ReadLibraryIndex(const char* index_path, LibraryIndex* index)
+{
+	LibraryIndexHeader header;
+	void* buf = NULL;
+	int64_t len = 0;
+	size_t records_size;
+
+	memset(index, 0, sizeof(LibraryIndex));
+	if (!filestream_read_file(index_path, &buf, &len))
+		return false;
+
+	if ((size_t)len < sizeof(header))
+		goto error;
+	memcpy(&header, buf, sizeof(header));
+	records_size = (size_t)header.count * sizeof(LibraryRecord);
+	if (header.magic != LIBRARY_INDEX_MAGIC || header.version != LIBRARY_INDEX_VERSION ||
+		header.record_size != sizeof(LibraryRecord) ||
+		(uint64_t)len != sizeof(header) + records_size + header.strings_size ||
+		(header.strings_size && ((char*)buf)[len - 1] != '\0'))
+		goto error;
+
+	index->records = (LibraryRecord*)malloc(records_size ? records_size : 1);
+	index->strings = (char*)malloc(header.strings_size ? header.strings_size : 1);
+	if (!index->records || !index->strings)
+		goto error;
+
+	memcpy(index->records, (uint8_t*)buf + sizeof(header), records_size);
+	memcpy(index->strings, (uint8_t*)buf + sizeof(header) + records_size, header.strings_size);
+	index->count = header.count;
+	index->strings_size = header.strings_size;
+	free(buf);
+	return true;
+
+error:
+	FreeLibraryIndex(index);
+	free(buf);
+	return false;
+}
+
+/* Writes an index to a temporary file and renames it over the old one. */
+static bool WriteLibraryIndex(const char* index_path, const LibraryIndex* index)
+{
+	char tmp_path[PATH_MAX_LENGTH];
+	LibraryIndexHeader header;
+	RFILE* file;
+	bool ok;
+
+	header.magic = LIBRARY_INDEX_MAGIC;
+	header.version = LIBRARY_INDEX_VERSION;
+	header.record_size = sizeof(LibraryRecord);
+	header.count = index->count;
+	header.strings_size = index->strings_size;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", index_path);
+	file = filestream_open(tmp_path, RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+	if (!file)
+		return false;
+
+	ok = filestream_write(file, &header, sizeof(header)) == sizeof(header) &&
+		filestream_write(file, index->records, (int64_t)index->count * sizeof(LibraryRecord)) ==
+			(int64_t)index->count * sizeof(LibraryRecord) &&
+		filestream_write(file, index->strings, index->strings_size) == index->strings_size;
+	ok = filestream_close(file) == 0 && ok;
+
+#ifdef _WIN32
+	/* rename() won't replace an existing file on Windows. */
+	if (ok && filestream_exists(index_path))
+		filestream_delete(index_path);
+#endif
+	if (!ok || filestream_rename(tmp_path, index_path) != 0)
+	{
+		filestream_delete(tmp_path);
+		return false;
+	}
+	return true;
+}
+
+/* Loads an index file as the current library. */
+bool LoadLibraryIndex(const char* index_path)
+{
+	LibraryIndex index;
+
+	if (library_manager.task != NULL || !ReadLibraryIndex(index_path, &index))
+		return false;
+
+	FreeLibraryIndex(&library_manager.index);
+	library_manager.index = index;
+	return true;
+}
+
+/**************************************************************************************************
+ * DAT Files
+ *************************************************************************************************/
+
+/* Checks whether a tag starts with the given element name. */
+static bool IsTag(const char* tag, const char* name)
+{
+	size_t len = strlen(name);
+	return strncmp(tag, name, len) == 0 &&
+		(tag[len] == ' ' || tag[len] == '\t' || tag[len] == '\r' || tag[len] == '\n' ||
+		 tag[len] == '/' || tag[len] == '>');
+}
+
+/* Copies an attribute value out of a tag, decoding the standard XML entities. */
+static bool GetAttribute(const char* tag, const char* end, const char* attr, char* out, size_t size)
+{
+	size_t len = strlen(attr);
+	const char* p = tag;
+	size_t n = 0;
+	char quote;
+
+	for (;;)
+	{
+		p = strstr(p, attr);
+		if (!p || p >= end)
+			return false;
+		if ((p[-1] == ' ' || p[-1] == '\t' || p[-1] == '\r' || p[-1] == '\n') &&
+			p[len] == '=' && (p[len + 1] == '"' || p[len + 1] == '\''))
+			break;
+		p += len;
+	}
+
+	quote = p[len + 1];
+	for (p += len + 2; p < end && *p != quote && n + 1 < size; p++)
+	{
+		char c = *p;
+
+		if (c == '&')
+		{
+			if (strncmp(p, "&amp;", 5) == 0) { c = '&'; p += 4; }
+			else if (strncmp(p, "&lt;", 4) == 0) { c = '<'; p += 3; }
+			else if (strncmp(p, "&gt;", 4) == 0) { c = '>'; p += 3; }
+			else if (strncmp(p, "&quot;", 6) == 0) { c = '"'; p += 5; }
+			else if (strncmp(p, "&apos;", 6) == 0) { c = '\''; p += 5; }
+		}
+		out[n++] = c;
+	}
+	out[n] = '\0';
+	return true;
+}
+
+/* Converts a hex SHA1 string to bytes. */
+static bool ParseSha1(const char* hex, uint8_t* sha1)
+{
+	int i;
+
+	if (strlen(hex) != LIBRARY_SHA1_SIZE * 2)
+		return false;
+
+	for (i = 0; i < LIBRARY_SHA1_SIZE; i++)
+	{
+		char byte[3] = { hex[i * 2], hex[i * 2 + 1], '\0' };
+		char* end;
+
+		sha1[i] = (uint8_t)strtoul(byte, &end, 16);
+		if (*end != '\0')
+			return false;
+	}
+	return true;
+}
+
+/* Orders DAT ROMs by CRC32. */
+static int CompareDatRoms(const void* a, const void* b)
+{
+	uint32_t crc_a = ((const DatRom*)a)->crc;
+	uint32_t crc_b = ((const DatRom*)b)->crc;
+	return crc_a < crc_b ? -1 : crc_a > crc_b;
+}
+
+/* Adds a ROM to the DAT. */
+static bool AddDatRom(DatFile* dat, const DatRom* rom)
+{
+	if (dat->count == dat->capacity)
+	{
+		uint32_t capacity = dat->capacity ? dat->capacity * 2 : 1024;
+		DatRom* roms = (DatRom*)realloc(dat->roms, capacity * sizeof(DatRom));
+
+		if (!roms)
+			return false;
+		dat->roms = roms;
+		dat->capacity = capacity;
+	}
+
+	dat->roms[dat->count++] = *rom;
+	return true;
+}
+
+/* Releases a DAT. */
+static void FreeDat(DatFile* dat)
+{
+	free(dat->roms);
+	free(dat->strings);
+	memset(dat, 0, sizeof(DatFile));
+}
+
+/* Reads the games and ROMs of a Logiqx XML DAT. */
+static bool LoadDat(const char* path, DatFile* dat)
+{
+	char game[LIBRARY_NAME_LENGTH] = "";
+	uint32_t game_name = UINT32_MAX;
+	void* buf = NULL;
+	int64_t len = 0;
+	const char* p;
+
+	if (!filestream_read_file(path, &buf, &len))
+		return false;
+
+	for (p = (const char*)buf; (p = strchr(p, '<')) != NULL; )
+	{
+		const char* end;
+
+		p++;
+		end = strchr(p, '>');
+		if (!end)
+			break;
+
+		if (IsTag(p, "game") || IsTag(p, "machine"))
+		{
+			if (GetAttribute(p, end, "name", game, sizeof(game)))
+				game_name = AddString(&dat->strings, &dat->strings_size, &dat->strings_capacity, game);
+		}
+		else if (IsTag(p, "rom") && game_name != UINT32_MAX)
+		{
+			char value[LIBRARY_NAME_LENGTH];
+			DatRom rom;
+
+			memset(&rom, 0, sizeof(rom));
+			rom.name = game_name;
+			if (!GetAttribute(p, end, "crc", value, sizeof(value)))
+				continue;
+			rom.crc = (uint32_t)strtoul(value, NULL, 16);
+			if (GetAttribute(p, end, "size", value, sizeof(value)))
+				rom.size = strtoull(value, NULL, 10);
+			if (GetAttribute(p, end, "sha1", value, sizeof(value)))
+				rom.has_sha1 = ParseSha1(value, rom.sha1);
+			if (!AddDatRom(dat, &rom))
+				break;
+		}
+		p = end;
+	}
+
+	free(buf);
+	qsort(dat->roms, dat->count, sizeof(DatRom), CompareDatRoms);
+	return dat->count > 0;
+}
+
+/* Finds the DAT ROM with the given CRC32 and size. */
+static const DatRom* FindDatRom(const DatFile* dat, uint32_t crc, uint64_t size)
+{
+	DatRom key;
+	const DatRom* rom;
+
+	if (dat->count == 0)
+		return NULL;
+
+	key.crc = crc;
+	rom = (const DatRom*)bsearch(&key, dat->roms, dat->count, sizeof(DatRom), CompareDatRoms);
+	if (!rom)
+		return NULL;
+
+	/* Several ROMs can share a CRC, step back to the first and look for the size. */
+	while (rom > dat->roms && rom[-1].crc == crc)
+		rom--;
+	for (; rom < dat->roms + dat->count && rom->crc == crc; rom++)
+	{
+		if (rom->size == size)
+			return rom;
+	}
+	return NULL;
+}
+
+/**************************************************************************************************
+ * Library Scanning
+ *************************************************************************************************/
+
+/* Orders index records by path. */
+static const char* sort_strings;
+static int CompareRecords(const void* a, const void* b)
+{
+	return strcmp(sort_strings + ((const LibraryRecord*)a)->path,
+		sort_strings + ((const LibraryRecord*)b)->path);
+}
+
+/* Orders scanned files by path. */
+static int CompareScanFiles(const void* a, const void* b)
+{
+	return strcmp(((const ScanFile*)a)->path, ((const ScanFile*)b)->path);
+}
+
+/* Finds a file in the previous index by path. */
+static const LibraryRecord* FindRecord(const LibraryIndex* index, const char* path)
+{
+	size_t lo = 0;
+	size_t hi = index->count;
+
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		int cmp = strcmp(path, index->strings + index->records[mid].path);
+
+		if (cmp == 0)
+			return &index->records[mid];
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return NULL;
+}
+
+/* Reads a file's size and modification time. */
+static bool StatFile(const char* path, uint64_t* size, int64_t* mtime)
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_stat64(path, &st) != 0)
+		return false;
+#else
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return false;
+#endif
+	*size = (uint64_t)st.st_size;
+	*mtime = (int64_t)st.st_mtime;
+	return true;
+}
+
+/* Checks whether an extension is in a '|' separated list, ignoring case. */
+static bool HasExtension(const char* extensions, const char* ext)
+{
+	size_t length = strlen(ext);
+
+	while (length && extensions && *extensions)
+	{
+		const char* next = strchr(extensions, '|');
+		size_t count = next ? (size_t)(next - extensions) : strlen(extensions);
+
+		if (count == length && strncasecmp(extensions, ext, length) == 0)
+			return true;
+		extensions = next ? next + 1 : NULL;
+	}
+	return false;
+}
+
+#ifdef HAVE_COMPRESSION
+
+/* Archive member picked as an archive's content. */
+typedef struct ArchiveContent
+{
+	const char*	extensions;
+	uint64_t	size;
+	uint32_t	crc;
+	bool		found;
+}
+ArchiveContent;
+
+/* Archive walk callback, takes the first member with a scanned extension or else the first file. */
+static int FindArchiveContent(const char* name, const char* valid_exts, const uint8_t* cdata,
+	unsigned cmode, uint32_t csize, uint32_t size, uint32_t crc32, struct archive_extract_userdata* userdata)
+{
+	ArchiveContent* content = (ArchiveContent*)userdata->cb_data;
+	size_t length = strlen(name);
+	bool suitable;
+
+	if (length == 0 || name[length - 1] == '/' || name[length - 1] == '\\')
+		return 1;
+
+	suitable = !path_is_compressed_file(name) && HasExtension(content->extensions, path_get_extension(name));
+	if (suitable || !content->found)
+	{
+		content->size = size;
+		content->crc = crc32;
+		content->found = true;
+	}
+	return suitable ? 0 : 1;
+}
+
+/* Takes an archive's content CRC32 and size from its directory, nothing is decompressed. */
+static bool HashArchive(LibraryScan* scan, ScanFile* file)
+{
+	struct archive_extract_userdata userdata = { 0 };
+	file_archive_transfer_t transfer = { 0 };
+	ArchiveContent content = { 0 };
+	bool ok = true;
+
+	content.extensions = scan->extensions;
+	userdata.cb_data = &content;
+	transfer.type = ARCHIVE_TRANSFER_INIT;
+	while (file_archive_parse_file_iterate(&transfer, &ok, file->path, NULL, FindArchiveContent, &userdata) == 0)
+		;
+
+	if (!ok || !content.found)
+		return false;
+
+	file->crc = content.crc;
+	file->content_size = content.size;
+	return true;
+}
+
+#endif
+
+/* Computes a file's CRC32 from a read-only mapping, archives use their content's CRC32. */
+static bool HashFile(LibraryScan* scan, ScanFile* file)
+{
+	size_t size = 0;
+	void* data;
+
+#ifdef HAVE_COMPRESSION
+	if (path_is_compressed_file(file->path))
+		return HashArchive(scan, file);
+#endif
+
+	file->content_size = file->size;
+	if (file->size == 0)
+	{
+		file->crc = 0;
+		return true;
+	}
+
+	data = MapFileReadOnly(file->path, &size);
+	if (!data)
+		return false;
+	file->crc = encoding_crc32(0, (const uint8_t*)data, size);
+	UnmapFileReadOnly(data, size);
+	return true;
+}
+
+/* Hashes a file if it changed and matches it against the DAT. */
+static void ProcessFile(LibraryScan* scan, ScanFile* file)
+{
+	const DatRom* rom;
+
+	if (!file->hashed)
+	{
+		file->flags = 0;
+		if (!HashFile(scan, file))
+		{
+			/* Still listed, as unidentified content the next scan tries again. */
+			lmc_core_log(RETRO_LOG_WARN, "Library scan could not read %s, indexing it unidentified", file->path);
+			file->crc = 0;
+			file->content_size = file->size;
+			file->flags = LIBRARY_FLAG_UNREAD;
+			return;
+		}
+		file->hashed = true;
+	}
+
+	file->flags &= ~LIBRARY_FLAG_MATCHED;
+	rom = FindDatRom(&scan->dat, file->crc, file->content_size);
+	if (!rom)
+		return;
+
+	/* CRC32 matches are confirmed with the SHA1 when the DAT has one. Archived content would
+	 * have to be decompressed for it, its CRC32 and size are taken as they are. */
+	if (rom->has_sha1 && !path_is_compressed_file(file->path))
+	{
+		if (!(file->flags & LIBRARY_FLAG_SHA1))
+		{
+			char hex[LIBRARY_SHA1_SIZE * 2 + 1];
+
+			if (sha1_calculate(file->path, hex) != 0 || !ParseSha1(hex, file->sha1))
+				return;
+			file->flags |= LIBRARY_FLAG_SHA1;
+		}
+		if (memcmp(file->sha1, rom->sha1, LIBRARY_SHA1_SIZE) != 0)
+			return;
+	}
+
+	file->name = scan->dat.strings + rom->name;
+	file->flags |= LIBRARY_FLAG_MATCHED;
+}
+
+/* Takes the next file to process, NULL once all are taken or the scan is cancelled. */
+static ScanFile* NextScanFile(LibraryScan* scan)
+{
+	ScanFile* file = NULL;
+
+#ifdef HAVE_THREADS
+	slock_lock(scan->lock);
+#endif
+	if (!scan->cancel && scan->next < scan->count)
+	{
+		file = &scan->files[scan->next++];
+		if (!file->hashed)
+			scan->hashed++;
+	}
+#ifdef HAVE_THREADS
+	slock_unlock(scan->lock);
+#endif
+	return file;
+}
+
+/* Hashing worker, processes files until none are left. */
+static void ScanWorker(void* data)
+{
+	LibraryScan* scan = (LibraryScan*)data;
+	ScanFile* file;
+
+	while ((file = NextScanFile(scan)) != NULL)
+		ProcessFile(scan, file);
+}
+
+/* Lists the directory and picks up the unchanged files from the previous index. */
+static bool ListFiles(LibraryScan* scan)
+{
+	size_t i;
+
+	scan->list = dir_list_new(scan->directory, string_is_empty(scan->extensions) ? NULL : scan->extensions,
+		false, false, false, true);
+	if (!scan->list)
+		return false;
+
+	scan->files = (ScanFile*)calloc(scan->list->size ? scan->list->size : 1, sizeof(ScanFile));
+	if (!scan->files)
+		return false;
+
+	for (i = 0; i < scan->list->size && !scan->cancel; i++)
+	{
+		ScanFile* file = &scan->files[scan->count];
+		const LibraryRecord* record;
+
+		file->path = scan->list->elems[i].data;
+		if (!StatFile(file->path, &file->size, &file->mtime))
+			continue;
+
+		record = FindRecord(&scan->old, file->path);
+		if (record && record->size == file->size && record->mtime == file->mtime &&
+			!(record->flags & LIBRARY_FLAG_UNREAD))
+		{
+			file->crc = record->crc;
+			file->content_size = record->content_size;
+			file->flags = record->flags & LIBRARY_FLAG_SHA1;
+			memcpy(file->sha1, record->sha1, LIBRARY_SHA1_SIZE);
+			file->hashed = true;
+		}
+		scan->count++;
+	}
+
+	qsort(scan->files, scan->count, sizeof(ScanFile), CompareScanFiles);
+	return true;
+}
+
+/* Processes the listed files on a pool of workers. */
+static void ProcessFiles(LibraryScan* scan)
+{
+#ifdef HAVE_THREADS
+	sthread_t* workers[LIBRARY_MAX_WORKERS];
+	unsigned count = cpu_features_get_core_amount();
+	unsigned i;
+
+	if (count > LIBRARY_MAX_WORKERS)
+		count = LIBRARY_MAX_WORKERS;
+
+	/* The scan thread hashes alongside the extra workers. */
+	for (i = 1; i < count; i++)
+		workers[i] = sthread_create(ScanWorker, scan);
+	ScanWorker(scan);
+	for (i = 1; i < count; i++)
+	{
+		if (workers[i])
+			sthread_join(workers[i]);
+	}
+#else
+	ScanWorker(scan);
+#endif
+}
+
+/* Builds the new index from the processed files. */
+static bool BuildIndex(LibraryScan* scan)
+{
+	LibraryIndex* index = &scan->result;
+	size_t i;
+
+	index->records = (LibraryRecord*)calloc(scan->count ? scan->count : 1, sizeof(LibraryRecord));
+	if (!index->records)
+		return false;
+
+	for (i = 0; i < scan->count; i++)
+	{
+		const ScanFile* file = &scan->files[i];
+		LibraryRecord* record = &index->records[index->count];
+		char name[PATH_MAX_LENGTH];
+
+		if (file->name)
+			strlcpy(name, file->name, sizeof(name));
+		else
+		{
+			strlcpy(name, path_basename(file->path), sizeof(name));
+			path_remove_extension(name);
+		}
+
+		record->size = file->size;
+		record->content_size = file->content_size;
+		record->mtime = file->mtime;
+		record->crc = file->crc;
+		record->flags = file->flags;
+		memcpy(record->sha1, file->sha1, LIBRARY_SHA1_SIZE);
+		record->path = AddString(&index->strings, &index->strings_size, &scan->strings_capacity, file->path);
+		record->name = AddString(&index->strings, &index->strings_size, &scan->strings_capacity, name);
+		if (record->path == UINT32_MAX || record->name == UINT32_MAX)
+			return false;
+		index->count++;
+	}
+
+	return true;
+}
+
+/* Runs a whole scan, on its own thread when threads are available. */
+static void RunScan(void* data)
+{
+	LibraryScan* scan = (LibraryScan*)data;
+
+	if (!string_is_empty(scan->dat_path) && !LoadDat(scan->dat_path, &scan->dat))
+		lmc_core_log(RETRO_LOG_WARN, "Library scan could not read DAT %s", scan->dat_path);
+
+	if (!ListFiles(scan))
+		scan->failed = true;
+	else
+	{
+		ProcessFiles(scan);
+		if (!scan->cancel)
+		{
+			scan->failed = !BuildIndex(scan);
+			if (!scan->failed && !WriteLibraryIndex(scan->index_path, &scan->result))
+				lmc_core_log(RETRO_LOG_WARN, "Failed to write library index %s", scan->index_path);
+		}
+	}
+
+#ifdef HAVE_THREADS
+	slock_lock(scan->lock);
+	scan->done = true;
+	slock_unlock(scan->lock);
+#else
+	scan->done = true;
+#endif
+}
+
+/* Releases a scan and everything it built. */
+static void FreeScan(LibraryScan* scan)
+{
+#ifdef HAVE_THREADS
+	if (scan->thread)
+		sthread_join(scan->thread);
+	if (scan->lock)
+		slock_free(scan->lock);
+#endif
+	if (scan->list)
+		string_list_free(scan->list);
+	FreeLibraryIndex(&scan->old);
+	FreeLibraryIndex(&scan->result);
+	FreeDat(&scan->dat);
+	free(scan->files);
+	free(scan);
+}
+
+/* Checks whether the scan has finished. */
+static bool IsScanDone(LibraryScan* scan)
+{
+	bool done;
+
+#ifdef HAVE_THREADS
+	slock_lock(scan->lock);
+	done = scan->done;
+	slock_unlock(scan->lock);
+#else
+	done = scan->done;
+#endif
+	return done;
+}
+
+/* Background task handler, polls the scan thread so other tasks keep running. */
+static void LibraryTaskHandler(retro_task_t* task)
+{
+	LibraryScan* scan = (LibraryScan*)task->state;
+
+	if (task_get_cancelled(task))
+		scan->cancel = true;
+
+#ifdef HAVE_THREADS
+	if (!scan->thread)
+	{
+		scan->thread = sthread_create(RunScan, scan);
+		if (!scan->thread)
+			RunScan(scan);
+	}
+#else
+	RunScan(scan);
+#endif
+
+	if (!IsScanDone(scan))
+	{
+		task->when = cpu_features_get_time_usec() + LIBRARY_POLL_USEC;
+		return;
+	}
+
+	if (scan->failed && !scan->cancel)
+		task_set_error(task, strdup("Library scan failed"));
+	task_set_progress(task, 100);
+	task_set_finished(task, true);
+}
+
+/* Background task callback, swaps the new index in on the main loop. */
+static void LibraryTaskCallback(retro_task_t* task, void* task_data, void* user_data, const char* error)
+{
+	LibraryScan* scan = (LibraryScan*)task->state;
+
+	task->state = NULL;
+	library_manager.task = NULL;
+
+	if (error == NULL && !scan->cancel)
+	{
+		lmc_core_log(RETRO_LOG_INFO, "Library scan found %u files, %u hashed",
+			scan->result.count, (unsigned)scan->hashed);
+		FreeLibraryIndex(&library_manager.index);
+		library_manager.index = scan->result;
+		memset(&scan->result, 0, sizeof(LibraryIndex));
+	}
+	else if (error != NULL)
+		lmc_core_log(RETRO_LOG_ERROR, "%s: %s", error, scan->directory);
+
+	FreeScan(scan);
+}
+
+/* Checks whether a library scan is still pending. */
+static bool IsLibraryTaskPending(void* data)
+{
+	return library_manager.task != NULL;
+}
+
+/* Starts scanning a directory in the background, the index is replaced once it completes. */
+bool StartLibraryScan(const char* directory, const char* extensions, const char* dat_path, const char* index_path)
+{
+	LibraryScan* scan;
+	retro_task_t* task;
+	size_t i;
+
+	if (library_manager.task != NULL)
+		return false;
+
+	scan = (LibraryScan*)calloc(1, sizeof(LibraryScan));
+	if (!scan)
+		return false;
+
+	strlcpy(scan->directory, directory, sizeof(scan->directory));
+	strlcpy(scan->extensions, extensions ? extensions : "", sizeof(scan->extensions));
+	strlcpy(scan->dat_path, dat_path ? dat_path : "", sizeof(scan->dat_path));
+	strlcpy(scan->index_path, index_path, sizeof(scan->index_path));
+
+	/* The scan works from its own copy of the current index, sorted by path for lookups. */
+	if (library_manager.index.count)
+	{
+		LibraryIndex* old = &scan->old;
+
+		old->records = (LibraryRecord*)malloc(library_manager.index.count * sizeof(LibraryRecord));
+		old->strings = (char*)malloc(library_manager.index.strings_size);
+		if (old->records && old->strings)
+		{
+			old->count = library_manager.index.count;
+			old->strings_size = library_manager.index.strings_size;
+			memcpy(old->records, library_manager.index.records, old->count * sizeof(LibraryRecord));
+			memcpy(old->strings, library_manager.index.strings, old->strings_size);
+			for (i = 1; i < old->count; i++)
+			{
+				if (strcmp(old->strings + old->records[i - 1].path, old->strings + old->records[i].path) > 0)
+				{
+					sort_strings = old->strings;
+					qsort(old->records, old->count, sizeof(LibraryRecord), CompareRecords);
+					break;
+				}
+			}
+		}
+		else
+			FreeLibraryIndex(old);
+	}
+
+#ifdef HAVE_THREADS
+	scan->lock = slock_new();
+	if (!scan->lock)
+	{
+		FreeScan(scan);
+		return false;
+	}
+#endif
+
+	task = task_init();
+	if (!task)
+	{
+		FreeScan(scan);
+		return false;
+	}
+
+	task->handler = LibraryTaskHandler;
+	task->callback = LibraryTaskCallback;
+	task->state = scan;
+	task->mute = true;
+	library_manager.task = task;
+	if (!task_queue_push(task))
+	{
+		library_manager.task = NULL;
+		free(task);
+		FreeScan(scan);
+		return false;
+	}
+	return true;
+}
+
+/* Cancels a scan in progress and waits for it to wind down, keeping the current index. */
+void CancelLibraryScan(void)
+{
+	if (library_manager.task == NULL)
+		return;
+
+	task_set_cancelled(library_manager.task, true);
+	while (library_manager.task != NULL)
+		task_queue_wait(IsLibraryTaskPending, NULL);
+}
@@ -0,0 +1,99 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _LIBRARY_MANAGER_H
+#define _LIBRARY_MANAGER_H
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <retro_miscellaneous.h>
+#include <queues/task_queue.h>
+
+#include "LegacyMachine.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define LIBRARY_INDEX_FILE		"library.idx"	/* Index file in the settings directory. */
+#define LIBRARY_INDEX_MAGIC		0x494C4D4C		/* "LMLI" */
+#define LIBRARY_INDEX_VERSION	2
+#define LIBRARY_MAX_WORKERS		4				/* Hashing threads during a scan. */
+#define LIBRARY_SHA1_SIZE		20
+
+#define LIBRARY_FLAG_MATCHED	(1 << 0)		/* Content matched a DAT entry. */
+#define LIBRARY_FLAG_SHA1		(1 << 1)		/* SHA1 has been computed. */
+#define LIBRARY_FLAG_UNREAD		(1 << 2)		/* File couldn't be read, it's unidentified. */
+
+/**************************************************************************************************
+ * LibraryManager Structures
+ *************************************************************************************************/
+
+/* Library entry as stored in the index, strings are offsets into the string pool. */
+typedef struct LibraryRecord
+{
+	uint64_t	size;						/* File size. */
+	uint64_t	content_size;				/* Content size, the member's size for archives. */
+	int64_t		mtime;						/* File modification time. */
+	uint32_t	path;						/* Offset of the content path. */
+	uint32_t	name;						/* Offset of the display name. */
+	uint32_t	crc;						/* CRC32 of the content, from the directory for archives. */
+	uint32_t	flags;						/* LIBRARY_FLAG_* */
+	uint8_t		sha1[LIBRARY_SHA1_SIZE];	/* SHA1 of the file, when LIBRARY_FLAG_SHA1 is set. */
+}
+LibraryRecord;
+
+/* Index header, followed by the records and the string pool. */
+typedef struct LibraryIndexHeader
+{
+	uint32_t	magic;						/* LIBRARY_INDEX_MAGIC */
+	uint32_t	version;					/* LIBRARY_INDEX_VERSION */
+	uint32_t	record_size;				/* sizeof(LibraryRecord), guards against other builds. */
+	uint32_t	count;						/* Number of records. */
+	uint32_t	strings_size;				/* Size of the string pool. */
+}
+LibraryIndexHeader;
+
+/* Records sorted by path with their string pool. */
+typedef struct LibraryIndex
+{
+	LibraryRecord*	records;
+	char*			strings;
+	uint32_t		count;
+	uint32_t		strings_size;
+}
+LibraryIndex;
+
+typedef struct LibraryManager
+{
+	LibraryIndex	index;					/* Current library, swapped in when a scan finishes. */
+	retro_task_t*	task;					/* Scan in progress. */
+}
+LibraryManager;
+
+/**************************************************************************************************
+ * LibraryManager Prototypes
+ *************************************************************************************************/
+
+RETRO_BEGIN_DECLS
+
+LibraryManager* GetLibraryManagerContext(void);
+bool LoadLibraryIndex(const char* index_path);
+bool StartLibraryScan(const char* directory, const char* extensions, const char* dat_path, const char* index_path);
+void CancelLibraryScan(void);
+void FreeLibraryIndex(LibraryIndex* index);
+
+RETRO_END_DECLS
+
+#endif
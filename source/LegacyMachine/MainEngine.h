@@ -28,6 +28,13 @@
 #include "Menu/MenuManager.h"
 #endif
 #include "SystemManager.h"
+#include "MovieManager.h"
+#include "ContentManager.h"
+#include "VFSManager.h"
+#include "LibraryManager.h"
+#include "SaveManager.h"
+#include "DiskManager.h"
+#include "IOManager.h"
 #include "CoreLibrary.h"
 
 /**************************************************************************************************
@@ -45,6 +52,13 @@ typedef struct MainEngine
 	MenuManager*			menu;		/* Pointer to frontend menu manager. */
 #endif
 	SystemManager*			system;		/* Pointer to libretro system manager. */	
+	MovieManager*			movie;		/* Pointer to input movie manager. */
+	ContentManager*			content;	/* Pointer to content manager. */
+	VFSManager*				vfs;		/* Pointer to core file system manager. */
+	LibraryManager*			library;	/* Pointer to content library manager. */
+	SaveManager*			save;		/* Pointer to battery save manager. */
+	DiskManager*			disk;		/* Pointer to disc image manager. */
+	IOManager*				io;			/* Pointer to asynchronous file I/O manager. */
 	WindowDriver*			window;		/* Pointer to window driver. */
 	VideoDriver*			video;		/* Pointer to video driver. */
 	AudioDriver*			audio;		/* Pointer to audio driver. */
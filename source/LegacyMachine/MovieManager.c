@@ -0,0 +1,414 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_endianness.h>
+
+#include "MovieManager.h"
+#include "MainEngine.h"
+#include "Logging.h"
+#include "Common/Hash.h"
+
+/**************************************************************************************************
+ * MovieManager Context
+ *************************************************************************************************/
+
+static MovieManager movie_manager = { 0 };
+
+/**************************************************************************************************
+ * Local Movie Functions
+ *************************************************************************************************/
+
+/* Write little endian values to the movie being recorded. */
+static bool WriteMovie8(uint8_t value)
+{
+	return filestream_write(movie_manager.file, &value, sizeof(value)) == sizeof(value);
+}
+
+static bool WriteMovie16(uint16_t value)
+{
+	value = swap_if_big16(value);
+	return filestream_write(movie_manager.file, &value, sizeof(value)) == sizeof(value);
+}
+
+static bool WriteMovie32(uint32_t value)
+{
+	value = swap_if_big32(value);
+	return filestream_write(movie_manager.file, &value, sizeof(value)) == sizeof(value);
+}
+
+static bool WriteMovie64(uint64_t value)
+{
+	value = swap_if_big64(value);
+	return filestream_write(movie_manager.file, &value, sizeof(value)) == sizeof(value);
+}
+
+/* Read little endian values from the movie being played back. */
+static uint16_t ReadMovie16(const uint8_t** cursor)
+{
+	uint16_t value;
+	memcpy(&value, *cursor, sizeof(value));
+	*cursor += sizeof(value);
+	return swap_if_big16(value);
+}
+
+static uint32_t ReadMovie32(const uint8_t** cursor)
+{
+	uint32_t value;
+	memcpy(&value, *cursor, sizeof(value));
+	*cursor += sizeof(value);
+	return swap_if_big32(value);
+}
+
+static uint64_t ReadMovie64(const uint8_t** cursor)
+{
+	uint64_t value;
+	memcpy(&value, *cursor, sizeof(value));
+	*cursor += sizeof(value);
+	return swap_if_big64(value);
+}
+
+/* Allocates the scratch buffer used to serialize the running core's state. */
+static bool AllocateMovieStateBuffer(void)
+{
+	CoreLibrary* core = legacy_machine->system->current_core;
+	size_t size = core->retro_serialize_size ? core->retro_serialize_size() : 0;
+
+	if (size == 0 || !core->retro_serialize)
+		return false;
+
+	movie_manager.state = (uint8_t*)malloc(size);
+	if (!movie_manager.state)
+		return false;
+
+	movie_manager.state_size = size;
+	return true;
+}
+
+/* Serializes the running core's state into the scratch buffer and hashes it. */
+static bool HashMovieCoreState(uint64_t* hash)
+{
+	CoreLibrary* core = legacy_machine->system->current_core;
+	size_t size;
+
+	if (!movie_manager.state)
+		return false;
+
+	/* Never grow the buffer here, a state that no longer fits is simply not hashed. */
+	size = core->retro_serialize_size();
+	if (size == 0 || size > movie_manager.state_size)
+		return false;
+	if (!core->retro_serialize(movie_manager.state, size))
+		return false;
+
+	*hash = HashMemory64(movie_manager.state, size);
+	return true;
+}
+
+/* Writes the pending run of identical input frames. */
+static bool FlushMovieRun(void)
+{
+	bool ok = true;
+	unsigned i;
+
+	if (movie_manager.run == 0)
+		return true;
+
+	ok = WriteMovie8(MOVIE_RECORD_INPUT) && WriteMovie32(movie_manager.run);
+	for (i = 0; i < MAX_PLAYERS && ok; i++)
+		ok = WriteMovie16(movie_manager.masks[i]);
+
+	movie_manager.run = 0;
+	return ok;
+}
+
+/**************************************************************************************************
+ * MovieManager Functions
+ *************************************************************************************************/
+
+/* Returns the current movie manager context. */
+MovieManager* GetMovieManagerContext(void)
+{
+	return &movie_manager;
+}
+
+/* Starts recording input to a movie file, anchored to the current state or to a reset. */
+bool BeginMovieRecording(const char* path, bool from_state, unsigned hash_interval)
+{
+	CoreLibrary* core = legacy_machine->system->current_core;
+	size_t state_size = 0;
+	bool ok;
+
+	EndMovie();
+	movie_manager.desync_frame = -1;
+
+	if ((from_state || hash_interval) && !AllocateMovieStateBuffer())
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Movie recording requires a core that supports serialization");
+		EndMovie();
+		return false;
+	}
+
+	if (from_state)
+	{
+		state_size = movie_manager.state_size;
+		if (!core->retro_serialize(movie_manager.state, state_size))
+		{
+			lmc_trace(LMC_LOG_ERRORS, "Failed to serialize movie anchor state");
+			EndMovie();
+			return false;
+		}
+	}
+	else
+	{
+		core->retro_reset();
+	}
+
+	movie_manager.file = filestream_open(path, RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+	if (!movie_manager.file)
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Failed to create movie file %s", path);
+		EndMovie();
+		return false;
+	}
+
+	ok = WriteMovie32(MOVIE_MAGIC) && WriteMovie32(MOVIE_VERSION) && WriteMovie32(MAX_PLAYERS) &&
+		WriteMovie32(hash_interval) && WriteMovie64(state_size);
+	if (ok && state_size)
+		ok = filestream_write(movie_manager.file, movie_manager.state, state_size) == (int64_t)state_size;
+	if (!ok)
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Failed to write movie file %s", path);
+		EndMovie();
+		return false;
+	}
+
+	movie_manager.hash_interval = hash_interval;
+	movie_manager.mode = MOVIE_RECORDING;
+	return true;
+}
+
+/* Starts playing back a movie file in place of live input. */
+bool BeginMoviePlayback(const char* path, bool verify)
+{
+	CoreLibrary* core = legacy_machine->system->current_core;
+	void* data = NULL;
+	int64_t size = 0;
+	uint64_t state_size;
+
+	EndMovie();
+	movie_manager.desync_frame = -1;
+
+	/* The whole movie is read up front so playback never touches the disk or allocates. */
+	if (!filestream_read_file(path, &data, &size))
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Failed to load movie file %s", path);
+		return false;
+	}
+
+	movie_manager.data = (uint8_t*)data;
+	movie_manager.cursor = movie_manager.data;
+	movie_manager.end = movie_manager.data + size;
+
+	if (size < 24 ||
+		ReadMovie32(&movie_manager.cursor) != MOVIE_MAGIC ||
+		ReadMovie32(&movie_manager.cursor) != MOVIE_VERSION ||
+		ReadMovie32(&movie_manager.cursor) != MAX_PLAYERS)
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Invalid movie file %s", path);
+		EndMovie();
+		return false;
+	}
+
+	movie_manager.hash_interval = ReadMovie32(&movie_manager.cursor);
+	state_size = ReadMovie64(&movie_manager.cursor);
+	if (state_size > (uint64_t)(movie_manager.end - movie_manager.cursor))
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Invalid movie file %s", path);
+		EndMovie();
+		return false;
+	}
+
+	movie_manager.verify = verify && movie_manager.hash_interval;
+	if (movie_manager.verify && !AllocateMovieStateBuffer())
+	{
+		lmc_trace(LMC_LOG_ERRORS, "Movie verification requires a core that supports serialization");
+		movie_manager.verify = false;
+	}
+
+	if (state_size)
+	{
+		if (!core->retro_unserialize || !core->retro_unserialize(movie_manager.cursor, (size_t)state_size))
+		{
+			lmc_trace(LMC_LOG_ERRORS, "Failed to restore movie anchor state");
+			EndMovie();
+			return false;
+		}
+		movie_manager.cursor += state_size;
+	}
+	else
+	{
+		core->retro_reset();
+	}
+
+	movie_manager.mode = MOVIE_PLAYBACK;
+	return true;
+}
+
+/* Stops recording or playing back a movie. */
+void EndMovie(void)
+{
+	int desync_frame;
+
+	if (movie_manager.file)
+	{
+		if (movie_manager.mode == MOVIE_RECORDING)
+		{
+			FlushMovieRun();
+			WriteMovie8(MOVIE_RECORD_END);
+		}
+		filestream_close(movie_manager.file);
+	}
+
+	if (movie_manager.data)
+		free(movie_manager.data);
+	if (movie_manager.state)
+		free(movie_manager.state);
+
+	/* Keep the desync result around after playback ends. */
+	desync_frame = movie_manager.desync_frame;
+	memset(&movie_manager, 0, sizeof(movie_manager));
+	movie_manager.desync_frame = desync_frame;
+}
+
+/* Loads the recorded input for the frame about to run. */
+void UpdateMovieFrame(void)
+{
+	if (movie_manager.mode != MOVIE_PLAYBACK)
+		return;
+
+	while (movie_manager.run == 0)
+	{
+		uint8_t type;
+		unsigned i;
+
+		if (movie_manager.cursor >= movie_manager.end)
+			type = MOVIE_RECORD_END;
+		else
+			type = *movie_manager.cursor++;
+
+		if (type == MOVIE_RECORD_INPUT &&
+			movie_manager.end - movie_manager.cursor >= (ptrdiff_t)(sizeof(uint32_t) + sizeof(uint16_t) * MAX_PLAYERS))
+		{
+			movie_manager.run = ReadMovie32(&movie_manager.cursor);
+			for (i = 0; i < MAX_PLAYERS; i++)
+				movie_manager.masks[i] = ReadMovie16(&movie_manager.cursor);
+		}
+		else if (type == MOVIE_RECORD_HASH &&
+			movie_manager.end - movie_manager.cursor >= (ptrdiff_t)(sizeof(uint32_t) + sizeof(uint64_t)))
+		{
+			/* A hash that was not consumed at its frame boundary is stale. */
+			movie_manager.cursor += sizeof(uint32_t) + sizeof(uint64_t);
+		}
+		else
+		{
+			lmc_trace(LMC_LOG_VERBOSE, "Movie playback finished after %u frames", movie_manager.frame);
+			EndMovie();
+			return;
+		}
+	}
+
+	movie_manager.run--;
+}
+
+/* Records the input the core saw this frame, or verifies the state while playing back. */
+void FinishMovieFrame(void)
+{
+	JoypadInputState* joypad_state = legacy_machine->input->joypad->state;
+	uint64_t hash;
+
+	if (movie_manager.mode == MOVIE_RECORDING)
+	{
+		uint16_t masks[MAX_PLAYERS];
+		bool ok = true;
+		unsigned i;
+
+		/* LMC_INPUT_B (bit 1) lines up with RETRO_DEVICE_ID_JOYPAD_B (bit 0). */
+		for (i = 0; i < MAX_PLAYERS; i++)
+			masks[i] = (uint16_t)(joypad_state[i].inputs >> 1);
+
+		if (movie_manager.run &&
+			(memcmp(masks, movie_manager.masks, sizeof(masks)) != 0 || movie_manager.run == UINT32_MAX))
+			ok = FlushMovieRun();
+
+		memcpy(movie_manager.masks, masks, sizeof(masks));
+		movie_manager.run++;
+		movie_manager.frame++;
+
+		if (ok && movie_manager.hash_interval && (movie_manager.frame % movie_manager.hash_interval) == 0 &&
+			HashMovieCoreState(&hash))
+		{
+			ok = FlushMovieRun() && WriteMovie8(MOVIE_RECORD_HASH) &&
+				WriteMovie32(movie_manager.frame) && WriteMovie64(hash);
+		}
+
+		if (!ok)
+		{
+			lmc_trace(LMC_LOG_ERRORS, "Failed to write movie, recording stopped");
+			EndMovie();
+		}
+	}
+	else if (movie_manager.mode == MOVIE_PLAYBACK)
+	{
+		movie_manager.frame++;
+
+		/* Hashes are recorded right after the run that ends on their frame. */
+		if (movie_manager.run == 0 &&
+			movie_manager.end - movie_manager.cursor >= (ptrdiff_t)(1 + sizeof(uint32_t) + sizeof(uint64_t)) &&
+			*movie_manager.cursor == MOVIE_RECORD_HASH)
+		{
+			const uint8_t* record = movie_manager.cursor + 1;
+			uint32_t frame = ReadMovie32(&record);
+			uint64_t expected = ReadMovie64(&record);
+
+			if (frame == movie_manager.frame)
+			{
+				movie_manager.cursor = record;
+
+				if (movie_manager.verify && movie_manager.desync_frame < 0 &&
+					HashMovieCoreState(&hash) && hash != expected)
+				{
+					movie_manager.desync_frame = (int)frame;
+					lmc_trace(LMC_LOG_ERRORS, "Movie playback desynchronized at frame %u", frame);
+				}
+			}
+		}
+	}
+}
+
+/* Gets recorded input state on a given port while playing back. */
+int16_t GetMovieInputState(unsigned port, unsigned device, unsigned index, unsigned id)
+{
+	if (port >= MAX_PLAYERS || device != RETRO_DEVICE_JOYPAD)
+		return 0;
+
+	if (id == RETRO_DEVICE_ID_JOYPAD_MASK)
+		return (int16_t)movie_manager.masks[port];
+
+	return (int16_t)((movie_manager.masks[port] >> (id & 0x0F)) & 1);
+}
@@ -0,0 +1,83 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _MOVIE_MANAGER_H
+#define _MOVIE_MANAGER_H
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <streams/file_stream.h>
+
+#include "LegacyMachine.h"
+#include "Input/InputDriver.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define MOVIE_MAGIC		0x4D434D4C	/* "LMCM" */
+#define MOVIE_VERSION	1
+
+/* Movie record types. */
+#define MOVIE_RECORD_INPUT	0	/* Run length followed by one joypad bitmask per port. */
+#define MOVIE_RECORD_HASH	1	/* Frame number followed by a hash of the serialized state. */
+#define MOVIE_RECORD_END	2	/* End of movie. */
+
+/**************************************************************************************************
+ * MovieManager Structure
+ *************************************************************************************************/
+
+typedef enum
+{
+	MOVIE_IDLE,
+	MOVIE_RECORDING,
+	MOVIE_PLAYBACK
+}
+MovieMode;
+
+typedef struct MovieManager
+{
+	RFILE*			file;					/* Output stream while recording. */
+	uint8_t*		data;					/* Whole movie file while playing back. */
+	const uint8_t*	cursor;					/* Next record to play back. */
+	const uint8_t*	end;					/* End of the movie data. */
+	uint8_t*		state;					/* Scratch buffer for serialized state hashes. */
+	size_t			state_size;				/* Size of the scratch buffer. */
+	uint16_t		masks[MAX_PLAYERS];		/* Joypad bitmasks for the current frame. */
+	uint32_t		run;					/* Frames in (recording) or left in (playback) the current run. */
+	uint32_t		frame;					/* Frames run since the movie started. */
+	uint32_t		hash_interval;			/* Frames between state hashes, 0 = none. */
+	int				desync_frame;			/* First frame a state hash mismatched, -1 = none. */
+	MovieMode		mode;					/* Current movie mode. */
+	bool			verify;					/* True to verify state hashes while playing back. */
+}
+MovieManager;
+
+/**************************************************************************************************
+ * MovieManager Prototypes
+ *************************************************************************************************/
+
+RETRO_BEGIN_DECLS
+
+MovieManager* GetMovieManagerContext(void);
+bool BeginMovieRecording(const char* path, bool from_state, unsigned hash_interval);
+bool BeginMoviePlayback(const char* path, bool verify);
+void EndMovie(void);
+void UpdateMovieFrame(void);
+void FinishMovieFrame(void);
+int16_t GetMovieInputState(unsigned port, unsigned device, unsigned index, unsigned id);
+
+RETRO_END_DECLS
+
+#endif
@@ -0,0 +1,357 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#include <compat/strl.h>
+#include <compat/fopen_utf8.h>
+#ifdef _WIN32
+#include <encodings/utf.h>
+#endif
+
+#include "SaveManager.h"
+#include "MainEngine.h"
+#include "Logging.h"
+#include "Common/Hash.h"
+
+/**************************************************************************************************
+ * SaveManager Context
+ *************************************************************************************************/
+
+static SaveManager save_manager = { 0 };
+
+/**************************************************************************************************
+ * Local Save Functions
+ *************************************************************************************************/
+
+/* Replaces a file with a fully written temporary file. */
+static bool ReplaceSaveFile(const char* tmp_path, const char* path)
+{
+#ifdef _WIN32
+	wchar_t* tmp_path_w = utf8_to_utf16_string_alloc(tmp_path);
+	wchar_t* path_w = utf8_to_utf16_string_alloc(path);
+	bool ok = tmp_path_w && path_w &&
+		MoveFileExW(tmp_path_w, path_w, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+
+	free(tmp_path_w);
+	free(path_w);
+	return ok;
+#else
+	char dir[PATH_MAX_LENGTH];
+	int fd;
+
+	if (rename(tmp_path, path) != 0)
+		return false;
+
+	/* Sync the directory so the rename itself survives a power cut. */
+	fill_pathname_basedir(dir, path, sizeof(dir));
+	fd = open(dir, O_RDONLY);
+	if (fd >= 0)
+	{
+		fsync(fd);
+		close(fd);
+	}
+	return true;
+#endif
+}
+
+/* Writes a save to a temporary file, syncs it to disk and renames it over the old save, so
+ * a power cut leaves either the old or the new save. */
+static bool WriteSaveFile(const char* path, const void* data, size_t size)
+{
+	char tmp_path[PATH_MAX_LENGTH];
+	FILE* file;
+	bool ok;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	file = (FILE*)fopen_utf8(tmp_path, "wb");
+	if (!file)
+		return false;
+
+	ok = fwrite(data, 1, size, file) == size && fflush(file) == 0;
+#ifdef _WIN32
+	ok = ok && _commit(_fileno(file)) == 0;
+#else
+	ok = ok && fsync(fileno(file)) == 0;
+#endif
+	ok = fclose(file) == 0 && ok;
+
+	if (!ok || !ReplaceSaveFile(tmp_path, path))
+	{
+		remove(tmp_path);
+		return false;
+	}
+	return true;
+}
+
+/* Writes a snapshot, logging the outcome. */
+static void WriteSaveSnapshot(SaveSnapshot* snapshot)
+{
+	if (WriteSaveFile(snapshot->path, snapshot->data, snapshot->size))
+	{
+		save_manager.writes++;
+		lmc_core_log(RETRO_LOG_INFO, "Saved SRAM to %s", snapshot->path);
+	}
+	else
+	{
+		save_manager.failures++;
+		lmc_core_log(RETRO_LOG_ERROR, "Failed to save SRAM to %s", snapshot->path);
+	}
+}
+
+#ifdef HAVE_THREADS
+/* Writer thread, writes the latest snapshot whenever one is queued. */
+static void SaveWriter(void* data)
+{
+	slock_lock(save_manager.lock);
+	for (;;)
+	{
+		SaveSnapshot snapshot;
+
+		while (!save_manager.queued && !save_manager.quit)
+			scond_wait(save_manager.cond, save_manager.lock);
+		if (!save_manager.queued)
+			break;
+
+		/* Take the pending snapshot, the emulation thread fills the other buffer meanwhile. */
+		snapshot = save_manager.writing;
+		save_manager.writing = save_manager.pending;
+		save_manager.pending = snapshot;
+		save_manager.queued = false;
+		save_manager.busy = true;
+		slock_unlock(save_manager.lock);
+
+		WriteSaveSnapshot(&save_manager.writing);
+
+		slock_lock(save_manager.lock);
+		save_manager.busy = false;
+		scond_broadcast(save_manager.cond);
+	}
+	slock_unlock(save_manager.lock);
+}
+
+/* Starts the writer thread. */
+static bool StartSaveWriter(void)
+{
+	if (save_manager.thread)
+		return true;
+
+	save_manager.lock = slock_new();
+	save_manager.cond = scond_new();
+	if (save_manager.lock && save_manager.cond)
+		save_manager.thread = sthread_create(SaveWriter, NULL);
+
+	if (!save_manager.thread)
+	{
+		if (save_manager.lock)
+			slock_free(save_manager.lock);
+		if (save_manager.cond)
+			scond_free(save_manager.cond);
+		save_manager.lock = NULL;
+		save_manager.cond = NULL;
+		return false;
+	}
+	return true;
+}
+
+/* Waits until every queued snapshot has been written. */
+static void WaitSaveWriter(void)
+{
+	if (!save_manager.thread)
+		return;
+
+	slock_lock(save_manager.lock);
+	while (save_manager.queued || save_manager.busy)
+		scond_wait(save_manager.cond, save_manager.lock);
+	slock_unlock(save_manager.lock);
+}
+#endif
+
+/* Copies the SRAM into the pending snapshot and hands it to the writer. */
+static bool QueueSaveRAM(void)
+{
+	SaveSnapshot* pending = &save_manager.pending;
+
+#ifdef HAVE_THREADS
+	if (!StartSaveWriter())
+		return false;
+	slock_lock(save_manager.lock);
+#endif
+
+	if (pending->capacity < save_manager.size)
+	{
+		uint8_t* data = (uint8_t*)realloc(pending->data, save_manager.size);
+
+		if (!data)
+		{
+#ifdef HAVE_THREADS
+			slock_unlock(save_manager.lock);
+#endif
+			return false;
+		}
+		pending->data = data;
+		pending->capacity = save_manager.size;
+	}
+
+	memcpy(pending->data, save_manager.sram, save_manager.size);
+	pending->size = save_manager.size;
+	strlcpy(pending->path, save_manager.path, sizeof(pending->path));
+
+#ifdef HAVE_THREADS
+	save_manager.queued = true;
+	scond_broadcast(save_manager.cond);
+	slock_unlock(save_manager.lock);
+#else
+	/* Without threads the save is written straight away. */
+	WriteSaveSnapshot(pending);
+#endif
+	return true;
+}
+
+/**************************************************************************************************
+ * SaveManager Functions
+ *************************************************************************************************/
+
+/* Returns the current save manager context. */
+SaveManager* GetSaveManagerContext(void)
+{
+	return &save_manager;
+}
+
+/* Loads the current content's SRAM file into the core's save RAM. */
+bool LoadSaveRAM(const char* save_dir, const char* name)
+{
+	CoreLibrary* core = legacy_machine->system->current_core;
+	void* data = NULL;
+	int64_t len = 0;
+
+	CloseSaveRAM();
+
+	if (!core->retro_get_memory_data || !core->retro_get_memory_size || string_is_empty(name))
+		return false;
+
+	save_manager.sram = core->retro_get_memory_data(RETRO_MEMORY_SAVE_RAM);
+	save_manager.size = core->retro_get_memory_size(RETRO_MEMORY_SAVE_RAM);
+	if (!save_manager.sram || save_manager.size == 0)
+	{
+		save_manager.sram = NULL;
+		save_manager.size = 0;
+		return false;
+	}
+
+	fill_pathname_join(save_manager.path, save_dir, name, sizeof(save_manager.path));
+	strlcat(save_manager.path, SAVE_RAM_EXTENSION, sizeof(save_manager.path));
+
+#ifdef HAVE_THREADS
+	/* A save of this content may still be on its way to disk. */
+	WaitSaveWriter();
+#endif
+
+	if (path_is_valid(save_manager.path) && filestream_read_file(save_manager.path, &data, &len))
+	{
+		if ((size_t)len != save_manager.size)
+			lmc_core_log(RETRO_LOG_WARN, "SRAM file %s is %lld bytes, the core expects %u",
+				save_manager.path, (long long)len, (unsigned)save_manager.size);
+		memcpy(save_manager.sram, data, (size_t)len < save_manager.size ? (size_t)len : save_manager.size);
+		free(data);
+		lmc_core_log(RETRO_LOG_INFO, "Loaded SRAM from %s", save_manager.path);
+	}
+
+	/* Only SRAM that changes from here on is written back. */
+	save_manager.hash = HashMemory64(save_manager.sram, save_manager.size);
+	save_manager.frames = 0;
+	return true;
+}
+
+/* Counts a frame and checks the SRAM for changes every interval. */
+void UpdateSaveRAM(void)
+{
+	if (!save_manager.sram || save_manager.interval == 0)
+		return;
+
+	if (++save_manager.frames < save_manager.interval)
+		return;
+
+	save_manager.frames = 0;
+	FlushSaveRAM();
+}
+
+/* Queues the SRAM for writing if it changed since it was last loaded or queued. */
+bool FlushSaveRAM(void)
+{
+	uint64_t hash;
+
+	if (!save_manager.sram)
+		return false;
+
+	hash = HashMemory64(save_manager.sram, save_manager.size);
+	if (hash == save_manager.hash || !QueueSaveRAM())
+		return false;
+
+	save_manager.hash = hash;
+	return true;
+}
+
+/* Queues any last SRAM changes and detaches from the core's save RAM. */
+void CloseSaveRAM(void)
+{
+	FlushSaveRAM();
+
+	save_manager.sram = NULL;
+	save_manager.size = 0;
+	save_manager.path[0] = '\0';
+}
+
+/* Waits for queued saves to be written and stops the writer. */
+void DeinitSaveManager(void)
+{
+	CloseSaveRAM();
+
+#ifdef HAVE_THREADS
+	if (save_manager.thread)
+	{
+		slock_lock(save_manager.lock);
+		save_manager.quit = true;
+		scond_broadcast(save_manager.cond);
+		slock_unlock(save_manager.lock);
+
+		sthread_join(save_manager.thread);
+		slock_free(save_manager.lock);
+		scond_free(save_manager.cond);
+		save_manager.thread = NULL;
+		save_manager.lock = NULL;
+		save_manager.cond = NULL;
+	}
+#endif
+
+	free(save_manager.pending.data);
+	free(save_manager.writing.data);
+	memset(&save_manager.pending, 0, sizeof(save_manager.pending));
+	memset(&save_manager.writing, 0, sizeof(save_manager.writing));
+	save_manager.quit = false;
+}
@@ -0,0 +1,86 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _SAVE_MANAGER_H
+#define _SAVE_MANAGER_H
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <retro_miscellaneous.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "LegacyMachine.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define SAVE_CHECK_INTERVAL		60			/* Frames between SRAM change checks. */
+#define SAVE_RAM_EXTENSION		".srm"
+
+/**************************************************************************************************
+ * SaveManager Structure
+ *************************************************************************************************/
+
+/* SRAM copy handed to the writer. */
+typedef struct SaveSnapshot
+{
+	char		path[PATH_MAX_LENGTH];		/* File the SRAM is written to. */
+	uint8_t*	data;
+	size_t		size;
+	size_t		capacity;
+}
+SaveSnapshot;
+
+typedef struct SaveManager
+{
+	char			path[PATH_MAX_LENGTH];	/* SRAM file of the current content. */
+	void*			sram;					/* Core's save RAM, NULL if it has none. */
+	size_t			size;					/* Size of the core's save RAM. */
+	uint64_t		hash;					/* Hash of the SRAM last loaded or queued for writing. */
+	unsigned		interval;				/* Frames between change checks, 0 only checks on close. */
+	unsigned		frames;					/* Frames since the last check. */
+	SaveSnapshot	pending;				/* Latest SRAM waiting to be written. */
+	SaveSnapshot	writing;				/* SRAM the writer is working on. */
+	uint32_t		writes;					/* SRAM files written. */
+	uint32_t		failures;				/* SRAM files that failed to write. */
+#ifdef HAVE_THREADS
+	sthread_t*		thread;					/* Writer thread, started with the first write. */
+	slock_t*		lock;
+	scond_t*		cond;
+#endif
+	bool			queued;					/* The pending snapshot hasn't been taken by the writer. */
+	bool			busy;					/* The writer is writing a snapshot. */
+	bool			quit;					/* Writer exits once the queue is empty. */
+}
+SaveManager;
+
+/**************************************************************************************************
+ * SaveManager Prototypes
+ *************************************************************************************************/
+
+RETRO_BEGIN_DECLS
+
+SaveManager* GetSaveManagerContext(void);
+bool LoadSaveRAM(const char* save_dir, const char* name);
+void UpdateSaveRAM(void);
+bool FlushSaveRAM(void);
+void CloseSaveRAM(void);
+void DeinitSaveManager(void);
+
+RETRO_END_DECLS
+
+#endif
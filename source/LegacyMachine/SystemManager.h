@@ -17,6 +17,8 @@
 /**************************************************************************************************
  * Includes
  *************************************************************************************************/
+#include <retro_miscellaneous.h>
+
 #include "CoreLibrary.h"
 
 /**************************************************************************************************
@@ -24,6 +26,27 @@
  *************************************************************************************************/
 
 #define MAX_COUNTERS 64
+#define CORE_CACHE_MAX		8	/* Most closed cores that can be kept initialized. */
+
+/**************************************************************************************************
+ * CoreCacheEntry Structure
+ *************************************************************************************************/
+
+/* Closed core kept initialized, with the frontend state it set up, so reopening it is instant. */
+typedef struct CoreCacheEntry
+{
+	char										path[PATH_MAX_LENGTH];	/* Full core path. */
+	CoreLibrary									core;
+	struct retro_variable*						variables;
+	const struct retro_system_content_info_override* overrides;
+	struct retro_frame_time_callback			cb_frame_time;
+	struct retro_audio_callback					cb_audio;
+	struct retro_disk_control_ext_callback		cb_disk_control;
+	void*										content_map;	/* Last content's mapping, the core may hold on to it. */
+	size_t										content_map_size;
+	unsigned									last_used;	/* Cache clock when the core was closed. */
+}
+CoreCacheEntry;
 
 /**************************************************************************************************
  * SystemManager Structure
@@ -49,6 +72,13 @@ typedef struct SystemManager
 	struct retro_hw_render_callback		cb_hw_render; 
 
 	unsigned total_performance_counters;
+
+	/* Core cache */
+	char				core_path[PATH_MAX_LENGTH];	/* Full path of the current core. */
+	CoreCacheEntry		core_cache[CORE_CACHE_MAX];
+	unsigned			core_cache_size;			/* Closed cores kept, 0 disables the cache. */
+	unsigned			core_cache_clock;
+	LMC_CoreLoadStats	core_stats;
 }
 SystemManager;
 
@@ -0,0 +1,574 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include <vfs/vfs_implementation.h>
+#include <string/stdstring.h>
+#include <compat/strl.h>
+#include <compat/posix_string.h>
+
+#include "VFSManager.h"
+#include "Logging.h"
+#include "DiskManager.h"
+#include "Common/FileMap.h"
+#ifdef HAVE_CHD
+#include "ChdImage.h"
+#endif
+
+/**************************************************************************************************
+ * VFSManager Structures
+ *************************************************************************************************/
+
+/* File handle given to cores, in place of the bundled implementation's own handle. */
+typedef struct VFSFile
+{
+	libretro_vfs_implementation_file* stream;	/* Underlying file, NULL when mapped. */
+	VFSFileStats*	entry;				/* Statistics for the file's path. */
+	char*			path;				/* Path the core opened. */
+	uint8_t*		map;				/* Read-only mapping of the whole file. */
+	DiskImage*		disk;				/* Disc image lending its mapping, NULL if mapped here. */
+#ifdef HAVE_CHD
+	ChdImage*		chd;				/* CHD track, for "image.chd#track" paths. */
+#endif
+	uint8_t*		buffer;				/* Read-ahead buffer, NULL when reads go straight through. */
+	size_t			buffer_size;		/* Capacity of the read-ahead buffer. */
+	size_t			buffer_length;		/* Bytes held in the read-ahead buffer. */
+	int64_t			buffer_offset;		/* File offset of the buffer's first byte. */
+	int64_t			size;				/* File size, for files that track their own position. */
+	int64_t			position;			/* Position of the core's next read. */
+	int64_t			stream_position;	/* Position of the underlying file, -1 if unknown. */
+}
+VFSFile;
+
+/**************************************************************************************************
+ * VFSManager Context
+ *************************************************************************************************/
+
+static VFSManager vfs_manager = { 0 };
+
+/**************************************************************************************************
+ * Local Statistics Functions
+ *************************************************************************************************/
+
+static void LockStats(void)
+{
+#ifdef HAVE_THREADS
+	slock_lock(vfs_manager.lock);
+#endif
+}
+
+static void UnlockStats(void)
+{
+#ifdef HAVE_THREADS
+	slock_unlock(vfs_manager.lock);
+#endif
+}
+
+/* Finds the statistics entry for a path, taking a free one for paths not seen yet. */
+static VFSFileStats* OpenStatsEntry(const char* path, bool mapped)
+{
+	VFSFileStats* entry = NULL;
+	int i;
+
+	LockStats();
+
+	for (i = 0; i < VFS_MAX_FILE_STATS; i++)
+	{
+		if (string_is_equal(vfs_manager.files[i].path, path))
+		{
+			entry = &vfs_manager.files[i];
+			break;
+		}
+		if (entry == NULL && vfs_manager.files[i].path[0] == '\0')
+			entry = &vfs_manager.files[i];
+	}
+
+	if (entry == NULL)
+		entry = &vfs_manager.overflow;
+	else if (entry->path[0] == '\0')
+	{
+		strlcpy(entry->path, path, sizeof(entry->path));
+		entry->stats.path = entry->path;
+	}
+
+	entry->open++;
+	entry->stats.opens++;
+	entry->stats.mapped = mapped;
+
+	UnlockStats();
+	return entry;
+}
+
+static void CloseStatsEntry(VFSFileStats* entry)
+{
+	LockStats();
+	entry->open--;
+	UnlockStats();
+}
+
+/* Counts a call that reached the operating system, entries are shared by every open handle. */
+static void CountSyscall(VFSFile* file)
+{
+	LockStats();
+	file->entry->stats.syscalls++;
+	UnlockStats();
+}
+
+/**************************************************************************************************
+ * Local Read Functions
+ *************************************************************************************************/
+
+/* Reads from the underlying file, counting the call. */
+static int64_t ReadStream(VFSFile* file, void* s, uint64_t len)
+{
+	int64_t count = retro_vfs_file_read_impl(file->stream, s, len);
+
+	CountSyscall(file);
+	file->stream_position = count >= 0 ? file->stream_position + count : -1;
+	return count;
+}
+
+/* Moves the underlying file to a position, skipping the call when it's already there. */
+static bool SeekStream(VFSFile* file, int64_t position)
+{
+	if (file->stream_position == position)
+		return true;
+
+	CountSyscall(file);
+	if (retro_vfs_file_seek_impl(file->stream, position, RETRO_VFS_SEEK_POSITION_START) < 0)
+	{
+		file->stream_position = -1;
+		return false;
+	}
+
+	file->stream_position = position;
+	return true;
+}
+
+/* Checks whether reads are served here rather than by the implementation. */
+static bool HasOwnPosition(const VFSFile* file)
+{
+#ifdef HAVE_CHD
+	if (file->chd)
+		return true;
+#endif
+	return file->map != NULL || file->buffer != NULL;
+}
+
+/* Copies straight out of the file mapping. */
+static int64_t ReadMapped(VFSFile* file, void* s, uint64_t len)
+{
+	uint64_t count;
+
+	if (file->position >= file->size)
+		return 0;
+
+	count = MIN(len, (uint64_t)(file->size - file->position));
+	memcpy(s, file->map + file->position, (size_t)count);
+	file->position += count;
+	return (int64_t)count;
+}
+
+/* Serves small reads from the read-ahead buffer, refilling it with one large read on a miss. */
+static int64_t ReadBuffered(VFSFile* file, void* s, uint64_t len)
+{
+	uint8_t* out = (uint8_t*)s;
+	int64_t total = 0;
+	int64_t count;
+
+	while (len > 0 && file->position < file->size)
+	{
+		if (file->position >= file->buffer_offset &&
+			file->position < file->buffer_offset + (int64_t)file->buffer_length)
+		{
+			size_t offset = (size_t)(file->position - file->buffer_offset);
+			size_t length = (size_t)MIN(len, (uint64_t)(file->buffer_length - offset));
+
+			memcpy(out, file->buffer + offset, length);
+			out += length;
+			len -= length;
+			total += length;
+			file->position += length;
+			continue;
+		}
+
+		if (!SeekStream(file, file->position))
+			return total > 0 ? total : -1;
+
+		/* Reads at least as large as the buffer gain nothing from it. */
+		if (len >= file->buffer_size)
+		{
+			count = ReadStream(file, out, len);
+			if (count <= 0)
+				return total > 0 ? total : count;
+
+			out += count;
+			len -= count;
+			total += count;
+			file->position += count;
+			continue;
+		}
+
+		file->buffer_offset = file->position;
+		file->buffer_length = 0;
+		count = ReadStream(file, file->buffer, file->buffer_size);
+		if (count <= 0)
+			return total > 0 ? total : count;
+		file->buffer_length = (size_t)count;
+	}
+
+	return total;
+}
+
+/**************************************************************************************************
+ * Local VFS Interface Functions
+ *************************************************************************************************/
+
+static const char* RETRO_CALLCONV VFSGetPath(struct retro_vfs_file_handle* stream)
+{
+	VFSFile* file = (VFSFile*)stream;
+	return file ? file->path : NULL;
+}
+
+/* Opens a file, read-only files are memory mapped or read through the read-ahead buffer. */
+static struct retro_vfs_file_handle* RETRO_CALLCONV VFSOpen(const char* path, unsigned mode, unsigned hints)
+{
+	VFSFile* file;
+	size_t map_size = 0;
+	bool read_only = mode == RETRO_VFS_FILE_ACCESS_READ;
+
+	if (string_is_empty(path))
+		return NULL;
+
+	file = (VFSFile*)calloc(1, sizeof(VFSFile));
+	if (!file)
+		return NULL;
+
+	file->path = strdup(path);
+	file->stream_position = 0;
+
+#ifdef HAVE_CHD
+	/* CHD tracks are decompressed here, the image itself still opens as a plain file. */
+	if (IsChdTrackPath(path))
+	{
+		if (!read_only || (file->chd = OpenChdImage(path, vfs_manager.chd_cache_size)) == NULL)
+		{
+			free(file->path);
+			free(file);
+			return NULL;
+		}
+
+		file->size = GetChdImageSize(file->chd);
+		file->entry = OpenStatsEntry(path, false);
+		return (struct retro_vfs_file_handle*)file;
+	}
+#endif
+
+	/* Schemes such as cdrom:// are left to the implementation. */
+	if (read_only && strstr(path, "://") == NULL)
+	{
+		/* Disc images of the current content are already mapped and read ahead. */
+		if ((file->disk = AcquireDiskImage(path)) != NULL)
+		{
+			file->map = file->disk->map;
+			map_size = file->disk->size;
+		}
+		else
+			file->map = (uint8_t*)MapFileReadOnly(path, &map_size);
+		file->size = (int64_t)map_size;
+	}
+
+	if (file->map == NULL)
+	{
+		/* The implementation's own mapping is covered above, keep it to plain streams. */
+		file->stream = retro_vfs_file_open_impl(path, mode, hints & ~RETRO_VFS_FILE_ACCESS_HINT_FREQUENT_ACCESS);
+		if (!file->stream)
+		{
+			free(file->path);
+			free(file);
+			return NULL;
+		}
+
+		if (read_only && vfs_manager.read_ahead > 0)
+		{
+			file->size = retro_vfs_file_size_impl(file->stream);
+			file->buffer = (uint8_t*)malloc(vfs_manager.read_ahead);
+			file->buffer_size = vfs_manager.read_ahead;
+		}
+	}
+
+	file->entry = OpenStatsEntry(path, file->map != NULL);
+	return (struct retro_vfs_file_handle*)file;
+}
+
+static int RETRO_CALLCONV VFSClose(struct retro_vfs_file_handle* stream)
+{
+	VFSFile* file = (VFSFile*)stream;
+	int ret = 0;
+
+	if (!file)
+		return -1;
+
+	if (file->stream)
+		ret = retro_vfs_file_close_impl(file->stream);
+#ifdef HAVE_CHD
+	CloseChdImage(file->chd);
+#endif
+	if (file->disk)
+		ReleaseDiskImage(file->disk);
+	else
+		UnmapFileReadOnly(file->map, (size_t)file->size);
+	CloseStatsEntry(file->entry);
+
+	free(file->buffer);
+	free(file->path);
+	free(file);
+	return ret;
+}
+
+static int64_t RETRO_CALLCONV VFSSize(struct retro_vfs_file_handle* stream)
+{
+	VFSFile* file = (VFSFile*)stream;
+
+	if (!file)
+		return -1;
+	if (HasOwnPosition(file))
+		return file->size;
+	return retro_vfs_file_size_impl(file->stream);
+}
+
+static int64_t RETRO_CALLCONV VFSTruncate(struct retro_vfs_file_handle* stream, int64_t length)
+{
+	VFSFile* file = (VFSFile*)stream;
+
+	if (!file || HasOwnPosition(file))
+		return -1;
+
+	CountSyscall(file);
+	return retro_vfs_file_truncate_impl(file->stream, length);
+}
+
+static int64_t RETRO_CALLCONV VFSTell(struct retro_vfs_file_handle* stream)
+{
+	VFSFile* file = (VFSFile*)stream;
+
+	if (!file)
+		return -1;
+	if (HasOwnPosition(file))
+		return file->position;
+	return retro_vfs_file_tell_impl(file->stream);
+}
+
+/* Seeks within files that track their own position without touching the file, returns 0 like
+ * the implementation. */
+static int64_t RETRO_CALLCONV VFSSeek(struct retro_vfs_file_handle* stream, int64_t offset, int seek_position)
+{
+	VFSFile* file = (VFSFile*)stream;
+	int64_t position;
+
+	if (!file)
+		return -1;
+
+	if (!HasOwnPosition(file))
+	{
+		CountSyscall(file);
+		return retro_vfs_file_seek_impl(file->stream, offset, seek_position);
+	}
+
+	switch (seek_position)
+	{
+	case RETRO_VFS_SEEK_POSITION_START:
+		position = offset;
+		break;
+	case RETRO_VFS_SEEK_POSITION_CURRENT:
+		position = file->position + offset;
+		break;
+	case RETRO_VFS_SEEK_POSITION_END:
+		position = file->size + offset;
+		break;
+	default:
+		return -1;
+	}
+
+	if (position < 0)
+		return -1;
+
+	file->position = position;
+	return 0;
+}
+
+static int64_t RETRO_CALLCONV VFSRead(struct retro_vfs_file_handle* stream, void* s, uint64_t len)
+{
+	VFSFile* file = (VFSFile*)stream;
+	uint32_t misses = 0;
+	int64_t count;
+
+	if (!file || !s)
+		return -1;
+
+#ifdef HAVE_CHD
+	if (file->chd)
+	{
+		count = ReadChdImage(file->chd, file->position, s, len, &misses);
+		if (count > 0)
+			file->position += count;
+	}
+	else
+#endif
+	if (file->map)
+		count = ReadMapped(file, s, len);
+	else if (file->buffer)
+		count = ReadBuffered(file, s, len);
+	else
+		count = ReadStream(file, s, len);
+
+	LockStats();
+	file->entry->stats.reads++;
+	file->entry->stats.cache_misses += misses;
+	if (count > 0)
+		file->entry->stats.bytes_read += count;
+	UnlockStats();
+	return count;
+}
+
+static int64_t RETRO_CALLCONV VFSWrite(struct retro_vfs_file_handle* stream, const void* s, uint64_t len)
+{
+	VFSFile* file = (VFSFile*)stream;
+	int64_t count;
+
+	if (!file || HasOwnPosition(file))
+		return -1;
+
+	count = retro_vfs_file_write_impl(file->stream, s, len);
+
+	LockStats();
+	file->entry->stats.writes++;
+	file->entry->stats.syscalls++;
+	if (count > 0)
+		file->entry->stats.bytes_written += count;
+	UnlockStats();
+	return count;
+}
+
+static int RETRO_CALLCONV VFSFlush(struct retro_vfs_file_handle* stream)
+{
+	VFSFile* file = (VFSFile*)stream;
+
+	if (!file)
+		return -1;
+	if (HasOwnPosition(file))
+		return 0;
+
+	CountSyscall(file);
+	return retro_vfs_file_flush_impl(file->stream);
+}
+
+/* Interface handed to cores, paths and directories go straight to the implementation. */
+static const struct retro_vfs_interface vfs_interface =
+{
+	VFSGetPath,
+	VFSOpen,
+	VFSClose,
+	VFSSize,
+	VFSTell,
+	VFSSeek,
+	VFSRead,
+	VFSWrite,
+	VFSFlush,
+	retro_vfs_file_remove_impl,
+	retro_vfs_file_rename_impl,
+	VFSTruncate,
+	retro_vfs_stat_impl,
+	retro_vfs_mkdir_impl,
+	retro_vfs_opendir_impl,
+	retro_vfs_readdir_impl,
+	retro_vfs_dirent_get_name_impl,
+	retro_vfs_dirent_is_dir_impl,
+	retro_vfs_closedir_impl
+};
+
+/**************************************************************************************************
+ * VFSManager Functions
+ *************************************************************************************************/
+
+/* Returns the current VFS manager context. */
+VFSManager* GetVFSManagerContext(void)
+{
+#ifdef HAVE_THREADS
+	if (vfs_manager.lock == NULL)
+		vfs_manager.lock = slock_new();
+#endif
+	return &vfs_manager;
+}
+
+/* Hands the VFS interface to a core that asks for a version we support. */
+bool GetVFSInterface(struct retro_vfs_interface_info* info)
+{
+	if (info->required_interface_version > VFS_INTERFACE_VERSION)
+		return false;
+
+	info->required_interface_version = VFS_INTERFACE_VERSION;
+	info->iface = (struct retro_vfs_interface*)&vfs_interface;
+	return true;
+}
+
+/* Clears the statistics, entries of files still open keep their path. */
+void ResetVFSStats(void)
+{
+	int i;
+
+	LockStats();
+
+	for (i = 0; i < VFS_MAX_FILE_STATS; i++)
+	{
+		VFSFileStats* entry = &vfs_manager.files[i];
+
+		memset(&entry->stats, 0, sizeof(entry->stats));
+		if (entry->open > 0)
+			entry->stats.path = entry->path;
+		else
+			entry->path[0] = '\0';
+	}
+	memset(&vfs_manager.overflow.stats, 0, sizeof(vfs_manager.overflow.stats));
+
+	UnlockStats();
+}
+
+/* Copies the statistics of the index'th tracked file, cores may still be updating them. */
+bool GetVFSStats(int index, LMC_FileStats* stats)
+{
+	bool found = false;
+	int i;
+
+	LockStats();
+
+	for (i = 0; i < VFS_MAX_FILE_STATS && !found; i++)
+	{
+		if (vfs_manager.files[i].path[0] == '\0')
+			continue;
+
+		if (index-- == 0)
+		{
+			*stats = vfs_manager.files[i].stats;
+			found = true;
+		}
+	}
+
+	UnlockStats();
+	return found;
+}
@@ -0,0 +1,75 @@
+/*
+* LegacyMachine - A libRetro implementation for creating simple lo-fi
+* frontends intended to simulate the look and feel of the classic
+* video gaming consoles, computers, and arcade machines being emulated.
+*
+* Copyright (C) 2022-2024 Steven Leffew
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _VFS_MANAGER_H
+#define _VFS_MANAGER_H
+
+/**************************************************************************************************
+ * Includes
+ *************************************************************************************************/
+#include <retro_miscellaneous.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "LegacyMachine.h"
+#include "CoreLibrary.h"
+
+/**************************************************************************************************
+ * Definitions
+ *************************************************************************************************/
+
+#define VFS_INTERFACE_VERSION	3				/* Highest VFS API version offered to cores. */
+#define VFS_READ_AHEAD_SIZE		(64 * 1024)		/* Default read-ahead for buffered files. */
+#define VFS_MAX_FILE_STATS		64				/* Files tracked for I/O statistics. */
+#define VFS_CHD_CACHE_SIZE		(8 * 1024 * 1024)	/* Default hunk cache size per CHD track. */
+
+/**************************************************************************************************
+ * VFSManager Structures
+ *************************************************************************************************/
+
+/* I/O statistics for one path, shared by every handle a core opens on it. */
+typedef struct VFSFileStats
+{
+	char			path[PATH_MAX_LENGTH];	/* Path the core opened, empty for a free entry. */
+	LMC_FileStats	stats;					/* Counters reported through LMC_GetFileStats(). */
+	int				open;					/* Handles currently open on the path. */
+}
+VFSFileStats;
+
+typedef struct VFSManager
+{
+	VFSFileStats	files[VFS_MAX_FILE_STATS];	/* Statistics per path. */
+	VFSFileStats	overflow;				/* Counters for files beyond the tracked ones. */
+	size_t			read_ahead;				/* Read-ahead buffer size, 0 disables buffering. */
+	size_t			chd_cache_size;			/* Decompressed hunk cache size per CHD track. */
+#ifdef HAVE_THREADS
+	slock_t*		lock;					/* Guards the statistics table, cores may use threads. */
+#endif
+}
+VFSManager;
+
+/**************************************************************************************************
+ * VFSManager Prototypes
+ *************************************************************************************************/
+
+RETRO_BEGIN_DECLS
+
+VFSManager* GetVFSManagerContext(void);
+bool GetVFSInterface(struct retro_vfs_interface_info* info);
+void ResetVFSStats(void);
+bool GetVFSStats(int index, LMC_FileStats* stats);
+
+RETRO_END_DECLS
+
+#endif
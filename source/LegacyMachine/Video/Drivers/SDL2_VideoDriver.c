@@ -14,6 +14,7 @@
 /**************************************************************************************************
  * Includes
  *************************************************************************************************/
+#include <string.h>
 #include <SDL.h>
 
 #include "../VideoDriver.h"
@@ -250,7 +251,14 @@ static void SDL2_RefreshVideo(const void* data, unsigned width, unsigned height,
 #ifdef HAVE_MENU
 	else
 	{
-		TLN_SetRenderTarget(framebuffer, pitch);
+		/* Menus render into their own framebuffer, it keeps the scanlines Tilengine skips
+		 * between frames where the locked texture doesn't. */
+		const uint8_t* menu_data = (const uint8_t*)legacy_machine->menu->framebuffer.data;
+		uint8_t* texture_data = (uint8_t*)framebuffer;
+		unsigned y;
+
+		for (y = 0; y < height; y++)
+			memcpy(texture_data + y * frame->out_pitch, menu_data + y * pitch, width * sizeof(uint32_t));
 	}
 #endif
 	if (crt_filter->enabled && crt != NULL)
@@ -294,7 +294,7 @@ bool LMC_GetInput(LMC_Input input)
  */
 void LMC_EnableKeyboardAsJoypadInput(LMC_Player player, bool enable)
 {
-	legacy_machine->input->joypad->state[player].keyboard_enabled = enable;
+	GetJoypadConfigState(player)->keyboard_enabled = enable;
 }
 
 /*!
@@ -327,7 +327,8 @@ void LMC_AssignInputJoypad(LMC_Player player, int index)
  */
 void LMC_DefineJoypadInputKey(LMC_Player player, LMC_Input input, uint32_t keycode)
 {
-	legacy_machine->input->joypad->state[player].key_map[input & INPUT_MASK] = keycode;
+	GetJoypadConfigState(player)->key_map[input & INPUT_MASK] = keycode;
+	UpdateInputLookups(player);
 }
 
 /*!
@@ -345,7 +346,8 @@ void LMC_DefineJoypadInputKey(LMC_Player player, LMC_Input input, uint32_t keyco
  */
 void LMC_DefineJoypadInputButton(LMC_Player player, LMC_Input input, uint8_t joybutton)
 {
-	legacy_machine->input->joypad->state[player].button_map[input & INPUT_MASK] = joybutton;
+	GetJoypadConfigState(player)->button_map[input & INPUT_MASK] = joybutton;
+	UpdateInputLookups(player);
 }
 
 /*!
@@ -366,7 +368,7 @@ void LMC_DefineJoypadInputButton(LMC_Player player, LMC_Input input, uint8_t joy
  */
 void LMC_DefineJoypadInputHat(LMC_Player player, int hat_index, LMC_Input input, LMC_HatDirection hat_direction)
 {
-	legacy_machine->input->joypad->state[player].hat_map[hat_index][(int)hat_direction] = (uint8_t)input;
+	GetJoypadConfigState(player)->hat_map[hat_index][(int)hat_direction] = (uint8_t)input;
 }
 
 /*!
@@ -387,7 +389,108 @@ void LMC_DefineJoypadInputHat(LMC_Player player, int hat_index, LMC_Input input,
  */
 void LMC_DefineJoypadInputAxis(LMC_Player player, int axis_index, LMC_Input input, LMC_AxisDirection axis_direction)
 {
-	legacy_machine->input->joypad->state[player].axis_map[axis_index][(int)axis_direction] = (uint8_t)input;
+	GetJoypadConfigState(player)->axis_map[axis_index][(int)axis_direction] = (uint8_t)input;
+}
+
+/*!
+ * \brief
+ * Assigns a joypad axis to one of a player's analog stick axes.
+ *
+ * \param player
+ * Player number to configure (LMC_PLAYER1 - LMC_PLAYER8).
+ *
+ * \param axis_index
+ * Index of joypad axis to assign.
+ *
+ * \param stick
+ * Analog stick to associate with the joypad axis.
+ *
+ * \param axis
+ * Analog stick axis to associate with the joypad axis.
+ */
+void LMC_DefineJoypadInputAnalog(LMC_Player player, int axis_index, LMC_AnalogStick stick, LMC_AnalogAxis axis)
+{
+	if (axis_index < 0 || axis_index >= MAX_AXES || stick >= MAX_ANALOG_STICKS || axis >= MAX_ANALOG_AXES)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return;
+	}
+
+	GetJoypadConfigState(player)->analog_map[stick][axis] = (uint8_t)axis_index;
+	LMC_SetLastError(LMC_ERR_OK);
+}
+
+/*!
+ * \brief
+ * Configures how a player's analog stick deflection is reported to libretro cores.
+ *
+ * \param player
+ * Player number to configure (LMC_PLAYER1 - LMC_PLAYER8).
+ *
+ * \param deadzone
+ * Fraction of deflection around center reported as zero (0.0 - less than 1.0).
+ *
+ * \param sensitivity
+ * Multiplier applied after the response curve, output saturates at full deflection.
+ *
+ * \param curve
+ * Response curve, member of the LMC_AnalogCurve enumeration.
+ *
+ * \returns
+ * True if the response was applied or false if a parameter is invalid or out of memory.
+ *
+ * The response is precomputed into a table covering every raw axis value, so per-frame
+ * analog queries cost a single lookup.
+ */
+bool LMC_ConfigAnalogResponse(LMC_Player player, float deadzone, float sensitivity, LMC_AnalogCurve curve)
+{
+	JoypadInputState* joypad_state;
+
+	if (player > LMC_PLAYER8 || deadzone < 0.0f || deadzone >= 1.0f || sensitivity < 0.0f || curve > LMC_ANALOG_CUBIC)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return false;
+	}
+
+	joypad_state = GetJoypadConfigState(player);
+	joypad_state->analog_deadzone = deadzone;
+	joypad_state->analog_sensitivity = sensitivity;
+	joypad_state->analog_curve = curve;
+
+	if (!UpdateAnalogResponse(player))
+	{
+		LMC_SetLastError(LMC_ERR_OUT_OF_MEMORY);
+		return false;
+	}
+
+	LMC_SetLastError(LMC_ERR_OK);
+	return true;
+}
+
+/*!
+ * \brief
+ * Sets when input is polled for a running libretro core.
+ *
+ * \param poll_type
+ * Polling behavior, member of the LMC_PollType enumeration:
+ *   * LMC_POLL_EARLY: poll once before the core runs a frame.
+ *   * LMC_POLL_NORMAL: poll when the core calls retro_input_poll (default).
+ *   * LMC_POLL_LATE: poll on the core's first input query after retro_input_poll.
+ *
+ * Late polling samples keyboard and joypad state as close as possible to the moment the
+ * core reads it, trimming up to a frame of input latency. A core that requests a specific
+ * poll type through RETRO_ENVIRONMENT_POLL_TYPE_OVERRIDE takes precedence over this setting.
+ */
+void LMC_SetInputPollType(LMC_PollType poll_type)
+{
+	if (poll_type > LMC_POLL_LATE)
+	{
+		LMC_SetLastError(LMC_ERR_INV_PARAM);
+		return;
+	}
+
+	legacy_machine->input->poll_type = poll_type;
+	LMC_SetLastError(LMC_ERR_OK);
 }
 
 /*!
@@ -292,6 +292,9 @@ static bool SDL2_ProcessEvents(void)
 	if (!window_info.running)
 		return false;
 
+	/* Publish joypads connected since the last frame before routing their events. */
+	legacy_machine->input->joypad->cb_update();
+
 	/* dispatch message queue */
 	while (SDL_PollEvent(&evt))
 	{
@@ -373,9 +376,11 @@ static bool SDL2_ProcessEvents(void)
 			}
 			break;
 		case SDL_JOYDEVICEADDED:
+			/* Device index, the device is opened and configured on the hotplug thread. */
 			legacy_machine->input->joypad->cb_connect(evt.jdevice.which);
 			break;
 		case SDL_JOYDEVICEREMOVED:
+			/* Instance id. */
 			legacy_machine->input->joypad->cb_disconnect(evt.jdevice.which);
 			break;
 		}
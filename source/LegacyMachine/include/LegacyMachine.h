@@ -72,10 +72,6 @@ LMC_CRT;
 
 typedef struct MainEngine* LMC_Engine;		/*!< Engine context. */
 
-/* Callbacks */
-
-typedef void(*LMC_AutoConfigureJoypadCallback)(void);
-
 /*! Standard paths. */
 typedef enum
 {
@@ -104,6 +100,20 @@ typedef enum
 }
 LMC_Player;
 
+/* Callbacks */
+
+typedef void(*LMC_AutoConfigureJoypadCallback)(LMC_Player player, const char* name, int vendor, int product);
+typedef void(*LMC_FileCallback)(int request, const void* data, size_t size, bool ok, void* user_data);
+
+/*! Priority classes for LMC_ReadFileAsync() and LMC_WriteFileAsync(), higher classes start first. */
+typedef enum
+{
+	LMC_FILE_PRIORITY_CONTENT,		/*!< Content the player is waiting on. */
+	LMC_FILE_PRIORITY_SAVE,			/*!< Saves and settings. */
+	LMC_FILE_PRIORITY_THUMBNAIL		/*!< Menu artwork and other background reads. */
+}
+LMC_FilePriority;
+
 /*! Standard inputs query for libretro cores and LMC_GetInput(). */
 typedef enum
 {
@@ -158,6 +168,81 @@ typedef enum
 }
 LMC_AxisDirection;
 
+/*! Analog sticks for LMC_DefineJoypadInputAnalog(). */
+typedef enum
+{
+	LMC_ANALOG_LEFT,	/*!< Left analog stick. */
+	LMC_ANALOG_RIGHT,	/*!< Right analog stick. */
+	MAX_ANALOG_STICKS
+}
+LMC_AnalogStick;
+
+/*! Analog stick axes for LMC_DefineJoypadInputAnalog(). */
+typedef enum
+{
+	LMC_ANALOG_X,		/*!< Horizontal axis. */
+	LMC_ANALOG_Y,		/*!< Vertical axis. */
+	MAX_ANALOG_AXES
+}
+LMC_AnalogAxis;
+
+/*! Analog response curves for LMC_ConfigAnalogResponse(). */
+typedef enum
+{
+	LMC_ANALOG_LINEAR,		/*!< Output follows stick deflection. */
+	LMC_ANALOG_QUADRATIC,	/*!< Finer control near center, squared deflection. */
+	LMC_ANALOG_CUBIC		/*!< Finest control near center, cubed deflection. */
+}
+LMC_AnalogCurve;
+
+/*! Input polling behavior for libretro cores, set with LMC_SetInputPollType(). */
+typedef enum
+{
+	LMC_POLL_EARLY,		/*!< Poll input once before the core runs a frame. */
+	LMC_POLL_NORMAL,	/*!< Poll input when the core calls retro_input_poll (default). */
+	LMC_POLL_LATE		/*!< Poll input on the core's first input state query after retro_input_poll. */
+}
+LMC_PollType;
+
+/*! I/O statistics for a file opened by a core through the VFS interface, see LMC_GetFileStats(). */
+typedef struct
+{
+	const char*	path;			/*!< Path the core opened. */
+	uint64_t	bytes_read;		/*!< Bytes the core read. */
+	uint64_t	bytes_written;	/*!< Bytes the core wrote. */
+	uint32_t	reads;			/*!< Read calls made by the core. */
+	uint32_t	writes;			/*!< Write calls made by the core. */
+	uint32_t	syscalls;		/*!< Calls that reached the operating system, mapped reads make none. */
+	uint32_t	opens;			/*!< Times the core opened the file. */
+	uint32_t	cache_misses;	/*!< CHD hunks decompressed on the reading thread instead of prefetched. */
+	bool		mapped;			/*!< File was memory mapped the last time it was opened. */
+}
+LMC_FileStats;
+
+/*! Core loading statistics, see LMC_GetCoreLoadStats(). */
+typedef struct
+{
+	uint64_t	load_usec;		/*!< Time the last LMC_LoadCore() call took in microseconds. */
+	uint64_t	saved_usec;		/*!< Startup time saved by reusing cached cores so far. */
+	uint32_t	hits;			/*!< Cores reused from the core cache. */
+	uint32_t	misses;			/*!< Cores loaded from disk and initialized. */
+	bool		cached;			/*!< The last core loaded came from the core cache. */
+}
+LMC_CoreLoadStats;
+
+/*! Content found by a library scan, see LMC_GetLibraryEntry(). */
+typedef struct
+{
+	const char*	path;			/*!< Full content path. */
+	const char*	name;			/*!< DAT game name when matched, the file name otherwise. */
+	uint64_t	size;			/*!< Content size in bytes, of the archive member for archives. */
+	uint32_t	crc;			/*!< CRC32 of the content, of the archive member for archives. 0 when unreadable. */
+	char		sha1[41];		/*!< SHA1 of the file as hex, empty unless it was needed for a DAT match. */
+	bool		matched;		/*!< Content matched an entry of the scan's DAT file. */
+	bool		unidentified;	/*!< File couldn't be read, it's listed without a CRC32. */
+}
+LMC_LibraryEntry;
+
 /*! CreateWindow flags. Can be none or a combination of the following: */
 enum
 {
@@ -221,9 +306,44 @@ LMCAPI uint32_t LMC_GetVersion(void);
 LMCAPI bool LMC_IsCoreRunning(void);
 LMCAPI bool LMC_LoadCore(const char* filename);
 LMCAPI bool LMC_LoadContent(const char* filename);
+LMCAPI bool LMC_IsContentLoading(void);
+LMCAPI void LMC_PrefetchContent(const char* core, const char* content);
 LMCAPI void LMC_CloseCore(void);
+LMCAPI void LMC_SetCoreCacheSize(int size);
+LMCAPI bool LMC_GetCoreLoadStats(LMC_CoreLoadStats* stats);
 LMCAPI void LMC_UpdateFrame(int frame);
 
+/*****************************************************************************
+ * Movie Management
+ ****************************************************************************/
+LMCAPI bool LMC_StartRecording(const char* filename, bool from_state, int hash_interval);
+LMCAPI bool LMC_StartPlayback(const char* filename, bool verify);
+LMCAPI void LMC_StopMovie(void);
+LMCAPI bool LMC_IsMovieActive(void);
+LMCAPI int LMC_GetMovieDesyncFrame(void);
+
+/*****************************************************************************
+ * Save Management
+ ****************************************************************************/
+LMCAPI void LMC_SetSaveInterval(int frames);
+LMCAPI bool LMC_FlushSave(void);
+
+/*****************************************************************************
+ * Disk Control
+ ****************************************************************************/
+LMCAPI int LMC_GetDiskCount(void);
+LMCAPI int LMC_GetDiskIndex(void);
+LMCAPI bool LMC_SetDiskIndex(int index);
+LMCAPI const char* LMC_GetDiskLabel(int index);
+
+/*****************************************************************************
+ * Asynchronous File I/O
+ ****************************************************************************/
+LMCAPI int LMC_ReadFileAsync(const char* path, LMC_FilePriority priority, LMC_FileCallback callback, void* user_data);
+LMCAPI int LMC_WriteFileAsync(const char* path, const void* data, size_t size, LMC_FilePriority priority, LMC_FileCallback callback, void* user_data);
+LMCAPI bool LMC_CancelFileRequest(int request);
+LMCAPI void LMC_SetFileRequestLimit(int count);
+
 /*****************************************************************************
  * Menu Management
  ****************************************************************************/
@@ -261,6 +381,23 @@ LMCAPI void LMC_DisableCRTEffect(void);
  ****************************************************************************/
 LMCAPI const char* LMC_GetPath(LMC_Path path_type);
 
+/*****************************************************************************
+ * File I/O Management
+ ****************************************************************************/
+LMCAPI void LMC_SetFileReadAhead(int size);
+LMCAPI void LMC_SetChdCacheSize(int size);
+LMCAPI int LMC_GetFileStatsCount(void);
+LMCAPI bool LMC_GetFileStats(int index, LMC_FileStats* stats);
+
+/*****************************************************************************
+ * Library Management
+ ****************************************************************************/
+LMCAPI bool LMC_LoadLibrary(void);
+LMCAPI bool LMC_ScanLibrary(const char* extensions, const char* dat_file);
+LMCAPI bool LMC_IsLibraryScanning(void);
+LMCAPI int LMC_GetLibraryEntryCount(void);
+LMCAPI bool LMC_GetLibraryEntry(int index, LMC_LibraryEntry* entry);
+
 /*****************************************************************************
  * Input Management
  ****************************************************************************/
@@ -275,6 +412,11 @@ LMCAPI void LMC_DefineJoypadInputHat(LMC_Player player, int hat_index,
 	LMC_Input input, LMC_HatDirection hat_direction);
 LMCAPI void LMC_DefineJoypadInputAxis(LMC_Player player, int axis_index,
 	LMC_Input input, LMC_AxisDirection axis_direction);
+LMCAPI void LMC_DefineJoypadInputAnalog(LMC_Player player, int axis_index,
+	LMC_AnalogStick stick, LMC_AnalogAxis axis);
+LMCAPI bool LMC_ConfigAnalogResponse(LMC_Player player, float deadzone,
+	float sensitivity, LMC_AnalogCurve curve);
+LMCAPI void LMC_SetInputPollType(LMC_PollType poll_type);
 
 /*****************************************************************************
  * Error Management
@@ -55,7 +55,7 @@ extern nbio_intf_t nbio_stdio;
 
 #endif
 
-#if defined(_linux__)
+#if defined(__linux__)
 static nbio_intf_t *internal_nbio = &nbio_linux;
 #elif defined(HAVE_MMAP) && defined(BSD)
 static nbio_intf_t *internal_nbio = &nbio_mmap_unix;
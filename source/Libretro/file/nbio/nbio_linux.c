@@ -44,6 +44,7 @@ struct nbio_linux_t
    aio_context_t ctx;
    struct iocb cb;
    size_t len;
+   size_t done; /* bytes moved by the last operation, reported by get_ptr */
    int fd;
    bool busy;
 };
@@ -89,9 +90,11 @@ static void nbio_begin_op(struct nbio_linux_t* handle, uint16_t op)
    handle->cb.aio_buf        = (uint64_t)(uintptr_t)handle->ptr;
    handle->cb.aio_offset     = 0;
    handle->cb.aio_nbytes     = handle->len;
+   handle->done              = 0;
 
+   /* a failed submit completes at once with nothing moved */
    if (io_submit(handle->ctx, 1, &cbp) != 1)
-      abort();
+      return;
 
    handle->busy = true;
 }
@@ -117,6 +120,7 @@ static void *nbio_linux_open(const char * filename, unsigned mode)
    handle->ctx  = ctx;
    handle->len  = lseek(fd, 0, SEEK_END);
    handle->ptr  = malloc(handle->len);
+   handle->done = handle->len;
    handle->busy = false;
 
    return handle;
@@ -145,7 +149,10 @@ static bool nbio_linux_iterate(void *data)
    {
       struct io_event ev;
       if (io_getevents(handle->ctx, 0, 1, &ev, NULL) == 1)
+      {
+         handle->done = ev.res > 0 ? (size_t)ev.res : 0;
          handle->busy = false;
+      }
    }
    return !handle->busy;
 }
@@ -166,8 +173,9 @@ static void nbio_linux_resize(void *data, size_t len)
       abort(); /* this one returns void and I can't find any other way
                   for it to report failure */
 
-   handle->ptr = realloc(handle->ptr, len);
-   handle->len = len;
+   handle->ptr  = realloc(handle->ptr, len);
+   handle->len  = len;
+   handle->done = len;
 }
 
 static void *nbio_linux_get_ptr(void *data, size_t* len)
@@ -176,7 +184,7 @@ static void *nbio_linux_get_ptr(void *data, size_t* len)
    if (!handle)
       return NULL;
    if (len)
-      *len = handle->len;
+      *len = handle->done;
    if (!handle->busy)
       return handle->ptr;
    return NULL;
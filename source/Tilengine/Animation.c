@@ -19,7 +19,6 @@
 #include "Animation.h"
 #include "Engine.h"
 #include "Palette.h"
-#include "Tables.h"
 #include "Debug.h"
 
 /* linear interploation */
@@ -30,9 +29,9 @@ static int lerp (int x, int x0, int x1, int fx0, int fx1)
 
 static inline void blendColors (uint8_t* srcptr0, uint8_t* srcptr1, uint8_t* dstptr, uint8_t f0, uint8_t f1)
 {
-	dstptr[0] = blendfunc(engine->blend_table, srcptr0[0], f0) + blendfunc(engine->blend_table, srcptr1[0], f1);
-	dstptr[1] = blendfunc(engine->blend_table, srcptr0[1], f0) + blendfunc(engine->blend_table, srcptr1[1], f1);
-	dstptr[2] = blendfunc(engine->blend_table, srcptr0[2], f0) + blendfunc(engine->blend_table, srcptr1[2], f1);
+	dstptr[0] = (srcptr0[0]*f0)/255 + (srcptr1[0]*f1)/255;
+	dstptr[1] = (srcptr0[1]*f0)/255 + (srcptr1[1]*f1)/255;
+	dstptr[2] = (srcptr0[2]*f0)/255 + (srcptr1[2]*f1)/255;
 }
 
 static void SetAnimation (Animation* animation, TLN_Sequence sequence, animation_t type);
@@ -40,7 +39,7 @@ static void ColorCycle (TLN_Palette srcpalette, TLN_Palette dstpalette, struct S
 static void ColorCycleBlend (TLN_Palette srcpalette, TLN_Palette dstpalette, struct Strip* strip, int t);
 
 /* updates animation state */
-void UpdateAnimation(Animation* animation, int time)
+void UpdateAnimation(Engine* ctx, Animation* animation, int time)
 {
 	TLN_Sequence sequence = animation->sequence;
 	TLN_SequenceFrame* frames = NULL;
@@ -60,11 +59,15 @@ void UpdateAnimation(Animation* animation, int time)
 				strip->t0 = time;
 				if (!animation->blend)
 					ColorCycle(animation->srcpalette, animation->palette, strip);
+				MarkDirtyFrame(ctx);
 			}
 
 			/* interpolate */
 			if (animation->blend)
+			{
 				ColorCycleBlend(animation->srcpalette, animation->palette, strip, time);
+				MarkDirtyFrame(ctx);
+			}
 		}
 		return;
 	}
@@ -81,6 +84,8 @@ void UpdateAnimation(Animation* animation, int time)
 		break;
 
 	case TYPE_TILESET:
+		if (animation->tileset->tiles[sequence->target] != frames[animation->pos].index)
+			MarkDirtyFrame(ctx);
 		animation->tileset->tiles[sequence->target] = frames[animation->pos].index;
 		break;
 
@@ -119,14 +124,16 @@ void UpdateAnimation(Animation* animation, int time)
  */
 bool TLN_GetAnimationState (int index)
 {
-	if (index >= engine->numsprites)
+	Engine* const ctx = GetEngine();
+
+	if (index >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->sprites[index].animation.enabled;
+	return ctx->sprites[index].animation.enabled;
 }
 
 /*!
@@ -147,28 +154,29 @@ bool TLN_GetAnimationState (int index)
  */
 bool TLN_SetPaletteAnimation (int index, TLN_Palette palette, TLN_Sequence sequence, bool blend)
 {
+	Engine* const ctx = GetEngine();
 	Animation* animation = NULL;
 	int c;
 	struct Strip* strips;
 
 	TLN_SetLastError (TLN_ERR_OK);
 	
-	if (index >= engine->numanimations)
+	if (index >= ctx->numanimations)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_ANIMATION);
 		return false;
 	}
 	
-	if (engine->animations[index].sequence == sequence)
+	if (ctx->animations[index].sequence == sequence)
 		return true;
 
 	/* validate type */
 	if (!CheckBaseObject (palette, OT_PALETTE) || !CheckBaseObject (sequence, OT_SEQUENCE))
 		return false;
 
-	animation = &engine->animations[index];
+	animation = &ctx->animations[index];
 	if (!animation->enabled)
-		ListAppendNode(&engine->list_animations, index);
+		ListAppendNode(&ctx->list_animations, index);
 	SetAnimation (animation, sequence, TYPE_PALETTE);
 	animation->palette = palette;
 	animation->blend = blend;
@@ -205,9 +213,10 @@ bool TLN_SetPaletteAnimation (int index, TLN_Palette palette, TLN_Sequence seque
  */
 bool TLN_SetPaletteAnimationSource (int index, TLN_Palette palette)
 {
+	Engine* const ctx = GetEngine();
 	Animation* animation = NULL;
 
-	if (index >= engine->numanimations)
+	if (index >= ctx->numanimations)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_ANIMATION);
 		return false;
@@ -216,7 +225,7 @@ bool TLN_SetPaletteAnimationSource (int index, TLN_Palette palette)
 	if (!CheckBaseObject (palette, OT_PALETTE))
 		return false;
 
-	animation = &engine->animations[index];
+	animation = &ctx->animations[index];
 	CopyBaseObject (animation->srcpalette, palette);
 	CopyBaseObject (animation->palette, palette);
 
@@ -264,10 +273,11 @@ bool SetTilesetAnimation(TLN_Tileset tileset, int index, TLN_Sequence sequence)
  */
 bool TLN_SetSpriteAnimation (int nsprite, TLN_Sequence sequence, int loop)
 {
+	Engine* const ctx = GetEngine();
 	Sprite* sprite;
 	Animation* animation = NULL;
 	
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
@@ -277,7 +287,7 @@ bool TLN_SetSpriteAnimation (int nsprite, TLN_Sequence sequence, int loop)
 	if (!CheckBaseObject (sequence, OT_SEQUENCE))
 		return false;
 	
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
 	animation = &sprite->animation;
 	SetAnimation (animation, sequence, TYPE_SPRITE);
 	animation->nsprite = nsprite;
@@ -306,16 +316,17 @@ bool TLN_SetSpriteAnimation (int nsprite, TLN_Sequence sequence, int loop)
  */
 bool TLN_SetAnimationDelay(int index, int frame, int delay)
 {
+	Engine* const ctx = GetEngine();
 	Animation* animation;
 	TLN_SequenceFrame* frames = NULL;
 
-	if (index >= engine->numanimations || index < 0)
+	if (index >= ctx->numanimations || index < 0)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	animation = &engine->sprites[index].animation;
+	animation = &ctx->sprites[index].animation;
 	frames = (TLN_SequenceFrame*)animation->sequence->data;
 
 	if (frame >= animation->sequence->count || frame < 0)
@@ -339,12 +350,13 @@ bool TLN_SetAnimationDelay(int index, int frame, int delay)
  */
 int TLN_GetAvailableAnimation (void)
 {
+	Engine* const ctx = GetEngine();
 	int c;
 
 	TLN_SetLastError (TLN_ERR_OK);
-	for (c=0; c<engine->numanimations; c++)
+	for (c=0; c<ctx->numanimations; c++)
 	{
-		if (!engine->animations[c].enabled)
+		if (!ctx->animations[c].enabled)
 			return c;
 	}
 	return -1;
@@ -362,22 +374,23 @@ int TLN_GetAvailableAnimation (void)
  */
 bool TLN_DisablePaletteAnimation (int index)
 {
+	Engine* const ctx = GetEngine();
 	Animation* animation;
 	
-	if (index >= engine->numanimations)
+	if (index >= ctx->numanimations)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_ANIMATION);
 		return false;
 	}
 	
-	animation = &engine->animations[index];
+	animation = &ctx->animations[index];
 	if (animation->enabled)
-		ListUnlinkNode(&engine->list_animations, index);
+		ListUnlinkNode(&ctx->list_animations, index);
 	
 	animation->enabled = false;
 	animation->type = TYPE_NONE;
 	animation->sequence = NULL;
-	ListUnlinkNode(&engine->list_animations, index);
+	ListUnlinkNode(&ctx->list_animations, index);
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -390,16 +403,17 @@ bool TLN_DisablePaletteAnimation (int index)
  */
 bool TLN_PauseSpriteAnimation(int index)
 {
+	Engine* const ctx = GetEngine();
 	Sprite* sprite;
 	Animation* animation;
 
-	if (index >= engine->numsprites)
+	if (index >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[index];
+	sprite = &ctx->sprites[index];
 	animation = &sprite->animation;
 	animation->paused = true;
 	TLN_SetLastError(TLN_ERR_OK);
@@ -414,16 +428,17 @@ bool TLN_PauseSpriteAnimation(int index)
  */
 bool TLN_ResumeSpriteAnimation(int index)
 {
+	Engine* const ctx = GetEngine();
 	Sprite* sprite;
 	Animation* animation;
 
-	if (index >= engine->numsprites)
+	if (index >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[index];
+	sprite = &ctx->sprites[index];
 	animation = &sprite->animation;
 	animation->paused = false;
 	TLN_SetLastError(TLN_ERR_OK);
@@ -442,16 +457,17 @@ bool TLN_ResumeSpriteAnimation(int index)
  */
 bool TLN_DisableSpriteAnimation(int index)
 {
+	Engine* const ctx = GetEngine();
 	Sprite* sprite;
 	Animation* animation;
 
-	if (index >= engine->numsprites)
+	if (index >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[index];
+	sprite = &ctx->sprites[index];
 	animation = &sprite->animation;
 	animation->enabled = false;
 	animation->type = TYPE_NONE;
@@ -46,6 +46,8 @@ typedef struct
 Animation;
 
 bool SetTilesetAnimation(TLN_Tileset tileset, int index, TLN_Sequence sequence);
-void UpdateAnimation(Animation* animation, int time);
+struct Engine;
+
+void UpdateAnimation(struct Engine* ctx, Animation* animation, int time);
 
 #endif
@@ -267,3 +267,26 @@ int TLN_GetBitmapPitch (TLN_Bitmap bitmap)
 	else
 		return 0;
 }
+
+/* classifies a block of pixels by its transparent pixels */
+PixelsType GetPixelsType (uint8_t* data, int width, int height, int pitch)
+{
+	int empty = 0;
+	int x, y;
+
+	for (y=0; y<height; y++)
+	{
+		for (x=0; x<width; x++)
+		{
+			if (data[x] == 0)
+				empty += 1;
+		}
+		data += pitch;
+	}
+
+	if (empty == 0)
+		return PIXELS_SOLID;
+	else if (empty == width*height)
+		return PIXELS_EMPTY;
+	return PIXELS_MIXED;
+}
@@ -28,4 +28,15 @@ struct Bitmap
 #define get_bitmap_ptr(bitmap, x, y) \
 	(bitmap->data + (y) * bitmap->pitch + (x))
 
+/* pixel coverage of a tile, sprite picture or bitmap, lets the renderer skip or unkey it */
+typedef enum
+{
+	PIXELS_MIXED,		/* transparent and solid pixels */
+	PIXELS_SOLID,		/* no transparent pixels */
+	PIXELS_EMPTY,		/* only transparent pixels */
+}
+PixelsType;
+
+PixelsType GetPixelsType (uint8_t* data, int width, int height, int pitch);
+
 #endif
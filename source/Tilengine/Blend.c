@@ -0,0 +1,262 @@
+/*
+* Tilengine - The 2D retro graphics engine with raster effects
+* Copyright (C) 2015-2019 Marc Palacios Domenech <mailto:megamarc@hotmail.com>
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/* arithmetic color blending. Spans run 4 pixels at a time with SSE2 or NEON, only the user
+ * provided BLEND_CUSTOM function still goes through a lookup table, owned by each context so
+ * it's never written while another context draws */
+
+#include <stdlib.h>
+#include "Blend.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLEND_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BLEND_NEON
+#include <arm_neon.h>
+#endif
+
+#define BLEND_SIZE	(1 << 16)
+#define ALPHA_MASK	0xFF000000
+
+/* creates a table for user function results indexed by (src << 8) + dst */
+uint8_t* CreateBlendTable (void)
+{
+	int a,b;
+	uint8_t* table = (uint8_t*)malloc (BLEND_SIZE);
+	if (table == NULL)
+		return NULL;
+
+	/* source color until a function is set */
+	for (a=0; a<256; a++)
+	{
+		for (b=0; b<256; b++)
+			table[(a<<8) + b] = a;
+	}
+	return table;
+}
+
+void DeleteBlendTable (uint8_t* table)
+{
+	free (table);
+}
+
+/* precomputes the user function for BLEND_CUSTOM */
+void SetCustomBlendTable (uint8_t* table, TLN_BlendFunction function)
+{
+	int a,b;
+
+	if (table == NULL)
+		return;
+
+	for (a=0; a<256; a++)
+	{
+		for (b=0; b<256; b++)
+			table[(a<<8) + b] = function (a, b);
+	}
+}
+
+/* fills blend parameters, returns NULL for BLEND_NONE */
+Blend* SetBlend (Blend* blend, TLN_Blend mode, uint8_t factor, const uint8_t* table)
+{
+	switch (mode)
+	{
+	case BLEND_MIX25:	blend->op = factor ? BLEND_OP_SRC : BLEND_OP_MIX25; break;
+	case BLEND_MIX50:	blend->op = factor ? BLEND_OP_SRC : BLEND_OP_MIX50; break;
+	case BLEND_MIX75:	blend->op = factor ? BLEND_OP_SRC : BLEND_OP_MIX75; break;
+	case BLEND_ADD:		blend->op = BLEND_OP_ADD; break;
+	case BLEND_SUB:		blend->op = BLEND_OP_SUB; break;
+	case BLEND_MOD:		blend->op = BLEND_OP_MOD; break;
+	case BLEND_CUSTOM:	blend->op = BLEND_OP_CUSTOM; break;
+	default:			return NULL;
+	}
+	blend->factor = factor;
+	blend->table = table;
+	return blend;
+}
+
+/* blends one color component */
+static inline uint8_t blend_channel (const Blend* blend, int src, int dst)
+{
+	int value;
+	switch (blend->op)
+	{
+	case BLEND_OP_MIX25:	value = (src + dst + dst) / 3; break;
+	case BLEND_OP_MIX50:	value = (src + dst) >> 1; break;
+	case BLEND_OP_MIX75:	value = (src + src + dst) / 3; break;
+	case BLEND_OP_SRC:		value = src; break;
+	case BLEND_OP_ADD:		value = (src + dst) > 255 ? 255 : (src + dst); break;
+	case BLEND_OP_SUB:		value = (src - dst) < 0 ? 0 : (src - dst); break;
+	case BLEND_OP_MOD:		value = (src * dst) / 255; break;
+	default:				value = blend->table[(src << 8) + dst]; break;
+	}
+
+	/* weights the result against the destination */
+	if (blend->factor != 0)
+		value = (value*blend->factor + dst*(255 - blend->factor) + 127) / 255;
+	return (uint8_t)value;
+}
+
+uint8_t BlendChannel (const Blend* blend, uint8_t src, uint8_t dst)
+{
+	return blend_channel (blend, src, dst);
+}
+
+/* blends pixels one at a time */
+static void blend_span_scalar (const Blend* blend, uint32_t* src, uint32_t* dst, int width)
+{
+	uint8_t* srcpixel = (uint8_t*)src;
+	uint8_t* dstpixel = (uint8_t*)dst;
+	while (width > 0)
+	{
+		if (srcpixel[3] != 0)
+		{
+			dstpixel[0] = blend_channel (blend, srcpixel[0], dstpixel[0]);
+			dstpixel[1] = blend_channel (blend, srcpixel[1], dstpixel[1]);
+			dstpixel[2] = blend_channel (blend, srcpixel[2], dstpixel[2]);
+		}
+		srcpixel += sizeof(uint32_t);
+		dstpixel += sizeof(uint32_t);
+		width -= 1;
+	}
+}
+
+#if defined(BLEND_SSE2)
+
+/* x / 255 rounded down, for any 16-bit lane */
+static inline __m128i div255_sse2 (__m128i x)
+{
+	return _mm_srli_epi16 (_mm_mulhi_epu16 (x, _mm_set1_epi16 ((short)0x8081)), 7);
+}
+
+/* blends 8 components widened to 16-bit lanes */
+static inline __m128i blend_lanes_sse2 (const Blend* blend, __m128i src, __m128i dst)
+{
+	const __m128i third = _mm_set1_epi16 (21846);	/* x / 3 as (x*21846) >> 16, exact up to 765 */
+	__m128i value;
+	switch (blend->op)
+	{
+	case BLEND_OP_MIX25:	value = _mm_mulhi_epu16 (_mm_add_epi16 (src, _mm_add_epi16 (dst, dst)), third); break;
+	case BLEND_OP_MIX50:	value = _mm_srli_epi16 (_mm_add_epi16 (src, dst), 1); break;
+	case BLEND_OP_MIX75:	value = _mm_mulhi_epu16 (_mm_add_epi16 (_mm_add_epi16 (src, src), dst), third); break;
+	case BLEND_OP_ADD:		value = _mm_min_epi16 (_mm_add_epi16 (src, dst), _mm_set1_epi16 (255)); break;
+	case BLEND_OP_SUB:		value = _mm_subs_epu16 (src, dst); break;
+	case BLEND_OP_MOD:		value = div255_sse2 (_mm_mullo_epi16 (src, dst)); break;
+	default:				value = src; break;
+	}
+
+	if (blend->factor != 0)
+	{
+		const __m128i factor = _mm_set1_epi16 (blend->factor);
+		const __m128i invfactor = _mm_set1_epi16 (255 - blend->factor);
+		value = _mm_add_epi16 (_mm_mullo_epi16 (value, factor), _mm_mullo_epi16 (dst, invfactor));
+		value = div255_sse2 (_mm_add_epi16 (value, _mm_set1_epi16 (127)));
+	}
+	return value;
+}
+
+/* blends 4 pixels at a time */
+static void blend_span_simd (const Blend* blend, uint32_t* src, uint32_t* dst, int width)
+{
+	const __m128i zero = _mm_setzero_si128 ();
+	const __m128i alpha = _mm_set1_epi32 ((int)ALPHA_MASK);
+	while (width >= 4)
+	{
+		const __m128i srcpixels = _mm_loadu_si128 ((__m128i*)src);
+		const __m128i dstpixels = _mm_loadu_si128 ((__m128i*)dst);
+		__m128i lo = blend_lanes_sse2 (blend, _mm_unpacklo_epi8 (srcpixels, zero), _mm_unpacklo_epi8 (dstpixels, zero));
+		__m128i hi = blend_lanes_sse2 (blend, _mm_unpackhi_epi8 (srcpixels, zero), _mm_unpackhi_epi8 (dstpixels, zero));
+
+		/* keeps the destination alpha, and the whole pixel where the source is empty */
+		__m128i keep = _mm_or_si128 (_mm_cmpeq_epi32 (_mm_and_si128 (srcpixels, alpha), zero), alpha);
+		__m128i result = _mm_packus_epi16 (lo, hi);
+		_mm_storeu_si128 ((__m128i*)dst, _mm_or_si128 (_mm_and_si128 (keep, dstpixels), _mm_andnot_si128 (keep, result)));
+		src += 4;
+		dst += 4;
+		width -= 4;
+	}
+	blend_span_scalar (blend, src, dst, width);
+}
+
+#elif defined(BLEND_NEON)
+
+/* x / 255 rounded down, for 16-bit lanes up to 65280 */
+static inline uint16x8_t div255_neon (uint16x8_t x)
+{
+	return vshrq_n_u16 (vaddq_u16 (vaddq_u16 (x, vdupq_n_u16 (1)), vshrq_n_u16 (x, 8)), 8);
+}
+
+/* x / 3 rounded down, for 16-bit lanes up to 765 */
+static inline uint16x8_t div3_neon (uint16x8_t x)
+{
+	const uint16x4_t third = vdup_n_u16 (21846);
+	return vcombine_u16 (vshrn_n_u32 (vmull_u16 (vget_low_u16 (x), third), 16),
+		vshrn_n_u32 (vmull_u16 (vget_high_u16 (x), third), 16));
+}
+
+/* blends 8 components widened to 16-bit lanes */
+static inline uint16x8_t blend_lanes_neon (const Blend* blend, uint16x8_t src, uint16x8_t dst)
+{
+	uint16x8_t value;
+	switch (blend->op)
+	{
+	case BLEND_OP_MIX25:	value = div3_neon (vaddq_u16 (src, vaddq_u16 (dst, dst))); break;
+	case BLEND_OP_MIX50:	value = vshrq_n_u16 (vaddq_u16 (src, dst), 1); break;
+	case BLEND_OP_MIX75:	value = div3_neon (vaddq_u16 (vaddq_u16 (src, src), dst)); break;
+	case BLEND_OP_ADD:		value = vminq_u16 (vaddq_u16 (src, dst), vdupq_n_u16 (255)); break;
+	case BLEND_OP_SUB:		value = vqsubq_u16 (src, dst); break;
+	case BLEND_OP_MOD:		value = div255_neon (vmulq_u16 (src, dst)); break;
+	default:				value = src; break;
+	}
+
+	if (blend->factor != 0)
+	{
+		value = vmlaq_n_u16 (vmulq_n_u16 (value, blend->factor), dst, 255 - blend->factor);
+		value = div255_neon (vaddq_u16 (value, vdupq_n_u16 (127)));
+	}
+	return value;
+}
+
+/* blends 4 pixels at a time */
+static void blend_span_simd (const Blend* blend, uint32_t* src, uint32_t* dst, int width)
+{
+	const uint32x4_t alpha = vdupq_n_u32 (ALPHA_MASK);
+	while (width >= 4)
+	{
+		const uint8x16_t srcpixels = vld1q_u8 ((uint8_t*)src);
+		const uint8x16_t dstpixels = vld1q_u8 ((uint8_t*)dst);
+		uint16x8_t lo = blend_lanes_neon (blend, vmovl_u8 (vget_low_u8 (srcpixels)), vmovl_u8 (vget_low_u8 (dstpixels)));
+		uint16x8_t hi = blend_lanes_neon (blend, vmovl_u8 (vget_high_u8 (srcpixels)), vmovl_u8 (vget_high_u8 (dstpixels)));
+
+		/* keeps the destination alpha, and the whole pixel where the source is empty */
+		uint32x4_t keep = vorrq_u32 (vceqq_u32 (vandq_u32 (vreinterpretq_u32_u8 (srcpixels), alpha), vdupq_n_u32 (0)), alpha);
+		uint8x16_t result = vcombine_u8 (vqmovn_u16 (lo), vqmovn_u16 (hi));
+		vst1q_u8 ((uint8_t*)dst, vbslq_u8 (vreinterpretq_u8_u32 (keep), dstpixels, result));
+		src += 4;
+		dst += 4;
+		width -= 4;
+	}
+	blend_span_scalar (blend, src, dst, width);
+}
+
+#endif
+
+/* blends src over dst where src alpha isn't 0, dst alpha is kept */
+void BlendSpan (const Blend* blend, uint32_t* src, uint32_t* dst, int width)
+{
+#if defined(BLEND_SSE2) || defined(BLEND_NEON)
+	if (blend->op != BLEND_OP_CUSTOM)
+	{
+		blend_span_simd (blend, src, dst, width);
+		return;
+	}
+#endif
+	blend_span_scalar (blend, src, dst, width);
+}
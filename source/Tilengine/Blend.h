@@ -0,0 +1,54 @@
+/*
+* Tilengine - The 2D retro graphics engine with raster effects
+* Copyright (C) 2015-2019 Marc Palacios Domenech <mailto:megamarc@hotmail.com>
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _BLEND_H
+#define _BLEND_H
+
+#include "Tilengine.h"
+
+/* per channel color operation, before the factor is applied */
+typedef enum
+{
+	BLEND_OP_MIX25,		/* classic presets, bit exact with the former lookup tables */
+	BLEND_OP_MIX50,
+	BLEND_OP_MIX75,
+	BLEND_OP_SRC,		/* source color, weighted by factor for the mix modes */
+	BLEND_OP_ADD,
+	BLEND_OP_SUB,
+	BLEND_OP_MOD,
+	BLEND_OP_CUSTOM		/* user function from TLN_SetCustomBlendFunction() */
+}
+BlendOp;
+
+/* blending parameters of a layer, sprite or window */
+typedef struct
+{
+	BlendOp	op;
+	uint8_t	factor;		/* strength of the effect, 0 = classic preset at full strength */
+	const uint8_t* table;	/* BLEND_OP_CUSTOM results of the owning context */
+}
+Blend;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	uint8_t* CreateBlendTable(void);
+	void DeleteBlendTable(uint8_t* table);
+	void SetCustomBlendTable(uint8_t* table, TLN_BlendFunction function);
+	Blend* SetBlend(Blend* blend, TLN_Blend mode, uint8_t factor, const uint8_t* table);
+	uint8_t BlendChannel(const Blend* blend, uint8_t src, uint8_t dst);
+	void BlendSpan(const Blend* blend, uint32_t* src, uint32_t* dst, int width);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,7 +11,7 @@
 #include "Tilengine.h"
 #include "Palette.h"
 #include "Blitters.h"
-#include "Tables.h"
+#include "Blend.h"
 #include "Engine.h"
 
 /* indexes for blitter array table */
@@ -19,10 +19,31 @@
 #define BLIT_SCALING	1
 #define BLIT_KEY		2
 
+#define BLEND_SPAN		64			/* pixels resolved at once before blending */
+#define OPAQUE			0xFF000000	/* alpha of resolved pixels, 0 marks empty ones */
+
+/* SIMD paths: AVX2 is compiled in on x86 and picked at runtime, 16 pixel runs use SSE2 or NEON */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BLIT_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLIT_RUNS
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BLIT_RUNS
+#include <arm_neon.h>
+#endif
+
 /* 8 to 32 BPP blitters ----------------------------------------------------- */
 
 /* paints scanline without checking color key (always solid) */
-static void blitFast_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, uint8_t* blend)
+static void blitFast_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
 {
 	uint32_t* dstpixel = (uint32_t*)dstptr;
 	uint32_t* color = (uint32_t*)palette->data;
@@ -35,25 +56,28 @@ static void blitFast_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr,
 }
 
 /* paints scanline without checking color key (always solid) with blending */
-static void blitFastBlend_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, uint8_t* blend)
+static void blitFastBlend_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
 {
-	uint8_t *src, *dst;
+	uint32_t* dstpixel = (uint32_t*)dstptr;
 	uint32_t* color = (uint32_t*)palette->data;
-	dst = (uint8_t*)dstptr;
-	while (width)
+	uint32_t span[BLEND_SPAN];
+	while (width > 0)
 	{
-		src = (uint8_t*)&color[*srcpixel];
-		dst[0] = blendfunc(blend, src[0], dst[0]);
-		dst[1] = blendfunc(blend, src[1], dst[1]);
-		dst[2] = blendfunc(blend, src[2], dst[2]);
-		srcpixel += dx;
-		dst += sizeof(uint32_t);
-		width--;
+		const int count = width < BLEND_SPAN ? width : BLEND_SPAN;
+		int c;
+		for (c = 0; c < count; c++)
+		{
+			span[c] = color[*srcpixel] | OPAQUE;
+			srcpixel += dx;
+		}
+		BlendSpan(blend, span, dstpixel, count);
+		dstpixel += count;
+		width -= count;
 	}
 }
 
 /* paints scanline without checking color key (always solid) with scaling */
-static void blitFastScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, uint8_t* blend)
+static void blitFastScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
 {
 	uint32_t* dstpixel = (uint32_t*)dstptr;
 	uint32_t* color = (uint32_t*)palette->data;
@@ -67,26 +91,29 @@ static void blitFastScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void*
 }
 
 /* paints scanline without checking color key (always solid) with scaling and blending */
-static void blitFastBlendScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, uint8_t* blend)
+static void blitFastBlendScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
 {
-	uint8_t *src, *dst;
+	uint32_t* dstpixel = (uint32_t*)dstptr;
 	uint32_t* color = (uint32_t*)palette->data;
-	dst = (uint8_t*)dstptr;
-	while (width)
+	uint32_t span[BLEND_SPAN];
+	while (width > 0)
 	{
-		uint32_t item = *(srcpixel + offset/(1 << FIXED_BITS));
-		src = (uint8_t*)&color[item];
-		dst[0] = blendfunc(blend, src[0], dst[0]);
-		dst[1] = blendfunc(blend, src[1], dst[1]);
-		dst[2] = blendfunc(blend, src[2], dst[2]);
-		offset += dx;
-		dst += sizeof(uint32_t);
-		width--;
+		const int count = width < BLEND_SPAN ? width : BLEND_SPAN;
+		int c;
+		for (c = 0; c < count; c++)
+		{
+			uint32_t item = *(srcpixel + offset/(1 << FIXED_BITS));
+			span[c] = color[item] | OPAQUE;
+			offset += dx;
+		}
+		BlendSpan(blend, span, dstpixel, count);
+		dstpixel += count;
+		width -= count;
 	}
 }
 
 /* paints scanline skipping empty pixels */
-static void blitKey_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, uint8_t* blend)
+static void blitKey_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
 {
 	uint32_t* dstpixel = (uint32_t*)dstptr;
 	uint32_t* color = (uint32_t*)palette->data;
@@ -101,28 +128,28 @@ static void blitKey_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr,
 }
 
 /* paints scanline skipping empty pixels with blending */
-static void blitKeyBlend_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, uint8_t* blend)
+static void blitKeyBlend_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
 {
-	uint8_t *src, *dst;
+	uint32_t* dstpixel = (uint32_t*)dstptr;
 	uint32_t* color = (uint32_t*)palette->data;
-	dst = (uint8_t*)dstptr;
-	while (width)
+	uint32_t span[BLEND_SPAN];
+	while (width > 0)
 	{
-		if (*srcpixel)
+		const int count = width < BLEND_SPAN ? width : BLEND_SPAN;
+		int c;
+		for (c = 0; c < count; c++)
 		{
-			src = (uint8_t*)&color[*srcpixel];
-			dst[0] = blendfunc(blend, src[0], dst[0]);
-			dst[1] = blendfunc(blend, src[1], dst[1]);
-			dst[2] = blendfunc(blend, src[2], dst[2]);
+			span[c] = *srcpixel ? color[*srcpixel] | OPAQUE : 0;
+			srcpixel += dx;
 		}
-		srcpixel += dx;
-		dst += sizeof(uint32_t);
-		width--;
+		BlendSpan(blend, span, dstpixel, count);
+		dstpixel += count;
+		width -= count;
 	}
 }
 
 /* paints scanline skipping empty pixels with scaling */
-static void blitKeyScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, uint8_t* blend)
+static void blitKeyScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
 {
 	uint32_t* dstpixel = (uint32_t*)dstptr;
 	uint32_t* color = (uint32_t*)palette->data;
@@ -139,28 +166,229 @@ static void blitKeyScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* d
 }
 
 /* paints scanline skipping empty pixels with scaling and blending */
-static void blitKeyBlendScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, uint8_t* blend)
+static void blitKeyBlendScaling_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
 {
-	uint8_t *src, *dst;
+	uint32_t* dstpixel = (uint32_t*)dstptr;
 	uint32_t* color = (uint32_t*)palette->data;
-	dst = (uint8_t*)dstptr;
-	while (width)
+	uint32_t span[BLEND_SPAN];
+	while (width > 0)
 	{
-		uint32_t item = *(srcpixel + offset/(1 << FIXED_BITS));
-		if (item)
+		const int count = width < BLEND_SPAN ? width : BLEND_SPAN;
+		int c;
+		for (c = 0; c < count; c++)
 		{
-			src = (uint8_t*)&color[item];
-			dst[0] = blendfunc(blend, src[0], dst[0]);
-			dst[1] = blendfunc(blend, src[1], dst[1]);
-			dst[2] = blendfunc(blend, src[2], dst[2]);
+			uint32_t item = *(srcpixel + offset/(1 << FIXED_BITS));
+			span[c] = item ? color[item] | OPAQUE : 0;
+			offset += dx;
 		}
-		offset += dx;
-		dst += sizeof(uint32_t);
-		width--;
+		BlendSpan(blend, span, dstpixel, count);
+		dstpixel += count;
+		width -= count;
+	}
+}
+
+/* SIMD 8 to 32 BPP blitters ------------------------------------------------ */
+
+#ifdef BLIT_AVX2
+
+/* loads 8 palette indexes stepping dx */
+static TARGET_AVX2 __m256i avx2_indexes(uint8_t* srcpixel, int dx)
+{
+	if (dx == 1)
+		return _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)srcpixel));
+	else if (dx == -1)
+	{
+		const __m128i reverse = _mm_setr_epi8(7,6,5,4,3,2,1,0, 8,9,10,11,12,13,14,15);
+		__m128i index = _mm_loadl_epi64((__m128i*)(srcpixel - 7));
+		return _mm256_cvtepu8_epi32(_mm_shuffle_epi8(index, reverse));
 	}
+	return _mm256_setr_epi32(srcpixel[0], srcpixel[dx], srcpixel[dx*2], srcpixel[dx*3],
+		srcpixel[dx*4], srcpixel[dx*5], srcpixel[dx*6], srcpixel[dx*7]);
 }
 
-/* blitter table selector */
+/* paints scanline without checking color key (always solid) */
+static TARGET_AVX2 void blitFast_8_32_avx2 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
+{
+	uint32_t* dstpixel = (uint32_t*)dstptr;
+	int* color = (int*)palette->data;
+	while (width >= 8)
+	{
+		__m256i src = _mm256_i32gather_epi32(color, avx2_indexes(srcpixel, dx), 4);
+		_mm256_storeu_si256((__m256i*)dstpixel, src);
+		srcpixel += dx*8;
+		dstpixel += 8;
+		width -= 8;
+	}
+	blitFast_8_32(srcpixel, palette, dstpixel, width, dx, offset, blend);
+}
+
+/* paints scanline without checking color key (always solid) with blending */
+static TARGET_AVX2 void blitFastBlend_8_32_avx2 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
+{
+	uint32_t* dstpixel = (uint32_t*)dstptr;
+	int* color = (int*)palette->data;
+	const __m256i opaque = _mm256_set1_epi32((int)OPAQUE);
+	uint32_t span[BLEND_SPAN];
+	while (width >= 8)
+	{
+		const int count = (width < BLEND_SPAN ? width : BLEND_SPAN) & ~7;
+		int c;
+		for (c = 0; c < count; c += 8)
+		{
+			__m256i src = _mm256_i32gather_epi32(color, avx2_indexes(srcpixel, dx), 4);
+			_mm256_storeu_si256((__m256i*)&span[c], _mm256_or_si256(src, opaque));
+			srcpixel += dx*8;
+		}
+		BlendSpan(blend, span, dstpixel, count);
+		dstpixel += count;
+		width -= count;
+	}
+	blitFastBlend_8_32(srcpixel, palette, dstpixel, width, dx, offset, blend);
+}
+
+/* paints scanline skipping empty pixels */
+static TARGET_AVX2 void blitKey_8_32_avx2 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
+{
+	uint32_t* dstpixel = (uint32_t*)dstptr;
+	int* color = (int*)palette->data;
+	while (width >= 8)
+	{
+		__m256i index = avx2_indexes(srcpixel, dx);
+		__m256i empty = _mm256_cmpeq_epi32(index, _mm256_setzero_si256());
+		if (_mm256_movemask_epi8(empty) != -1)
+		{
+			__m256i src = _mm256_i32gather_epi32(color, index, 4);
+			__m256i dst = _mm256_loadu_si256((__m256i*)dstpixel);
+			_mm256_storeu_si256((__m256i*)dstpixel, _mm256_blendv_epi8(src, dst, empty));
+		}
+		srcpixel += dx*8;
+		dstpixel += 8;
+		width -= 8;
+	}
+	blitKey_8_32(srcpixel, palette, dstpixel, width, dx, offset, blend);
+}
+
+/* paints scanline skipping empty pixels with blending */
+static TARGET_AVX2 void blitKeyBlend_8_32_avx2 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
+{
+	uint32_t* dstpixel = (uint32_t*)dstptr;
+	int* color = (int*)palette->data;
+	const __m256i opaque = _mm256_set1_epi32((int)OPAQUE);
+	uint32_t span[BLEND_SPAN];
+	while (width >= 8)
+	{
+		const int count = (width < BLEND_SPAN ? width : BLEND_SPAN) & ~7;
+		int c;
+		for (c = 0; c < count; c += 8)
+		{
+			__m256i index = avx2_indexes(srcpixel, dx);
+			__m256i empty = _mm256_cmpeq_epi32(index, _mm256_setzero_si256());
+			__m256i src = _mm256_setzero_si256();
+			if (_mm256_movemask_epi8(empty) != -1)
+				src = _mm256_andnot_si256(empty, _mm256_or_si256(_mm256_i32gather_epi32(color, index, 4), opaque));
+			_mm256_storeu_si256((__m256i*)&span[c], src);
+			srcpixel += dx*8;
+		}
+		BlendSpan(blend, span, dstpixel, count);
+		dstpixel += count;
+		width -= count;
+	}
+	blitKeyBlend_8_32(srcpixel, palette, dstpixel, width, dx, offset, blend);
+}
+
+/* checks if the cpu and the os support AVX2 */
+static bool has_avx2(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+#ifdef BLIT_RUNS
+
+#define RUN_LENGTH	16
+
+/* kind of run of RUN_LENGTH palette indexes */
+typedef enum
+{
+	RUN_EMPTY,
+	RUN_MIXED,
+	RUN_SOLID
+}
+RunType;
+
+/* classifies a run of palette indexes by its empty pixels */
+static RunType get_run_type(uint8_t* srcpixel)
+{
+#ifdef BLIT_AVX2
+	const int empty = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i*)srcpixel), _mm_setzero_si128()));
+	if (empty == 0xFFFF)
+		return RUN_EMPTY;
+	else if (empty == 0)
+		return RUN_SOLID;
+#else
+	const uint8x16_t index = vld1q_u8(srcpixel);
+	if (vmaxvq_u8(index) == 0)
+		return RUN_EMPTY;
+	else if (vminvq_u8(index) != 0)
+		return RUN_SOLID;
+#endif
+	return RUN_MIXED;
+}
+
+/* paints scanline skipping runs of empty pixels */
+static void blitKeyRuns_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
+{
+	uint32_t* dstpixel = (uint32_t*)dstptr;
+	while (dx == 1 && width >= RUN_LENGTH)
+	{
+		const RunType run = get_run_type(srcpixel);
+		if (run == RUN_SOLID)
+			blitFast_8_32(srcpixel, palette, dstpixel, RUN_LENGTH, dx, offset, blend);
+		else if (run == RUN_MIXED)
+			blitKey_8_32(srcpixel, palette, dstpixel, RUN_LENGTH, dx, offset, blend);
+		srcpixel += RUN_LENGTH;
+		dstpixel += RUN_LENGTH;
+		width -= RUN_LENGTH;
+	}
+	blitKey_8_32(srcpixel, palette, dstpixel, width, dx, offset, blend);
+}
+
+/* paints scanline skipping runs of empty pixels with blending */
+static void blitKeyBlendRuns_8_32 (uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend)
+{
+	uint32_t* dstpixel = (uint32_t*)dstptr;
+	while (dx == 1 && width >= RUN_LENGTH)
+	{
+		const RunType run = get_run_type(srcpixel);
+		if (run == RUN_SOLID)
+			blitFastBlend_8_32(srcpixel, palette, dstpixel, RUN_LENGTH, dx, offset, blend);
+		else if (run == RUN_MIXED)
+			blitKeyBlend_8_32(srcpixel, palette, dstpixel, RUN_LENGTH, dx, offset, blend);
+		srcpixel += RUN_LENGTH;
+		dstpixel += RUN_LENGTH;
+		width -= RUN_LENGTH;
+	}
+	blitKeyBlend_8_32(srcpixel, palette, dstpixel, width, dx, offset, blend);
+}
+
+#endif
+
+/* blitter table selector, superseded by the run skipping one where SIMD is available */
+#ifndef BLIT_RUNS
 static const ScanBlitPtr blitters[]=
 {
 	blitFast_8_32,
@@ -172,29 +400,77 @@ static const ScanBlitPtr blitters[]=
 	blitKeyScaling_8_32,
 	blitKeyBlendScaling_8_32
 };
+#endif
+
+/* scaled spans stay scalar, their indexes load one by one and the gathers don't pay that back */
+#ifdef BLIT_AVX2
+static const ScanBlitPtr blitters_avx2[]=
+{
+	blitFast_8_32_avx2,
+	blitFastBlend_8_32_avx2,
+	blitFastScaling_8_32,
+	blitFastBlendScaling_8_32,
+	blitKey_8_32_avx2,
+	blitKeyBlend_8_32_avx2,
+	blitKeyScaling_8_32,
+	blitKeyBlendScaling_8_32
+};
+#endif
+
+#ifdef BLIT_RUNS
+static const ScanBlitPtr blitters_runs[]=
+{
+	blitFast_8_32,
+	blitFastBlend_8_32,
+	blitFastScaling_8_32,
+	blitFastBlendScaling_8_32,
+	blitKeyRuns_8_32,
+	blitKeyBlendRuns_8_32,
+	blitKeyScaling_8_32,
+	blitKeyBlendScaling_8_32
+};
+#endif
+
+/* returns the fastest blitter table the cpu supports */
+static const ScanBlitPtr* get_blitters(void)
+{
+#ifdef BLIT_AVX2
+	if (has_avx2())
+		return blitters_avx2;
+#endif
+#ifdef BLIT_RUNS
+	return blitters_runs;
+#else
+	return blitters;
+#endif
+}
 
-/* returns suitable blitter for specified conditions */
+/* returns suitable blitter for specified conditions. The table is looked up on every call
+ * instead of being cached, contexts on different threads can select blitters at once and the
+ * cpu check is cheap next to the layer and sprite setup calling this */
 ScanBlitPtr SelectBlitter (bool key, bool scaling, bool blend)
 {
 	int index = (key << BLIT_KEY) + (scaling << BLIT_SCALING) + (blend << BLIT_BLEND);
-	return blitters[index];
+	return get_blitters()[index];
 }
 
 /* paints constant color */
-void BlitColor(void* dstptr, uint32_t color, int width, uint8_t* blend)
+void BlitColor(void* dstptr, uint32_t color, int width, Blend* blend)
 {
 	/* blend */
 	if (blend != NULL)
 	{
-		uint8_t* src = (uint8_t*)&color;
-		uint8_t* dst = (uint8_t*)dstptr;
-		while (width)
+		uint32_t* dstpixel = (uint32_t*)dstptr;
+		uint32_t span[BLEND_SPAN];
+		int c;
+		for (c = 0; c < BLEND_SPAN; c++)
+			span[c] = color | OPAQUE;
+		while (width > 0)
 		{
-			dst[0] = blendfunc(blend, src[0], dst[0]);
-			dst[1] = blendfunc(blend, src[1], dst[1]);
-			dst[2] = blendfunc(blend, src[2], dst[2]);
-			dst += sizeof(uint32_t);
-			width--;
+			const int count = width < BLEND_SPAN ? width : BLEND_SPAN;
+			BlendSpan(blend, span, dstpixel, count);
+			dstpixel += count;
+			width -= count;
 		}
 	}
 
@@ -211,27 +487,14 @@ void BlitColor(void* dstptr, uint32_t color, int width, uint8_t* blend)
 }
 
 /* perfoms direct 32 -> 32 bpp blit with opcional blend */
-void Blit32_32(uint32_t *src, uint32_t* dst, int width, uint8_t* blend)
+void Blit32_32(uint32_t *src, uint32_t* dst, int width, Blend* blend)
 {
 	Color* srcpixel = (Color*)src;
 	Color* dstpixel = (Color*)dst;
 
 	/* blending */
 	if (blend != NULL)
-	{
-		while (width > 0)
-		{
-			if (srcpixel->a != 0)
-			{
-				dstpixel->r = blendfunc(blend, srcpixel->r, dstpixel->r);
-				dstpixel->g = blendfunc(blend, srcpixel->g, dstpixel->g);
-				dstpixel->b = blendfunc(blend, srcpixel->b, dstpixel->b);
-			}
-			srcpixel += 1;
-			dstpixel += 1;
-			width -= 1;
-		}
-	}
+		BlendSpan(blend, src, dst, width);
 
 	/* regular */
 	else
@@ -248,7 +511,7 @@ void Blit32_32(uint32_t *src, uint32_t* dst, int width, uint8_t* blend)
 }
 
 /* performs mosaic effect with optional blend */
-void BlitMosaic(uint32_t *src, uint32_t* dst, int width, int size, uint8_t* blend)
+void BlitMosaic(uint32_t *src, uint32_t* dst, int width, int size, Blend* blend)
 {
 	Color* srcpixel = (Color*)src;
 	Color* dstpixel = (Color*)dst;
@@ -256,30 +519,18 @@ void BlitMosaic(uint32_t *src, uint32_t* dst, int width, int size, uint8_t* blen
 	/* blending */
 	if (blend != NULL)
 	{
-		while (width > 0)
+		uint32_t span[BLEND_SPAN];
+		int x = 0;
+		while (x < width)
 		{
-			if (size > width)
-				size = width;
-
-			if (srcpixel->a != 0)
-			{
-				int block = size;
-				while (block != 0)
-				{
-					dstpixel->r = blendfunc(blend, srcpixel->r, dstpixel->r);
-					dstpixel->g = blendfunc(blend, srcpixel->g, dstpixel->g);
-					dstpixel->b = blendfunc(blend, srcpixel->b, dstpixel->b);
-					dstpixel += 1;
-					block -= 1;
-				}
-			}
-			else
-				dstpixel += size;
-			srcpixel += size;
-			width -= size;
+			const int count = width - x < BLEND_SPAN ? width - x : BLEND_SPAN;
+			int c;
+			for (c = 0; c < count; c++)
+				span[c] = src[(x + c) - (x + c) % size];
+			BlendSpan(blend, span, dst + x, count);
+			x += count;
 		}
 	}
-
 	/* regular */
 	else
 	{
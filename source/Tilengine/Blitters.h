@@ -12,10 +12,11 @@
 #define _BLITTERS_H
 
 #include "Tilengine.h"
+#include "Blend.h"
 
 /* blitter callback signature */
 typedef void(*ScanBlitPtr) \
-	(uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, uint8_t* blend);
+	(uint8_t *srcpixel, TLN_Palette palette, void* dstptr, int width, int dx, int offset, Blend* blend);
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,13 +26,13 @@ extern "C" {
 	ScanBlitPtr SelectBlitter(bool key, bool scaling, bool blend);
 
 	/* solid color with opcional blend */
-	void BlitColor(void* dstptr, uint32_t color, int width, uint8_t* blend);
+	void BlitColor(void* dstptr, uint32_t color, int width, Blend* blend);
 
 	/* perfoms direct 32 -> 32 bpp blit with opcional blend */
-	void Blit32_32(uint32_t *src, uint32_t* dst, int width, uint8_t* blend);
+	void Blit32_32(uint32_t *src, uint32_t* dst, int width, Blend* blend);
 
 	/* performs mosaic blit */
-	void BlitMosaic(uint32_t *src, uint32_t* dst, int width, int size, uint8_t* blend);
+	void BlitMosaic(uint32_t *src, uint32_t* dst, int width, int size, Blend* blend);
 
 #ifdef __cplusplus
 }
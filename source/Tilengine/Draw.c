@@ -18,81 +18,208 @@
 #include "ObjectList.h"
 #include "Sprite.h"
 
+/* lines per band handed to each rendering thread */
+#define BAND_HEIGHT	16
+
+/* pixels of a transformed scanline whose texture coordinates are computed at once */
+#define TEXEL_BATCH	8
+
+/* largest layer size whose wrapped fixed point texture coordinates fit in 32 bits, larger
+ * layers step their coordinates in 64 bits one pixel at a time */
+#define TEXCOORD_MAX_SIZE	(1 << (31 - FIXED_BITS))
+
+/* source pixels a scaled bitmap run covers at most, keeps the blitter's fixed point offset in range */
+#define SCALING_SPAN	(1 << (30 - FIXED_BITS))
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DRAW_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DRAW_NEON
+#include <arm_neon.h>
+#endif
+
 /* private prototypes */
-static void DrawSpriteCollision(int nsprite, uint8_t *srcpixel, uint16_t *dstpixel, int width, int dx);
-static void DrawSpriteCollisionScaling(int nsprite, uint8_t *srcpixel, uint16_t *dstpixel, int width, int dx, int srcx);
+static void DrawSpriteCollision(int nsprite, uint8_t *srcpixel, uint16_t *dstpixel, int width, int dx, Scanbuffers* buffers);
+static void DrawSpriteCollisionScaling(int nsprite, uint8_t *srcpixel, uint16_t *dstpixel, int width, int dx, int srcx, Scanbuffers* buffers);
 
-static bool check_sprite_coverage(Sprite* sprite, int nscan)
+static bool check_sprite_coverage(const Engine* ctx, Sprite* sprite, int nscan)
 {
 	/* check sprite coverage */
 	if (nscan < sprite->dstrect.y1 || nscan >= sprite->dstrect.y2)
 		return false;
 	if (sprite->dstrect.x2 < 0 || sprite->srcrect.x2 < 0)
 		return false;
-	if ((sprite->flags & FLAG_MASKED) && nscan >= engine->sprite_mask_top && nscan <= engine->sprite_mask_bottom)
+	if ((sprite->flags & FLAG_MASKED) && nscan >= ctx->sprite_mask_top && nscan <= ctx->sprite_mask_bottom)
+		return false;
+	return true;
+}
+
+/* allocates a set of scratch buffers for a framebuffer width */
+bool CreateScanbuffers(Scanbuffers* buffers, Engine* context, int width, int numlayers, int numsprites, bool hits)
+{
+	memset(buffers, 0, sizeof(Scanbuffers));
+	buffers->context = context;
+	buffers->priority = (uint32_t*)calloc(width, sizeof(uint32_t));
+	buffers->collision = (uint16_t*)calloc(width, sizeof(uint16_t));
+	buffers->linebuffer = (uint32_t*)calloc(width, sizeof(uint32_t));
+	if (numlayers > 0)
+		buffers->mosaic = (uint32_t*)calloc((size_t)width * numlayers, sizeof(uint32_t));
+	if (numlayers > 0)
+		buffers->raster = (Layer*)malloc(sizeof(Layer));
+	if (hits && numsprites > 0)
+		buffers->hits = (uint8_t*)calloc(numsprites, sizeof(uint8_t));
+
+	if (!buffers->priority || !buffers->collision || !buffers->linebuffer ||
+		(numlayers > 0 && (!buffers->mosaic || !buffers->raster)) || (hits && numsprites > 0 && !buffers->hits))
+	{
+		DeleteScanbuffers(buffers);
 		return false;
+	}
 	return true;
 }
 
+/* frees a set of scratch buffers */
+void DeleteScanbuffers(Scanbuffers* buffers)
+{
+	free(buffers->priority);
+	free(buffers->collision);
+	free(buffers->linebuffer);
+	free(buffers->mosaic);
+	free(buffers->raster);
+	free(buffers->hits);
+	memset(buffers, 0, sizeof(Scanbuffers));
+}
+
+/* flags a sprite as colliding */
+static inline void set_sprite_collision(int nsprite, Scanbuffers* buffers)
+{
+	if (buffers->hits != NULL)
+		buffers->hits[nsprite] = 1;
+	else
+		buffers->context->sprites[nsprite].collision = true;
+}
+
+/* returns the layer as drawn on a scanline: a copy in the scratch buffers with the entry of its
+ * raster table applied, or the layer itself when it has none */
+static Layer* get_line_layer(int nlayer, int line, Scanbuffers* buffers)
+{
+	Engine* const ctx = buffers->context;
+	Layer* layer = &ctx->layers[nlayer];
+	Layer* copy = buffers->raster;
+	const TLN_RasterLine* entry;
+	const int framewidth = ctx->framebuffer.width;
+
+	if (layer->raster == NULL)
+		return layer;
+
+	/* mosaic blocks take the entry of their first line */
+	if (layer->mosaic.h != 0)
+		line -= line % layer->mosaic.h;
+	entry = &layer->raster[line];
+	*copy = *layer;
+
+	/* scroll offset, wrapped like TLN_SetLayerPosition() */
+	if ((entry->dx != 0 || entry->dy != 0) && layer->width > 0 && layer->height > 0)
+	{
+		copy->hstart = (layer->hstart + entry->dx) % layer->width;
+		copy->vstart = (layer->vstart + entry->dy) % layer->height;
+		if (copy->hstart < 0)
+			copy->hstart += layer->width;
+		if (copy->vstart < 0)
+			copy->vstart += layer->height;
+	}
+
+	/* horizontal clip */
+	if (entry->x1 != 0 || entry->x2 != 0)
+	{
+		copy->window.x1 = entry->x1 < 0 ? 0 : entry->x1 > framewidth ? framewidth : entry->x1;
+		copy->window.x2 = entry->x2 < copy->window.x1 ? copy->window.x1 : entry->x2 > framewidth ? framewidth : entry->x2;
+	}
+
+	/* blend factor, weighting the source color for the mix modes as in SetBlend() */
+	if (entry->blend != 0 && layer->blend != NULL)
+	{
+		copy->blend_data = *layer->blend;
+		if (copy->blend_data.op <= BLEND_OP_MIX75)
+			copy->blend_data.op = BLEND_OP_SRC;
+		copy->blend_data.factor = entry->blend;
+		copy->blend = &copy->blend_data;
+	}
+
+	if (entry->palette != NULL)
+		copy->palette = entry->palette;
+
+	return copy;
+}
+
 /* draw background scanline taking into account mosaic and windowing effects */
-static bool draw_background_scanline(int nlayer, int line)
+static bool draw_background_scanline(int nlayer, int line, Scanbuffers* buffers)
 {
 	/* draw */
-	Layer* layer = &engine->layers[nlayer];
+	Engine* const ctx = buffers->context;
+	Layer* layer = get_line_layer(nlayer, line, buffers);
 	LayerWindow* window = &layer->window;
-	uint32_t* mosaic = layer->mosaic.buffer;
+	const int framewidth = ctx->framebuffer.width;
+	uint32_t* mosaic = buffers->mosaic + nlayer*framewidth;
 	uint32_t* scan = NULL;
 	const bool inside = line >= window->y1 && line <= window->y2;
-	const int framewidth = engine->framebuffer.width;
 	const int windowwidth = layer->window.x2 - layer->window.x1;
 	bool priority = false;
 	bool build_mosaic = false;
+	int drawline = line;
+	bool drawinside = inside;
+
+	buffers->layer = layer;
 
 	/* determine target buffer */
 	if (layer->mosaic.h != 0)
 	{
-		if (line % layer->mosaic.h == 0)
+		/* blocks are built on their first line, or on the first line of a band starting mid-block */
+		if (line % layer->mosaic.h == 0 || line == buffers->first)
 		{
 			build_mosaic = true;
-			scan = engine->linebuffer;
+			drawline = line - (line % layer->mosaic.h);
+			drawinside = drawline >= window->y1 && drawline <= window->y2;
+			scan = buffers->linebuffer;
 		}
 		else
 			scan = NULL;
 	}
 	else if (layer->mode >= MODE_TRANSFORM)
-		scan = engine->linebuffer;
+		scan = buffers->linebuffer;
 	else
-		scan = GetFramebufferLine(line);
+		scan = GetFramebufferLine(ctx, line);
 
-	if (scan == engine->linebuffer)
-		memset(scan, 0, engine->framebuffer.pitch);
+	if (scan == buffers->linebuffer)
+		memset(scan, 0, framewidth * sizeof(uint32_t));
 
 	/* regular region */
 	if (scan != NULL)
 	{
 		if (!window->invert)
 		{
-			if (inside)
-				priority |= layer->draw(nlayer, scan, line, window->x1, window->x2);
+			if (drawinside)
+				priority |= layer->draw(nlayer, scan, drawline, window->x1, window->x2, buffers);
 		}
 		else
 		{
-			if (inside)
+			if (drawinside)
 			{
-				priority |= layer->draw(nlayer, scan, line, 0, layer->window.x1);
-				priority |= layer->draw(nlayer, scan, line, layer->window.x2, framewidth);
+				priority |= layer->draw(nlayer, scan, drawline, 0, layer->window.x1, buffers);
+				priority |= layer->draw(nlayer, scan, drawline, layer->window.x2, framewidth, buffers);
 			}
 			else
-				priority |= layer->draw(nlayer, scan, line, 0, framewidth);
+				priority |= layer->draw(nlayer, scan, drawline, 0, framewidth, buffers);
 		}
 	}
-	scan = GetFramebufferLine(line);
+	scan = GetFramebufferLine(ctx, line);
 
 	/* build mosaic to linebuffer */
 	if (build_mosaic)
 	{
-		memset(mosaic, 0, engine->framebuffer.pitch);
-		BlitMosaic(engine->linebuffer, mosaic, framewidth, layer->mosaic.w, NULL);
+		memset(mosaic, 0, framewidth * sizeof(uint32_t));
+		BlitMosaic(buffers->linebuffer, mosaic, framewidth, layer->mosaic.w, NULL);
 	}
 
 	/* blit mosaic */
@@ -115,7 +242,7 @@ static bool draw_background_scanline(int nlayer, int line)
 		}
 	}
 	else if (layer->mode >= MODE_TRANSFORM)
-		Blit32_32(engine->linebuffer, scan, engine->framebuffer.width, layer->blend);
+		Blit32_32(buffers->linebuffer, scan, framewidth, layer->blend);
 
 	/* clipped region */
 	if (window->color != 0)
@@ -137,106 +264,406 @@ static bool draw_background_scanline(int nlayer, int line)
 	return priority;
 }
 
-/* Draws the next scanline of the frame started with TLN_BeginFrame() or TLN_BeginWindowFrame() */
-bool DrawScanline(void)
+/* applies world positions set with TLN_SetWorldPosition() to layers and sprites that need it */
+static void update_world_positions(Engine* ctx)
 {
-	int line = engine->line;
-	uint32_t* scan = GetFramebufferLine(line);
-	int size = engine->framebuffer.width;
 	int c;
 	int index;
-	bool background_priority = false;	/* at least one tile in priority layer */
-	bool sprite_priority = false;		/* at least one sprite in priority layer */
-	List* list;
 
-	/* call raster effect callback */
-	if (engine->cb_raster)
-		engine->cb_raster(line);
+	for (c = ctx->numlayers - 1; c >= 0; c--)
+	{
+		Layer* layer = &ctx->layers[c];
+		if (ctx->dirty || layer->dirty)
+		{
+			const int lx = (int)(ctx->xworld * layer->world.xfactor) - layer->world.offsetx;
+			const int ly = (int)(ctx->yworld * layer->world.yfactor) - layer->world.offsety;
+			TLN_SetLayerPosition(c, lx, ly);
+			layer->dirty = false;
+		}
+	}
 
-	/* background is bitmap */
-	if (engine->bgbitmap && engine->bgpalette)
+	if (ctx->numsprites > 0)
 	{
-		if (size > engine->bgbitmap->width)
-			size = engine->bgbitmap->width;
-		if (line < engine->bgbitmap->height)
-			engine->blit_fast(TLN_GetBitmapPtr(engine->bgbitmap, 0, line), engine->bgpalette, scan, size, 1, 0, NULL);
+		index = ctx->list_sprites.first;
+		while (index != -1)
+		{
+			Sprite* sprite = &ctx->sprites[index];
+			if (sprite->world_space && (sprite->dirty || ctx->dirty))
+			{
+				sprite->x = sprite->xworld - ctx->xworld;
+				sprite->y = sprite->yworld - ctx->yworld;
+				UpdateSprite(ctx, sprite);
+				sprite->dirty = false;
+			}
+			index = sprite->list_node.next;
+		}
 	}
 
-	/* background is solid color */
-	else if (engine->bgcolor)
-		BlitColor(scan, engine->bgcolor, size, NULL);
+	ctx->dirty = false;
+}
 
-	/* draw regular background layers */
-	if (engine->numlayers > 0)
+/* flags sprite_lines as outdated after sprites move, change or get reordered */
+void InvalidateSpriteLines(Engine* ctx)
+{
+	ctx->sprite_lines.valid = ctx->framebuffer.height;
+}
+
+/* marks scanlines [y1, y2) to be drawn on the next frame when dirty tracking is enabled */
+void MarkDirtyLines(Engine* ctx, int y1, int y2)
+{
+	if (ctx == NULL || !ctx->dirty_lines.enabled)
+		return;
+
+	if (y1 < 0)
+		y1 = 0;
+	if (y2 > ctx->framebuffer.height)
+		y2 = ctx->framebuffer.height;
+	if (y1 < y2)
+		memset(&ctx->dirty_lines.lines[y1], 1, y2 - y1);
+}
+
+/* marks the whole frame to be drawn */
+void MarkDirtyFrame(Engine* ctx)
+{
+	if (ctx == NULL || !ctx->dirty_lines.enabled)
+		return;
+
+	memset(ctx->dirty_lines.lines, 1, ctx->framebuffer.height);
+}
+
+/* marks the scanlines showing rows [row1, row2) of a tilemap in the layers using it */
+void MarkDirtyTilemap(Engine* ctx, TLN_Tilemap tilemap, int row1, int row2)
+{
+	int c;
+
+	if (ctx == NULL || !ctx->dirty_lines.enabled)
+		return;
+
+	for (c = 0; c < ctx->numlayers; c++)
 	{
-		background_priority = false;
-		memset(engine->priority, 0, engine->framebuffer.pitch);
-		for (c = engine->numlayers - 1; c >= 0; c--)
+		const Layer* layer = &ctx->layers[c];
+		int y1, y2, start;
+
+		if (!layer->ok || layer->tilemap != tilemap)
+			continue;
+
+		/* rows can't be mapped to scanlines when they get displaced */
+		if (layer->mode != MODE_NORMAL || layer->column != NULL || layer->raster != NULL || layer->mosaic.h != 0)
+		{
+			MarkDirtyFrame(ctx);
+			return;
+		}
+
+		/* the layer repeats every height pixels */
+		y1 = row1 * layer->height / tilemap->rows;
+		y2 = row2 * layer->height / tilemap->rows;
+		start = (y1 - layer->vstart) % layer->height;
+		if (start > 0)
+			start -= layer->height;
+		for (; start < ctx->framebuffer.height; start += layer->height)
+			MarkDirtyLines(ctx, start, start + y2 - y1);
+	}
+}
+
+/* marks the scanlines an object covers in the layers showing its list */
+void MarkDirtyObject(Engine* ctx, TLN_ObjectList list, const struct _Object* object)
+{
+	const int height = (object->flags & FLAG_ROTATE) ? object->width : object->height;
+	int c;
+
+	if (ctx == NULL || !ctx->dirty_lines.enabled)
+		return;
+
+	for (c = 0; c < ctx->numlayers; c++)
+	{
+		const Layer* layer = &ctx->layers[c];
+
+		if (!layer->ok || layer->objects != list)
+			continue;
+
+		/* object lines can't be mapped to scanlines when they get displaced */
+		if (layer->raster != NULL || layer->mosaic.h != 0)
 		{
-			Layer* layer = &engine->layers[c];
-	
-			/* update if dirty */
-			if (engine->dirty || layer->dirty)
+			MarkDirtyFrame(ctx);
+			return;
+		}
+
+		MarkDirtyLines(ctx, object->y - layer->vstart, object->y + height - layer->vstart);
+	}
+}
+
+/* marks what changed without going through a setter before drawing a frame */
+static void update_dirty_lines(Engine* ctx)
+{
+	const int height = ctx->framebuffer.height;
+	int index;
+	int line;
+	int c;
+
+	if (!ctx->dirty_lines.enabled)
+		return;
+
+	/* any change in a layer redraws the whole frame */
+	if (memcmp(ctx->dirty_lines.layers, ctx->layers, ctx->numlayers * sizeof(Layer)) != 0)
+	{
+		memcpy(ctx->dirty_lines.layers, ctx->layers, ctx->numlayers * sizeof(Layer));
+		MarkDirtyFrame(ctx);
+	}
+
+	/* raster tables are edited in place, compare them line by line */
+	for (c = 0; c < ctx->numlayers; c++)
+	{
+		const TLN_RasterLine* table = ctx->layers[c].raster;
+		const int block = ctx->layers[c].mosaic.h;
+		TLN_RasterLine* last = &ctx->dirty_lines.rasters[c * height];
+		if (table == NULL)
+			continue;
+
+		for (line = 0; line < height; line++)
+		{
+			if (memcmp(&table[line], &last[line], sizeof(TLN_RasterLine)) != 0)
 			{
-				const int lx = (int)(engine->xworld * layer->world.xfactor) - layer->world.offsetx;
-				const int ly = (int)(engine->yworld * layer->world.yfactor) - layer->world.offsety;
-				TLN_SetLayerPosition(c, lx, ly);
-				layer->dirty = false;
-			}
+				memcpy(&last[line], &table[line], sizeof(TLN_RasterLine));
 
-			/* draw */
-			if (layer->ok && !layer->priority)
-				background_priority |= draw_background_scanline(c, line);
+				/* mosaic blocks take the entry of their first line, redraw the whole block */
+				if (block != 0)
+					MarkDirtyLines(ctx, line - line % block, line - line % block + block);
+				else
+					ctx->dirty_lines.lines[line] = 1;
+			}
 		}
 	}
 
-	/* draw regular sprites */
-	if (engine->numsprites > 0)
+	/* collisions are only detected on drawn scanlines */
+	if (ctx->numsprites > 0)
 	{
-		memset(engine->collision, -1, engine->framebuffer.width * sizeof(uint16_t));
-		list = &engine->list_sprites;
-		index = list->first;
+		index = ctx->list_sprites.first;
 		while (index != -1)
 		{
-			Sprite* sprite = &engine->sprites[index];
+			Sprite* sprite = &ctx->sprites[index];
+			if (sprite->do_collision)
+				MarkDirtyLines(ctx, sprite->dstrect.y1, sprite->dstrect.y2);
+			index = sprite->list_node.next;
+		}
+	}
+}
+
+/* returns true if a scanline must be drawn */
+static inline bool is_dirty_line(const Engine* ctx, int line)
+{
+	return !ctx->dirty_lines.enabled || ctx->cb_raster != NULL || ctx->dirty_lines.lines[line];
+}
+
+/* checks whether a sprite with the given rectangles goes in sprite_lines, off screen ones don't */
+static inline bool is_sprite_listed(const rect_t* srcrect, const rect_t* dstrect)
+{
+	return dstrect->x2 >= 0 && srcrect->x2 >= 0;
+}
+
+/* adds a sprite to a scanline after the sprites drawn before it */
+static bool insert_sprite_line(const Engine* ctx, SpriteLine* sprite_line, int index)
+{
+	const int order = ctx->sprites[index].order;
+	int c = sprite_line->count;
+
+	if (sprite_line->count == sprite_line->capacity)
+	{
+		const int capacity = sprite_line->capacity ? sprite_line->capacity * 2 : 8;
+		int* items = (int*)realloc(sprite_line->items, capacity * sizeof(int));
+		if (items == NULL)
+			return false;
+		sprite_line->items = items;
+		sprite_line->capacity = capacity;
+	}
+
+	while (c > 0 && ctx->sprites[sprite_line->items[c - 1]].order > order)
+	{
+		sprite_line->items[c] = sprite_line->items[c - 1];
+		c--;
+	}
+	sprite_line->items[c] = index;
+	sprite_line->count += 1;
+	return true;
+}
+
+/* removes a sprite from a scanline */
+static void remove_sprite_line(SpriteLine* sprite_line, int index)
+{
+	int c;
+
+	for (c = 0; c < sprite_line->count; c++)
+	{
+		if (sprite_line->items[c] == index)
+		{
+			memmove(&sprite_line->items[c], &sprite_line->items[c + 1], (sprite_line->count - c - 1) * sizeof(int));
+			sprite_line->count -= 1;
+			return;
+		}
+	}
+}
+
+/* adds a sprite to the scanlines it covers from the given one down */
+static void add_sprite_lines(Engine* ctx, int index, int line, const rect_t* dstrect)
+{
+	const int y1 = dstrect->y1 > line ? dstrect->y1 : line;
+	const int y2 = dstrect->y2 < ctx->framebuffer.height ? dstrect->y2 : ctx->framebuffer.height;
+	int y;
+
+	for (y = y1; y < y2; y++)
+	{
+		if (!insert_sprite_line(ctx, &ctx->sprite_lines.lines[y], index))
+		{
+			tln_trace(TLN_LOG_ERRORS, "Out of memory building sprite scanlines");
+			return;
+		}
+	}
+}
+
+/* rebuilds the sprites covering each scanline from the given one down, in drawing order. With a
+ * limit only the first sprites of each scanline are drawn, as classic sprite hardware did */
+static void update_sprite_lines(Engine* ctx, int line)
+{
+	const int height = ctx->framebuffer.height;
+	int order = 0;
+	int index;
+	int y;
+
+	if (ctx->numsprites == 0 || line >= ctx->sprite_lines.valid)
+		return;
+
+	for (y = line; y < height; y++)
+		ctx->sprite_lines.lines[y].count = 0;
+
+	index = ctx->list_sprites.first;
+	while (index != -1)
+	{
+		Sprite* sprite = &ctx->sprites[index];
+		sprite->order = order++;
+		if (is_sprite_listed(&sprite->srcrect, &sprite->dstrect))
+			add_sprite_lines(ctx, index, line, &sprite->dstrect);
+		index = sprite->list_node.next;
+	}
+	ctx->sprite_lines.valid = line;
+}
+
+/* moves a sprite from the scanlines it covered with the given rectangles to the ones it covers
+ * now. Only the scanlines it left or entered change, the drawing order stays the same */
+void MoveSpriteLines(Engine* ctx, Sprite* sprite, const rect_t* srcrect, const rect_t* dstrect)
+{
+	const int index = (int)(sprite - ctx->sprites);
+	const int height = ctx->framebuffer.height;
+	const int line = ctx->sprite_lines.valid;
+	const bool was_listed = is_sprite_listed(srcrect, dstrect);
+	const bool is_listed = is_sprite_listed(&sprite->srcrect, &sprite->dstrect);
+	int y1, y2, y;
+
+	if (line >= height)
+		return;
+
+	if (was_listed)
+	{
+		y1 = dstrect->y1 > line ? dstrect->y1 : line;
+		y2 = dstrect->y2 < height ? dstrect->y2 : height;
+		for (y = y1; y < y2; y++)
+		{
+			if (!is_listed || y < sprite->dstrect.y1 || y >= sprite->dstrect.y2)
+				remove_sprite_line(&ctx->sprite_lines.lines[y], index);
+		}
+	}
 
-			/* update if dirty */
-			if (sprite->world_space && (sprite->dirty || engine->dirty))
+	if (is_listed)
+	{
+		y1 = sprite->dstrect.y1 > line ? sprite->dstrect.y1 : line;
+		y2 = sprite->dstrect.y2 < height ? sprite->dstrect.y2 : height;
+		for (y = y1; y < y2; y++)
+		{
+			if ((!was_listed || y < dstrect->y1 || y >= dstrect->y2) &&
+				!insert_sprite_line(ctx, &ctx->sprite_lines.lines[y], index))
 			{
-				sprite->x = sprite->xworld - engine->xworld;
-				sprite->y = sprite->yworld - engine->yworld;
-				UpdateSprite(sprite);
-				sprite->dirty = false;
+				/* leave it to a full rebuild */
+				InvalidateSpriteLines(ctx);
+				return;
 			}
+		}
+	}
+}
+
+/* draws a scanline using the given scratch buffers, doesn't modify engine state */
+static void draw_scanline(int line, Scanbuffers* buffers)
+{
+	Engine* const ctx = buffers->context;
+	uint32_t* scan = GetFramebufferLine(ctx, line);
+	int size = ctx->framebuffer.width;
+	int c;
+	bool background_priority = false;	/* at least one tile in priority layer */
+	bool sprite_priority = false;		/* at least one sprite in priority layer */
+	const int* sprites = NULL;			/* sprites covering this scanline */
+	int numsprites = 0;
+
+	/* background is bitmap */
+	if (ctx->bgbitmap && ctx->bgpalette)
+	{
+		if (size > ctx->bgbitmap->width)
+			size = ctx->bgbitmap->width;
+		if (line < ctx->bgbitmap->height)
+			ctx->blit_fast(TLN_GetBitmapPtr(ctx->bgbitmap, 0, line), ctx->bgpalette, scan, size, 1, 0, NULL);
+	}
+
+	/* background is solid color */
+	else if (ctx->bgcolor)
+		BlitColor(scan, ctx->bgcolor, size, NULL);
+
+	/* draw regular background layers */
+	if (ctx->numlayers > 0)
+	{
+		background_priority = false;
+		memset(buffers->priority, 0, ctx->framebuffer.width * sizeof(uint32_t));
+		for (c = ctx->numlayers - 1; c >= 0; c--)
+		{
+			Layer* layer = &ctx->layers[c];
+			if (layer->ok && !layer->priority)
+				background_priority |= draw_background_scanline(c, line, buffers);
+		}
+	}
 
-			if (check_sprite_coverage(sprite, line))
+	/* draw regular sprites */
+	if (ctx->numsprites > 0)
+	{
+		memset(buffers->collision, -1, ctx->framebuffer.width * sizeof(uint16_t));
+		sprites = ctx->sprite_lines.lines[line].items;
+		numsprites = ctx->sprite_lines.lines[line].count;
+		if (ctx->sprite_lines.limit > 0 && numsprites > ctx->sprite_lines.limit)
+			numsprites = ctx->sprite_lines.limit;
+		for (c = 0; c < numsprites; c++)
+		{
+			Sprite* sprite = &ctx->sprites[sprites[c]];
+			if (check_sprite_coverage(ctx, sprite, line))
 			{
 				if (!(sprite->flags & FLAG_PRIORITY))
-					sprite->draw(index, scan, line, 0, 0);
+					sprite->draw(sprites[c], scan, line, 0, 0, buffers);
 				else
 					sprite_priority = true;
 			}
-			index = sprite->list_node.next;
 		}
 	}
 
 	/* draw background layers with priority */
-	if (engine->numlayers > 0)
+	if (ctx->numlayers > 0)
 	{
-		for (c = engine->numlayers - 1; c >= 0; c--)
+		for (c = ctx->numlayers - 1; c >= 0; c--)
 		{
-			Layer* layer = &engine->layers[c];
+			Layer* layer = &ctx->layers[c];
 			if (layer->ok && layer->priority)
-				draw_background_scanline(c, line);
+				draw_background_scanline(c, line, buffers);
 		}
 	}
 
 	/* overlay background tiles with priority */
 	if (background_priority == true)
 	{
-		uint32_t* src = engine->priority;
+		uint32_t* src = buffers->priority;
 		uint32_t* dst = scan;
-		for (c = 0; c < engine->framebuffer.width; c++)
+		for (c = 0; c < ctx->framebuffer.width; c++)
 		{
 			if (*src)
 				*dst = *src;
@@ -248,20 +675,108 @@ bool DrawScanline(void)
 	/* draw sprites with priority */
 	if (sprite_priority == true)
 	{
-		index = list->first;
+		for (c = 0; c < numsprites; c++)
+		{
+			Sprite* sprite = &ctx->sprites[sprites[c]];
+			if (check_sprite_coverage(ctx, sprite, line) && (sprite->flags & FLAG_PRIORITY))
+				sprite->draw(sprites[c], scan, line, 0, 0, buffers);
+		}
+	}
+}
+
+/* Draws the next scanline of the frame started with TLN_BeginFrame() or TLN_BeginWindowFrame() */
+bool DrawScanline(Engine* ctx)
+{
+	int line = ctx->line;
+
+	/* call raster effect callback */
+	if (ctx->cb_raster)
+		ctx->cb_raster(line);
+
+	/* update if dirty */
+	update_world_positions(ctx);
+	update_sprite_lines(ctx, line);
+	if (line == 0)
+	{
+		update_dirty_lines(ctx);
+		ctx->buffers[0].first = 0;
+	}
+
+	/* mosaic blocks restart after skipped scanlines */
+	if (is_dirty_line(ctx, line))
+		draw_scanline(line, &ctx->buffers[0]);
+	else
+		ctx->buffers[0].first = line + 1;
+	if (ctx->dirty_lines.enabled)
+		ctx->dirty_lines.lines[line] = 0;
+
+	/* next scanline */
+	ctx->line++;
+	return ctx->line < ctx->framebuffer.height;
+}
+
+/* worker job: draws one band of lines of the given context with the running thread's buffers */
+static void draw_band(int band, int thread, void* data)
+{
+	Engine* const ctx = (Engine*)data;
+	Scanbuffers* buffers = &ctx->buffers[thread];
+	int line = band * BAND_HEIGHT;
+	int end = line + BAND_HEIGHT;
+
+	if (end > ctx->framebuffer.height)
+		end = ctx->framebuffer.height;
+
+	buffers->first = line;
+	for (; line < end; line++)
+	{
+		/* mosaic blocks restart after skipped scanlines */
+		if (is_dirty_line(ctx, line))
+			draw_scanline(line, buffers);
+		else
+			buffers->first = line + 1;
+	}
+}
+
+/* Draws the whole frame in horizontal bands across the rendering threads. Without a raster
+ * callback nothing changes mid-frame, so bands can be drawn in any order */
+void DrawFrameBands(Engine* ctx)
+{
+	const int numbands = (ctx->framebuffer.height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+	int c;
+	int index;
+
+	update_world_positions(ctx);
+	update_sprite_lines(ctx, 0);
+	update_dirty_lines(ctx);
+
+	for (c = 0; c < ctx->numthreads; c++)
+	{
+		if (ctx->buffers[c].hits != NULL)
+			memset(ctx->buffers[c].hits, 0, ctx->numsprites);
+	}
+
+	RunWorkers(ctx->workers, draw_band, ctx, numbands);
+	if (ctx->dirty_lines.enabled)
+		memset(ctx->dirty_lines.lines, 0, ctx->framebuffer.height);
+
+	/* merge sprite collisions found by each thread */
+	if (ctx->numsprites > 0)
+	{
+		index = ctx->list_sprites.first;
 		while (index != -1)
 		{
-			Sprite* sprite = &engine->sprites[index];
-			if (check_sprite_coverage(sprite, line) && (sprite->flags & FLAG_PRIORITY))
-				sprite->draw(index, scan, line, 0, 0);
+			Sprite* sprite = &ctx->sprites[index];
+			for (c = 0; c < ctx->numthreads; c++)
+			{
+				if (ctx->buffers[c].hits != NULL && ctx->buffers[c].hits[index])
+					sprite->collision = true;
+			}
 			index = sprite->list_node.next;
 		}
 	}
 
-	/* next scanline */
-	engine->dirty = false;
-	engine->line++;
-	return engine->line < engine->framebuffer.height;
+	ctx->buffers[0].first = 0;
+	ctx->line = ctx->framebuffer.height;
 }
 
 typedef struct
@@ -319,10 +834,183 @@ static inline void process_flip_rotation(uint16_t flags, Tilescan* scan)
 	}
 }
 
+/* returns pixel coverage of a tile, index 0 is always empty */
+static inline PixelsType get_tile_type(TLN_Tilemap tilemap, TLN_Tile tile)
+{
+	if (tile->index == 0)
+		return PIXELS_EMPTY;
+
+	const TLN_Tileset tileset = tilemap->tilesets[tile->tileset];
+	return (PixelsType)tileset->types[tileset->tiles[tile->index]];
+}
+
+/* texture coordinates of a transformed scanline, stepped in fixed point TEXEL_BATCH pixels at a
+ * time. Coordinates are kept wrapped into the layer, so each step only needs a mask when the
+ * size is a power of two or a conditional subtraction otherwise, instead of a modulo per pixel */
+typedef struct
+{
+	uint32_t x, y;						/* first pixel of the next batch */
+	uint32_t width, height;				/* layer size */
+	uint32_t xmask, ymask;				/* size - 1 when it's a power of two, 0 otherwise */
+	uint32_t xstep, ystep;				/* offset from one batch to the next */
+	uint32_t xoffset[TEXEL_BATCH];		/* offset of each pixel of a batch from the first one */
+	uint32_t yoffset[TEXEL_BATCH];
+	bool wide;							/* layer larger than TEXCOORD_MAX_SIZE, uses the 64 bit fields */
+	int64_t wx, wy;						/* next pixel */
+	int64_t wdx, wdy;					/* offset from one pixel to the next */
+	int64_t wwidth, wheight;			/* layer size */
+}
+Texcoords;
+
+/* converts a transformed coordinate to 64 bit fixed point, it may lie far outside the layer */
+static inline int64_t float2wide(math2d_t value)
+{
+	return (int64_t)(value * (1 << FIXED_BITS));
+}
+
+/* wraps a fixed point coordinate into [0, size) */
+static inline int64_t wrap_fix(int64_t value, int64_t size)
+{
+	value %= size;
+	if (value < 0)
+		value += size;
+	return value;
+}
+
+/* sets up stepping from x,y by dx,dy per pixel, all in fixed point, across a layer of the given size */
+static void init_texcoords(Texcoords* tc, int64_t x, int64_t y, int64_t dx, int64_t dy, int width, int height)
+{
+	const int64_t w = (int64_t)int2fix(1) * width;
+	const int64_t h = (int64_t)int2fix(1) * height;
+	int c;
+
+	tc->wide = width > TEXCOORD_MAX_SIZE || height > TEXCOORD_MAX_SIZE;
+	if (tc->wide)
+	{
+		tc->wx = wrap_fix(x, w);
+		tc->wy = wrap_fix(y, h);
+		tc->wdx = wrap_fix(dx, w);
+		tc->wdy = wrap_fix(dy, h);
+		tc->wwidth = w;
+		tc->wheight = h;
+		return;
+	}
+
+	tc->x = (uint32_t)wrap_fix(x, w);
+	tc->y = (uint32_t)wrap_fix(y, h);
+	tc->width = (uint32_t)w;
+	tc->height = (uint32_t)h;
+	tc->xmask = (width & (width - 1)) == 0 ? (uint32_t)(w - 1) : 0;
+	tc->ymask = (height & (height - 1)) == 0 ? (uint32_t)(h - 1) : 0;
+	tc->xstep = (uint32_t)wrap_fix(dx * TEXEL_BATCH, w);
+	tc->ystep = (uint32_t)wrap_fix(dy * TEXEL_BATCH, h);
+	for (c = 0; c < TEXEL_BATCH; c++)
+	{
+		tc->xoffset[c] = (uint32_t)wrap_fix(dx * c, w);
+		tc->yoffset[c] = (uint32_t)wrap_fix(dy * c, h);
+	}
+}
+
+/* wraps a coordinate in [0, 2*size) */
+static inline uint32_t wrap_texcoord(uint32_t value, uint32_t size, uint32_t mask)
+{
+	if (mask != 0)
+		return value & mask;
+	return value >= size ? value - size : value;
+}
+
+#if defined(DRAW_SSE2)
+
+/* wraps 4 coordinates in [0, 2*size) and converts them to integer */
+static inline __m128i wrap_texcoords_sse2(__m128i value, uint32_t size, uint32_t mask)
+{
+	if (mask != 0)
+		value = _mm_and_si128(value, _mm_set1_epi32((int)mask));
+	else
+	{
+		/* unsigned compare with the sign bit flipped */
+		const __m128i bias = _mm_set1_epi32((int)0x80000000);
+		const __m128i limit = _mm_set1_epi32((int)size);
+		const __m128i below = _mm_cmplt_epi32(_mm_xor_si128(value, bias), _mm_xor_si128(limit, bias));
+		value = _mm_sub_epi32(value, _mm_andnot_si128(below, limit));
+	}
+	return _mm_srli_epi32(value, FIXED_BITS);
+}
+
+#elif defined(DRAW_NEON)
+
+/* wraps 4 coordinates in [0, 2*size) and converts them to integer */
+static inline uint32x4_t wrap_texcoords_neon(uint32x4_t value, uint32_t size, uint32_t mask)
+{
+	if (mask != 0)
+		value = vandq_u32(value, vdupq_n_u32(mask));
+	else
+	{
+		const uint32x4_t limit = vdupq_n_u32(size);
+		value = vsubq_u32(value, vandq_u32(vcgeq_u32(value, limit), limit));
+	}
+	return vshrq_n_u32(value, FIXED_BITS);
+}
+
+#endif
+
+/* gets the integer coordinates of the next TEXEL_BATCH pixels of a wide layer */
+static void get_texcoords_wide(Texcoords* tc, int* xpos, int* ypos)
+{
+	int c;
+	for (c = 0; c < TEXEL_BATCH; c++)
+	{
+		xpos[c] = (int)(tc->wx >> FIXED_BITS);
+		ypos[c] = (int)(tc->wy >> FIXED_BITS);
+		tc->wx += tc->wdx;
+		if (tc->wx >= tc->wwidth)
+			tc->wx -= tc->wwidth;
+		tc->wy += tc->wdy;
+		if (tc->wy >= tc->wheight)
+			tc->wy -= tc->wheight;
+	}
+}
+
+/* gets the integer coordinates of the next TEXEL_BATCH pixels */
+static inline void get_texcoords(Texcoords* tc, int* xpos, int* ypos)
+{
+	if (tc->wide)
+	{
+		get_texcoords_wide(tc, xpos, ypos);
+		return;
+	}
+
+#if defined(DRAW_SSE2)
+	const __m128i x = _mm_set1_epi32((int)tc->x);
+	const __m128i y = _mm_set1_epi32((int)tc->y);
+	_mm_storeu_si128((__m128i*)&xpos[0], wrap_texcoords_sse2(_mm_add_epi32(x, _mm_loadu_si128((__m128i*)&tc->xoffset[0])), tc->width, tc->xmask));
+	_mm_storeu_si128((__m128i*)&xpos[4], wrap_texcoords_sse2(_mm_add_epi32(x, _mm_loadu_si128((__m128i*)&tc->xoffset[4])), tc->width, tc->xmask));
+	_mm_storeu_si128((__m128i*)&ypos[0], wrap_texcoords_sse2(_mm_add_epi32(y, _mm_loadu_si128((__m128i*)&tc->yoffset[0])), tc->height, tc->ymask));
+	_mm_storeu_si128((__m128i*)&ypos[4], wrap_texcoords_sse2(_mm_add_epi32(y, _mm_loadu_si128((__m128i*)&tc->yoffset[4])), tc->height, tc->ymask));
+#elif defined(DRAW_NEON)
+	const uint32x4_t x = vdupq_n_u32(tc->x);
+	const uint32x4_t y = vdupq_n_u32(tc->y);
+	vst1q_s32(&xpos[0], vreinterpretq_s32_u32(wrap_texcoords_neon(vaddq_u32(x, vld1q_u32(&tc->xoffset[0])), tc->width, tc->xmask)));
+	vst1q_s32(&xpos[4], vreinterpretq_s32_u32(wrap_texcoords_neon(vaddq_u32(x, vld1q_u32(&tc->xoffset[4])), tc->width, tc->xmask)));
+	vst1q_s32(&ypos[0], vreinterpretq_s32_u32(wrap_texcoords_neon(vaddq_u32(y, vld1q_u32(&tc->yoffset[0])), tc->height, tc->ymask)));
+	vst1q_s32(&ypos[4], vreinterpretq_s32_u32(wrap_texcoords_neon(vaddq_u32(y, vld1q_u32(&tc->yoffset[4])), tc->height, tc->ymask)));
+#else
+	int c;
+	for (c = 0; c < TEXEL_BATCH; c++)
+	{
+		xpos[c] = (int)(wrap_texcoord(tc->x + tc->xoffset[c], tc->width, tc->xmask) >> FIXED_BITS);
+		ypos[c] = (int)(wrap_texcoord(tc->y + tc->yoffset[c], tc->height, tc->ymask) >> FIXED_BITS);
+	}
+#endif
+
+	tc->x = wrap_texcoord(tc->x + tc->xstep, tc->width, tc->xmask);
+	tc->y = wrap_texcoord(tc->y + tc->ystep, tc->height, tc->ymask);
+}
+
 /* draw scanline of tiled background */
-static bool DrawTiledScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2)
+static bool DrawTiledScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	const Layer *layer = (const Layer*)&engine->layers[nlayer];
+	const Layer *layer = buffers->layer;
 	bool priority = false;
 	Tilescan scan = { 0 };
 
@@ -364,7 +1052,8 @@ static bool DrawTiledScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1
 		int width = x1 - x;
 
 		/* paint if not empty tile */
-		if (tile->index)
+		const PixelsType type = get_tile_type(tilemap, tile);
+		if (type != PIXELS_EMPTY)
 		{
 			const TLN_Tileset tileset = tilemap->tilesets[tile->tileset];
 			const uint16_t tile_index = tileset->tiles[tile->index];
@@ -373,8 +1062,8 @@ static bool DrawTiledScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1
 			TLN_Palette palette = tileset->palette;
 			if (layer->palette != NULL)
 				palette = layer->palette;
-			else if (engine->palettes[tile->palette] != NULL)
-				palette = engine->palettes[tile->palette];
+			else if (buffers->context->palettes[tile->palette] != NULL)
+				palette = buffers->context->palettes[tile->palette];
 
 			/* process rotate & flip flags */
 			scan.dx = 1;
@@ -386,13 +1075,15 @@ static bool DrawTiledScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1
 			uint32_t *dst = dstpixel;
 			if (tile->flags & FLAG_PRIORITY)
 			{
-				dst = engine->priority;
+				dst = buffers->priority;
 				priority = true;
 			}
 
-			int line = GetTilesetLine(tileset, tile_index, scan.srcy);
-			bool color_key = *(tileset->color_key + line);
-			layer->blitters[1](srcpixel, palette, dst + x, width, scan.dx, 0, layer->blend);
+			/* solid lines skip color key, rotated tiles are scanned across lines */
+			bool color_key = type == PIXELS_MIXED;
+			if (color_key && !(tile->flags & FLAG_ROTATE))
+				color_key = *(tileset->color_key + GetTilesetLine(tileset, tile_index, scan.srcy));
+			layer->blitters[color_key](srcpixel, palette, dst + x, width, scan.dx, 0, layer->blend);
 		}
 
 		/* next tile */
@@ -404,10 +1095,26 @@ static bool DrawTiledScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1
 	return priority;
 }
 
+/* returns the layer column or row shown at a screen position when scaled by step, the product
+ * is taken in 64 bits as it exceeds 32 bit fixed point on large layers or strong downscaling */
+static inline int get_scaled_pos(int start, int pos, fix_t step, int size)
+{
+	const int64_t value = start + (((int64_t)pos * step) >> FIXED_BITS);
+	if (value >= 0 && value < size)
+		return (int)value;
+	return (int)wrap_fix(value, size);
+}
+
+/* returns the layer row shown at a scanline when scaled vertically */
+static inline int get_scaled_row(const Layer* layer, int line)
+{
+	return get_scaled_pos(layer->vstart, line, layer->dy, layer->height);
+}
+
 /* draw scanline of tiled background with scaling */
-static bool DrawTiledScanlineScaling(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2)
+static bool DrawTiledScanlineScaling(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	const Layer *layer = (const Layer*)&engine->layers[nlayer];
+	const Layer *layer = buffers->layer;
 	bool priority = false;
 	Tilescan scan = { 0 };
 
@@ -415,52 +1122,54 @@ static bool DrawTiledScanlineScaling(int nlayer, uint32_t* dstpixel, int nscan,
 	int x = tx1;
 	const TLN_Tilemap tilemap = layer->tilemap;
 	const TLN_Tileset tileset = tilemap->tilesets[0];
-	int xpos = (layer->hstart + fix2int(x*layer->dx)) % layer->width;
+	int xpos = get_scaled_pos(layer->hstart, x, layer->dx, layer->width);
 	int xtile = xpos >> tileset->hshift;
 
 	scan.width = scan.height = scan.stride = tileset->width;
 	scan.srcx = xpos & tileset->hmask;
 
+	/* source row, the same for all tiles without column offset */
+	int ypos = get_scaled_row(layer, nscan);
+	int ytile = ypos >> tileset->vshift;
+	int srcy = ypos & tileset->vmask;
+
 	/* fill whole scanline */
-	fix_t fix_x = int2fix(x);
+	int64_t fix_x = int2fix(x);
 	int column = x % tileset->width;
 	while (x < tx2)
 	{
 		/* column offset: update ypos */
-		int ypos = nscan;
 		if (layer->column)
-			ypos += layer->column[column];
+		{
+			ypos = get_scaled_row(layer, nscan + layer->column[column]);
+			ytile = ypos >> tileset->vshift;
+			srcy = ypos & tileset->vmask;
+		}
 
-		ypos = layer->vstart + fix2int(ypos*layer->dy);
-		if (ypos < 0)
-			ypos = layer->height + ypos;
-		else
-			ypos = ypos % layer->height;
-
-		int ytile = ypos >> tileset->vshift;
-		scan.srcy = ypos & tileset->vmask;
+		/* set for every tile, vertical flip alters it */
+		scan.srcy = srcy;
 
 		TLN_Tile tile = &tilemap->tiles[ytile*tilemap->cols + xtile];
 
 		/* get effective tile width */
 		int tilewidth = tileset->width - scan.srcx;
 		fix_t dx = int2fix(tilewidth);
-		fix_t fix_tilewidth = tilewidth * layer->xfactor;
-		fix_x += fix_tilewidth;
-		int x1 = fix2int(fix_x);
-		int tilescalewidth = x1 - x;
+		fix_x += (int64_t)tilewidth * layer->xfactor;
+		int64_t x1 = fix_x >> FIXED_BITS;
+		int64_t tilescalewidth = x1 - x;
 		if (tilescalewidth)
-			dx /= tilescalewidth;
+			dx = (fix_t)(dx / tilescalewidth);
 		else
 			dx = 0;
 
 		/* right clip */
 		if (x1 > tx2)
 			x1 = tx2;
-		int width = x1 - x;
+		int width = (int)x1 - x;
 
 		/* paint if tile is not empty */
-		if (tile->index)
+		const PixelsType type = get_tile_type(tilemap, tile);
+		if (type != PIXELS_EMPTY)
 		{
 			const TLN_Tileset tileset = tilemap->tilesets[tile->tileset];
 			const uint16_t tile_index = tileset->tiles[tile->index];
@@ -469,8 +1178,8 @@ static bool DrawTiledScanlineScaling(int nlayer, uint32_t* dstpixel, int nscan,
 			TLN_Palette palette = tileset->palette;
 			if (layer->palette != NULL)
 				palette = layer->palette;
-			else if (engine->palettes[tile->palette] != NULL)
-				palette = engine->palettes[tile->palette];
+			else if (buffers->context->palettes[tile->palette] != NULL)
+				palette = buffers->context->palettes[tile->palette];
 
 			/* process flip flags */
 			scan.dx = dx;
@@ -483,18 +1192,21 @@ static bool DrawTiledScanlineScaling(int nlayer, uint32_t* dstpixel, int nscan,
 			uint32_t *dst = dstpixel;
 			if (tile->flags & FLAG_PRIORITY)
 			{
-				dst = engine->priority;
+				dst = buffers->priority;
 				priority = true;
 			}
 
-			int line = GetTilesetLine(tileset, tile_index, scan.srcy);
-			bool color_key = *(tileset->color_key + line);
+			bool color_key = type == PIXELS_MIXED;
+			if (color_key)
+				color_key = *(tileset->color_key + GetTilesetLine(tileset, tile_index, scan.srcy));
 			layer->blitters[color_key](srcpixel, palette, dst + x, width, scan.dx, 0, layer->blend);
 		}
 
 		/* next tile */
-		x = x1;
-		xtile = (xtile + 1) % tilemap->cols;
+		x = (int)x1;
+		xtile += 1;
+		if (xtile == tilemap->cols)
+			xtile = 0;
 		scan.srcx = 0;
 		column += 1;
 	}
@@ -502,75 +1214,97 @@ static bool DrawTiledScanlineScaling(int nlayer, uint32_t* dstpixel, int nscan,
 }
 
 /* draw scanline of tiled background with affine transform */
-static bool DrawTiledScanlineAffine(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2)
+static bool DrawTiledScanlineAffine(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	const Layer *layer = (const Layer*)&engine->layers[nlayer];
-	bool priority = false;
+	const Layer *layer = buffers->layer;
 	Tilescan scan = { 0 };
+	Texcoords texcoords;
+	int xpos[TEXEL_BATCH];
+	int ypos[TEXEL_BATCH];
 
 	const TLN_Tilemap tilemap = layer->tilemap;
 	const TLN_Tileset tileset = tilemap->tilesets[0];
-	int xpos = layer->hstart;
-	int ypos = layer->vstart + nscan;
+
+	/* current tile, resolved again only when the next pixel falls in another one */
+	int last_xtile = -1;
+	int last_ytile = -1;
+	TLN_Tile tile = NULL;
+	TLN_Tileset tile_tileset = NULL;
+	uint16_t tile_index = 0;
+	TLN_Palette palette = NULL;
+
+	if (tx1 >= tx2)
+		return false;
 
 	Point2D p1, p2;
-	Point2DSet(&p1, (math2d_t)xpos + tx1, (math2d_t)ypos);
-	Point2DSet(&p2, (math2d_t)xpos + tx2, (math2d_t)ypos);
+	Point2DSet(&p1, (math2d_t)layer->hstart + tx1, (math2d_t)layer->vstart + nscan);
+	Point2DSet(&p2, (math2d_t)layer->hstart + tx2, (math2d_t)layer->vstart + nscan);
 	Point2DMultiply(&p1, (Matrix3*)&layer->transform);
 	Point2DMultiply(&p2, (Matrix3*)&layer->transform);
 
-	int x1 = float2fix(p1.x);
-	int y1 = float2fix(p1.y);
-	int x2 = float2fix(p2.x);
-	int y2 = float2fix(p2.y);
+	const int64_t x1 = float2wide(p1.x);
+	const int64_t y1 = float2wide(p1.y);
+	const int64_t x2 = float2wide(p2.x);
+	const int64_t y2 = float2wide(p2.y);
 
 	const int twidth = tx2 - tx1;
-	const int dx = (x2 - x1) / twidth;
-	const int dy = (y2 - y1) / twidth;
+	const int64_t dx = (x2 - x1) / twidth;
+	const int64_t dy = (y2 - y1) / twidth;
 
 	scan.width = scan.height = scan.stride = tileset->width;
+	init_texcoords(&texcoords, x1, y1, dx, dy, layer->width, layer->height);
 	dstpixel += tx1;
 
 	while (tx1 < tx2)
 	{
-		xpos = abs((fix2int(x1) + layer->width)) % layer->width;
-		ypos = abs((fix2int(y1) + layer->height)) % layer->height;
+		const int count = tx2 - tx1 < TEXEL_BATCH ? tx2 - tx1 : TEXEL_BATCH;
+		int c;
 
-		int xtile = xpos >> tileset->hshift;
-		int ytile = ypos >> tileset->vshift;
+		get_texcoords(&texcoords, xpos, ypos);
+		for (c = 0; c < count; c++)
+		{
+			const int xtile = xpos[c] >> tileset->hshift;
+			const int ytile = ypos[c] >> tileset->vshift;
 
-		scan.srcx = xpos & tileset->hmask;
-		scan.srcy = ypos & tileset->vmask;
-		TLN_Tile tile = &tilemap->tiles[ytile*tilemap->cols + xtile];
+			if (xtile != last_xtile || ytile != last_ytile)
+			{
+				last_xtile = xtile;
+				last_ytile = ytile;
+				tile = &tilemap->tiles[ytile*tilemap->cols + xtile];
+				if (tile->index != 0)
+				{
+					tile_tileset = tilemap->tilesets[tile->tileset];
+					tile_index = tile_tileset->tiles[tile->index];
+					palette = layer->palette != NULL ? layer->palette : tile_tileset->palette;
+				}
+			}
 
-		/* paint if not empty tile */
-		if (tile->index != 0)
-		{
-			const TLN_Tileset tileset = tilemap->tilesets[tile->tileset];
-			const uint16_t tile_index = tileset->tiles[tile->index];
+			/* paint if not empty tile */
+			if (tile->index != 0)
+			{
+				scan.srcx = xpos[c] & tileset->hmask;
+				scan.srcy = ypos[c] & tileset->vmask;
 
-			/* process flip & rotation flags */
-			if ((tile->flags & (FLAG_FLIPX + FLAG_FLIPY + FLAG_ROTATE)) != 0)
-				process_flip_rotation(tile->flags, &scan);
+				/* process flip & rotation flags */
+				if ((tile->flags & (FLAG_FLIPX + FLAG_FLIPY + FLAG_ROTATE)) != 0)
+					process_flip_rotation(tile->flags, &scan);
 
-			/* paint RGB pixel value */
-			const TLN_Palette palette = layer->palette != NULL ? layer->palette : tileset->palette;
-			*dstpixel = palette->data[GetTilesetPixel(tileset, tile_index, scan.srcx, scan.srcy)];
+				/* paint RGB pixel value */
+				dstpixel[c] = palette->data[GetTilesetPixel(tile_tileset, tile_index, scan.srcx, scan.srcy)];
+			}
 		}
 
-		/* next pixel */
-		tx1 += 1;
-		x1 += dx;
-		y1 += dy;
-		dstpixel += 1;
+		/* next pixels */
+		tx1 += count;
+		dstpixel += count;
 	}
 	return false;
 }
 
 /* draw scanline of tiled background with per-pixel mapping */
-static bool DrawTiledScanlinePixelMapping(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2)
+static bool DrawTiledScanlinePixelMapping(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	const Layer *layer = (const Layer*)&engine->layers[nlayer];
+	const Layer *layer = buffers->layer;
 	bool priority = false;
 	Tilescan scan = { 0 };
 
@@ -582,7 +1316,7 @@ static bool DrawTiledScanlinePixelMapping(int nlayer, uint32_t* dstpixel, int ns
 	const TLN_Tileset tileset = tilemap->tilesets[0];
 	const int hstart = layer->hstart + layer->width;
 	const int vstart = layer->vstart + layer->height;
-	TLN_PixelMap* pixel_map = &layer->pixel_map[nscan*engine->framebuffer.width + x];
+	TLN_PixelMap* pixel_map = &layer->pixel_map[nscan*buffers->context->framebuffer.width + x];
 
 	scan.width = scan.height = scan.stride = tileset->width;
 
@@ -622,9 +1356,12 @@ static bool DrawTiledScanlinePixelMapping(int nlayer, uint32_t* dstpixel, int ns
 }
 
 /* draw sprite scanline */
-static bool DrawSpriteScanline(int nsprite, uint32_t* dstscan, int nscan, int tx1, int tx2)
+static bool DrawSpriteScanline(int nsprite, uint32_t* dstscan, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	Sprite* sprite = (Sprite*)&engine->sprites[nsprite];
+	Sprite* sprite = (Sprite*)&buffers->context->sprites[nsprite];
+	const PixelsType type = (PixelsType)sprite->info->type;
+	if (type == PIXELS_EMPTY)
+		return false;
 
 	Tilescan scan = { 0 };
 	scan.srcx = sprite->srcrect.x1;
@@ -648,20 +1385,23 @@ static bool DrawSpriteScanline(int nsprite, uint32_t* dstscan, int nscan, int tx
 	/* blit scanline */
 	uint8_t* srcpixel = sprite->pixels + (scan.srcy*sprite->pitch) + scan.srcx;
 	uint32_t *dstpixel = dstscan + sprite->dstrect.x1;
-	sprite->blitter(srcpixel, sprite->palette, dstpixel, w, scan.dx, 0, sprite->blend);
+	sprite->blitters[type == PIXELS_MIXED](srcpixel, sprite->palette, dstpixel, w, scan.dx, 0, sprite->blend);
 
 	if (sprite->do_collision)
 	{
-		uint16_t* dstpixel = engine->collision + sprite->dstrect.x1;
-		DrawSpriteCollision(nsprite, srcpixel, dstpixel, w, scan.dx);
+		uint16_t* dstpixel = buffers->collision + sprite->dstrect.x1;
+		DrawSpriteCollision(nsprite, srcpixel, dstpixel, w, scan.dx, buffers);
 	}
 	return true;
 }
 
 /* draw sprite scanline with scaling */
-static bool DrawScalingSpriteScanline(int nsprite, uint32_t* dstscan, int nscan, int tx1, int tx2)
+static bool DrawScalingSpriteScanline(int nsprite, uint32_t* dstscan, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	Sprite* sprite = (Sprite*)&engine->sprites[nsprite];
+	Sprite* sprite = (Sprite*)&buffers->context->sprites[nsprite];
+	const PixelsType type = (PixelsType)sprite->info->type;
+	if (type == PIXELS_EMPTY)
+		return false;
 
 	int srcx = sprite->srcrect.x1;
 	int srcy = sprite->srcrect.y1 + (nscan - sprite->dstrect.y1)*sprite->dy;
@@ -686,18 +1426,18 @@ static bool DrawScalingSpriteScanline(int nsprite, uint32_t* dstscan, int nscan,
 	/* blit scanline */
 	uint8_t* srcpixel = sprite->pixels + (fix2int(srcy)*sprite->pitch);
 	uint32_t* dstpixel = dstscan + sprite->dstrect.x1;
-	sprite->blitter(srcpixel, sprite->palette, dstpixel, dstw, dx, srcx, sprite->blend);
+	sprite->blitters[type == PIXELS_MIXED](srcpixel, sprite->palette, dstpixel, dstw, dx, srcx, sprite->blend);
 
 	if (sprite->do_collision)
 	{
-		uint16_t* dstpixel = engine->collision + sprite->dstrect.x1;
-		DrawSpriteCollisionScaling(nsprite, srcpixel, dstpixel, dstw, dx, srcx);
+		uint16_t* dstpixel = buffers->collision + sprite->dstrect.x1;
+		DrawSpriteCollisionScaling(nsprite, srcpixel, dstpixel, dstw, dx, srcx, buffers);
 	}
 	return true;
 }
 
 /* updates per-pixel sprite collision buffer */
-static void DrawSpriteCollision(int nsprite, uint8_t *srcpixel, uint16_t *dstpixel, int width, int dx)
+static void DrawSpriteCollision(int nsprite, uint8_t *srcpixel, uint16_t *dstpixel, int width, int dx, Scanbuffers* buffers)
 {
 	while (width)
 	{
@@ -705,8 +1445,8 @@ static void DrawSpriteCollision(int nsprite, uint8_t *srcpixel, uint16_t *dstpix
 		{
 			if (*dstpixel != 0xFFFF)
 			{
-				engine->sprites[nsprite].collision = true;
-				engine->sprites[*dstpixel].collision = true;
+				set_sprite_collision(nsprite, buffers);
+				set_sprite_collision(*dstpixel, buffers);
 			}
 			*dstpixel = (uint16_t)nsprite;
 		}
@@ -717,7 +1457,7 @@ static void DrawSpriteCollision(int nsprite, uint8_t *srcpixel, uint16_t *dstpix
 }
 
 /* updates per-pixel sprite collision buffer for scaled sprite */
-static void DrawSpriteCollisionScaling(int nsprite, uint8_t *srcpixel, uint16_t *dstpixel, int width, int dx, int srcx)
+static void DrawSpriteCollisionScaling(int nsprite, uint8_t *srcpixel, uint16_t *dstpixel, int width, int dx, int srcx, Scanbuffers* buffers)
 {
 	while (width)
 	{
@@ -726,8 +1466,8 @@ static void DrawSpriteCollisionScaling(int nsprite, uint8_t *srcpixel, uint16_t
 		{
 			if (*dstpixel != 0xFFFF)
 			{
-				engine->sprites[nsprite].collision = true;
-				engine->sprites[*dstpixel].collision = true;
+				set_sprite_collision(nsprite, buffers);
+				set_sprite_collision(*dstpixel, buffers);
 			}
 			*dstpixel = (uint16_t)nsprite;
 		}
@@ -740,9 +1480,9 @@ static void DrawSpriteCollisionScaling(int nsprite, uint8_t *srcpixel, uint16_t
 }
 
 /* draws regular bitmap scanline for bitmap-based layer */
-static bool DrawBitmapScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2)
+static bool DrawBitmapScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	const Layer *layer = (const Layer*)&engine->layers[nlayer];
+	const Layer *layer = buffers->layer;
 
 	/* target lines */
 	int x = tx1;
@@ -772,43 +1512,39 @@ static bool DrawBitmapScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx
 }
 
 /* draws regular bitmap scanline for bitmap-based layer with scaling */
-static bool DrawBitmapScanlineScaling(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2)
+static bool DrawBitmapScanlineScaling(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	const Layer *layer = (const Layer*)&engine->layers[nlayer];
+	const Layer *layer = buffers->layer;
 
 	/* target line */
 	int x = tx1;
 	dstpixel += x;
-	int xpos = (layer->hstart + fix2int(x*layer->dx)) % layer->width;
+	int xpos = get_scaled_pos(layer->hstart, x, layer->dx, layer->width);
+	const int ypos = get_scaled_row(layer, nscan);
 
 	/* fill whole scanline */
 	const TLN_Bitmap bitmap = layer->bitmap;
 	const TLN_Palette palette = layer->palette != NULL ? layer->palette : bitmap->palette;
-	fix_t fix_x = int2fix(x);
+	int64_t fix_x = int2fix(x);
 	while (x < tx2)
 	{
-		int ypos = layer->vstart + fix2int(nscan*layer->dy);
-		if (ypos < 0)
-			ypos = layer->height + ypos;
-		else
-			ypos = ypos % layer->height;
-
-		/* get effective width */
-		int width = layer->width - xpos;
-		fix_t dx = int2fix(width);
-		fix_t fix_tilewidth = width * layer->xfactor;
-		fix_x += fix_tilewidth;
-		int x1 = fix2int(fix_x);
-		int tilescalewidth = x1 - x;
+		/* get effective width, in runs of at most SCALING_SPAN source pixels */
+		int span = layer->width - xpos;
+		if (span > SCALING_SPAN)
+			span = SCALING_SPAN;
+		fix_t dx = int2fix(span);
+		fix_x += (int64_t)span * layer->xfactor;
+		int64_t x1 = fix_x >> FIXED_BITS;
+		int64_t tilescalewidth = x1 - x;
 		if (tilescalewidth)
-			dx /= tilescalewidth;
+			dx = (fix_t)(dx / tilescalewidth);
 		else
 			dx = 0;
 
 		/* right clipping */
 		if (x1 > tx2)
 			x1 = tx2;
-		width = x1 - x;
+		const int width = (int)x1 - x;
 
 		/* draw bitmap scanline */
 		uint8_t* srcpixel = (uint8_t*)get_bitmap_ptr(bitmap, xpos, ypos);
@@ -816,57 +1552,65 @@ static bool DrawBitmapScanlineScaling(int nlayer, uint32_t* dstpixel, int nscan,
 
 		/* next */
 		dstpixel += width;
-		x = x1;
-		xpos = 0;
+		x = (int)x1;
+		xpos += span;
+		if (xpos == layer->width)
+			xpos = 0;
 	}
 	return false;
 }
 
 /* draws regular bitmap scanline for bitmap-based layer with affine transform */
-static bool DrawBitmapScanlineAffine(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2)
+static bool DrawBitmapScanlineAffine(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	const Layer *layer = (const Layer*)&engine->layers[nlayer];
+	const Layer *layer = buffers->layer;
 	bool priority = false;
+	Texcoords texcoords;
+	int xpos[TEXEL_BATCH];
+	int ypos[TEXEL_BATCH];
 
-	int xpos = layer->hstart;
-	int ypos = layer->vstart + nscan;
+	if (tx1 >= tx2)
+		return false;
 
 	Point2D p1, p2;
-	Point2DSet(&p1, (math2d_t)xpos + tx1, (math2d_t)ypos);
-	Point2DSet(&p2, (math2d_t)xpos + tx2, (math2d_t)ypos);
+	Point2DSet(&p1, (math2d_t)layer->hstart + tx1, (math2d_t)layer->vstart + nscan);
+	Point2DSet(&p2, (math2d_t)layer->hstart + tx2, (math2d_t)layer->vstart + nscan);
 	Point2DMultiply(&p1, (Matrix3*)&layer->transform);
 	Point2DMultiply(&p2, (Matrix3*)&layer->transform);
 
-	int x1 = float2fix(p1.x);
-	int y1 = float2fix(p1.y);
-	int x2 = float2fix(p2.x);
-	int y2 = float2fix(p2.y);
+	const int64_t x1 = float2wide(p1.x);
+	const int64_t y1 = float2wide(p1.y);
+	const int64_t x2 = float2wide(p2.x);
+	const int64_t y2 = float2wide(p2.y);
 
 	const int twidth = tx2 - tx1;
-	const int dx = (x2 - x1) / twidth;
-	const int dy = (y2 - y1) / twidth;
+	const int64_t dx = (x2 - x1) / twidth;
+	const int64_t dy = (y2 - y1) / twidth;
 
 	const TLN_Bitmap bitmap = layer->bitmap;
 	const TLN_Palette palette = layer->palette != NULL ? layer->palette : bitmap->palette;
+	init_texcoords(&texcoords, x1, y1, dx, dy, layer->width, layer->height);
+	dstpixel += tx1;
 	while (tx1 < tx2)
 	{
-		xpos = abs((fix2int(x1) + layer->width)) % layer->width;
-		ypos = abs((fix2int(y1) + layer->height)) % layer->height;
-		*dstpixel = palette->data[*get_bitmap_ptr(bitmap, xpos, ypos)];
+		const int count = tx2 - tx1 < TEXEL_BATCH ? tx2 - tx1 : TEXEL_BATCH;
+		int c;
 
-		/* next pixel */
-		tx1 += 1;
-		x1 += dx;
-		y1 += dy;
-		dstpixel += 1;
+		get_texcoords(&texcoords, xpos, ypos);
+		for (c = 0; c < count; c++)
+			dstpixel[c] = palette->data[*get_bitmap_ptr(bitmap, xpos[c], ypos[c])];
+
+		/* next pixels */
+		tx1 += count;
+		dstpixel += count;
 	}
 	return priority;
 }
 
 /* draws regular bitmap scanline for bitmap-based layer with per-pixel mapping */
-static bool DrawBitmapScanlinePixelMapping(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2)
+static bool DrawBitmapScanlinePixelMapping(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	const Layer *layer = (const Layer*)&engine->layers[nlayer];
+	const Layer *layer = buffers->layer;
 	bool priority = false;
 
 	/* target lines */
@@ -877,7 +1621,7 @@ static bool DrawBitmapScanlinePixelMapping(int nlayer, uint32_t* dstpixel, int n
 	const int vstart = layer->vstart + layer->height;
 	const TLN_Bitmap bitmap = layer->bitmap;
 	const TLN_Palette palette = layer->palette != NULL ? layer->palette : bitmap->palette;
-	const TLN_PixelMap* pixel_map = &layer->pixel_map[nscan*engine->framebuffer.width + x];
+	const TLN_PixelMap* pixel_map = &layer->pixel_map[nscan*buffers->context->framebuffer.width + x];
 	while (x < tx2)
 	{
 		int xpos = abs(hstart + pixel_map->dx) % layer->width;
@@ -893,36 +1637,39 @@ static bool DrawBitmapScanlinePixelMapping(int nlayer, uint32_t* dstpixel, int n
 }
 
 /* draws regular object layer scanline */
-static bool DrawObjectScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2)
+static bool DrawObjectScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx1, int tx2, Scanbuffers* buffers)
 {
-	const Layer *layer = (const Layer*)&engine->layers[nlayer];
-	struct _Object* object = layer->objects->list;
-	struct _Object tmpobject = { 0 };
-	
+	const Layer *layer = buffers->layer;
+	const TLN_ObjectList objects = layer->objects;
+	const ObjectRow* row;
+	int c;
+
 	int x1 = layer->hstart + tx1;
 	int x2 = layer->hstart + tx2;
 	int y = layer->vstart + nscan;
-	uint32_t* dstscan = GetFramebufferLine(nscan);
+	uint32_t* dstscan = GetFramebufferLine(buffers->context, nscan);
 	bool priority = false;
 
-	while (object != NULL)
+	/* only objects indexed in the row of this line */
+	if (y / OBJECT_ROW_HEIGHT >= objects->num_rows)
+		return false;
+	row = &objects->rows[y / OBJECT_ROW_HEIGHT];
+
+	for (c = 0; c < row->count; c++)
 	{
-		/* swap width & height for rotated objects */
-		memcpy(&tmpobject, object, sizeof(struct _Object));
-		if (tmpobject.flags & FLAG_ROTATE)
-		{
-			tmpobject.width = object->height;
-			tmpobject.height = object->width;
-		}
+		struct _Object* object = row->items[c];
 
-		if (IsObjectInLine(&tmpobject, x1, x2, y) && tmpobject.visible && tmpobject.bitmap != NULL)
+		if (object->visible && object->bitmap != NULL && object->pixels != PIXELS_EMPTY &&
+			IsObjectInLine(object, x1, x2, y))
 		{
+			/* swap width & height for rotated objects */
+			const int width = (object->flags & FLAG_ROTATE) ? object->height : object->width;
 			Tilescan scan = { 0 };
 			scan.srcx = 0;
-			scan.srcy = y - tmpobject.y;
+			scan.srcy = y - object->y;
 
-			int dstx1 = tmpobject.x - x1;
-			int dstx2 = dstx1 + tmpobject.width;
+			int dstx1 = object->x - x1;
+			int dstx2 = dstx1 + width;
 			if (dstx1 < tx1)
 			{
 				int w = tx1 - dstx1;
@@ -933,28 +1680,27 @@ static bool DrawObjectScanline(int nlayer, uint32_t* dstpixel, int nscan, int tx
 				dstx2 = tx2;
 			int w = dstx2 - dstx1;
 
-			TLN_Bitmap bitmap = tmpobject.bitmap;
+			TLN_Bitmap bitmap = object->bitmap;
 			scan.width = bitmap->width;
 			scan.height = bitmap->height;
 			scan.stride = bitmap->pitch;
 
 			/* process rotate & flip flags */
 			scan.dx = 1;
-			if ((tmpobject.flags & (FLAG_FLIPX + FLAG_FLIPY + FLAG_ROTATE)) != 0)
-				process_flip_rotation(tmpobject.flags, &scan);
+			if ((object->flags & (FLAG_FLIPX + FLAG_FLIPY + FLAG_ROTATE)) != 0)
+				process_flip_rotation(object->flags, &scan);
 
 			/* paint tile scanline */
 			uint8_t* srcpixel = get_bitmap_ptr(bitmap, scan.srcx, scan.srcy);
 			uint32_t *target = dstscan;
-			if (tmpobject.flags & FLAG_PRIORITY)
+			if (object->flags & FLAG_PRIORITY)
 			{
-				target = engine->priority;
+				target = buffers->priority;
 				priority = true;
 			}
 			uint32_t* dstpixel = target + dstx1;
-			layer->blitters[1](srcpixel, bitmap->palette, dstpixel, w, scan.dx, 0, layer->blend);
+			layer->blitters[object->pixels == PIXELS_MIXED](srcpixel, bitmap->palette, dstpixel, w, scan.dx, 0, layer->blend);
 		}
-		object = object->next;
 	}
 
 	return priority;
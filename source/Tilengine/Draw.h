@@ -22,12 +22,39 @@ typedef enum
 }
 draw_t;
 
-typedef bool (*ScanDrawPtr)(int,uint32_t*,int,int,int);
+/* scratch buffers for drawing scanlines, one set per rendering thread */
+typedef struct
+{
+	uint32_t*	priority;	/* buffer receiving tiles with priority */
+	uint16_t*	collision;	/* buffer with sprite coverage IDs for per-pixel collision */
+	uint32_t*	linebuffer;	/* buffer for intermediate scanline output */
+	uint32_t*	mosaic;		/* mosaic line buffers, one line per layer */
+	uint8_t*	hits;		/* sprites found colliding, NULL to flag sprites directly */
+	int			first;		/* first line of the band being drawn */
+	struct Layer* layer;	/* layer being drawn, or its per-line copy with the raster table applied */
+	struct Layer* raster;	/* storage for the per-line copy */
+	struct Engine* context;	/* context drawing with these buffers */
+}
+Scanbuffers;
+
+typedef bool (*ScanDrawPtr)(int,uint32_t*,int,int,int,Scanbuffers*);
 typedef struct Layer Layer;
+struct Engine;
+struct _Object;
 
 ScanDrawPtr GetLayerDraw (Layer* layer);
 ScanDrawPtr GetSpriteDraw (draw_t mode);
 
-extern bool DrawScanline(void);
+bool CreateScanbuffers(Scanbuffers* buffers, struct Engine* context, int width, int numlayers, int numsprites, bool hits);
+void DeleteScanbuffers(Scanbuffers* buffers);
+
+void InvalidateSpriteLines(struct Engine* ctx);
+void MarkDirtyLines(struct Engine* ctx, int y1, int y2);
+void MarkDirtyFrame(struct Engine* ctx);
+void MarkDirtyTilemap(struct Engine* ctx, TLN_Tilemap tilemap, int row1, int row2);
+void MarkDirtyObject(struct Engine* ctx, TLN_ObjectList list, const struct _Object* object);
+
+extern bool DrawScanline(struct Engine* ctx);
+extern void DrawFrameBands(struct Engine* ctx);
 
 #endif
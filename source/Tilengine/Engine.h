@@ -21,14 +21,15 @@
 #include "Bitmap.h"
 #include "Blitters.h"
 #include "List.h"
+#include "Workers.h"
 
 /* motor */
 typedef struct Engine
 {
 	uint32_t	header;			/* object signature to identify as engine context */
-	uint32_t*	priority;		/* buffer receiving tiles with priority */
-	uint16_t*	collision;		/* buffer with sprite coverage IDs for per-pixel collision */
-	uint32_t*	linebuffer;		/* buffer for intermediate scanline output  */
+	Scanbuffers* buffers;		/* scratch buffers for each rendering thread, first one for serial rendering */
+	int			numthreads;		/* rendering threads, 1 = draw on the calling thread only */
+	Workers*	workers;		/* band rendering threads, NULL when numthreads is 1 */
 	int			numsprites;		/* number of sprites */
 	Sprite*		sprites;		/* pointer to sprite buffer */
 	int			numlayers;		/* number of layers */
@@ -43,8 +44,8 @@ typedef struct Engine
 	TLN_Bitmap	bgbitmap;		/* background bitmap */
 	TLN_Palette	bgpalette;		/* background bitmap palette */
 	TLN_Palette palettes[NUM_PALETTES];	/* optional global palettes */
+	uint8_t*	blend_table;	/* results of the TLN_SetCustomBlendFunction() function */
 	ScanBlitPtr	blit_fast;		/* blitter for background bitmap */
-	uint8_t*	blend_table;	/* current blending table */
 	void		(*cb_raster)(int);	/* raster callback */
 	void		(*cb_frame)(int);	/* frame callback */
 	int			frame;			/* current frame number */
@@ -58,6 +59,23 @@ typedef struct Engine
 	int xworld, yworld;			/* world coordinates with TLN_SetWorldPosition() */
 	bool dirty;					/* world position updated since last draw */
 
+	struct
+	{
+		SpriteLine*	lines;		/* sprites covering each scanline, in drawing order */
+		int		limit;			/* max sprites per scanline, 0 = unlimited */
+		int		valid;			/* scanlines from this one are up to date */
+	}
+	sprite_lines;
+
+	struct
+	{
+		bool		enabled;		/* only scanlines marked in lines are drawn */
+		uint8_t*	lines;			/* scanlines to draw on the next frame */
+		Layer*		layers;			/* layer state when last drawn, to detect changes */
+		TLN_RasterLine* rasters;	/* raster tables when last drawn, one line per scanline and layer */
+	}
+	dirty_lines;
+
 	struct
 	{
 		int		width;
@@ -69,11 +87,24 @@ typedef struct Engine
 }
 Engine;
 
-extern Engine* engine;
+/* thread local storage */
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+extern Engine* default_engine;
+extern THREAD_LOCAL Engine* thread_engine;
+
+/* current context: the one bound to the calling thread with TLN_SetThreadContext(), or the
+ * default one. Public functions resolve it once and pass it down, the drawing code gets it
+ * from its scanline buffers */
+#define GetEngine() (thread_engine != NULL ? thread_engine : default_engine)
 
 extern void tln_trace(TLN_LogLevel log_level, const char* format, ...);
 
-#define GetFramebufferLine(line) \
-	(uint32_t*)(engine->framebuffer.data + (line*engine->framebuffer.pitch))
+#define GetFramebufferLine(ctx,line) \
+	(uint32_t*)((ctx)->framebuffer.data + ((line)*(ctx)->framebuffer.pitch))
 
 #endif
@@ -15,7 +15,7 @@
 #include "Layer.h"
 #include "Tileset.h"
 #include "Tilemap.h"
-#include "Tables.h"
+#include "Blend.h"
 #include "ObjectList.h"
 #include "Bitmap.h"
 
@@ -44,14 +44,15 @@ static void SetBlitter (Layer* layer);
  */
 bool TLN_SetLayer(int nlayer, TLN_Tileset tileset, TLN_Tilemap tilemap)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->ok = false;
 	if (!CheckBaseObject(tilemap, OT_TILEMAP))
 		return false;
@@ -155,14 +156,15 @@ bool TLN_SetLayerTilemap(int nlayer, TLN_Tilemap tilemap)
 */
 bool TLN_SetLayerBitmap(int nlayer, TLN_Bitmap bitmap)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->ok = false;
 	if (!CheckBaseObject(bitmap, OT_BITMAP))
 		return false;
@@ -201,15 +203,16 @@ bool TLN_SetLayerBitmap(int nlayer, TLN_Bitmap bitmap)
  */
 bool TLN_SetLayerObjects(int nlayer, TLN_ObjectList objects, TLN_Tileset tileset)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer = NULL;
 	TLN_Object* item = NULL;
 
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->ok = false;
 
 	if (!CheckBaseObject(objects, OT_OBJECTLIST))
@@ -244,16 +247,28 @@ bool TLN_SetLayerObjects(int nlayer, TLN_ObjectList objects, TLN_Tileset tileset
 			{
 				item->width = item->bitmap->width;
 				item->height = item->bitmap->height;
+				item->pixels = GetPixelsType(item->bitmap->data, item->width, item->height, item->bitmap->pitch);
 			}
 		}
 		item = item->next;
 	}
 
+	/* sizes may have changed, rebuild index */
+	if (!IndexObjectList(objects))
+	{
+		TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
+		return false;
+	}
+
 	if (objects->visible)
 	{
 		layer->ok = true;
 		layer->draw = GetLayerDraw(layer);
 		SetBlitter(layer);
+
+		/* objects may have got their bitmaps and sizes just now */
+		for (item = objects->list; item != NULL; item = item->next)
+			MarkDirtyObject(ctx, objects, item);
 	}
 	TLN_SetLastError(TLN_ERR_OK);
 	return true;
@@ -267,14 +282,15 @@ bool TLN_SetLayerObjects(int nlayer, TLN_ObjectList objects, TLN_Tileset tileset
  */
 bool TLN_SetLayerPriority(int nlayer, bool enable)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->priority = enable;
 	return true;
 }
@@ -302,14 +318,16 @@ bool TLN_DisableLayerParent(int nlayer)
  */
 int TLN_GetLayerWidth (int nlayer)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->layers[nlayer].width;
+	return ctx->layers[nlayer].width;
 }
 
 /*!
@@ -323,14 +341,16 @@ int TLN_GetLayerWidth (int nlayer)
  */
 int TLN_GetLayerHeight (int nlayer)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->layers[nlayer].height;
+	return ctx->layers[nlayer].height;
 }
 
 /*!
@@ -344,22 +364,25 @@ int TLN_GetLayerHeight (int nlayer)
  * Member of the TLN_Blend enumeration
  * 
  * \param factor
- * Deprecated as of 1.12, left for backwards compatibility but doesn't have effect.
+ * Strength of the effect, from 1 (barely visible) to 255 (full effect). For the BLEND_MIX modes
+ * it's the opacity of the layer. 0 keeps the classic preset: 25/50/75% mixes and full strength
+ * add, sub, mod and custom blending.
  * 
  * \see
  * Blending
  */
 bool TLN_SetLayerBlendMode (int nlayer, TLN_Blend mode, uint8_t factor)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
-	layer->blend = SelectBlendTable (mode);
+	layer = &ctx->layers[nlayer];
+	layer->blend = SetBlend (&layer->blend_data, mode, factor, ctx->blend_table);
 	SetBlitter (layer);
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
@@ -385,14 +408,15 @@ bool TLN_SetLayerBlendMode (int nlayer, TLN_Blend mode, uint8_t factor)
  */
 bool TLN_SetLayerPalette (int nlayer, TLN_Palette palette)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	if (!CheckBaseObject (palette, OT_PALETTE))
 	{
 		layer->ok = false;
@@ -412,9 +436,11 @@ bool TLN_SetLayerPalette (int nlayer, TLN_Palette palette)
  */
 TLN_Palette TLN_GetLayerPalette (int nlayer)
 {
-	if (nlayer < engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer < ctx->numlayers)
 	{
-		Layer* layer = &engine->layers[nlayer];
+		Layer* layer = &ctx->layers[nlayer];
 		TLN_SetLastError(TLN_ERR_OK);
 
 		if (layer->palette != NULL)
@@ -440,10 +466,12 @@ TLN_Palette TLN_GetLayerPalette (int nlayer)
  */
 TLN_LayerType TLN_GetLayerType(int nlayer)
 {
-	if (nlayer < engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer < ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_OK);
-		return engine->layers[nlayer].type;
+		return ctx->layers[nlayer].type;
 	}
 
 	TLN_SetLastError(TLN_ERR_IDX_LAYER);
@@ -455,10 +483,12 @@ TLN_LayerType TLN_GetLayerType(int nlayer)
  */
 TLN_Tileset TLN_GetLayerTileset(int nlayer)
 {
-	if (nlayer < engine->numlayers && engine->layers[nlayer].tilemap != NULL)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer < ctx->numlayers && ctx->layers[nlayer].tilemap != NULL)
 	{
 		TLN_SetLastError(TLN_ERR_OK);
-		return engine->layers[nlayer].tilemap->tilesets[0];
+		return ctx->layers[nlayer].tilemap->tilesets[0];
 	}
 
 	TLN_SetLastError(TLN_ERR_IDX_LAYER);
@@ -473,10 +503,12 @@ TLN_Tileset TLN_GetLayerTileset(int nlayer)
  */
 TLN_Tilemap TLN_GetLayerTilemap(int nlayer)
 {
-	if (nlayer < engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer < ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_OK);
-		return engine->layers[nlayer].tilemap;
+		return ctx->layers[nlayer].tilemap;
 	}
 
 	TLN_SetLastError(TLN_ERR_IDX_LAYER);
@@ -491,10 +523,12 @@ TLN_Tilemap TLN_GetLayerTilemap(int nlayer)
  */
 TLN_Bitmap TLN_GetLayerBitmap(int nlayer)
 {
-	if (nlayer < engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer < ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_OK);
-		return engine->layers[nlayer].bitmap;
+		return ctx->layers[nlayer].bitmap;
 	}
 
 	TLN_SetLastError(TLN_ERR_IDX_LAYER);
@@ -509,10 +543,12 @@ TLN_Bitmap TLN_GetLayerBitmap(int nlayer)
  */
 TLN_ObjectList TLN_GetLayerObjects(int nlayer)
 {
-	if (nlayer < engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer < ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_OK);
-		return engine->layers[nlayer].objects;
+		return ctx->layers[nlayer].objects;
 	}
 
 	TLN_SetLastError(TLN_ERR_IDX_LAYER);
@@ -546,14 +582,15 @@ TLN_ObjectList TLN_GetLayerObjects(int nlayer)
  */
 bool TLN_SetLayerPosition (int nlayer, int hstart, int vstart)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	if (layer->width == 0 || layer->height == 0)
 	{
 		TLN_SetLastError(TLN_ERR_REF_TILEMAP);
@@ -582,14 +619,16 @@ bool TLN_SetLayerPosition (int nlayer, int hstart, int vstart)
 */
 int TLN_GetLayerX(int nlayer)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return 0;
 	}
 
 	TLN_SetLastError(TLN_ERR_OK);
-	return engine->layers[nlayer].hstart;
+	return ctx->layers[nlayer].hstart;
 }
 
 /*
@@ -600,14 +639,16 @@ int TLN_GetLayerX(int nlayer)
 */
 int TLN_GetLayerY(int nlayer)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return 0;
 	}
 
 	TLN_SetLastError(TLN_ERR_OK);
-	return engine->layers[nlayer].vstart;
+	return ctx->layers[nlayer].vstart;
 }
 
 /*!
@@ -637,6 +678,7 @@ int TLN_GetLayerY(int nlayer)
  */
 bool TLN_GetLayerTile (int nlayer, int x, int y, TLN_TileInfo* info)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
 	TLN_Tileset tileset;
 	TLN_Tilemap tilemap;
@@ -647,7 +689,7 @@ bool TLN_GetLayerTile (int nlayer, int x, int y, TLN_TileInfo* info)
 	int column = 0;
 	int column_offset = 0;
 
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
@@ -658,7 +700,7 @@ bool TLN_GetLayerTile (int nlayer, int x, int y, TLN_TileInfo* info)
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	if (!CheckBaseObject(layer->tilemap, OT_TILEMAP) || !CheckBaseObject (layer->tilemap->tilesets[0], OT_TILESET))
 		return false;
 
@@ -729,13 +771,52 @@ bool TLN_GetLayerTile (int nlayer, int x, int y, TLN_TileInfo* info)
  */
 bool TLN_SetLayerColumnOffset (int nlayer, int* offset)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	engine->layers[nlayer].column = offset;
+	ctx->layers[nlayer].column = offset;
+	TLN_SetLastError (TLN_ERR_OK);
+	return true;
+}
+
+/*!
+ * \brief
+ * Enables per-scanline parameters for this layer
+ *
+ * \param nlayer
+ * Layer index [0, num_layers - 1]
+ *
+ * \param table
+ * Array of TLN_RasterLine with one entry for each scanline of the framebuffer. Set NULL to disable it
+ *
+ * Each scanline of the layer is drawn with the scroll offset, clip region, blend factor and palette
+ * of its entry in the table. Effects like line scroll, parallax strips, waves or color gradients that
+ * would otherwise require a raster callback are applied directly by the renderer, so frames keep
+ * being drawn in parallel bands. The table is not copied: its contents can be updated between frames.
+ *
+ * \remarks
+ * Zeroed entries leave the layer unchanged. The blend factor only applies when blending is enabled
+ * with TLN_SetLayerBlendMode(). Layers with mosaic take the entry of the first line of each block.
+ *
+ * \see
+ * TLN_SetLayerPosition(), TLN_SetLayerClip(), TLN_SetLayerBlendMode(), TLN_SetLayerPalette()
+ */
+bool TLN_SetLayerRasterTable (int nlayer, TLN_RasterLine* table)
+{
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
+	{
+		TLN_SetLastError (TLN_ERR_IDX_LAYER);
+		return false;
+	}
+
+	ctx->layers[nlayer].raster = table;
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -746,15 +827,16 @@ bool TLN_SetLayerColumnOffset (int nlayer, int* offset)
  */
 bool TLN_EnableLayer(int nlayer)
 {
+	Engine* const ctx = GetEngine();
 	Layer* layer = NULL;
 
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 
 	/* check proper config */
 	if (layer->type == LAYER_TILE && layer->tilemap != NULL || layer->type == LAYER_BITMAP && layer->bitmap != NULL || layer->type == LAYER_OBJECT && layer->objects != NULL)
@@ -784,13 +866,15 @@ bool TLN_EnableLayer(int nlayer)
  */
 bool TLN_DisableLayer (int nlayer)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	engine->layers[nlayer].ok = false;
+	ctx->layers[nlayer].ok = false;
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -821,14 +905,15 @@ bool TLN_DisableLayer (int nlayer)
  */
 bool TLN_SetLayerAffineTransform (int nlayer, TLN_Affine *affine)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 	
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	if (affine)
 	{
 		Matrix3 transform;
@@ -924,14 +1009,15 @@ bool TLN_SetLayerTransform (int layer, float angle, float dx, float dy, float sx
  */
 bool TLN_SetLayerScaling (int nlayer, float sx, float sy)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 	
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->xfactor = float2fix(sx);
 	layer->dx = float2fix((1.0f/sx));
 	layer->dy = float2fix((1.0f/sy));
@@ -956,14 +1042,15 @@ bool TLN_SetLayerScaling (int nlayer, float sx, float sy)
  */
 bool TLN_SetLayerPixelMapping (int nlayer, TLN_PixelMap* table)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->pixel_map = table;
 	if (table != NULL)
 		layer->mode = MODE_PIXEL_MAP;
@@ -987,14 +1074,15 @@ bool TLN_SetLayerPixelMapping (int nlayer, TLN_PixelMap* table)
  */
 bool TLN_ResetLayerMode (int nlayer)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 	
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->mode = MODE_NORMAL;
 	layer->draw = GetLayerDraw (layer);
 	SetBlitter (layer);
@@ -1025,17 +1113,19 @@ bool TLN_SetLayerClip (int nlayer, int x1, int y1, int x2, int y2)
  */
 bool TLN_DisableLayerClip (int nlayer)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 	
-	LayerWindow* window = &engine->layers[nlayer].window;
+	LayerWindow* window = &ctx->layers[nlayer].window;
 	window->x1 = 0;
-	window->x2 = engine->framebuffer.width;
+	window->x2 = ctx->framebuffer.width;
 	window->y1 = 0;
-	window->y2 = engine->framebuffer.height;
+	window->y2 = ctx->framebuffer.height;
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -1054,17 +1144,19 @@ bool TLN_DisableLayerClip (int nlayer)
  */
 bool TLN_SetLayerWindow(int nlayer, int x1, int y1, int x2, int y2, bool invert)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	LayerWindow* window = &engine->layers[nlayer].window;
-	window->x1 = x1 >= 0 && x1 <= engine->framebuffer.width ? x1 : 0;
-	window->x2 = x2 >= 0 && x2 <= engine->framebuffer.width ? x2 : engine->framebuffer.width;
-	window->y1 = y1 >= 0 && y1 <= engine->framebuffer.height ? y1 : 0;
-	window->y2 = y2 >= 0 && y2 <= engine->framebuffer.height ? y2 : engine->framebuffer.height;
+	LayerWindow* window = &ctx->layers[nlayer].window;
+	window->x1 = x1 >= 0 && x1 <= ctx->framebuffer.width ? x1 : 0;
+	window->x2 = x2 >= 0 && x2 <= ctx->framebuffer.width ? x2 : ctx->framebuffer.width;
+	window->y1 = y1 >= 0 && y1 <= ctx->framebuffer.height ? y1 : 0;
+	window->y2 = y2 >= 0 && y2 <= ctx->framebuffer.height ? y2 : ctx->framebuffer.height;
 	window->invert = invert;
 	TLN_SetLastError(TLN_ERR_OK);
 	return true;
@@ -1083,15 +1175,17 @@ bool TLN_SetLayerWindow(int nlayer, int x1, int y1, int x2, int y2, bool invert)
 */
 bool TLN_SetLayerWindowColor(int nlayer, uint8_t r, uint8_t g, uint8_t b, TLN_Blend blend)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	LayerWindow* window = &engine->layers[nlayer].window;
+	LayerWindow* window = &ctx->layers[nlayer].window;
 	window->color = PackRGB32(r, g, b);
-	window->blend = SelectBlendTable(blend);
+	window->blend = SetBlend(&window->blend_data, blend, 0, ctx->blend_table);
 	TLN_SetLastError(TLN_ERR_OK);
 	return true;
 }
@@ -1103,17 +1197,19 @@ bool TLN_SetLayerWindowColor(int nlayer, uint8_t r, uint8_t g, uint8_t b, TLN_Bl
 */
 bool TLN_DisableLayerWindow(int nlayer)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	LayerWindow* window = &engine->layers[nlayer].window;
+	LayerWindow* window = &ctx->layers[nlayer].window;
 	window->x1 = 0;
-	window->x2 = engine->framebuffer.width;
+	window->x2 = ctx->framebuffer.width;
 	window->y1 = 0;
-	window->y2 = engine->framebuffer.height;
+	window->y2 = ctx->framebuffer.height;
 	window->invert = false;
 	TLN_SetLastError(TLN_ERR_OK);
 	return true;
@@ -1126,13 +1222,15 @@ bool TLN_DisableLayerWindow(int nlayer)
 */
 bool TLN_DisableLayerWindowColor(int nlayer)
 {
-	if (nlayer >= engine->numlayers)
+	Engine* const ctx = GetEngine();
+
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	LayerWindow* window = &engine->layers[nlayer].window;
+	LayerWindow* window = &ctx->layers[nlayer].window;
 	window->color = 0;
 	window->blend = NULL;
 	return true;
@@ -1156,14 +1254,15 @@ bool TLN_DisableLayerWindowColor(int nlayer)
  */
 bool TLN_SetLayerMosaic (int nlayer, int width, int height)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->mosaic.w = width;
 	layer->mosaic.h = height;
 	SetBlitter (layer);
@@ -1183,24 +1282,20 @@ bool TLN_SetLayerMosaic (int nlayer, int width, int height)
  */
 bool TLN_DisableLayerMosaic (int nlayer)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->mosaic.h = 0;
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
 
-Layer* GetLayer(int index)
-{
-	return &engine->layers[index];
-}
-
 static void SetBlitter (Layer* layer)
 {
 	bool scaling = layer->mode == MODE_SCALING;
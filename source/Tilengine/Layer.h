@@ -20,7 +20,8 @@ typedef struct
 {
 	int x1, y1, x2, y2;	/* clip region */
 	bool invert;		/* false=clip outside, true=clip inside */
-	uint8_t* blend;		/* optional solid color blend function */
+	Blend* blend;		/* optional solid color blend, NULL if disabled */
+	Blend blend_data;	/* parameters pointed by blend */
 	uint32_t color;		/* color for optional blend function */
 }
 LayerWindow;
@@ -41,10 +42,12 @@ typedef struct Layer
 	ScanBlitPtr		blitters[2];
 	Matrix3			transform;
 	int*			column;		/* column offset (optional) */
+	TLN_RasterLine*	raster;		/* per-scanline parameters (optional) */
 	fix_t			xfactor;
 	fix_t			dx;
 	fix_t			dy;
-	uint8_t*		blend;		/* pointer to blend table */
+	Blend*			blend;		/* blending parameters, NULL if disabled */
+	Blend			blend_data;	/* parameters pointed by blend */
 	TLN_PixelMap*	pixel_map;	/* pointer to pixel mapping table */
 	draw_t			mode;
 	bool			priority;	/* whole layer in front of regular sprites */
@@ -65,16 +68,13 @@ typedef struct Layer
 	/* clip */
 	LayerWindow window;
 
-	/* mosaic */
+	/* mosaic, line buffers are in Scanbuffers */
 	struct
 	{
 		int w, h;			/* virtual pixel size */
-		uint32_t* buffer;	/* line buffer */
 	}
 	mosaic;
 }
 Layer;
 
-Layer* GetLayer(int index);
-
 #endif
\ No newline at end of file
@@ -12,6 +12,8 @@
 #include <stdlib.h>
 #include "Tilengine.h"
 #include "ObjectList.h"
+#include "Draw.h"
+#include "Engine.h"
 #include "Sprite.h"
 #include "simplexml.h"
 #include "LoadFile.h"
@@ -172,8 +174,65 @@ TLN_ObjectList TLN_CreateObjectList(void)
 	return list;
 }
 
-/* adds entry to linked list */
-static void add_to_list(TLN_ObjectList list, struct _Object* object)
+/* adds object to the index rows it overlaps, growing the index as needed */
+static bool add_to_rows(TLN_ObjectList list, struct _Object* object)
+{
+	const int height = (object->flags & FLAG_ROTATE) ? object->width : object->height;
+	int row1, row2, c;
+
+	if (height <= 0 || object->y + height <= 0)
+		return true;
+
+	row1 = object->y > 0 ? object->y / OBJECT_ROW_HEIGHT : 0;
+	row2 = (object->y + height - 1) / OBJECT_ROW_HEIGHT;
+	if (row2 >= list->num_rows)
+	{
+		ObjectRow* rows = (ObjectRow*)realloc(list->rows, (row2 + 1) * sizeof(ObjectRow));
+		if (rows == NULL)
+			return false;
+		memset(&rows[list->num_rows], 0, (row2 + 1 - list->num_rows) * sizeof(ObjectRow));
+		list->rows = rows;
+		list->num_rows = row2 + 1;
+	}
+
+	for (c = row1; c <= row2; c++)
+	{
+		ObjectRow* row = &list->rows[c];
+		if (row->count == row->capacity)
+		{
+			const int capacity = row->capacity ? row->capacity * 2 : 8;
+			struct _Object** items = (struct _Object**)realloc(row->items, capacity * sizeof(struct _Object*));
+			if (items == NULL)
+				return false;
+			row->items = items;
+			row->capacity = capacity;
+		}
+		row->items[row->count++] = object;
+	}
+	return true;
+}
+
+/* rebuilds the spatial index after object sizes change */
+bool IndexObjectList(TLN_ObjectList list)
+{
+	struct _Object* object;
+	int c;
+
+	for (c = 0; c < list->num_rows; c++)
+		list->rows[c].count = 0;
+
+	object = list->list;
+	while (object != NULL)
+	{
+		if (!add_to_rows(list, object))
+			return false;
+		object = object->next;
+	}
+	return true;
+}
+
+/* adds entry to linked list and spatial index */
+static bool add_to_list(TLN_ObjectList list, struct _Object* object)
 {
 	if (list->list == NULL)
 		list->list = object;
@@ -182,6 +241,10 @@ static void add_to_list(TLN_ObjectList list, struct _Object* object)
 	list->last = object;
 	list->num_items += 1;
 	object->next = NULL;
+	if (!add_to_rows(list, object))
+		return false;
+	MarkDirtyObject(GetEngine(), list, object);
+	return true;
 }
 
 /*!
@@ -202,7 +265,11 @@ static bool CloneObjectToList(TLN_ObjectList list, TLN_Object* data)
 		return false;
 
 	memcpy(object, data, sizeof(struct _Object));
-	add_to_list(list, object);
+	if (!add_to_list(list, object))
+	{
+		TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
+		return false;
+	}
 	return true;
 }
 /*!
@@ -230,7 +297,11 @@ bool TLN_AddTileObjectToList(TLN_ObjectList list, uint16_t id, uint16_t gid, uin
 	object->gid = gid;
 	object->x = x;
 	object->y = y;
-	add_to_list(list, object);
+	if (!add_to_list(list, object))
+	{
+		TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
+		return false;
+	}
 	return true;
 }
 
@@ -336,6 +407,14 @@ TLN_ObjectList TLN_CloneObjectList(TLN_ObjectList src)
 		return NULL;
 
 	list = (TLN_ObjectList)CloneBaseObject(src);
+	if (list == NULL)
+		return NULL;
+
+	/* the clone gets its own nodes and index */
+	list->list = list->last = NULL;
+	list->num_items = 0;
+	list->rows = NULL;
+	list->num_rows = 0;
 	object = src->list;
 	while (object != NULL)
 	{
@@ -416,7 +495,12 @@ bool TLN_GetListObject(TLN_ObjectList list, TLN_ObjectInfo* info)
 bool IsObjectInLine(struct _Object* object, int x1, int x2, int y)
 {
 	rect_t rect;
-	MakeRect(&rect, object->x, object->y, object->width, object->height);
+
+	/* rotated objects swap width & height */
+	if (object->flags & FLAG_ROTATE)
+		MakeRect(&rect, object->x, object->y, object->height, object->width);
+	else
+		MakeRect(&rect, object->x, object->y, object->width, object->height);
 	if (y >= rect.y1 && y < rect.y2 && !(x1 > rect.x2 || x2 < rect.x1))
 		return true;
 	else
@@ -432,6 +516,7 @@ bool IsObjectInLine(struct _Object* object, int x1, int x2, int y)
 bool TLN_DeleteObjectList(TLN_ObjectList list)
 {
 	struct _Object* object;
+	int c;
 	if (!CheckBaseObject(list, OT_OBJECTLIST))
 		return false;
 
@@ -445,6 +530,11 @@ bool TLN_DeleteObjectList(TLN_ObjectList list)
 		object = next;
 	}
 
+	/* delete index */
+	for (c = 0; c < list->num_rows; c++)
+		free(list->rows[c].items);
+	free(list->rows);
+
 	DeleteBaseObject(list);
 	return true;
 }
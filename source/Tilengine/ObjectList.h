@@ -28,12 +28,25 @@ typedef struct _Object
 	int width;
 	int height;
 	TLN_Bitmap bitmap;	/* computed after calling TLN_SetLayerObjects() */
+	uint8_t pixels;		/* PixelsType of bitmap, computed along with it */
 	bool has_gid;
 	bool visible;
 	struct _Object* next;
 }
 TLN_Object;
 
+/* height in pixels of the rows objects are indexed by */
+#define OBJECT_ROW_HEIGHT	32
+
+/* objects overlapping a row, in list order */
+typedef struct
+{
+	struct _Object** items;
+	int count;
+	int capacity;
+}
+ObjectRow;
+
 struct ObjectList
 {
 	DEFINE_OBJECT;
@@ -47,8 +60,11 @@ struct ObjectList
 	struct _Object* last;
 	struct _Object* iterator;
 	TLN_ObjectInfo* info;
+	ObjectRow* rows;	/* spatial index, one row every OBJECT_ROW_HEIGHT pixels */
+	int num_rows;
 };
 
 extern bool IsObjectInLine(struct _Object* object, int x1, int x2, int y);
+extern bool IndexObjectList(TLN_ObjectList list);
 
 #endif
\ No newline at end of file
@@ -13,7 +13,7 @@
 #include "Engine.h"
 #include "Tilengine.h"
 #include "Palette.h"
-#include "Tables.h"
+#include "Blend.h"
 
 /*!
  * \brief
@@ -117,6 +117,7 @@ bool TLN_SetPaletteColor (TLN_Palette palette, int index, uint8_t r, uint8_t g,
 	if (CheckBaseObject (palette, OT_PALETTE) && index < palette->entries)
 	{
 		Color* color = (Color*)GetPaletteData (palette, index);
+		const uint32_t value = color->value;
 		if (index == 0)
 			color->value = 0;
 		else
@@ -126,6 +127,8 @@ bool TLN_SetPaletteColor (TLN_Palette palette, int index, uint8_t r, uint8_t g,
 			color->b = b;
 			color->a = 255;
 		}
+		if (color->value != value)
+			MarkDirtyFrame(GetEngine());
 		TLN_SetLastError (TLN_ERR_OK);
 		return true;
 	}
@@ -182,7 +185,6 @@ bool TLN_MixPalettes (TLN_Palette src1, TLN_Palette src2, TLN_Palette dst, uint8
 {
 	int c;
 	const uint8_t invfactor = 255 - factor;
-	const uint8_t* blend_table = engine->blend_table;
 	uint8_t* src1ptr;
 	uint8_t* src2ptr;
 	uint8_t* dstptr;
@@ -194,7 +196,6 @@ bool TLN_MixPalettes (TLN_Palette src1, TLN_Palette src2, TLN_Palette dst, uint8
 	src1ptr = TLN_GetPaletteData (src1, 0);
 	src2ptr = TLN_GetPaletteData (src2, 0);
 	dstptr  = TLN_GetPaletteData (dst, 0);
-	blend_table = SelectBlendTable (BLEND_MOD);
 
 	if (src1->entries > src2->entries)
 		count = src1->entries;
@@ -203,24 +204,27 @@ bool TLN_MixPalettes (TLN_Palette src1, TLN_Palette src2, TLN_Palette dst, uint8
 
 	for (c=0; c<count; c++)
 	{
-		dstptr[0] = blendfunc(blend_table,src2ptr[0],factor) + blendfunc(blend_table,src1ptr[0],invfactor);
-		dstptr[1] = blendfunc(blend_table,src2ptr[1],factor) + blendfunc(blend_table,src1ptr[1],invfactor);
-		dstptr[2] = blendfunc(blend_table,src2ptr[2],factor) + blendfunc(blend_table,src1ptr[2],invfactor);
+		dstptr[0] = (src2ptr[0]*factor)/255 + (src1ptr[0]*invfactor)/255;
+		dstptr[1] = (src2ptr[1]*factor)/255 + (src1ptr[1]*invfactor)/255;
+		dstptr[2] = (src2ptr[2]*factor)/255 + (src1ptr[2]*invfactor)/255;
 		src1ptr += sizeof(uint32_t);
 		src2ptr += sizeof(uint32_t);
 		dstptr  += sizeof(uint32_t);
 	}
 
+	MarkDirtyFrame(GetEngine());
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
 
 /* edita rango de colores segn tabla de mezcla */
-static bool EditPaletteColor (TLN_Palette palette, uint8_t* blend_table, uint8_t r, uint8_t g, uint8_t b, uint8_t start, uint8_t num)
+static bool EditPaletteColor (TLN_Palette palette, TLN_Blend mode, uint8_t r, uint8_t g, uint8_t b, uint8_t start, uint8_t num)
 {
+	Engine* const ctx = GetEngine();
 	int end;
 	int c;
 	uint8_t* color_ptr;
+	Blend blend;
 
 	if (!CheckBaseObject (palette, OT_PALETTE))
 		return false;
@@ -235,15 +239,17 @@ static bool EditPaletteColor (TLN_Palette palette, uint8_t* blend_table, uint8_t
 	if (end >= palette->entries)
 		end = palette->entries - 1;
 
+	SetBlend (&blend, mode, 0, ctx != NULL ? ctx->blend_table : NULL);
 	color_ptr = TLN_GetPaletteData (palette, start);
 	for (c=start; c<=end; c++)
 	{
-		color_ptr[0] = blendfunc(blend_table, color_ptr[0], r);
-		color_ptr[1] = blendfunc(blend_table, color_ptr[1], g);
-		color_ptr[2] = blendfunc(blend_table, color_ptr[2], b);
+		color_ptr[0] = BlendChannel(&blend, color_ptr[0], r);
+		color_ptr[1] = BlendChannel(&blend, color_ptr[1], g);
+		color_ptr[2] = BlendChannel(&blend, color_ptr[2], b);
 		color_ptr += sizeof(uint32_t);
 	}
 
+	MarkDirtyFrame(ctx);
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -272,7 +278,7 @@ static bool EditPaletteColor (TLN_Palette palette, uint8_t* blend_table, uint8_t
  */
 bool TLN_AddPaletteColor (TLN_Palette palette, uint8_t r, uint8_t g, uint8_t b, uint8_t start, uint8_t num)
 {
-	return EditPaletteColor (palette, SelectBlendTable(BLEND_ADD), r,g,b, start,num);
+	return EditPaletteColor (palette, BLEND_ADD, r,g,b, start,num);
 }
 
 /*!
@@ -299,7 +305,7 @@ bool TLN_AddPaletteColor (TLN_Palette palette, uint8_t r, uint8_t g, uint8_t b,
  */
 bool TLN_SubPaletteColor (TLN_Palette palette, uint8_t r, uint8_t g, uint8_t b, uint8_t start, uint8_t num)
 {
-	return EditPaletteColor (palette, SelectBlendTable(BLEND_SUB), r,g,b, start,num);
+	return EditPaletteColor (palette, BLEND_SUB, r,g,b, start,num);
 }
 
 /*!
@@ -326,7 +332,7 @@ bool TLN_SubPaletteColor (TLN_Palette palette, uint8_t r, uint8_t g, uint8_t b,
  */
 bool TLN_ModPaletteColor (TLN_Palette palette, uint8_t r, uint8_t g, uint8_t b, uint8_t start, uint8_t num)
 {
-	return EditPaletteColor (palette, SelectBlendTable(BLEND_MOD), r,g,b, start,num);
+	return EditPaletteColor (palette, BLEND_MOD, r,g,b, start,num);
 }
 
 /*!
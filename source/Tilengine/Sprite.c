@@ -16,7 +16,7 @@
 #include "Blitters.h"
 #include "Palette.h"
 #include "Spriteset.h"
-#include "Tables.h"
+#include "Blend.h"
 #include "Debug.h"
 
 #ifdef _MSC_VER
@@ -25,6 +25,13 @@
 
 static void SelectSpriteBlitter (Sprite* sprite);
 
+/* marks the scanlines covered by an enabled sprite to be drawn */
+static inline void redraw_sprite(Engine* ctx, Sprite* sprite)
+{
+	if (sprite->ok)
+		MarkDirtyLines(ctx, sprite->dstrect.y1, sprite->dstrect.y2);
+}
+
 /*!
  * \deprecated use \ref TLN_SetSpriteSet and \ref TLN_EnableSpriteFlag
  * \brief
@@ -69,9 +76,10 @@ bool TLN_ConfigSprite (int nsprite, TLN_Spriteset spriteset, uint32_t flags)
  */
 bool TLN_SetSpriteSet (int nsprite, TLN_Spriteset spriteset)
 {
+	Engine* const ctx = GetEngine();
 	Sprite *sprite;
 	bool enabled;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
@@ -79,7 +87,7 @@ bool TLN_SetSpriteSet (int nsprite, TLN_Spriteset spriteset)
 	if (!CheckBaseObject (spriteset, OT_SPRITESET))
 		return false;
 	
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
 	sprite->spriteset = spriteset;
 	sprite->pitch = sprite->spriteset->bitmap->pitch;
 	enabled = sprite->ok;
@@ -95,7 +103,11 @@ bool TLN_SetSpriteSet (int nsprite, TLN_Spriteset spriteset)
 
 	/* sprite enabled: add to the end */
 	if (enabled == false && sprite->ok == true)
-		ListAppendNode(&engine->list_sprites, nsprite);
+	{
+		ListAppendNode(&ctx->list_sprites, nsprite);
+		InvalidateSpriteLines(ctx);
+		redraw_sprite(ctx, sprite);
+	}
 	
 	return sprite->ok;
 }
@@ -113,13 +125,17 @@ bool TLN_SetSpriteSet (int nsprite, TLN_Spriteset spriteset)
  */
 bool TLN_SetSpriteFlags (int nsprite, uint32_t flags)
 {
-	if (nsprite >= engine->numsprites)
+	Engine* const ctx = GetEngine();
+
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 	
-	engine->sprites[nsprite].flags = flags;
+	if (ctx->sprites[nsprite].flags != flags)
+		redraw_sprite(ctx, &ctx->sprites[nsprite]);
+	ctx->sprites[nsprite].flags = flags;
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -132,16 +148,19 @@ bool TLN_SetSpriteFlags (int nsprite, uint32_t flags)
 */
 bool TLN_EnableSpriteFlag(int nsprite, uint32_t flag, bool enable)
 {
-	if (nsprite >= engine->numsprites)
+	Engine* const ctx = GetEngine();
+
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
+	redraw_sprite(ctx, &ctx->sprites[nsprite]);
 	if (enable)
-		engine->sprites[nsprite].flags |= flag;
+		ctx->sprites[nsprite].flags |= flag;
 	else
-		engine->sprites[nsprite].flags &= ~flag;
+		ctx->sprites[nsprite].flags &= ~flag;
 
 	TLN_SetLastError(TLN_ERR_OK);
 	return true;
@@ -170,17 +189,18 @@ bool TLN_EnableSpriteFlag(int nsprite, uint32_t flag, bool enable)
  */
 bool TLN_SetSpritePosition (int nsprite, int x, int y)
 {
+	Engine* const ctx = GetEngine();
 	Sprite *sprite;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 	
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
 	sprite->x = x;
 	sprite->y = y;
-	UpdateSprite (sprite);
+	UpdateSprite (ctx, sprite);
 
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
@@ -201,21 +221,24 @@ bool TLN_SetSpritePosition (int nsprite, int x, int y)
  */
 bool TLN_SetSpritePicture (int nsprite, int entry)
 {
+	Engine* const ctx = GetEngine();
 	Sprite *sprite;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 	
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
 	if (!CheckBaseObject (sprite->spriteset, OT_SPRITESET))
 		return false;
 
+	if (sprite->info != &sprite->spriteset->data[entry])
+		redraw_sprite(ctx, sprite);
 	sprite->index = entry;
 	sprite->info = &sprite->spriteset->data[entry];
 	sprite->pixels = sprite->spriteset->bitmap->data + sprite->info->offset;
-	UpdateSprite (sprite);
+	UpdateSprite (ctx, sprite);
 	debugmsg("SetSpritePicture %d -> %d\n", nsprite, entry);
 
 	TLN_SetLastError (TLN_ERR_OK);
@@ -234,8 +257,9 @@ bool TLN_SetSpritePicture (int nsprite, int entry)
  */
 bool TLN_SetSpritePalette (int nsprite, TLN_Palette palette)
 {
+	Engine* const ctx = GetEngine();
 	Sprite *sprite;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
@@ -243,7 +267,9 @@ bool TLN_SetSpritePalette (int nsprite, TLN_Palette palette)
 	if (!CheckBaseObject (palette, OT_PALETTE))
 		return false;
 
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
+	if (sprite->palette != palette)
+		redraw_sprite(ctx, sprite);
 	sprite->palette = palette;
 	sprite->ok = sprite->spriteset && sprite->palette;
 
@@ -266,14 +292,16 @@ bool TLN_SetSpritePalette (int nsprite, TLN_Palette palette)
  */
 TLN_Palette TLN_GetSpritePalette (int nsprite)
 {
-	if (nsprite >= engine->numsprites)
+	Engine* const ctx = GetEngine();
+
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return NULL;
 	}
 
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->sprites[nsprite].palette;
+	return ctx->sprites[nsprite].palette;
 }
 
 /* 
@@ -284,14 +312,16 @@ TLN_Palette TLN_GetSpritePalette (int nsprite)
 */
 int TLN_GetSpriteX(int nsprite)
 {
-	if (nsprite >= engine->numsprites)
+	Engine* const ctx = GetEngine();
+
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return 0;
 	}
 
 	TLN_SetLastError(TLN_ERR_OK);
-	return engine->sprites[nsprite].x;
+	return ctx->sprites[nsprite].x;
 }
 
 /*
@@ -302,14 +332,16 @@ int TLN_GetSpriteX(int nsprite)
 */
 int TLN_GetSpriteY(int nsprite)
 {
-	if (nsprite >= engine->numsprites)
+	Engine* const ctx = GetEngine();
+
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return 0;
 	}
 
 	TLN_SetLastError(TLN_ERR_OK);
-	return engine->sprites[nsprite].y;
+	return ctx->sprites[nsprite].y;
 }
 
 /*!
@@ -323,22 +355,26 @@ int TLN_GetSpriteY(int nsprite)
  * Member of the TLN_Blend enumeration
  * 
  * \param factor
- * Deprecated as of 1.12, left for backwards compatibility but doesn't have effect.
+ * Strength of the effect, from 1 (barely visible) to 255 (full effect). For the BLEND_MIX modes
+ * it's the opacity of the sprite. 0 keeps the classic preset: 25/50/75% mixes and full strength
+ * add, sub, mod and custom blending.
  * 
  * \see
  * Blending
  */
 bool TLN_SetSpriteBlendMode (int nsprite, TLN_Blend mode, uint8_t factor)
 {
+	Engine* const ctx = GetEngine();
 	Sprite *sprite;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[nsprite];
-	sprite->blend = SelectBlendTable (mode);
+	sprite = &ctx->sprites[nsprite];
+	redraw_sprite(ctx, sprite);
+	sprite->blend = SetBlend (&sprite->blend_data, mode, factor, ctx->blend_table);
 	SelectSpriteBlitter (sprite);
 
 	TLN_SetLastError (TLN_ERR_OK);
@@ -370,19 +406,21 @@ bool TLN_SetSpriteBlendMode (int nsprite, TLN_Blend mode, uint8_t factor)
  */
 bool TLN_SetSpriteScaling (int nsprite, float sx, float sy)
 {
+	Engine* const ctx = GetEngine();
 	Sprite *sprite;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
+	redraw_sprite(ctx, sprite);
 	sprite->sx = sx;
 	sprite->sy = sy;
 	sprite->mode = MODE_SCALING;
 	sprite->draw = GetSpriteDraw (sprite->mode);
-	UpdateSprite (sprite);
+	UpdateSprite (ctx, sprite);
 	SelectSpriteBlitter (sprite);
 	return true;
 }
@@ -399,18 +437,20 @@ bool TLN_SetSpriteScaling (int nsprite, float sx, float sy)
  */
 bool TLN_ResetSpriteScaling (int nsprite)
 {
+	Engine* const ctx = GetEngine();
 	Sprite *sprite;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 	
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
+	redraw_sprite(ctx, sprite);
 	sprite->sx = sprite->sy = 1.0f;
 	sprite->mode = MODE_NORMAL;
 	sprite->draw = GetSpriteDraw (sprite->mode);
-	UpdateSprite (sprite);
+	UpdateSprite (ctx, sprite);
 	
 	TLN_SetLastError (TLN_ERR_OK);
 	SelectSpriteBlitter (sprite);
@@ -457,13 +497,13 @@ bool TLN_SetSpriteRotation(int nsprite, float angle)
 	uint8_t* srcptr;
 	uint8_t* dstptr;
 
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
 
 	/* borra anterior */
 	if (sprite->rotation_bitmap != NULL)
@@ -558,13 +598,13 @@ bool TLN_ResetSpriteRotation(int nsprite)
 {
 	Sprite *sprite;
 
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[nsprite]; 
+	sprite = &ctx->sprites[nsprite]; 
 	if (sprite->rotation_bitmap != NULL)
 		TLN_DeleteBitmap(sprite->rotation_bitmap);
 
@@ -587,14 +627,16 @@ bool TLN_ResetSpriteRotation(int nsprite)
  */
 int TLN_GetSpritePicture (int nsprite)
 {
-	if (nsprite >= engine->numsprites)
+	Engine* const ctx = GetEngine();
+
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError (TLN_ERR_IDX_SPRITE);
 		return 0;
 	}	
 
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->sprites[nsprite].index;
+	return ctx->sprites[nsprite].index;
 }
 
 /*!
@@ -606,12 +648,13 @@ int TLN_GetSpritePicture (int nsprite)
  */
 int TLN_GetAvailableSprite(void)
 {
+	Engine* const ctx = GetEngine();
 	int c;
 
 	TLN_SetLastError(TLN_ERR_OK);
-	for (c = 0; c < engine->numsprites; c++)
+	for (c = 0; c < ctx->numsprites; c++)
 	{
-		if (!engine->sprites[c].ok)
+		if (!ctx->sprites[c].ok)
 			return c;
 	}
 	return -1;
@@ -639,13 +682,15 @@ int TLN_GetAvailableSprite(void)
  */
 bool TLN_EnableSpriteCollision(int nsprite, bool enable)
 {
-	if (nsprite >= engine->numsprites)
+	Engine* const ctx = GetEngine();
+
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	engine->sprites[nsprite].do_collision = enable;
+	ctx->sprites[nsprite].do_collision = enable;
 	return true;
 }
 
@@ -667,13 +712,15 @@ bool TLN_EnableSpriteCollision(int nsprite, bool enable)
  */
 bool TLN_GetSpriteCollision(int nsprite)
 {
-	if (nsprite >= engine->numsprites)
+	Engine* const ctx = GetEngine();
+
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	return engine->sprites[nsprite].collision;
+	return ctx->sprites[nsprite].collision;
 }
 
 /*!
@@ -689,16 +736,19 @@ bool TLN_GetSpriteCollision(int nsprite)
  */
 bool TLN_DisableSprite(int nsprite)
 {
+	Engine* const ctx = GetEngine();
 	Sprite* sprite;
 	bool enabled;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
 	enabled = sprite->ok;
+	if (enabled)
+		redraw_sprite(ctx, sprite);
 	sprite->ok = false;
 	sprite->collision = false;
 	sprite->do_collision = false;
@@ -707,7 +757,8 @@ bool TLN_DisableSprite(int nsprite)
 	if (enabled == true)
 	{
 		debugmsg("%s(%d)\t", __FUNCTION__, nsprite);
-		ListUnlinkNode(&engine->list_sprites, nsprite);
+		ListUnlinkNode(&ctx->list_sprites, nsprite);
+		InvalidateSpriteLines(ctx);
 	}
 
 	TLN_SetLastError(TLN_ERR_OK);
@@ -726,8 +777,9 @@ bool TLN_DisableSprite(int nsprite)
  */
 TLNAPI bool TLN_GetSpriteState(int nsprite, TLN_SpriteState* state)
 {
+	Engine* const ctx = GetEngine();
 	Sprite* sprite;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
@@ -739,7 +791,7 @@ TLNAPI bool TLN_GetSpriteState(int nsprite, TLN_SpriteState* state)
 		return false;
 	}
 
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
 	state->x = sprite->x;
 	state->y = sprite->y;
 	if (sprite->info != NULL)
@@ -769,17 +821,18 @@ TLNAPI bool TLN_GetSpriteState(int nsprite, TLN_SpriteState* state)
  */
 bool TLN_SetFirstSprite(int nsprite)
 {
+	Engine* const ctx = GetEngine();
 	Sprite* sprite;
 	List* list;
 	ListNode* node;
 	int cut1, cut2;
-	if (nsprite >= engine->numsprites || !engine->sprites[nsprite].ok || nsprite == engine->list_sprites.first)
+	if (nsprite >= ctx->numsprites || !ctx->sprites[nsprite].ok || nsprite == ctx->list_sprites.first)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
-	list = &engine->list_sprites;
-	sprite = &engine->sprites[nsprite];
+	list = &ctx->list_sprites;
+	sprite = &ctx->sprites[nsprite];
 	node = &sprite->list_node;
 
 	/* cut points inside the list to rejoin */
@@ -792,6 +845,8 @@ bool TLN_SetFirstSprite(int nsprite)
 	ListLinkNodes(list, nsprite, list->first);
 	ListLinkNodes(list, cut1, cut2);
 	list->first = nsprite;
+	InvalidateSpriteLines(ctx);
+	redraw_sprite(ctx, sprite);
 
 	debugmsg("%s(%d)\t", __FUNCTION__, nsprite);
 	ListPrint(list);
@@ -806,20 +861,21 @@ bool TLN_SetFirstSprite(int nsprite)
  */
 bool TLN_SetNextSprite(int nsprite, int next)
 {
+	Engine* const ctx = GetEngine();
 	List* list;
 	int cut1, cut2, cut3;
-	if (nsprite >= engine->numsprites || !engine->sprites[nsprite].ok || nsprite == next)
+	if (nsprite >= ctx->numsprites || !ctx->sprites[nsprite].ok || nsprite == next)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	if (next >= engine->numsprites || !engine->sprites[next].ok)
+	if (next >= ctx->numsprites || !ctx->sprites[next].ok)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
-	list = &engine->list_sprites;
+	list = &ctx->list_sprites;
 
 	/* cut points inside the list to rejoin */
 	cut1 = ListGetNext(list, nsprite);
@@ -834,6 +890,9 @@ bool TLN_SetNextSprite(int nsprite, int next)
 		list->first = cut3;
 	if (list->last == nsprite)
 		list->last = next;
+	InvalidateSpriteLines(ctx);
+	redraw_sprite(ctx, &ctx->sprites[nsprite]);
+	redraw_sprite(ctx, &ctx->sprites[next]);
 
 	debugmsg("%s(%d,%d)\t", __FUNCTION__, nsprite, next);
 	ListPrint(list);
@@ -870,14 +929,15 @@ static void nclamp(float* v)
 */
 bool TLN_SetSpritePivot(int nsprite, float px, float py)
 {
+	Engine* const ctx = GetEngine();
 	Sprite* sprite;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
 	nclamp(&px);
 	nclamp(&py);
 	sprite->ptx = px;
@@ -893,17 +953,49 @@ bool TLN_SetSpritePivot(int nsprite, float px, float py)
  */
 void TLN_SetSpritesMaskRegion(int top_line, int bottom_line)
 {
-	engine->sprite_mask_top = top_line;
-	engine->sprite_mask_bottom = bottom_line;
+	Engine* const ctx = GetEngine();
+
+	ctx->sprite_mask_top = top_line;
+	ctx->sprite_mask_bottom = bottom_line;
+	MarkDirtyFrame(ctx);
+}
+
+/*!
+ * \brief Limits the number of sprites drawn on each scanline, like classic sprite hardware did
+ * \param count Max sprites per scanline, 0 = unlimited (default)
+ * \remarks Sprites covering a scanline are counted in drawing order (see TLN_SetFirstSprite() and
+ * TLN_SetNextSprite()), the ones past the limit are not drawn on that scanline. Sprites outside
+ * the screen don't count, masked ones do.
+ */
+bool TLN_SetSpritesPerLine(int count)
+{
+	Engine* const ctx = GetEngine();
+
+	if (count < 0)
+	{
+		TLN_SetLastError(TLN_ERR_WRONG_SIZE);
+		return false;
+	}
+
+	ctx->sprite_lines.limit = count;
+	InvalidateSpriteLines(ctx);
+	MarkDirtyFrame(ctx);
+	TLN_SetLastError(TLN_ERR_OK);
+	return true;
 }
 
 /* updates clipping rect cache */
-void UpdateSprite (Sprite* sprite)
+void UpdateSprite (Engine* ctx, Sprite* sprite)
 {
 	int w,h;
+	const rect_t srcrect = sprite->srcrect;
+	const rect_t dstrect = sprite->dstrect;
 
 	if (!sprite->ok)
+	{
+		InvalidateSpriteLines(ctx);
 		return;
+	}
 
 	if (sprite->sx > 1.0)
 		w = 0;
@@ -929,10 +1021,10 @@ void UpdateSprite (Sprite* sprite)
 			sprite->srcrect.y1 -= sprite->dstrect.y1;
 			sprite->dstrect.y1 = 0;
 		}
-		if (sprite->dstrect.y2 > engine->framebuffer.height)
+		if (sprite->dstrect.y2 > ctx->framebuffer.height)
 		{
-			sprite->srcrect.y2 -= (sprite->dstrect.y2 - engine->framebuffer.height);
-			sprite->dstrect.y2 = engine->framebuffer.height;
+			sprite->srcrect.y2 -= (sprite->dstrect.y2 - ctx->framebuffer.height);
+			sprite->dstrect.y2 = ctx->framebuffer.height;
 		}
 
 		/* horizontal clipping */
@@ -941,10 +1033,10 @@ void UpdateSprite (Sprite* sprite)
 			sprite->srcrect.x1 -= sprite->dstrect.x1;
 			sprite->dstrect.x1 = 0;
 		}
-		if (sprite->dstrect.x2 > engine->framebuffer.width)
+		if (sprite->dstrect.x2 > ctx->framebuffer.width)
 		{
-			sprite->srcrect.x2 -= (sprite->dstrect.x2 - engine->framebuffer.width);
-			sprite->dstrect.x2 = engine->framebuffer.width;
+			sprite->srcrect.x2 -= (sprite->dstrect.x2 - ctx->framebuffer.width);
+			sprite->dstrect.x2 = ctx->framebuffer.width;
 		}
 	}
 
@@ -982,10 +1074,10 @@ void UpdateSprite (Sprite* sprite)
 			sprite->srcrect.y1 -= (sprite->dstrect.y1*sprite->dy);
 			sprite->dstrect.y1 = 0;
 		}
-		if (sprite->dstrect.y2 > engine->framebuffer.height)
+		if (sprite->dstrect.y2 > ctx->framebuffer.height)
 		{
-			sprite->srcrect.y2 -= (sprite->dstrect.y2 - engine->framebuffer.height)*sprite->dy;
-			sprite->dstrect.y2 = engine->framebuffer.height;
+			sprite->srcrect.y2 -= (sprite->dstrect.y2 - ctx->framebuffer.height)*sprite->dy;
+			sprite->dstrect.y2 = ctx->framebuffer.height;
 		}
 
 		/* clipping horizontal */
@@ -994,13 +1086,21 @@ void UpdateSprite (Sprite* sprite)
 			sprite->srcrect.x1 -= (sprite->dstrect.x1*sprite->dx);
 			sprite->dstrect.x1 = 0;
 		}
-		if (sprite->dstrect.x2 > engine->framebuffer.width)
+		if (sprite->dstrect.x2 > ctx->framebuffer.width)
 		{
-			sprite->srcrect.x2 -= (sprite->dstrect.x2 - engine->framebuffer.width)*sprite->dx;
-			sprite->dstrect.x2 = engine->framebuffer.width;
+			sprite->srcrect.x2 -= (sprite->dstrect.x2 - ctx->framebuffer.width)*sprite->dx;
+			sprite->dstrect.x2 = ctx->framebuffer.width;
 		}
 	}
 
+	/* moved or resized: redraw both locations */
+	if (memcmp(&srcrect, &sprite->srcrect, sizeof(rect_t)) || memcmp(&dstrect, &sprite->dstrect, sizeof(rect_t)))
+	{
+		MoveSpriteLines(ctx, sprite, &srcrect, &dstrect);
+		MarkDirtyLines(ctx, dstrect.y1, dstrect.y2);
+		redraw_sprite(ctx, sprite);
+	}
+
 	/*
 	debugmsg ("Sprite %02d scale=%.02f,%.02f src=[%d,%d,%d,%d] dst=[%d,%d,%d,%d]\n",
 		sprite->num, sprite->sx, sprite->sy,
@@ -1014,7 +1114,8 @@ static void SelectSpriteBlitter (Sprite* sprite)
 	const bool scaling = sprite->mode == MODE_SCALING;
 	const bool blend = sprite->blend != NULL;
 
-	sprite->blitter = SelectBlitter (true, scaling, blend);
+	sprite->blitters[0] = SelectBlitter (false, scaling, blend);
+	sprite->blitters[1] = SelectBlitter (true, scaling, blend);
 }
 
 void MakeRect(rect_t* rect, int x, int y, int w, int h)
@@ -27,6 +27,15 @@ rect_t;
 
 extern void MakeRect(rect_t* rect, int x, int y, int w, int h);
 
+/* sprites covering a scanline, sorted by drawing order */
+typedef struct
+{
+	int*	items;
+	int		count;
+	int		capacity;
+}
+SpriteLine;
+
 /* sprite */
 typedef struct Sprite
 {
@@ -37,6 +46,7 @@ typedef struct Sprite
 	int				pitch;
 	int				num;
 	int				index;			/* spriteset picture index */
+	int				order;			/* position in the drawing list when sprite_lines was built */
 	int				x,y;			/* screen space location (TLN_SetSpritePosition) */
 	int				dx,dy;
 	int				xworld, yworld;	/* world space location (TLN_SetSpriteWorldPosition) */
@@ -45,10 +55,11 @@ typedef struct Sprite
 	rect_t			srcrect;
 	rect_t			dstrect;
 	draw_t			mode;
-	uint8_t*		blend;
+	Blend*			blend;			/* blending parameters, NULL if disabled */
+	Blend			blend_data;		/* parameters pointed by blend */
 	uint32_t		flags;
 	ScanDrawPtr		draw;
-	ScanBlitPtr		blitter;
+	ScanBlitPtr		blitters[2];	/* without and with color key */
 	bool			ok;
 	bool			do_collision;
 	bool			collision;
@@ -60,6 +71,9 @@ typedef struct Sprite
 }
 Sprite;
 
-extern void UpdateSprite(Sprite* sprite);
+struct Engine;
+
+extern void UpdateSprite(struct Engine* ctx, Sprite* sprite);
+extern void MoveSpriteLines(struct Engine* ctx, Sprite* sprite, const rect_t* srcrect, const rect_t* dstrect);
 
 #endif
\ No newline at end of file
@@ -14,6 +14,8 @@
 #include "Spriteset.h"
 #include "Palette.h"
 #include "Bitmap.h"
+#include "Draw.h"
+#include "Engine.h"
 #include "crc32.h"
 
 static void set_sprite_entry (TLN_Spriteset spriteset, int entry, TLN_SpriteData* data)
@@ -22,6 +24,7 @@ static void set_sprite_entry (TLN_Spriteset spriteset, int entry, TLN_SpriteData
 	dst_data->w = data->w;
 	dst_data->h = data->h;
 	dst_data->offset = data->y*spriteset->bitmap->pitch + data->x;
+	dst_data->type = GetPixelsType (spriteset->bitmap->data + dst_data->offset, data->w, data->h, spriteset->bitmap->pitch);
 	if (data->name[0] != 0)
 		dst_data->hash = _crc32(0, data->name, strlen(data->name));
 	else
@@ -120,7 +123,9 @@ bool TLN_SetSpritesetData (TLN_Spriteset spriteset, int entry, TLN_SpriteData* d
 			src += pitch;
 			dst += spriteset->bitmap->pitch;
 		}
+		set_sprite_entry (spriteset, entry, data);
 	}
+	MarkDirtyFrame(GetEngine());
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -21,6 +21,7 @@ typedef struct
 	uint32_t hash;
 	int w,h;
 	int offset;
+	uint8_t type;	/* PixelsType of the picture */
 }
 SpriteEntry;
 
@@ -16,6 +16,8 @@
 #include <stdio.h>
 #include "Tilengine.h"
 #include "Tilemap.h"
+#include "Draw.h"
+#include "Engine.h"
 
 typedef struct
 {
@@ -212,6 +214,7 @@ bool TLN_SetTilemapTileset2(TLN_Tilemap tilemap, TLN_Tileset tileset, int index)
 	}
 
 	tilemap->tilesets[index] = tileset;
+	MarkDirtyFrame(GetEngine());
 	TLN_SetLastError(TLN_ERR_OK);
 	return true;
 }
@@ -289,6 +292,7 @@ bool TLN_SetTilemapTile (TLN_Tilemap tilemap, int row, int col, TLN_Tile tile)
 		if (dsttile != NULL)
 		{
 			dsttile->value = tile != NULL ? tile->value : 0;
+			MarkDirtyTilemap (GetEngine(), tilemap, row, row + 1);
 			TLN_SetLastError (TLN_ERR_OK);
 			return true;
 		}
@@ -416,6 +420,7 @@ bool TLN_CopyTiles (TLN_Tilemap src, int srcrow, int srccol, int rows, int cols,
 				return false;
 			}
 		}
+		MarkDirtyTilemap (GetEngine(), dst, dstrow, dstrow + tgtrect.h);
 	}
 
 	TLN_SetLastError (TLN_ERR_OK);
@@ -22,13 +22,14 @@
 #include "Engine.h"
 #include "Layer.h"
 #include "Sprite.h"
-#include "Tables.h"
+#include "Blend.h"
 #include "LoadTMX.h"
 
 /* magic number to recognize context object */
 #define ID_CONTEXT	0x7E5D0AB1
 
-TLN_Engine engine;	/* current context */
+TLN_Engine default_engine;					/* current context */
+THREAD_LOCAL TLN_Engine thread_engine;		/* context bound to the calling thread, NULL uses the current one */
 
 static TLN_Engine create_context(int hres, int vres, int numlayers, int numsprites, int numanimations);
 
@@ -98,12 +99,6 @@ static TLN_Engine create_context(int hres, int vres, int numlayers, int numsprit
 			TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
 			return NULL;
 		}
-		for (c = 0; c < context->numlayers; c++)
-			context->layers[c].mosaic.buffer = (uint32_t*)calloc(hres, sizeof(uint32_t));
-
-		/* buffer for intermediate scanline output */
-		context->linebuffer = (uint32_t*)calloc(hres, sizeof(uint32_t));
-		context->priority = (uint32_t*)malloc(context->framebuffer.pitch);
 	}
 
 	/* create static sprites */
@@ -121,13 +116,31 @@ static TLN_Engine create_context(int hres, int vres, int numlayers, int numsprit
 		{
 			Sprite* sprite = &context->sprites[c];
 			sprite->draw = GetSpriteDraw(MODE_NORMAL);
-			sprite->blitter = SelectBlitter(true, false, false);
+			sprite->blitters[0] = SelectBlitter(false, false, false);
+			sprite->blitters[1] = SelectBlitter(true, false, false);
 			sprite->sx = sprite->sy = 1.0f;
 		}
 		ListInit(&context->list_sprites, &context->sprites[0].list_node, sizeof(Sprite), context->numsprites);
 
-		/* sprite collision buffer */
-		context->collision = (uint16_t*)calloc(hres, sizeof(uint16_t));
+		/* per scanline sprite lists, grown as sprites get there */
+		context->sprite_lines.lines = (SpriteLine*)calloc(vres, sizeof(SpriteLine));
+		context->sprite_lines.valid = vres;
+		if (!context->sprite_lines.lines)
+		{
+			TLN_DeleteContext(context);
+			TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
+			return NULL;
+		}
+	}
+
+	/* scratch buffers for serial rendering */
+	context->numthreads = 1;
+	context->buffers = (Scanbuffers*)calloc(1, sizeof(Scanbuffers));
+	if (!context->buffers || !CreateScanbuffers(&context->buffers[0], context, hres, numlayers, numsprites, false))
+	{
+		TLN_DeleteContext(context);
+		TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
+		return NULL;
 	}
 
 	/* create static animations */
@@ -146,20 +159,25 @@ static TLN_Engine create_context(int hres, int vres, int numlayers, int numsprit
 
 	context->bgcolor = PackRGB32(0,0,0);
 	context->blit_fast = SelectBlitter (false, false, false);
-	if (!CreateBlendTables ())
+	context->blend_table = CreateBlendTable ();
+	if (context->blend_table == NULL)
 	{
 		TLN_DeleteContext(context);
 		TLN_SetLastError (TLN_ERR_OUT_OF_MEMORY);
 		return NULL;
 	}
-	context->blend_table = SelectBlendTable (BLEND_MOD);
 
 	/* set as default context if it's the first one */
-	if (engine == NULL)
-		engine = context;
+	if (default_engine == NULL)
+		default_engine = context;
 
+	/* layers unclipped, set here as the new context may not be the current one */
 	for (c = 0; c<context->numlayers; c++)
-		TLN_DisableLayerClip(c);
+	{
+		LayerWindow* window = &context->layers[c].window;
+		window->x2 = hres;
+		window->y2 = vres;
+	}
 
 #ifdef _DEBUG
 	TLN_SetLogLevel(TLN_LOG_ERRORS);
@@ -187,12 +205,21 @@ static bool check_context(TLN_Engine context)
 *
 * \returns
 * true if success or false if wrong context is supplied
+*
+* \remarks
+* The current context is shared by all threads, except the ones that bound their own with
+* TLN_SetThreadContext(). When called from one of these threads, it also replaces its binding
+*
+* \see
+* TLN_SetThreadContext()
 */
 bool TLN_SetContext(TLN_Engine context)
 {
 	if (check_context(context))
 	{
-		engine = context;
+		default_engine = context;
+		if (thread_engine != NULL)
+			thread_engine = context;
 		TLN_SetLastError(TLN_ERR_OK);
 		return true;
 	}
@@ -205,11 +232,51 @@ bool TLN_SetContext(TLN_Engine context)
 
 /*!
 * \brief
-* Returns the current engine context
+* Binds an engine context to the calling thread
+*
+* \param context
+* TLN_Engine object to use from the calling thread, or NULL to use the current context again
+*
+* \returns
+* true if success or false if wrong context is supplied
+*
+* All the functions called from this thread operate on the bound context, regardless of the
+* current context set with TLN_SetContext(). This allows separate contexts to be updated and
+* rendered at the same time from different threads, for example a menu on the main thread and
+* off-screen previews on a worker thread. A context must not be used from two threads at once.
+*
+* \remarks
+* Resources can be attached to contexts running on different threads as long as none of them
+* modifies or animates them. Tilesets loaded from the same file are shared by the loader.
+*
+* \see
+* TLN_SetContext(), TLN_GetContext()
+*/
+bool TLN_SetThreadContext(TLN_Engine context)
+{
+	if (context != NULL && !check_context(context))
+	{
+		TLN_SetLastError(TLN_ERR_NULL_POINTER);
+		return false;
+	}
+
+	/* unbinding reports on the context this thread used, the default one may be drawing on
+	 * another thread */
+	if (context == NULL && thread_engine != NULL)
+		thread_engine->error = TLN_ERR_OK;
+	thread_engine = context;
+	if (context != NULL)
+		TLN_SetLastError(TLN_ERR_OK);
+	return true;
+}
+
+/*!
+* \brief
+* Returns the engine context used by the calling thread
 */
 TLN_Engine TLN_GetContext(void)
 {
-	return engine;
+	return GetEngine();
 }
 
 /*!
@@ -218,10 +285,13 @@ TLN_Engine TLN_GetContext(void)
 */
 void TLN_Deinit(void)
 {
-	if (engine != NULL)
+	TLN_Engine context = GetEngine();
+	if (context != NULL)
 	{
-		TLN_DeleteContext(engine);
-		engine = NULL;
+		TLN_DeleteContext(context);
+		if (default_engine == context)
+			default_engine = NULL;
+		thread_engine = NULL;
 	}
 }
 
@@ -242,29 +312,34 @@ bool TLN_DeleteContext(TLN_Engine context)
 		return false;
 	}
 
-	DeleteBlendTables();
+	DeleteBlendTable(context->blend_table);
 
-	for (c = 0; c < context->numlayers; c++)
-		free(context->layers[c].mosaic.buffer);
+	DeleteWorkers(context->workers);
+	if (context->buffers)
+	{
+		for (c = 0; c < context->numthreads; c++)
+			DeleteScanbuffers(&context->buffers[c]);
+		free(context->buffers);
+	}
 
 	if (context->sprites)
 		free(context->sprites);
+	free(context->dirty_lines.lines);
+	free(context->dirty_lines.layers);
+	free(context->dirty_lines.rasters);
+	if (context->sprite_lines.lines)
+	{
+		for (c = 0; c < context->framebuffer.height; c++)
+			free(context->sprite_lines.lines[c].items);
+		free(context->sprite_lines.lines);
+	}
 
 	if (context->layers)
 		free(context->layers);
 
-	if (context->priority)
-		free(context->priority);
-
 	if (context->animations)
 		free(context->animations);
 
-	if (context->collision)
-		free(context->collision);
-
-	if (context->linebuffer)
-		free(context->linebuffer);
-
 	free(context);
 	return true;
 }
@@ -278,8 +353,10 @@ bool TLN_DeleteContext(TLN_Engine context)
  */
 void TLN_SetLogLevel(TLN_LogLevel log_level)
 {
-	if (engine != NULL)
-		engine->log_level = log_level;
+	Engine* const ctx = GetEngine();
+
+	if (ctx != NULL)
+		ctx->log_level = log_level;
 }
 
 /*!
@@ -310,7 +387,9 @@ uint32_t TLN_GetVersion (void)
  */
 void TLN_SetTargetFps(int fps)
 {
-	engine->target_fps = fps;
+	Engine* const ctx = GetEngine();
+
+	ctx->target_fps = fps;
 }
 
 /*!
@@ -320,7 +399,9 @@ void TLN_SetTargetFps(int fps)
  */
 int TLN_GetTargetFps(void)
 {
-	return engine->target_fps;
+	Engine* const ctx = GetEngine();
+
+	return ctx->target_fps;
 }
 
 /*!
@@ -332,8 +413,10 @@ int TLN_GetTargetFps(void)
  */
 int TLN_GetWidth (void)
 {
+	Engine* const ctx = GetEngine();
+
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->framebuffer.width;
+	return ctx->framebuffer.width;
 }
 
 /*!
@@ -345,8 +428,10 @@ int TLN_GetWidth (void)
  */
 int TLN_GetHeight (void)
 {
+	Engine* const ctx = GetEngine();
+
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->framebuffer.height;
+	return ctx->framebuffer.height;
 }
 
 /*!
@@ -372,8 +457,13 @@ int TLN_GetHeight (void)
  */
 void TLN_SetRenderTarget (uint8_t* data, int pitch)
 {
-	engine->framebuffer.data = data;
-	engine->framebuffer.pitch = pitch;
+	Engine* const ctx = GetEngine();
+
+	/* a different surface holds none of the scanlines drawn so far */
+	if (data != ctx->framebuffer.data || pitch != ctx->framebuffer.pitch)
+		MarkDirtyFrame(ctx);
+	ctx->framebuffer.data = data;
+	ctx->framebuffer.pitch = pitch;
 	TLN_SetLastError (TLN_ERR_OK);
 }
 
@@ -386,8 +476,10 @@ void TLN_SetRenderTarget (uint8_t* data, int pitch)
  */
 uint8_t* TLN_GetRenderTarget (void)
 {
+	Engine* const ctx = GetEngine();
+
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->framebuffer.data;
+	return ctx->framebuffer.data;
 }
 
 /*!
@@ -399,8 +491,10 @@ uint8_t* TLN_GetRenderTarget (void)
  */
 int TLN_GetRenderTargetPitch (void)
 {
+	Engine* const ctx = GetEngine();
+
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->framebuffer.pitch;
+	return ctx->framebuffer.pitch;
 }
 
 /* basic reference list without duplicates */
@@ -435,49 +529,49 @@ bool ref_add(RefList* refs, void* item)
 }
 
 /* Starts active rendering of the current frame */
-static void BeginFrame (int frame)
+static void BeginFrame (Engine* ctx, int frame)
 {
 	/* update active animations */
 	List* list;
 	int index;
 
 	/* adjust to target fps */
-	frame = (engine->frame*INTERNAL_FPS) / engine->target_fps;
-	engine->frame += 1;
+	frame = (ctx->frame*INTERNAL_FPS) / ctx->target_fps;
+	ctx->frame += 1;
 
 	/* color cycle animations */
-	if (engine->numanimations > 0)
+	if (ctx->numanimations > 0)
 	{
-		list = &engine->list_animations;
+		list = &ctx->list_animations;
 		index = list->first;
 		while (index != -1)
 		{
-			Animation* animation = &engine->animations[index];
-			UpdateAnimation(animation, frame);
+			Animation* animation = &ctx->animations[index];
+			UpdateAnimation(ctx, animation, frame);
 			index = animation->list_node.next;
 		}
 	}
 
 	/* sprite animations */
-	if (engine->numsprites > 0)
+	if (ctx->numsprites > 0)
 	{
-		list = &engine->list_sprites;
+		list = &ctx->list_sprites;
 		index = list->first;
 		while (index != -1)
 		{
-			Sprite* sprite = &engine->sprites[index];
+			Sprite* sprite = &ctx->sprites[index];
 			sprite->collision = false;
 			if (sprite->animation.enabled && !sprite->animation.paused)
-				UpdateAnimation(&sprite->animation, frame);
+				UpdateAnimation(ctx, &sprite->animation, frame);
 			index = sprite->list_node.next;
 		}
 	}
 
 	/* tileset animations. calls just once per globally used tileset, avoids duplicate calls */
 	RefList tilesets = { 0 };
-	for (index = 0; index < engine->numlayers; index += 1)
+	for (index = 0; index < ctx->numlayers; index += 1)
 	{
-		Layer* layer = &engine->layers[index];
+		Layer* layer = &ctx->layers[index];
 		if (layer->tilemap != NULL)
 		{
 			int ts;
@@ -491,16 +585,16 @@ static void BeginFrame (int frame)
 				{
 					int c;
 					for (c = 0; c < tileset->sp->num_sequences; c += 1)
-						UpdateAnimation(&tileset->animations[c], frame);
+						UpdateAnimation(ctx, &tileset->animations[c], frame);
 				}
 			}
 		}
 	}
 
 	/* frame callback */
-	engine->line = 0;
-	if (engine->cb_frame)
-		engine->cb_frame (engine->frame);
+	ctx->line = 0;
+	if (ctx->cb_frame)
+		ctx->cb_frame (ctx->frame);
 }
 
 /*!
@@ -514,11 +608,165 @@ static void BeginFrame (int frame)
  */
 void TLN_UpdateFrame(int frame)
 {
-	BeginFrame(frame);
-	while (DrawScanline()) {}
+	Engine* const ctx = GetEngine();
+
+	BeginFrame(ctx, frame);
+
+	/* raster effects need lines drawn in order */
+	if (ctx->workers != NULL && ctx->cb_raster == NULL)
+		DrawFrameBands(ctx);
+	else
+		while (DrawScanline(ctx)) {}
 	TLN_SetLastError(TLN_ERR_OK);
 }
 
+/*!
+ * \brief
+ * Sets the number of threads that render each frame
+ *
+ * \param count
+ * Number of threads including the calling one, up to 16. 1 renders on the calling thread only
+ * (default), 0 uses one thread per processor.
+ *
+ * TLN_UpdateFrame() splits the frame in horizontal bands drawn in parallel, each thread with its
+ * own scratch buffers. Frames are still drawn line by line on the calling thread while a raster
+ * callback is set, as raster effects need lines drawn in order.
+ *
+ * \see
+ * TLN_UpdateFrame(), TLN_SetRasterCallback()
+ */
+bool TLN_SetRenderThreads(int count)
+{
+	Engine* const ctx = GetEngine();
+	Scanbuffers* buffers;
+	Workers* workers = NULL;
+	int c;
+
+	if (count == 0)
+		count = GetNumProcessors();
+	if (count < 1)
+	{
+		TLN_SetLastError(TLN_ERR_WRONG_SIZE);
+		return false;
+	}
+	if (count > MAX_WORKERS)
+		count = MAX_WORKERS;
+
+	/* keep the serial buffers, replace the rest */
+	DeleteWorkers(ctx->workers);
+	ctx->workers = NULL;
+	for (c = 1; c < ctx->numthreads; c++)
+		DeleteScanbuffers(&ctx->buffers[c]);
+	ctx->numthreads = 1;
+
+	buffers = (Scanbuffers*)realloc(ctx->buffers, count * sizeof(Scanbuffers));
+	if (buffers == NULL)
+	{
+		TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
+		return false;
+	}
+	ctx->buffers = buffers;
+
+	if (count > 1)
+	{
+		for (c = 1; c < count; c++)
+		{
+			if (!CreateScanbuffers(&buffers[c], ctx, ctx->framebuffer.width, ctx->numlayers, ctx->numsprites, true))
+				break;
+		}
+		if (c == count)
+			workers = CreateWorkers(count);
+
+		if (workers == NULL)
+		{
+			while (--c >= 1)
+				DeleteScanbuffers(&buffers[c]);
+			TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
+			return false;
+		}
+		ctx->workers = workers;
+		ctx->numthreads = count;
+	}
+
+	TLN_SetLastError(TLN_ERR_OK);
+	return true;
+}
+
+/*!
+ * \brief
+ * Enables or disables drawing only the scanlines that changed
+ *
+ * \param enable
+ * true to draw only changed scanlines, false to draw whole frames (default)
+ *
+ * When enabled, TLN_UpdateFrame() only draws the scanlines affected by changes since the previous
+ * frame, and keeps the rest of the render target as it was. Mostly static screens such as menus
+ * drop to almost no CPU. Changes done through the API are tracked: layer setup and scrolling,
+ * raster tables, tilemap edits, palettes, tilesets, sprites and animations. Changes done to data
+ * through pointers, like TLN_GetBitmapPtr() or TLN_GetTilemapTiles(), must be reported with
+ * TLN_SetDirtyLines().
+ *
+ * \remarks
+ * The render target must keep its content between frames, setting a different one with
+ * TLN_SetRenderTarget() redraws the whole frame. Whole frames are still drawn while a raster
+ * callback is set.
+ *
+ * \see
+ * TLN_SetDirtyLines(), TLN_UpdateFrame()
+ */
+bool TLN_EnableDirtyTracking(bool enable)
+{
+	Engine* const ctx = GetEngine();
+
+	if (enable && !ctx->dirty_lines.enabled)
+	{
+		uint8_t* lines = (uint8_t*)malloc(ctx->framebuffer.height);
+		Layer* layers = (Layer*)calloc(ctx->numlayers + 1, sizeof(Layer));
+		TLN_RasterLine* rasters = (TLN_RasterLine*)calloc((size_t)ctx->framebuffer.height * (ctx->numlayers + 1), sizeof(TLN_RasterLine));
+		if (lines == NULL || layers == NULL || rasters == NULL)
+		{
+			free(lines);
+			free(layers);
+			free(rasters);
+			TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
+			return false;
+		}
+		ctx->dirty_lines.lines = lines;
+		ctx->dirty_lines.layers = layers;
+		ctx->dirty_lines.rasters = rasters;
+		ctx->dirty_lines.enabled = true;
+		MarkDirtyFrame(ctx);
+	}
+	else if (!enable && ctx->dirty_lines.enabled)
+	{
+		free(ctx->dirty_lines.lines);
+		free(ctx->dirty_lines.layers);
+		free(ctx->dirty_lines.rasters);
+		ctx->dirty_lines.lines = NULL;
+		ctx->dirty_lines.layers = NULL;
+		ctx->dirty_lines.rasters = NULL;
+		ctx->dirty_lines.enabled = false;
+	}
+
+	TLN_SetLastError(TLN_ERR_OK);
+	return true;
+}
+
+/*!
+ * \brief
+ * Marks scanlines to be drawn on the next frame when dirty tracking is enabled
+ *
+ * \param top_line First scanline to draw
+ * \param bottom_line Last scanline to draw
+ *
+ * \see
+ * TLN_EnableDirtyTracking()
+ */
+void TLN_SetDirtyLines(int top_line, int bottom_line)
+{
+	MarkDirtyLines(GetEngine(), top_line, bottom_line + 1);
+}
+
 /*!
  * \brief
  * Returns the number of layers specified during initialisation
@@ -528,8 +776,10 @@ void TLN_UpdateFrame(int frame)
  */
 int TLN_GetNumLayers (void)
 {
+	Engine* const ctx = GetEngine();
+
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->numlayers;
+	return ctx->numlayers;
 }
 
 /*!
@@ -542,8 +792,10 @@ int TLN_GetNumLayers (void)
 
 int TLN_GetNumSprites (void)
 {
+	Engine* const ctx = GetEngine();
+
 	TLN_SetLastError (TLN_ERR_OK);
-	return engine->numsprites;
+	return ctx->numsprites;
 }
 
 /*!
@@ -563,8 +815,11 @@ int TLN_GetNumSprites (void)
  */
 void TLN_SetRasterCallback (void (*callback)(int))
 {
+	Engine* const ctx = GetEngine();
+
 	TLN_SetLastError (TLN_ERR_OK);
-	engine->cb_raster = callback;
+	ctx->cb_raster = callback;
+	MarkDirtyFrame(ctx);
 }
 
 /*!
@@ -576,8 +831,10 @@ void TLN_SetRasterCallback (void (*callback)(int))
  */
 void TLN_SetFrameCallback (void (*callback)(int))
 {
+	Engine* const ctx = GetEngine();
+
 	TLN_SetLastError (TLN_ERR_OK);
-	engine->cb_frame = callback;
+	ctx->cb_frame = callback;
 }
 
 /*!
@@ -601,7 +858,10 @@ void TLN_SetFrameCallback (void (*callback)(int))
  */
 void TLN_SetBGColor (uint8_t r, uint8_t g, uint8_t b)
 {
-	engine->bgcolor = PackRGB32 (r,g,b);
+	Engine* const ctx = GetEngine();
+
+	ctx->bgcolor = PackRGB32 (r,g,b);
+	MarkDirtyFrame(ctx);
 }
 
 /*!
@@ -613,9 +873,12 @@ void TLN_SetBGColor (uint8_t r, uint8_t g, uint8_t b)
  */
 bool TLN_SetBGColorFromTilemap (TLN_Tilemap tilemap)
 {
+	Engine* const ctx = GetEngine();
+
 	if (CheckBaseObject (tilemap, OT_TILEMAP))
 	{
-		engine->bgcolor = tilemap->bgcolor | 0xFF000000;
+		ctx->bgcolor = tilemap->bgcolor | 0xFF000000;
+		MarkDirtyFrame(ctx);
 		TLN_SetLastError (TLN_ERR_OK);
 		return true;
 	}
@@ -632,7 +895,10 @@ bool TLN_SetBGColorFromTilemap (TLN_Tilemap tilemap)
  */
 void TLN_DisableBGColor (void)
 {
-	engine->bgcolor = 0;
+	Engine* const ctx = GetEngine();
+
+	ctx->bgcolor = 0;
+	MarkDirtyFrame(ctx);
 }
 
 /*!
@@ -650,13 +916,16 @@ void TLN_DisableBGColor (void)
  */
 bool TLN_SetBGBitmap (TLN_Bitmap bitmap)
 {
+	Engine* const ctx = GetEngine();
+
 	if (bitmap != NULL)
 	{
 		if (!CheckBaseObject(bitmap, OT_BITMAP))
 			return false;
-		engine->bgpalette = bitmap->palette;
+		ctx->bgpalette = bitmap->palette;
 	}
-	engine->bgbitmap = bitmap;
+	ctx->bgbitmap = bitmap;
+	MarkDirtyFrame(ctx);
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -673,10 +942,13 @@ bool TLN_SetBGBitmap (TLN_Bitmap bitmap)
  */
 bool TLN_SetBGPalette (TLN_Palette palette)
 {
+	Engine* const ctx = GetEngine();
+
 	if (!CheckBaseObject(palette, OT_PALETTE))
 		return false;
 
-	engine->bgpalette = palette;
+	ctx->bgpalette = palette;
+	MarkDirtyFrame(ctx);
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -689,6 +961,8 @@ bool TLN_SetBGPalette (TLN_Palette palette)
  */
 bool TLN_SetGlobalPalette(int index, TLN_Palette palette)
 {
+	Engine* const ctx = GetEngine();
+
 	if (index < 0 || index > NUM_PALETTES - 1)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_PALETTE);
@@ -698,7 +972,8 @@ bool TLN_SetGlobalPalette(int index, TLN_Palette palette)
 	if (palette != NULL && !CheckBaseObject(palette, OT_PALETTE))
 		return false;
 
-	engine->palettes[index] = palette;
+	ctx->palettes[index] = palette;
+	MarkDirtyFrame(ctx);
 	TLN_SetLastError(TLN_ERR_OK);
 	return true;
 }
@@ -711,6 +986,8 @@ bool TLN_SetGlobalPalette(int index, TLN_Palette palette)
 */
 TLN_Palette TLN_GetGlobalPalette(int index)
 {
+	Engine* const ctx = GetEngine();
+
 	if (index < 0 || index > NUM_PALETTES - 1)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_PALETTE);
@@ -718,12 +995,12 @@ TLN_Palette TLN_GetGlobalPalette(int index)
 	}
 
 	TLN_SetLastError(TLN_ERR_OK);
-	return engine->palettes[index];
+	return ctx->palettes[index];
 }
 
 /*!
  * \brief
- * Sets custom blend function to use when BLEND_CUSTOM mode is selected
+ * Sets custom blend function of the current context to use when BLEND_CUSTOM mode is selected
  * \param blend_function
  * pointer to a user-provided function that takes two parameters: source component intensity,
  * destination component intensity, and returns the desired intensity. This function is
@@ -737,18 +1014,13 @@ TLN_Palette TLN_GetGlobalPalette(int index)
  */
 void TLN_SetCustomBlendFunction (uint8_t (*blend_function)(uint8_t src, uint8_t dst))
 {
-	uint8_t* table = SelectBlendTable (BLEND_CUSTOM);
-	int a,b;
+	Engine* const ctx = GetEngine();
 
 	if (blend_function == NULL)
 		return;
 
-	/* rellena tabla */
-	for (a=0; a<256; a++)
-	{
-		for (b=0; b<256; b++)
-			table[(a<<8) + b] = blend_function (a, b);
-	}
+	SetCustomBlendTable (ctx->blend_table, blend_function);
+	MarkDirtyFrame(ctx);
 }
 
 /*!
@@ -815,9 +1087,11 @@ const char* const errornames[] =
  */
 void TLN_SetLastError (TLN_Error error)
 {
-	if (check_context(engine))
+	Engine* const ctx = GetEngine();
+
+	if (check_context(ctx))
 	{
-		engine->error = error;
+		ctx->error = error;
 		if (error != TLN_ERR_OK)
 			tln_trace(TLN_LOG_ERRORS, errornames[error]);
 	}
@@ -832,8 +1106,10 @@ void TLN_SetLastError (TLN_Error error)
  */
 TLN_Error TLN_GetLastError (void)
 {
-	if (check_context(engine))
-		return engine->error;
+	Engine* const ctx = GetEngine();
+
+	if (check_context(ctx))
+		return ctx->error;
 	else
 		return TLN_ERR_NULL_POINTER;
 }
@@ -859,7 +1135,9 @@ const char *TLN_GetErrorString (TLN_Error error)
 /* outputs trace message */
 void tln_trace(TLN_LogLevel log_level, const char* format, ...)
 {
-	if (engine != NULL && engine->log_level >= log_level)
+	Engine* const ctx = GetEngine();
+
+	if (ctx != NULL && ctx->log_level >= log_level)
 	{
 		char line[255];
 		va_list ap;
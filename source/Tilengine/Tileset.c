@@ -20,6 +20,8 @@
 #include "Palette.h"
 #include "simplexml.h"
 #include "Bitmap.h"
+#include "Draw.h"
+#include "Engine.h"
 
 static bool HasTransparentPixels (uint8_t* src, int width);
 
@@ -95,6 +97,7 @@ TLN_Tileset TLN_CreateTileset (int numtiles, int width, int height, TLN_Palette
 	tileset->palette = palette;
 	tileset->sp = sp;
 	tileset->color_key = (bool*)calloc(numtiles, height);
+	tileset->types = (uint8_t*)calloc(numtiles, sizeof(uint8_t));
 	tileset->attributes = (TLN_TileAttributes*)calloc(numtiles, sizeof(TLN_TileAttributes));
 	if (attributes != NULL)
 		memcpy (tileset->attributes, attributes, numtiles * sizeof(TLN_TileAttributes));
@@ -192,7 +195,10 @@ bool TLN_SetTilesetPixels (TLN_Tileset tileset, int entry, uint8_t* srcdata, int
 		srcdata += srcpitch;
 		dstdata += tileset->width;
 	}
+	dstdata -= tileset->width * tileset->height;
+	tileset->types[entry] = GetPixelsType (dstdata, tileset->width, tileset->height, tileset->width);
 
+	MarkDirtyFrame(GetEngine());
 	TLN_SetLastError (TLN_ERR_OK);
 	return true;
 }
@@ -227,9 +233,10 @@ TLN_Tileset TLN_CloneTileset (TLN_Tileset src)
 		
 	tileset->tiles = (uint16_t*)malloc(size_tiles);
 	tileset->color_key = (bool*)malloc(size_color);
+	tileset->types = (uint8_t*)malloc(src->numtiles);
 	tileset->attributes = (TLN_TileAttributes*)malloc(size_attributes);
 
-	if (tileset->tiles == NULL || tileset->color_key == NULL || tileset->attributes == NULL)
+	if (tileset->tiles == NULL || tileset->color_key == NULL || tileset->types == NULL || tileset->attributes == NULL)
 	{
 		TLN_DeleteTileset(tileset);
 		TLN_SetLastError(TLN_ERR_OUT_OF_MEMORY);
@@ -238,6 +245,7 @@ TLN_Tileset TLN_CloneTileset (TLN_Tileset src)
 
 	memcpy(tileset->tiles, src->tiles, size_tiles);
 	memcpy(tileset->color_key, src->color_key, size_color);
+	memcpy(tileset->types, src->types, src->numtiles);
 	memcpy(tileset->attributes, src->attributes, size_attributes);
 	TLN_SetLastError(TLN_ERR_OK);
 	return tileset;
@@ -270,6 +278,7 @@ bool TLN_DeleteTileset (TLN_Tileset tileset)
 		}
 		free(tileset->tiles);
 		free(tileset->color_key);
+		free(tileset->types);
 		free(tileset->attributes);
 		if (tileset->animations)
 			free(tileset->animations);
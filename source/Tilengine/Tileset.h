@@ -46,6 +46,7 @@ struct Tileset
 	TLN_TileImage* images;	/* image tiles array */
 	TLN_TileAttributes* attributes;	/* attribute array */
 	bool* color_key;		 /* array telling if each line has color key or is solid */
+	uint8_t* types;			 /* PixelsType of each tile */
 	uint16_t* tiles;		/* tile indexes for animation */
 	uint8_t	data[];			 /* variable size data for images[], attributes[], color_key[] and pixels */
 };
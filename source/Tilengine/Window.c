@@ -246,7 +246,7 @@ static bool create_window(void)
 						break;
 					}
 				}
-				engine->target_fps = target_fps;
+				GetEngine()->target_fps = target_fps;
 			}
 
 #if defined WIN32
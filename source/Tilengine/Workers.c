@@ -0,0 +1,213 @@
+/*
+* Tilengine - The 2D retro graphics engine with raster effects
+* Copyright (C) 2015-2019 Marc Palacios Domenech <mailto:megamarc@hotmail.com>
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+/* persistent worker thread pool. The calling thread takes part in every job, items are handed
+ * out one at a time so uneven items balance across threads */
+
+#include <stdlib.h>
+#include "Workers.h"
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE				thread_t;
+typedef CRITICAL_SECTION	mutex_t;
+typedef CONDITION_VARIABLE	cond_t;
+#define mutex_init(m)		InitializeCriticalSection(m)
+#define mutex_free(m)		DeleteCriticalSection(m)
+#define mutex_lock(m)		EnterCriticalSection(m)
+#define mutex_unlock(m)		LeaveCriticalSection(m)
+#define cond_init(c)		InitializeConditionVariable(c)
+#define cond_free(c)
+#define cond_wait(c,m)		SleepConditionVariableCS(c, m, INFINITE)
+#define cond_signal(c)		WakeConditionVariable(c)
+#define cond_broadcast(c)	WakeAllConditionVariable(c)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t			thread_t;
+typedef pthread_mutex_t		mutex_t;
+typedef pthread_cond_t		cond_t;
+#define mutex_init(m)		pthread_mutex_init(m, NULL)
+#define mutex_free(m)		pthread_mutex_destroy(m)
+#define mutex_lock(m)		pthread_mutex_lock(m)
+#define mutex_unlock(m)		pthread_mutex_unlock(m)
+#define cond_init(c)		pthread_cond_init(c, NULL)
+#define cond_free(c)		pthread_cond_destroy(c)
+#define cond_wait(c,m)		pthread_cond_wait(c, m)
+#define cond_signal(c)		pthread_cond_signal(c)
+#define cond_broadcast(c)	pthread_cond_broadcast(c)
+#endif
+
+typedef struct
+{
+	Workers*	pool;
+	int			index;
+	thread_t	thread;
+}
+Worker;
+
+struct Workers
+{
+	int			numthreads;			/* threads taking part in a job, including the caller */
+	Worker		threads[MAX_WORKERS];
+	mutex_t		lock;
+	cond_t		start;				/* signaled when a job is posted or on shutdown */
+	cond_t		done;				/* signaled when the last worker finishes a job */
+	unsigned	generation;			/* incremented for each posted job */
+	int			busy;				/* worker threads still on the current job */
+	bool		quit;
+	WorkerJob	job;
+	void*		data;
+	int			numitems;
+	int			next;				/* next item to hand out */
+};
+
+/* runs items of the current job until none are left, called with the lock held */
+static void run_items(Workers* workers, int thread)
+{
+	while (workers->next < workers->numitems)
+	{
+		const int item = workers->next++;
+		mutex_unlock(&workers->lock);
+		workers->job(item, thread, workers->data);
+		mutex_lock(&workers->lock);
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID param)
+#else
+static void* worker_main(void* param)
+#endif
+{
+	Worker* worker = (Worker*)param;
+	Workers* workers = worker->pool;
+	unsigned generation = 0;
+
+	mutex_lock(&workers->lock);
+	while (true)
+	{
+		while (workers->generation == generation && !workers->quit)
+			cond_wait(&workers->start, &workers->lock);
+		if (workers->quit)
+			break;
+
+		generation = workers->generation;
+		run_items(workers, worker->index);
+		workers->busy -= 1;
+		if (workers->busy == 0)
+			cond_signal(&workers->done);
+	}
+	mutex_unlock(&workers->lock);
+	return 0;
+}
+
+/* starts numthreads - 1 worker threads, the caller is the remaining one */
+Workers* CreateWorkers(int numthreads)
+{
+	Workers* workers;
+	int c;
+
+	if (numthreads < 2 || numthreads > MAX_WORKERS)
+		return NULL;
+
+	workers = (Workers*)calloc(1, sizeof(Workers));
+	if (workers == NULL)
+		return NULL;
+
+	mutex_init(&workers->lock);
+	cond_init(&workers->start);
+	cond_init(&workers->done);
+
+	for (c = 1; c < numthreads; c += 1)
+	{
+		Worker* worker = &workers->threads[c];
+		bool ok;
+		worker->pool = workers;
+		worker->index = c;
+#ifdef _WIN32
+		worker->thread = CreateThread(NULL, 0, worker_main, worker, 0, NULL);
+		ok = worker->thread != NULL;
+#else
+		ok = pthread_create(&worker->thread, NULL, worker_main, worker) == 0;
+#endif
+		if (!ok)
+			break;
+		workers->numthreads = c + 1;
+	}
+
+	if (workers->numthreads < 2)
+	{
+		DeleteWorkers(workers);
+		return NULL;
+	}
+	return workers;
+}
+
+/* stops and joins the worker threads */
+void DeleteWorkers(Workers* workers)
+{
+	int c;
+
+	if (workers == NULL)
+		return;
+
+	mutex_lock(&workers->lock);
+	workers->quit = true;
+	cond_broadcast(&workers->start);
+	mutex_unlock(&workers->lock);
+
+	for (c = 1; c < workers->numthreads; c += 1)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(workers->threads[c].thread, INFINITE);
+		CloseHandle(workers->threads[c].thread);
+#else
+		pthread_join(workers->threads[c].thread, NULL);
+#endif
+	}
+
+	cond_free(&workers->done);
+	cond_free(&workers->start);
+	mutex_free(&workers->lock);
+	free(workers);
+}
+
+/* runs job for items [0, numitems) across all threads and returns when all are done */
+void RunWorkers(Workers* workers, WorkerJob job, void* data, int numitems)
+{
+	mutex_lock(&workers->lock);
+	workers->job = job;
+	workers->data = data;
+	workers->numitems = numitems;
+	workers->next = 0;
+	workers->busy = workers->numthreads - 1;
+	workers->generation += 1;
+	cond_broadcast(&workers->start);
+
+	run_items(workers, 0);
+	while (workers->busy > 0)
+		cond_wait(&workers->done, &workers->lock);
+	mutex_unlock(&workers->lock);
+}
+
+/* returns number of online processors, at least 1 */
+int GetNumProcessors(void)
+{
+	int count;
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	count = (int)info.dwNumberOfProcessors;
+#else
+	count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return count > 0 ? count : 1;
+}
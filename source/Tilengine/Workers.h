@@ -0,0 +1,28 @@
+/*
+* Tilengine - The 2D retro graphics engine with raster effects
+* Copyright (C) 2015-2019 Marc Palacios Domenech <mailto:megamarc@hotmail.com>
+* All rights reserved
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/.
+* */
+
+#ifndef _WORKERS_H
+#define _WORKERS_H
+
+#include "Tilengine.h"
+
+#define MAX_WORKERS	16
+
+/* job callback: item to process, index of the thread running it (0 = caller) */
+typedef void (*WorkerJob)(int item, int thread, void* data);
+
+typedef struct Workers Workers;
+
+Workers* CreateWorkers(int numthreads);
+void DeleteWorkers(Workers* workers);
+void RunWorkers(Workers* workers, WorkerJob job, void* data, int numitems);
+int GetNumProcessors(void);
+
+#endif
@@ -18,6 +18,7 @@ static int first;
  */
 bool TLN_LoadWorld(const char* filename, int first_layer)
 {
+	Engine* const ctx = GetEngine();
 	int c;
 
 	if (!TMXLoad(filename, &tmxinfo))
@@ -60,7 +61,7 @@ bool TLN_LoadWorld(const char* filename, int first_layer)
 		}
 
 		/* direct set of layer properties */
-		Layer* layer = GetLayer(layerindex);
+		Layer* layer = &ctx->layers[layerindex];
 		layer->world.xfactor = tmxlayer->parallaxx;
 		layer->world.yfactor = tmxlayer->parallaxy;
 		layer->world.offsetx = (int)tmxlayer->offsetx;
@@ -100,6 +101,7 @@ bool TLN_LoadWorld(const char* filename, int first_layer)
  */
 void TLN_ReleaseWorld(void)
 {
+	Engine* const ctx = GetEngine();
 	int c;
 
 	for (c = 0; c < tmxinfo.num_layers; c += 1)
@@ -107,7 +109,7 @@ void TLN_ReleaseWorld(void)
 		TMXLayer* tmxlayer = &tmxinfo.layers[c];
 		const int layerindex = tmxinfo.num_layers - c - 1 + first;
 		
-		Layer* layer = GetLayer(layerindex);
+		Layer* layer = &ctx->layers[layerindex];
 		layer->ok = false;
 		switch (tmxlayer->type)
 		{
@@ -137,14 +139,15 @@ void TLN_ReleaseWorld(void)
  */
 bool TLN_SetLayerParallaxFactor(int nlayer, float x, float y)
 {
+	Engine* const ctx = GetEngine();
 	Layer *layer;
-	if (nlayer >= engine->numlayers)
+	if (nlayer >= ctx->numlayers)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_LAYER);
 		return false;
 	}
 
-	layer = &engine->layers[nlayer];
+	layer = &ctx->layers[nlayer];
 	layer->world.xfactor = x;
 	layer->world.yfactor = y;
 	layer->dirty = true;
@@ -159,9 +162,11 @@ bool TLN_SetLayerParallaxFactor(int nlayer, float x, float y)
  */
 void TLN_SetWorldPosition(int x, int y)
 {
-	engine->xworld = x;
-	engine->yworld = y;
-	engine->dirty = true;
+	Engine* const ctx = GetEngine();
+
+	ctx->xworld = x;
+	ctx->yworld = y;
+	ctx->dirty = true;
 }
 
 /*!
@@ -173,14 +178,15 @@ void TLN_SetWorldPosition(int x, int y)
  */
 bool TLN_SetSpriteWorldPosition(int nsprite, int x, int y)
 {
+	Engine* const ctx = GetEngine();
 	Sprite *sprite;
-	if (nsprite >= engine->numsprites)
+	if (nsprite >= ctx->numsprites)
 	{
 		TLN_SetLastError(TLN_ERR_IDX_SPRITE);
 		return false;
 	}
 
-	sprite = &engine->sprites[nsprite];
+	sprite = &ctx->sprites[nsprite];
 	sprite->xworld = x;
 	sprite->yworld = y;
 	sprite->world_space = true;
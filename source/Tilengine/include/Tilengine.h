@@ -274,6 +274,18 @@ typedef struct
 }
 TLN_TileImage;
 
+/*! per-scanline layer parameters for TLN_SetLayerRasterTable() */
+typedef struct
+{
+	int16_t dx;				/*!< horizontal offset added to the layer position */
+	int16_t dy;				/*!< vertical offset added to the layer position */
+	int16_t x1;				/*!< left edge of the clip region for this line */
+	int16_t x2;				/*!< right edge of the clip region, x1 = x2 = 0 keeps the layer clip */
+	uint8_t blend;			/*!< blend factor for this line, 0 keeps the layer factor */
+	TLN_Palette palette;	/*!< palette for this line, NULL keeps the layer palette */
+}
+TLN_RasterLine;
+
 /*! Sprite state */
 typedef struct
 {
@@ -405,6 +417,7 @@ TLNAPI TLN_Engine TLN_Init (int hres, int vres, int numlayers, int numsprites, i
 TLNAPI void TLN_Deinit (void);
 TLNAPI bool TLN_DeleteContext (TLN_Engine context);
 TLNAPI bool TLN_SetContext(TLN_Engine context);
+TLNAPI bool TLN_SetThreadContext(TLN_Engine context);
 TLNAPI TLN_Engine TLN_GetContext(void);
 TLNAPI void TLN_SetTargetFps(int fps);
 TLNAPI int TLN_GetTargetFps(void);
@@ -425,6 +438,9 @@ TLNAPI void TLN_SetRasterCallback (TLN_VideoCallback);
 TLNAPI void TLN_SetFrameCallback (TLN_VideoCallback);
 TLNAPI void TLN_SetRenderTarget (uint8_t* data, int pitch);
 TLNAPI void TLN_UpdateFrame (int frame);
+TLNAPI bool TLN_SetRenderThreads (int count);
+TLNAPI bool TLN_EnableDirtyTracking (bool enable);
+TLNAPI void TLN_SetDirtyLines (int top_line, int bottom_line);
 TLNAPI void TLN_SetLoadPath (const char* path);
 TLNAPI void TLN_SetCustomBlendFunction (TLN_BlendFunction);
 TLNAPI void TLN_SetLogLevel(TLN_LogLevel log_level);
@@ -586,6 +602,7 @@ TLNAPI bool TLN_SetLayerTransform (int layer, float angle, float dx, float dy, f
 TLNAPI bool TLN_SetLayerPixelMapping (int nlayer, TLN_PixelMap* table);
 TLNAPI bool TLN_SetLayerBlendMode (int nlayer, TLN_Blend mode, uint8_t factor);
 TLNAPI bool TLN_SetLayerColumnOffset (int nlayer, int* offset);
+TLNAPI bool TLN_SetLayerRasterTable (int nlayer, TLN_RasterLine* table);
 TLNAPI bool TLN_SetLayerClip (int nlayer, int x1, int y1, int x2, int y2);
 TLNAPI bool TLN_DisableLayerClip (int nlayer);
 TLNAPI bool TLN_SetLayerWindow(int nlayer, int x1, int y1, int x2, int y2, bool invert);
@@ -643,6 +660,7 @@ TLNAPI bool TLN_SetFirstSprite(int nsprite);
 TLNAPI bool TLN_SetNextSprite(int nsprite, int next);
 TLNAPI bool TLN_EnableSpriteMasking(int nsprite, bool enable);
 TLNAPI void TLN_SetSpritesMaskRegion(int top_line, int bottom_line);
+TLNAPI bool TLN_SetSpritesPerLine(int count);
 TLNAPI bool TLN_SetSpriteAnimation (int nsprite, TLN_Sequence sequence, int loop);
 TLNAPI bool TLN_DisableSpriteAnimation(int nsprite);
 TLNAPI bool TLN_PauseSpriteAnimation(int index);